@@ -79,10 +79,68 @@ extern "C" {
 # define U_CELL_CFG_GREETING_CALLBACK_MAX_LEN_BYTES 64
 #endif
 
+#ifndef U_CELL_CFG_SNAPSHOT_MAX_NUM_RATS
+/** The maximum number of RATs that can be included in a
+ * configuration snapshot, see uCellCfgSnapshotApply().
+ */
+# define U_CELL_CFG_SNAPSHOT_MAX_NUM_RATS 3
+#endif
+
+#ifndef U_CELL_CFG_SNAPSHOT_MAX_NUM_UDCONF
+/** The maximum number of "AT+UDCONF" settings that can be
+ * included in a configuration snapshot, see uCellCfgSnapshotApply().
+ */
+# define U_CELL_CFG_SNAPSHOT_MAX_NUM_UDCONF 4
+#endif
+
+#ifndef U_CELL_CFG_SNAPSHOT_FILE_NAME
+/** The name of the file, on the cellular module's file system, in
+ * which the fingerprint of the last configuration snapshot to be
+ * applied is stored, see uCellCfgSnapshotApply().
+ */
+# define U_CELL_CFG_SNAPSHOT_FILE_NAME "ubxlib_cfg_snapshot"
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** An "AT+UDCONF" setting, for use in a configuration snapshot.
+ */
+typedef struct {
+    int32_t param1; /**< the first parameter of the "AT+UDCONF" command. */
+    int32_t param2; /**< the second parameter of the "AT+UDCONF" command,
+                         -1 where the value follows param1 directly. */
+    int32_t value;  /**< the value to set. */
+} uCellCfgSnapshotUdconf_t;
+
+/** A snapshot of the configuration that an application wants a
+ * cellular module to have, for use with uCellCfgSnapshotApply().
+ * Anything that is not to be managed by the snapshot should be
+ * left at the value it has in #U_CELL_CFG_SNAPSHOT_DEFAULTS.
+ */
+typedef struct {
+    int32_t mnoProfile; /**< the MNO profile, -1 to leave alone. */
+    /** the RATs in rank order, unused entries set to
+        #U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED; leave rat[0] as
+        #U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED to leave the RATs alone. */
+    uCellNetRat_t rat[U_CELL_CFG_SNAPSHOT_MAX_NUM_RATS];
+    uint64_t bandMask1CatM1; /**< band mask 1 for cat-M1, zero (along with
+                                  bandMask2CatM1) to leave alone. */
+    uint64_t bandMask2CatM1; /**< band mask 2 for cat-M1. */
+    uint64_t bandMask1Nb1;   /**< band mask 1 for NB1, zero (along with
+                                  bandMask2Nb1) to leave alone. */
+    uint64_t bandMask2Nb1;   /**< band mask 2 for NB1. */
+    /** the "AT+UDCONF" settings. */
+    uCellCfgSnapshotUdconf_t udconf[U_CELL_CFG_SNAPSHOT_MAX_NUM_UDCONF];
+    size_t numUdconf; /**< the number of valid entries in udconf[]. */
+} uCellCfgSnapshot_t;
+
+/** Default values for #uCellCfgSnapshot_t, where nothing is managed.
+ */
+#define U_CELL_CFG_SNAPSHOT_DEFAULTS {-1, {U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED}, \
+                                      0, 0, 0, 0, {{0, 0, 0}}, 0}
+
 /** The interfaces that a GNSS chip inside or connected-via a cellular
  * may use, arranged as a bit-map and employed with uCellCfgSetGnssProfile()
  * / uCellCfgGetGnssProfile().  Not all modules support all values.
@@ -478,6 +536,47 @@ int32_t uCellCfgSetGnssProfile(uDeviceHandle_t cellHandle, int32_t profileBitMap
 int32_t uCellCfgGetGnssProfile(uDeviceHandle_t cellHandle, char *pServerName,
                                size_t sizeBytes);
 
+/** Apply a configuration snapshot to the cellular module, doing
+ * as little as possible.  Setting the MNO profile, RATs, band masks
+ * or "AT+UDCONF" values individually at every power-on costs AT
+ * round trips even when nothing has changed, and any change needs
+ * a reboot.  This function instead keeps a compact fingerprint of
+ * the last snapshot it applied in the file
+ * #U_CELL_CFG_SNAPSHOT_FILE_NAME on the module's file system: if the
+ * fingerprint matches that of pSnapshot, and the MNO profile that
+ * was read when the module was powered on agrees, nothing more is
+ * done, so a warm boot costs a single file read.  Otherwise the
+ * managed settings are read back from the module, only those that
+ * differ are written and the module is rebooted once at the end,
+ * (once more, before the rest, if the MNO profile has to be
+ * changed, since a new MNO profile may replace the RATs and band
+ * masks), after which the new fingerprint is stored.
+ *
+ * The module must be powered on for this to work but must NOT be
+ * connected to the cellular network.  If the configuration of the
+ * module may be changed by other means, call
+ * uCellCfgSnapshotForget() afterwards.
+ *
+ * @param cellHandle     the handle of the cellular instance.
+ * @param[in] pSnapshot  the configuration to apply; cannot be NULL.
+ * @return               on success the number of settings that had
+ *                       to be written (zero if the module was already
+ *                       configured), else negative error code.
+ */
+int32_t uCellCfgSnapshotApply(uDeviceHandle_t cellHandle,
+                              const uCellCfgSnapshot_t *pSnapshot);
+
+/** Forget the fingerprint of the last configuration snapshot
+ * applied with uCellCfgSnapshotApply(), so that the next call
+ * to uCellCfgSnapshotApply() reads back and checks all of the
+ * managed settings.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @return            zero on success (including if there was no
+ *                    fingerprint to forget) else negative error code.
+ */
+int32_t uCellCfgSnapshotForget(uDeviceHandle_t cellHandle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -48,10 +48,67 @@ extern "C" {
  */
 #define U_CELL_FILE_NAME_MAX_LENGTH 248
 
+#ifndef U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES
+/** The size of each block used by uCellFileReadStream() and
+ * uCellFileWriteStream(); a buffer of this size is allocated
+ * for the duration of the call.  Bigger blocks mean fewer AT
+ * command turn-arounds per file and hence a higher throughput.
+ */
+# define U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES 1024
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Callback that receives the data from uCellFileReadStream().
+ * IMPORTANT: this callback is called while the cellular API and
+ * the AT interface are locked; it must NOT call back into the
+ * cellular API and should return as quickly as possible.
+ *
+ * @param cellHandle              the handle of the cellular instance.
+ * @param[in] pData               a pointer to the block of data read
+ *                                from the file; this is NOT a
+ *                                null-terminated string.
+ * @param dataSize                the number of bytes at pData, never
+ *                                more than
+ *                                #U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES.
+ * @param offset                  the offset of pData from the start
+ *                                of the file.
+ * @param[in,out] pCallbackParam  the pCallbackParam pointer that
+ *                                was passed to uCellFileReadStream().
+ * @return                        true to continue reading, false
+ *                                to stop.
+ */
+typedef bool (uCellFileReadStreamCallback_t) (uDeviceHandle_t cellHandle,
+                                              const char *pData,
+                                              size_t dataSize,
+                                              size_t offset,
+                                              void *pCallbackParam);
+
+/** Callback that supplies the data for uCellFileWriteStream().
+ * IMPORTANT: this callback is called while the cellular API and
+ * the AT interface are locked; it must NOT call back into the
+ * cellular API and should return as quickly as possible.
+ *
+ * @param cellHandle              the handle of the cellular instance.
+ * @param[out] pBuffer            a pointer to a buffer into which the
+ *                                next block of data should be written.
+ * @param bufferSize              the amount of storage at pBuffer,
+ *                                will be
+ *                                #U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES.
+ * @param[in,out] pCallbackParam  the pCallbackParam pointer that
+ *                                was passed to uCellFileWriteStream().
+ * @return                        the number of bytes written to
+ *                                pBuffer, zero if there is no more
+ *                                data or negative error code to
+ *                                abort the write.
+ */
+typedef int32_t (uCellFileWriteStreamCallback_t) (uDeviceHandle_t cellHandle,
+                                                  char *pBuffer,
+                                                  size_t bufferSize,
+                                                  void *pCallbackParam);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS:  WORKAROUND FOR LINKER ISSUE
  * -------------------------------------------------------------- */
@@ -162,6 +219,66 @@ int32_t uCellFileBlockRead(uDeviceHandle_t cellHandle,
                            size_t offset,
                            size_t dataSize);
 
+/** Read a file from the file system, from the given offset to the
+ * end, passing it to pCallback in blocks of up to
+ * #U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES.  This is the most
+ * efficient way to read a large file: the AT interface is held
+ * for the duration, each block is requested as soon as the last
+ * has been delivered and a single buffer is used throughout.
+ * Since the AT interface is held, other cellular operations
+ * (including URCs) will be held off until the read completes.
+ * As for uCellFileBlockRead(), tags are NOT supported.  In order
+ * to avoid character loss it is recommended that flow control
+ * lines are connected on the interface to the module.
+ *
+ * @param cellHandle          the handle of the cellular instance.
+ * @param[in] pFileName       a pointer to file name to read file
+ *                            contents from the file system. File
+ *                            name cannot contain these characters:
+ *                            / * : % | " < > ?.
+ * @param offset              offset in bytes from the beginning of
+ *                            the file at which to start reading.
+ * @param[in] pCallback       the callback to receive the data, cannot
+ *                            be NULL.
+ * @param[in] pCallbackParam  a parameter that will be passed to
+ *                            pCallback; may be NULL.
+ * @return                    on success the number of bytes passed
+ *                            to pCallback, else negative error code.
+ */
+int32_t uCellFileReadStream(uDeviceHandle_t cellHandle,
+                            const char *pFileName,
+                            size_t offset,
+                            uCellFileReadStreamCallback_t *pCallback,
+                            void *pCallbackParam);
+
+/** Write a file to the file system with data supplied by pCallback
+ * in blocks of up to #U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES, stopping
+ * when pCallback returns zero.  As for uCellFileWrite(), if the file
+ * already exists the data is appended to it.  The AT interface is
+ * held for the duration, so other cellular operations (including
+ * URCs) will be held off until the write completes.  In order to
+ * avoid character loss it is recommended that flow control lines
+ * are connected on the interface to the module.
+ *
+ * @param cellHandle          the handle of the cellular instance.
+ * @param[in] pFileName       a pointer to file name to be stored on
+ *                            the file system. File name cannot
+ *                            contain these characters:
+ *                            / * : % | " < > ?.
+ * @param[in] pCallback       the callback to supply the data, cannot
+ *                            be NULL.
+ * @param[in] pCallbackParam  a parameter that will be passed to
+ *                            pCallback; may be NULL.
+ * @return                    on success the number of bytes written
+ *                            to the file, else negative error code;
+ *                            if pCallback returns a negative error
+ *                            code then that is returned.
+ */
+int32_t uCellFileWriteStream(uDeviceHandle_t cellHandle,
+                             const char *pFileName,
+                             uCellFileWriteStreamCallback_t *pCallback,
+                             void *pCallbackParam);
+
 /** Read size of file on the file system. If the file does not exists,
  * error will be return.
  *
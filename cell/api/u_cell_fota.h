@@ -45,10 +45,88 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_CELL_FOTA_IMAGE_BLOCK_LENGTH_BYTES
+/** The size of the blocks in which uCellFotaImageDownload() writes
+ * an image to the module file system; a buffer of this size is
+ * allocated for the duration of the download.
+ */
+# define U_CELL_FOTA_IMAGE_BLOCK_LENGTH_BYTES 1024
+#endif
+
+#ifndef U_CELL_FOTA_IMAGE_STALL_POLL_MS
+/** How long uCellFotaImageDownload() waits before calling the
+ * source callback again when it has returned no data.
+ */
+# define U_CELL_FOTA_IMAGE_STALL_POLL_MS 100
+#endif
+
+#ifndef U_CELL_FOTA_IMAGE_STALL_TIMEOUT_SECONDS
+/** How long uCellFotaImageDownload() will put up with the source
+ * callback returning no data before giving up.
+ */
+# define U_CELL_FOTA_IMAGE_STALL_TIMEOUT_SECONDS 60
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The progress of uCellFotaImageDownload(), passed to the
+ * progress callback after every block written.
+ */
+typedef struct {
+    size_t sizeBytes;         /**< the number of bytes of the image
+                                   written to the module so far. */
+    size_t totalSizeBytes;    /**< the total size of the image. */
+    int32_t elapsedMs;        /**< the time since the download started. */
+    int32_t bytesPerSecond;   /**< the average throughput since the
+                                   download started. */
+    int32_t etaSeconds;       /**< the estimated time to completion
+                                   at bytesPerSecond, -1 if not yet
+                                   known. */
+    size_t stallCount;        /**< the number of times the source
+                                   has run dry. */
+    int32_t stallTotalMs;     /**< the total time spent waiting for
+                                   the source. */
+} uCellFotaImageProgress_t;
+
+/** Function signature of the callback that supplies image data to
+ * uCellFotaImageDownload(), e.g. from a socket or an HTTP response.
+ * This is called from the task that called uCellFotaImageDownload()
+ * with no cellular locks held, so it is free to use the cellular
+ * API (e.g. to read from a socket on the same module).
+ *
+ * @param cellHandle              the handle of the cellular instance.
+ * @param[out] pBuffer            a place to put the data.
+ * @param bufferSize              the amount of storage at pBuffer.
+ * @param[in,out] pCallbackParam  the pSourceCallbackParam pointer that
+ *                                was passed to uCellFotaImageDownload().
+ * @return                        the number of bytes written to
+ *                                pBuffer, zero if no data is available
+ *                                right now (the callback will be called
+ *                                again after
+ *                                #U_CELL_FOTA_IMAGE_STALL_POLL_MS) or
+ *                                negative error code to abort the
+ *                                download.
+ */
+typedef int32_t (uCellFotaImageSourceCallback_t) (uDeviceHandle_t cellHandle,
+                                                  char *pBuffer,
+                                                  size_t bufferSize,
+                                                  void *pCallbackParam);
+
+/** Function signature of the progress callback for
+ * uCellFotaImageDownload().
+ *
+ * @param cellHandle              the handle of the cellular instance.
+ * @param[in] pProgress           the progress so far; only valid for
+ *                                the duration of the callback.
+ * @param[in,out] pCallbackParam  the pProgressCallbackParam pointer that
+ *                                was passed to uCellFotaImageDownload().
+ */
+typedef void (uCellFotaImageProgressCallback_t) (uDeviceHandle_t cellHandle,
+                                                 const uCellFotaImageProgress_t *pProgress,
+                                                 void *pCallbackParam);
+
 /** The possible FOTA status types.
  */
 typedef enum {
@@ -173,6 +251,56 @@ int32_t uCellFotaSetStatusCallback(uDeviceHandle_t cellHandle,
                                    uCellFotaStatusCallback_t *pCallback,
                                    void *pCallbackParameter);
 
+/** Download a module firmware image (e.g. a delta file) from the host
+ * into the module file system, for a host-driven firmware update.
+ * The data is pulled from pSourceCallback, collected into blocks of
+ * #U_CELL_FOTA_IMAGE_BLOCK_LENGTH_BYTES and each block is written to
+ * the module as soon as it is full.  If pSha256 is given, the image
+ * is hashed as it passes through, so no read-back of the file is
+ * needed to verify it.  Any existing file of the same name is deleted
+ * first; if the download fails or the hash does not match, the partial
+ * file is deleted.  If the module requires the image to be written to
+ * a particular area of the file system, set the tag for that area
+ * with uCellFileSetTag() before calling this function.
+ *
+ * Installing the image is a separate, module-specific, step; progress
+ * of that may be monitored with uCellFotaSetStatusCallback().
+ *
+ * @param cellHandle                  the handle of the cellular
+ *                                    instance.
+ * @param[in] pFileName               the name of the file to write
+ *                                    the image to; cannot be NULL.
+ * @param imageSizeBytes              the size of the image in bytes;
+ *                                    must be greater than zero.
+ * @param[in] pSha256                 the expected SHA256 of the image,
+ *                                    32 bytes of binary; may be NULL
+ *                                    if no verification is required.
+ * @param[in] pSourceCallback         the callback that supplies the
+ *                                    image data; cannot be NULL.
+ * @param[in] pSourceCallbackParam    a parameter that will be passed
+ *                                    to pSourceCallback; may be NULL.
+ * @param[in] pProgressCallback       a callback that will be called
+ *                                    with progress information after
+ *                                    every block written; may be NULL.
+ * @param[in] pProgressCallbackParam  a parameter that will be passed
+ *                                    to pProgressCallback; may be NULL.
+ * @return                            on success the number of bytes
+ *                                    written, else negative error code;
+ *                                    #U_ERROR_COMMON_AUTHENTICATION_FAILURE
+ *                                    is returned if the SHA256 does not
+ *                                    match, #U_ERROR_COMMON_TIMEOUT if the
+ *                                    source stalls for longer than
+ *                                    #U_CELL_FOTA_IMAGE_STALL_TIMEOUT_SECONDS.
+ */
+int32_t uCellFotaImageDownload(uDeviceHandle_t cellHandle,
+                               const char *pFileName,
+                               size_t imageSizeBytes,
+                               const char *pSha256,
+                               uCellFotaImageSourceCallback_t *pSourceCallback,
+                               void *pSourceCallbackParam,
+                               uCellFotaImageProgressCallback_t *pProgressCallback,
+                               void *pProgressCallbackParam);
+
 #ifdef __cplusplus
 }
 #endif
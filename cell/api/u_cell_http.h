@@ -66,6 +66,19 @@ extern "C" {
 # define U_CELL_HTTP_TIMEOUT_SECONDS_MIN 30
 #endif
 
+#ifndef U_CELL_HTTP_REQUEST_HEADER_MAX_NUM
+/** The number of custom request headers that may be set with
+ * uCellHttpSetRequestHeader().
+ */
+# define U_CELL_HTTP_REQUEST_HEADER_MAX_NUM 5
+#endif
+
+#ifndef U_CELL_HTTP_REQUEST_HEADER_MAX_LENGTH_BYTES
+/** The maximum length of a custom request header, name plus value.
+ */
+# define U_CELL_HTTP_REQUEST_HEADER_MAX_LENGTH_BYTES 128
+#endif
+
 #ifndef U_CELL_HTTP_FILE_NAME_RESPONSE_AUTO_PREFIX
 /** The prefix to use for an automatically-allocated response file name.
  */
@@ -330,6 +343,32 @@ int32_t uCellHttpRequestFile(uDeviceHandle_t cellHandle, int32_t httpHandle,
                              const char *pFileNamePutPost,
                              const char *pContentTypePutPost);
 
+/** Set, or remove, a custom header that will be included in all
+ * subsequent HTTP requests on the given HTTP instance, for example a
+ * "Range" header.  Not supported by all modules.
+ *
+ * @param cellHandle     the handle of the cellular instance to be used.
+ * @param httpHandle     the handle of the HTTP instance, as returned by
+ *                       uCellHttpOpen().
+ * @param headerId       the ID of the custom header, 0 to
+ *                       #U_CELL_HTTP_REQUEST_HEADER_MAX_NUM - 1; setting
+ *                       a header with the same ID as an existing one
+ *                       replaces it.
+ * @param[in] pName      the null-terminated name of the header, for
+ *                       example "Range", without a colon; use NULL to
+ *                       remove the header with this ID.
+ * @param[in] pValue     the null-terminated value of the header, for
+ *                       example "bytes=0-1023"; cannot be NULL if
+ *                       pName is non-NULL.  The name and value must be
+ *                       printable and not contain quotation marks,
+ *                       strlen(pName) + strlen(pValue) cannot be more than
+ *                       #U_CELL_HTTP_REQUEST_HEADER_MAX_LENGTH_BYTES.
+ * @return               zero on success, else negative error code.
+ */
+int32_t uCellHttpSetRequestHeader(uDeviceHandle_t cellHandle, int32_t httpHandle,
+                                  int32_t headerId, const char *pName,
+                                  const char *pValue);
+
 /** Get the last HTTP error code.
  *
  * @param cellHandle     the handle of the cellular instance to be used.
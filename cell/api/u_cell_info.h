@@ -58,10 +58,66 @@ extern "C" {
  */
 #define U_CELL_INFO_ICCID_BUFFER_SIZE 21
 
+#ifndef U_CELL_INFO_RADIO_RING_LENGTH
+/** The number of samples held in a #uCellInfoRadioRing_t, see
+ * uCellInfoSamplerStart().
+ */
+# define U_CELL_INFO_RADIO_RING_LENGTH 32
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A sample of the radio parameters, as stored by the radio sampler,
+ * see uCellInfoSamplerStart(); the values have the same meanings
+ * and units as those returned by uCellInfoGetRssiDbm(),
+ * uCellInfoGetRsrpDbm(), uCellInfoGetRsrqDb(), uCellInfoGetSnrDb(),
+ * uCellInfoGetCellId() and uCellInfoGetEarfcn().
+ */
+typedef struct {
+    int32_t timeMs;  /**< the value of uPortGetTickTimeMs() when
+                          the sample was taken. */
+    int32_t rssiDbm; /**< the RSSI, zero if not known. */
+    int32_t rsrpDbm; /**< the RSRP, zero if not known. */
+    int32_t rsrqDb;  /**< the RSRQ, 0x7FFFFFFF if not known. */
+    int32_t snrDb;   /**< the SNR, 0x7FFFFFFF if not known. */
+    int32_t cellId;  /**< the cell ID, -1 if not known. */
+    int32_t earfcn;  /**< the EARFCN, -1 if not known. */
+} uCellInfoRadioSample_t;
+
+/** A ring of radio parameter samples, written by the radio
+ * sampler; the storage is provided by the application and should
+ * be treated as opaque: use uCellInfoRadioRingRead() and
+ * uCellInfoRadioRingSummary() to read it.
+ */
+typedef struct {
+    uCellInfoRadioSample_t sample[U_CELL_INFO_RADIO_RING_LENGTH];
+    volatile uint32_t numWritten; /**< the total number of samples written. */
+    volatile uint32_t sequence;   /**< odd while a sample is being written. */
+} uCellInfoRadioRing_t;
+
+/** Summary statistics of one radio parameter, see
+ * uCellInfoRadioRingSummary().
+ */
+typedef struct {
+    size_t numSamples; /**< the number of samples where the value was known. */
+    int32_t min;       /**< the minimum value. */
+    int32_t max;       /**< the maximum value. */
+    int32_t mean;      /**< the mean value, rounded towards zero. */
+} uCellInfoRadioStatistic_t;
+
+/** Summary statistics of the radio parameters over a window,
+ * see uCellInfoRadioRingSummary().
+ */
+typedef struct {
+    size_t numSamples;                 /**< the number of samples in the window. */
+    uCellInfoRadioStatistic_t rssiDbm; /**< statistics for the RSSI. */
+    uCellInfoRadioStatistic_t rsrpDbm; /**< statistics for the RSRP. */
+    uCellInfoRadioStatistic_t rsrqDb;  /**< statistics for the RSRQ. */
+    uCellInfoRadioStatistic_t snrDb;   /**< statistics for the SNR. */
+} uCellInfoRadioSummary_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -172,7 +228,12 @@ int32_t uCellInfoGetCellId(uDeviceHandle_t cellHandle);
  */
 int32_t uCellInfoGetEarfcn(uDeviceHandle_t cellHandle);
 
-/** Get the IMEI of the cellular module.
+/** Get the IMEI of the cellular module.  The IMEI, like the IMSI,
+ * ICCID, manufacturer, model and firmware version strings, is read
+ * from the module once and then served from RAM; the cached values
+ * are discarded when the module is powered on, off or rebooted,
+ * when a +UUSIMSTAT URC indicates a SIM change (in the case of the
+ * IMSI and ICCID) and when a FOTA installation begins.
  *
  * @param cellHandle  the handle of the cellular instance.
  * @param[out] pImei  a pointer to #U_CELL_INFO_IMEI_SIZE bytes
@@ -308,6 +369,74 @@ int64_t uCellInfoGetTimeUtc(uDeviceHandle_t cellHandle);
 int32_t uCellInfoGetTimeUtcStr(uDeviceHandle_t cellHandle,
                                char *pStr, size_t size);
 
+/** Start a background task which samples the radio parameters
+ * every periodMs and writes them to pRing, for charting purposes.
+ * The task is of low priority and does not compete with other
+ * users of this API: if another cellular API call is in progress
+ * when a sample is due, the sample is put off, and a successful
+ * call to uCellInfoRefreshRadioParameters() by the application
+ * counts as a sample and restarts the period.  Samples are
+ * only taken while the module is registered with the network.
+ * If the sampler is already running it is restarted with the new
+ * parameters.  Memory is allocated by this function which is
+ * freed by uCellInfoSamplerStop() or when the cellular instance
+ * is removed.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @param periodMs    the sampling period in milliseconds; must be
+ *                    greater than zero.
+ * @param[out] pRing  storage for the samples; this must remain
+ *                    valid until uCellInfoSamplerStop() is called,
+ *                    and it is cleared by this function.  It may
+ *                    be read at any time, from any task, using
+ *                    uCellInfoRadioRingRead() and
+ *                    uCellInfoRadioRingSummary(), neither of
+ *                    which block the sampler or each other.
+ * @return            zero on success, negative error code on
+ *                    failure.
+ */
+int32_t uCellInfoSamplerStart(uDeviceHandle_t cellHandle, int32_t periodMs,
+                              uCellInfoRadioRing_t *pRing);
+
+/** Stop the radio sampler started with uCellInfoSamplerStart();
+ * the ring retains the samples written to it.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ */
+void uCellInfoSamplerStop(uDeviceHandle_t cellHandle);
+
+/** Read a sample from a ring written by the radio sampler.  This
+ * does not lock anything and does not talk to the module.
+ *
+ * @param[in] pRing     the ring; cannot be NULL.
+ * @param index         the index of the sample to read, where 0
+ *                      is the most recent sample, 1 the one before
+ *                      that, etc.
+ * @param[out] pSample  a place to put the sample; cannot be NULL.
+ * @return              zero on success, #U_ERROR_COMMON_EMPTY if
+ *                      there is no sample at index, else negative
+ *                      error code.
+ */
+int32_t uCellInfoRadioRingRead(const uCellInfoRadioRing_t *pRing, size_t index,
+                               uCellInfoRadioSample_t *pSample);
+
+/** Get summary statistics (minimum, maximum and mean) of the RSSI,
+ * RSRP, RSRQ and SNR in a ring written by the radio sampler, over
+ * a window of time.  This does not lock anything and does not talk
+ * to the module.
+ *
+ * @param[in] pRing      the ring; cannot be NULL.
+ * @param windowMs       the window: only samples taken in the last
+ *                       windowMs milliseconds are included; use zero
+ *                       to include all of the samples in the ring.
+ * @param[out] pSummary  a place to put the summary; cannot be NULL.
+ * @return               the number of samples in the window, else
+ *                       negative error code.
+ */
+int32_t uCellInfoRadioRingSummary(const uCellInfoRadioRing_t *pRing,
+                                  int32_t windowMs,
+                                  uCellInfoRadioSummary_t *pSummary);
+
 /** Determine if RTS flow control, the signal from the
  * cellular module to this software that the module is
  * ready to receive data, is enabled.
@@ -119,6 +119,23 @@ extern "C" {
 # define U_CELL_MQTT_PROMPT_TIMEOUT_KEEP_ALIVE_SECONDS 30
 #endif
 
+#ifndef U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM
+/** The maximum number of messages published with
+ * uCellMqttPublishAsync() that may be outstanding (i.e. whose
+ * callback has not yet been called) at any one time, the upper
+ * limit for uCellMqttSetPublishWindow(); this determines the size
+ * of the MQTT context.
+ */
+# define U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM 8
+#endif
+
+#ifndef U_CELL_MQTT_PUBLISH_WINDOW_DEFAULT
+/** The default number of messages published with
+ * uCellMqttPublishAsync() that may be outstanding at any one time.
+ */
+# define U_CELL_MQTT_PUBLISH_WINDOW_DEFAULT 4
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -170,6 +187,26 @@ typedef struct {
 // *INDENT-ON*
 } uCellMqttSnTopicName_t;
 
+/** A message read by uCellMqttMessageReadBulk().  The structure
+ * here MUST match #uMqttClientMessage_t.
+ */
+typedef struct {
+    char *pTopicNameStr;        /**< a place to put the null-terminated
+                                     topic string of the message; cannot
+                                     be NULL. */
+    size_t topicNameSizeBytes;  /**< the number of bytes of storage at
+                                     pTopicNameStr. */
+    char *pMessage;             /**< a place to put the message; may be
+                                     NULL. */
+    size_t messageSizeBytes;    /**< on entry the number of bytes of
+                                     storage at pMessage, on return the
+                                     number of bytes written to pMessage. */
+    uCellMqttQos_t qos;         /**< on return, the QoS of the message. */
+    int32_t errorCode;          /**< on return, zero or
+                                     #U_ERROR_COMMON_TRUNCATED if the
+                                     message did not fit into pMessage. */
+} uCellMqttMessage_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS:  WORKAROUND FOR LINKER ISSUE
  * -------------------------------------------------------------- */
@@ -664,6 +701,106 @@ int32_t uCellMqttPublish(uDeviceHandle_t cellHandle, const char *pTopicNameStr,
                          size_t messageSizeBytes,
                          uCellMqttQos_t qos, bool retain);
 
+/** Publish an MQTT message without waiting for the result: this
+ * function returns as soon as the module has accepted the message,
+ * the result is passed to pCallback when the module reports it,
+ * allowing several messages to be in flight to the broker at once
+ * rather than one per round trip.  The number of messages that may
+ * be outstanding (i.e. whose pCallback has not yet been called) is
+ * limited by the window set with uCellMqttSetPublishWindow(); if the
+ * window is full #U_ERROR_COMMON_BUSY is returned and the caller
+ * should try again later.  Outstanding messages are completed with
+ * an error if the connection to the broker is lost.
+ *
+ * The module reports the results of publishes in the order the
+ * messages were sent, without identifying them.  Hence, should the
+ * oldest message receive no result within the timeout set with
+ * uCellMqttSetPublishTimeout(), all outstanding messages are completed
+ * with #U_ERROR_COMMON_TIMEOUT and both this function and
+ * uCellMqttPublish() return #U_ERROR_COMMON_BUSY until the late results
+ * for those messages have arrived (or none has arrived for
+ * #U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS), so that none of them can be
+ * credited to a later message.  For the same reason uCellMqttPublish()
+ * returns #U_ERROR_COMMON_BUSY while any message published with this
+ * function is outstanding.
+ *
+ * Not supported for MQTT-SN.
+ *
+ * @param cellHandle          the handle of the cellular instance to
+ *                            be used.
+ * @param[in] pTopicNameStr   the null-terminated topic string
+ *                            for the message; cannot be NULL.
+ * @param[in] pMessage        a pointer to the message, as for
+ *                            uCellMqttPublish(); the message is
+ *                            copied to the module before this
+ *                            function returns.  Cannot be NULL.
+ * @param messageSizeBytes    the length of pMessage, as for
+ *                            uCellMqttPublish().
+ * @param qos                 the MQTT QoS to use for this message.
+ * @param retain              if true the message will be retained
+ *                            by the broker across MQTT disconnects/
+ *                            connects.
+ * @param[in] pCallback       the callback to be called with the result,
+ *                            may be NULL.  The first parameter is the
+ *                            token that was returned by this function,
+ *                            the second parameter is zero if the
+ *                            message was published successfully, else
+ *                            negative error code, and the third
+ *                            parameter is pCallbackParam.  The callback
+ *                            is called from a separate task, in the
+ *                            order in which messages were published,
+ *                            and should not block for long.
+ * @param[in] pCallbackParam  a parameter that will be passed to
+ *                            pCallback as its third parameter.
+ * @return                    on success a token, zero or positive,
+ *                            which will be passed to pCallback, else
+ *                            negative error code.
+ */
+int32_t uCellMqttPublishAsync(uDeviceHandle_t cellHandle,
+                              const char *pTopicNameStr,
+                              const char *pMessage,
+                              size_t messageSizeBytes,
+                              uCellMqttQos_t qos, bool retain,
+                              void (*pCallback) (int32_t, int32_t, void *),
+                              void *pCallbackParam);
+
+/** Set the number of messages published with uCellMqttPublishAsync()
+ * that may be outstanding at any one time.  If the new window is
+ * smaller than the number of messages currently outstanding then
+ * no further messages may be published with uCellMqttPublishAsync()
+ * until enough have completed.
+ *
+ * @param cellHandle  the handle of the cellular instance to be used.
+ * @param windowSize  the window size, 1 to
+ *                    #U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM; the default
+ *                    is #U_CELL_MQTT_PUBLISH_WINDOW_DEFAULT.
+ * @return            zero on success else negative error code.
+ */
+int32_t uCellMqttSetPublishWindow(uDeviceHandle_t cellHandle,
+                                  size_t windowSize);
+
+/** Set how long a message published with uCellMqttPublishAsync() may
+ * wait for its result before it, and every message published after it
+ * that is still outstanding, is completed with #U_ERROR_COMMON_TIMEOUT.
+ *
+ * @param cellHandle  the handle of the cellular instance to be used.
+ * @param timeoutMs   the timeout in milliseconds, must be greater than
+ *                    zero; the default is
+ *                    #U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS.
+ * @return            zero on success else negative error code.
+ */
+int32_t uCellMqttSetPublishTimeout(uDeviceHandle_t cellHandle,
+                                   int32_t timeoutMs);
+
+/** Get the number of messages published with uCellMqttPublishAsync()
+ * that are outstanding, i.e. whose callback has not yet been called.
+ *
+ * @param cellHandle  the handle of the cellular instance to be used.
+ * @return            the number of outstanding messages, else
+ *                    negative error code.
+ */
+int32_t uCellMqttGetPublishInFlight(uDeviceHandle_t cellHandle);
+
 /** Subscribe to an MQTT topic. The pKeepGoingCallback()
  * function set during initialisation will be called while
  * this function is waiting for a subscription to complete.
@@ -733,6 +870,31 @@ int32_t uCellMqttMessageRead(uDeviceHandle_t cellHandle, char *pTopicNameStr,
                              char *pMessage, size_t *pMessageSizeBytes,
                              uCellMqttQos_t *pQos);
 
+/** Read as many MQTT messages as there are, up to numMessages, in
+ * one go: the AT interface is locked once for all of them, rather
+ * than once per message as it would be for repeated calls to
+ * uCellMqttMessageRead(), making it a quicker way to catch up
+ * with a large number of unread messages, e.g. after a reconnect.
+ * Messages are read in order into the elements of pMessages; a
+ * message that is longer than the storage provided for it is
+ * copied as far as it will fit and the errorCode field of that
+ * element is set to #U_ERROR_COMMON_TRUNCATED.
+ *
+ * @param cellHandle             the handle of the cellular instance to
+ *                               be used.
+ * @param[in,out] pMessages      an array of numMessages messages with
+ *                               the storage fields populated; cannot
+ *                               be NULL.
+ * @param numMessages            the number of elements in pMessages.
+ * @return                       the number of messages read, which
+ *                               will be at least one, else negative
+ *                               error code; #U_ERROR_COMMON_EMPTY if
+ *                               there were no messages to read.
+ */
+int32_t uCellMqttMessageReadBulk(uDeviceHandle_t cellHandle,
+                                 uCellMqttMessage_t *pMessages,
+                                 size_t numMessages);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MQTT-SN ONLY
  * -------------------------------------------------------------- */
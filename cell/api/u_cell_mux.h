@@ -41,6 +41,24 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_CELL_MUX_TX_PRIORITY_DEFAULT
+/** The default transmit priority of a multiplexer channel, see
+ * uCellMuxSetChannelTxPriority().
+ */
+# define U_CELL_MUX_TX_PRIORITY_DEFAULT 0
+#endif
+
+#ifndef U_CELL_MUX_TX_WEIGHT_DEFAULT
+/** The default transmit weight of a multiplexer channel, see
+ * uCellMuxSetChannelTxPriority().
+ */
+# define U_CELL_MUX_TX_WEIGHT_DEFAULT 1
+#endif
+
+/** The maximum transmit weight of a multiplexer channel.
+ */
+#define U_CELL_MUX_TX_WEIGHT_MAX 255
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -58,6 +76,21 @@ extern "C" {
 # define U_CELL_MUX_MAX_CHANNELS 3
 #endif
 
+/** Transmit statistics for a multiplexer channel, see
+ * uCellMuxGetChannelStats().
+ */
+typedef struct {
+    size_t queuedBytes;       /**< the number of bytes passed to the write()
+                                   function of the channel that have not yet
+                                   been sent. */
+    uint32_t sentBytes;       /**< the total number of bytes sent on the channel. */
+    uint32_t numBatches;      /**< the number of batches of CMUX frames sent. */
+    int32_t latencyAverageMs; /**< the average time that a batch of CMUX frames
+                                   had to wait for the UART. */
+    int32_t latencyMaxMs;     /**< the longest time that a batch of CMUX frames
+                                   had to wait for the UART. */
+} uCellMuxChannelStats_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS:  WORKAROUND FOR LINKER ISSUE
  * -------------------------------------------------------------- */
@@ -126,6 +159,43 @@ int32_t uCellMuxEnable(uDeviceHandle_t cellHandle);
  */
 bool uCellMuxIsEnabled(uDeviceHandle_t cellHandle);
 
+/** Set the maximum length of information field (3GPP 27.010
+ * parameter N1) that will be requested of the module the next time
+ * uCellMuxEnable() is called.  The default is 128 bytes which, for
+ * bulk transfers (e.g. socket data or streamed GNSS), means that
+ * a lot of the bandwidth of the UART is spent on CMUX framing; a
+ * larger value reduces that overhead.  The receive buffer of each
+ * multiplexer channel is sized at four times this value (and never
+ * smaller than for the default), so a larger value will use more
+ * heap.  When multiplexer mode is enabled, the module is asked what
+ * range it supports and the value is limited to that; should the
+ * module not accept the value, the default will be used instead.
+ * uCellMuxGetInformationLengthMax() may be called once multiplexer
+ * mode is enabled to find out what value was agreed.
+ *
+ * This function must be called while multiplexer mode is not
+ * enabled.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @param lengthBytes the maximum information field length to
+ *                    request; use zero to return to the default.
+ * @return            zero on success or negative error code on
+ *                    failure.
+ */
+int32_t uCellMuxSetInformationLengthMax(uDeviceHandle_t cellHandle,
+                                        size_t lengthBytes);
+
+/** Get the maximum length of information field (3GPP 27.010
+ * parameter N1): if multiplexer mode is enabled this is the value
+ * that was agreed with the module, else it is the value that will
+ * be requested when multiplexer mode is next enabled.
+ *
+ * @param cellHandle the handle of the cellular instance.
+ * @return           on success the maximum information field
+ *                   length in bytes, else negative error code.
+ */
+int32_t uCellMuxGetInformationLengthMax(uDeviceHandle_t cellHandle);
+
 /** Add a multiplexer channel; may be called after uCellMuxEnable()
  * has returned success in order to, for instance, create a virtual
  * serial port to a GNSS chip inside a SARA-R422M8S or SARA-R510M8S
@@ -208,6 +278,42 @@ int32_t uCellMuxAddChannel(uDeviceHandle_t cellHandle,
 uDeviceSerial_t *pUCellMuxChannelGetDeviceSerial(uDeviceHandle_t cellHandle,
                                                  int32_t channel);
 
+/** Set the transmit priority and weight of an open multiplexer
+ * channel.  When more than one multiplexer channel has data waiting
+ * to be sent, the channel with the highest priority is sent first;
+ * between channels of equal priority the UART is shared in proportion
+ * to their weights (weighted fair queuing), so that, for instance, a
+ * large file transfer on the AT channel does not starve a GNSS channel.
+ * Data is scheduled in batches of CMUX frames, a batch is never
+ * interrupted.  The control channel is not subject to scheduling.
+ * When a channel is opened it has priority #U_CELL_MUX_TX_PRIORITY_DEFAULT
+ * and weight #U_CELL_MUX_TX_WEIGHT_DEFAULT.
+ *
+ * @param cellHandle the handle of the cellular instance.
+ * @param channel    the channel number, may be #U_CELL_MUX_CHANNEL_ID_GNSS;
+ *                   cannot be the control channel, zero.
+ * @param priority   the priority, larger numbers meaning higher
+ *                   priority.
+ * @param weight     the weight, from 1 to #U_CELL_MUX_TX_WEIGHT_MAX.
+ * @return           zero on success or negative error code on failure.
+ */
+int32_t uCellMuxSetChannelTxPriority(uDeviceHandle_t cellHandle,
+                                     int32_t channel, int32_t priority,
+                                     int32_t weight);
+
+/** Get the transmit statistics for an open multiplexer channel;
+ * the statistics are reset when the channel is opened.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @param channel     the channel number, may be
+ *                    #U_CELL_MUX_CHANNEL_ID_GNSS.
+ * @param[out] pStats a place to put the statistics; cannot be NULL.
+ * @return            zero on success or negative error code on failure.
+ */
+int32_t uCellMuxGetChannelStats(uDeviceHandle_t cellHandle,
+                                int32_t channel,
+                                uCellMuxChannelStats_t *pStats);
+
 /** Remove a multiplexer channel.  Note that this does NOT free
  * memory to ensure thread safety; memory is free'd when the cellular
  * instance is closed (or see uCellMuxFree()).
@@ -123,6 +123,37 @@ extern "C" {
 # define U_CELL_NET_SCAN_TIME_SECONDS (60 * 3)
 #endif
 
+#ifndef U_CELL_NET_LAST_GOOD_TIMEOUT_SECONDS
+/** The time in seconds allowed for an attempt to register on the
+ * network in a last good record, see uCellNetSetLastGoodCallbacks(),
+ * before falling back to automatic network selection.
+ */
+# define U_CELL_NET_LAST_GOOD_TIMEOUT_SECONDS 30
+#endif
+
+#ifndef U_CELL_NET_REGISTRATION_POLL_INTERVAL_MS
+/** How often to query the registration status while waiting to
+ * register when we can't rely on +CxREG URCs to wake us up.
+ */
+# define U_CELL_NET_REGISTRATION_POLL_INTERVAL_MS 300
+#endif
+
+#ifndef U_CELL_NET_REGISTRATION_URC_POLL_INTERVAL_MS
+/** How often to query the registration status while waiting to
+ * register once +CxREG URCs have been seen to arrive from the module,
+ * since they will then wake us up; the query is only a back-stop in
+ * case a URC is lost.  Until a +CxREG URC has been seen
+ * #U_CELL_NET_REGISTRATION_POLL_INTERVAL_MS is used.
+ */
+# define U_CELL_NET_REGISTRATION_URC_POLL_INTERVAL_MS 1000
+#endif
+
+/** The maximum number of attach attempts that may be made by
+ * uCellNetConnect() or uCellNetRegister(), see
+ * uCellNetGetAttachAttempts().
+ */
+#define U_CELL_NET_ATTACH_ATTEMPTS_MAX_NUM 2
+
 /** Determine if a given cellular network status value means that
  * we're registered with the network.
  */
@@ -236,6 +267,31 @@ typedef enum {
     U_CELL_NET_REG_DOMAIN_MAX_NUM
 } uCellNetRegDomain_t;
 
+/** A record of the network that the module last attached to
+ * successfully, see uCellNetSetLastGoodCallbacks().
+ */
+typedef struct {
+    char mccMnc[U_CELL_NET_MCC_MNC_LENGTH_BYTES]; /**< the MCC/MNC of the network
+                                                       as a null-terminated string. */
+    uCellNetRat_t rat; /**< the radio access technology. */
+    int32_t earfcn;    /**< the EARFCN, which identifies the band, -1
+                            if not known. */
+    int32_t cellId;    /**< the cell ID, -1 if not known. */
+} uCellNetLastGood_t;
+
+/** The outcome of an attempt to attach to the network, see
+ * uCellNetGetAttachAttempts().
+ */
+typedef struct {
+    bool lastGood;     /**< true if the attempt used the last good record,
+                            false if it used the MCC/MNC given, or
+                            automatic network selection. */
+    int32_t timeMs;    /**< the time the attempt took, from the start of
+                            registration to attach or giving up. */
+    int32_t errorCode; /**< zero if the attempt succeeded, else negative
+                            error code. */
+} uCellNetAttachAttempt_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -520,6 +576,117 @@ int32_t uCellNetScanGetNext(uDeviceHandle_t cellHandle,
  */
 void uCellNetScanGetLast(uDeviceHandle_t cellHandle);
 
+/** Start a network scan in the background and return immediately;
+ * as each network arrives in the response from the module it is
+ * parsed and passed to pCallback, rather than waiting for the whole
+ * scan, which can take minutes, to complete.  Note that the module
+ * treats any AT command sent while the scan is in progress as a
+ * request to abort the scan, hence the AT interface and the cellular
+ * API remain locked while the module is scanning and other users of
+ * them will wait; they are only released between attempts.  The
+ * results are NOT stored for uCellNetScanGetNext().  Memory is
+ * allocated by this function which is freed by uCellNetScanStop(),
+ * by the next call to this function, or when the cellular instance
+ * is removed.
+ *
+ * @param cellHandle         the handle of the cellular instance.
+ * @param[in] pCallback      the callback, called from a task
+ *                           created for the scan; cannot be NULL.
+ *                           For each network found the parameters
+ *                           are the cell handle, the name of the
+ *                           network, the MCC/MNC string of the
+ *                           network, the RAT of the network, the
+ *                           number of networks found so far,
+ *                           including this one, and pCallbackParameter.
+ *                           When the scan has finished the callback
+ *                           is called one last time with the name and
+ *                           MCC/MNC string NULL and the fifth parameter
+ *                           the total number of networks found or
+ *                           negative error code (see
+ *                           uCellNetScanGetFirst() for the meaning of
+ *                           #U_CELL_ERROR_TEMPORARY_FAILURE).  The
+ *                           callback must not call into the cellular
+ *                           API and should return quickly.
+ * @param pCallbackParameter a parameter that will be passed to
+ *                           pCallback; may be NULL.
+ * @return                   zero on success, #U_ERROR_COMMON_BUSY if
+ *                           a scan started with this function is
+ *                           still running, else negative error code.
+ */
+int32_t uCellNetScanStart(uDeviceHandle_t cellHandle,
+                          void (*pCallback) (uDeviceHandle_t,
+                                             const char *,
+                                             const char *,
+                                             uCellNetRat_t,
+                                             int32_t,
+                                             void *),
+                          void *pCallbackParameter);
+
+/** Stop a network scan started with uCellNetScanStart(); if the
+ * scan was still running it is aborted, which takes a second or
+ * so, and the callback is not called again.  It is good practice
+ * to call this once the scan has finished, to free memory.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ */
+void uCellNetScanStop(uDeviceHandle_t cellHandle);
+
+/** Set callbacks which load and save a record of the network that
+ * the module last attached to successfully, so that the next
+ * attach may be quicker: if a record is loaded and no MCC/MNC is
+ * given to uCellNetConnect() or uCellNetRegister() then
+ * manual selection of that network, on that RAT, is tried first,
+ * for up to #U_CELL_NET_LAST_GOOD_TIMEOUT_SECONDS, falling back to
+ * automatic network selection if it fails.  The selection is made
+ * in manual/automatic mode (AT+COPS=4), hence, once registered, the
+ * module will still fall back to automatic network selection should
+ * that network be lost, e.g. because the device has moved.  The
+ * EARFCN and cell ID are recorded for information but are not
+ * used, since changing the band mask would require a reboot.
+ *
+ * @param cellHandle         the handle of the cellular instance.
+ * @param[in] pLoad          called at the start of uCellNetConnect()
+ *                           or uCellNetRegister() when no MCC/MNC is
+ *                           given; the parameters are the cell handle,
+ *                           a place to put the record and
+ *                           pCallbackParameter.  It should return
+ *                           true if a record was loaded.  May be NULL.
+ * @param[in] pSave          called after a successful attach if the
+ *                           record has changed from the one loaded;
+ *                           the parameters are the cell handle, the
+ *                           record and pCallbackParameter.  May be NULL.
+ * @param pCallbackParameter passed to pLoad and pSave; may be NULL.
+ * @return                   zero on success else negative error code.
+ *                           Use NULL for both pLoad and pSave to remove
+ *                           the callbacks.
+ */
+int32_t uCellNetSetLastGoodCallbacks(uDeviceHandle_t cellHandle,
+                                     bool (*pLoad) (uDeviceHandle_t,
+                                                    uCellNetLastGood_t *,
+                                                    void *),
+                                     void (*pSave) (uDeviceHandle_t,
+                                                    const uCellNetLastGood_t *,
+                                                    void *),
+                                     void *pCallbackParameter);
+
+/** Get the outcome of the attach attempts made by the last call
+ * to uCellNetConnect() or uCellNetRegister(): there will be two
+ * attempts if a last good record was tried first and did not
+ * succeed (see uCellNetSetLastGoodCallbacks()), otherwise one.
+ *
+ * @param cellHandle      the handle of the cellular instance.
+ * @param[out] pAttempts  a place to put the attempts, in the order
+ *                        they were made; cannot be NULL.
+ * @param maxNum          the number of entries at pAttempts; no
+ *                        more than #U_CELL_NET_ATTACH_ATTEMPTS_MAX_NUM
+ *                        are required.
+ * @return                the number of entries written to pAttempts,
+ *                        else negative error code.
+ */
+int32_t uCellNetGetAttachAttempts(uDeviceHandle_t cellHandle,
+                                  uCellNetAttachAttempt_t *pAttempts,
+                                  size_t maxNum);
+
 /** Enable or disable the registration status call-back. This
  * call-back allows the application to know the various
  * states of the network scanning, registration and rejections
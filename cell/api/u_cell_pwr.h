@@ -469,6 +469,33 @@ int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
  */
 int32_t uCellPwrResetHard(uDeviceHandle_t cellHandle, int32_t pinReset);
 
+/** Switch fast boot on or off; it is off by default.  Normally, when
+ * the module is powered on, rebooted or reset, this code waits out
+ * a fixed, module-specific, boot time, or probes the module with
+ * "AT" allowing a full response time for each probe.  With fast boot
+ * on, the module is instead probed with "AT" at short but
+ * exponentially increasing intervals, and a greeting message (see
+ * uCellCfgSetGreeting()), if one has been set up with a callback,
+ * is also taken as a sign that the module is ready; the module is
+ * then configured as soon as it answers, which can save several
+ * seconds on each power-on.  This is useful where the module is
+ * duty-cycled.  Should the module not respond within the normal
+ * boot time, the usual probing takes over.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @param onNotOff    true to switch fast boot on, false to
+ *                    switch it off.
+ * @return            zero on success or negative error code.
+ */
+int32_t uCellPwrSetFastBoot(uDeviceHandle_t cellHandle, bool onNotOff);
+
+/** Get whether fast boot is on or off.
+ *
+ * @param cellHandle  the handle of the cellular instance.
+ * @return            true if fast boot is on, else false.
+ */
+bool uCellPwrGetFastBoot(uDeviceHandle_t cellHandle);
+
 /** Set the DTR power-saving pin.  "UPSV" or UART power saving is
  * normally handled automatically, using activity on the UART transmit
  * data line to wake-up the module, however this is not supported on
@@ -124,6 +124,10 @@ static void removeCellInstance(uCellPrivateInstance_t *pInstance)
             } else {
                 gpUCellPrivateInstanceList = pCurrent->pNext;
             }
+            // Stop any radio sampler or asynchronous network scan
+            // before the AT client is ignored
+            uCellPrivateSamplerRemoveContext(pInstance);
+            uCellPrivateScanAsyncRemoveContext(pInstance);
             // Tell the AT client to ignore any asynchronous events from now on
             uAtClientIgnoreAsync(pInstance->atHandle);
             // Free the wake-up callback
@@ -138,10 +142,17 @@ static void removeCellInstance(uCellPrivateInstance_t *pInstance)
             uCellPrivateSleepRemoveContext(pInstance);
             // Free any FOTA context
             uPortFree(pInstance->pFotaContext);
+            // Free any identity cache
+            uPortFree(pInstance->pIdentity);
+            // Free any last good network callbacks
+            uPortFree(pInstance->pLastGoodContext);
             // Free any HTTP context
             uCellPrivateHttpRemoveContext(pInstance);
             // Free any CMUX context
             uCellMuxPrivateRemoveContext(pInstance);
+            if (pInstance->registrationSemaphore != NULL) {
+                uPortSemaphoreDelete(pInstance->registrationSemaphore);
+            }
             uDeviceDestroyInstance(U_DEVICE_INSTANCE(pInstance->cellHandle));
             uPortFree(pInstance);
             pCurrent = NULL;
@@ -49,12 +49,23 @@
 #include "u_cell.h"         // Order is
 #include "u_cell_net.h"     // important here
 #include "u_cell_private.h" // don't change it
+#include "u_cell_pwr.h"
 #include "u_cell_cfg.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The offset basis for the 32-bit FNV-1a hash used as the
+ * fingerprint of a configuration snapshot.
+ */
+#define U_CELL_CFG_SNAPSHOT_FNV_OFFSET_BASIS 2166136261UL
+
+/** The prime for the 32-bit FNV-1a hash used as the fingerprint
+ * of a configuration snapshot.
+ */
+#define U_CELL_CFG_SNAPSHOT_FNV_PRIME 16777619UL
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -879,15 +890,16 @@ static void greetingCallback(uAtClientHandle_t atHandle, void *pParameter)
 }
 
 // URC handler for when the greeting message has been detected.
-//lint -esym(818, pParameter) Suppress pParameter could be const, need to
-// follow prototype
 static void GREETING_urc(uAtClientHandle_t atHandle, void *pParameter)
 {
-    const uCellPrivateInstance_t *pInstance = (uCellPrivateInstance_t *) pParameter;
+    uCellPrivateInstance_t *pInstance = (uCellPrivateInstance_t *) pParameter;
     uCellCfgGreeting_t *pGreeting;
 
     (void) atHandle;
 
+    // The module has clearly booted: let fast boot know
+    pInstance->greetingSeen = true;
+
     if (pInstance->pGreetingCallback != NULL) {
         // Put the data for the callback into a struct to our
         // local callback via the AT client's callback mechanism
@@ -992,6 +1004,203 @@ int32_t setAndStoreBaudRate(const uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: CONFIGURATION SNAPSHOT
+ * -------------------------------------------------------------- */
+
+// Add a 32-bit value to an FNV-1a hash, least significant byte
+// first so that the outcome does not depend on endianness.
+static uint32_t snapshotHashAdd(uint32_t hash, uint32_t value)
+{
+    for (size_t x = 0; x < sizeof(value); x++) {
+        hash ^= (value >> (x * 8)) & 0xFF;
+        hash *= U_CELL_CFG_SNAPSHOT_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+// Compute the fingerprint of a configuration snapshot; this is
+// done field by field so that structure padding plays no part.
+static uint32_t snapshotFingerprint(const uCellCfgSnapshot_t *pSnapshot)
+{
+    uint32_t hash = U_CELL_CFG_SNAPSHOT_FNV_OFFSET_BASIS;
+    const uint64_t bandMask[] = {pSnapshot->bandMask1CatM1, pSnapshot->bandMask2CatM1,
+                                 pSnapshot->bandMask1Nb1, pSnapshot->bandMask2Nb1
+                                };
+
+    hash = snapshotHashAdd(hash, (uint32_t) pSnapshot->mnoProfile);
+    for (size_t x = 0; x < sizeof(pSnapshot->rat) / sizeof(pSnapshot->rat[0]); x++) {
+        hash = snapshotHashAdd(hash, (uint32_t) pSnapshot->rat[x]);
+    }
+    for (size_t x = 0; x < sizeof(bandMask) / sizeof(bandMask[0]); x++) {
+        hash = snapshotHashAdd(hash, (uint32_t) bandMask[x]);
+        hash = snapshotHashAdd(hash, (uint32_t) (bandMask[x] >> 32));
+    }
+    hash = snapshotHashAdd(hash, (uint32_t) pSnapshot->numUdconf);
+    for (size_t x = 0; x < pSnapshot->numUdconf; x++) {
+        hash = snapshotHashAdd(hash, (uint32_t) pSnapshot->udconf[x].param1);
+        hash = snapshotHashAdd(hash, (uint32_t) pSnapshot->udconf[x].param2);
+        hash = snapshotHashAdd(hash, (uint32_t) pSnapshot->udconf[x].value);
+    }
+
+    return hash;
+}
+
+// Write the RATs of a snapshot to the module if they differ from
+// those already there, returning the number of settings written
+// or negative error code.
+static int32_t snapshotApplyRats(uDeviceHandle_t cellHandle,
+                                 const uCellCfgSnapshot_t *pSnapshot,
+                                 size_t maxNumRats)
+{
+    int32_t errorCodeOrCount = 0;
+    bool same = true;
+    uCellNetRat_t rat;
+
+    if (pSnapshot->rat[0] != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
+        for (size_t x = 0; (x < sizeof(pSnapshot->rat) / sizeof(pSnapshot->rat[0])) &&
+             same; x++) {
+            rat = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+            if (x < maxNumRats) {
+                rat = uCellCfgGetRat(cellHandle, (int32_t) x);
+                if ((int32_t) rat < 0) {
+                    rat = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+                }
+            }
+            same = (rat == pSnapshot->rat[x]);
+        }
+        if (!same) {
+            errorCodeOrCount = uCellCfgSetRat(cellHandle, pSnapshot->rat[0]);
+            for (size_t x = 1; (x < sizeof(pSnapshot->rat) / sizeof(pSnapshot->rat[0])) &&
+                 (errorCodeOrCount == 0); x++) {
+                if (pSnapshot->rat[x] != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) {
+                    errorCodeOrCount = uCellCfgSetRatRank(cellHandle, pSnapshot->rat[x],
+                                                          (int32_t) x);
+                }
+            }
+            if (errorCodeOrCount == 0) {
+                errorCodeOrCount = 1;
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Write the band masks of a snapshot to the module if they
+// differ from those already there, returning the number of
+// settings written or negative error code.
+static int32_t snapshotApplyBandMasks(uDeviceHandle_t cellHandle,
+                                      const uCellCfgSnapshot_t *pSnapshot)
+{
+    int32_t errorCodeOrCount = 0;
+    int32_t errorCode = 0;
+    const uCellNetRat_t rat[] = {U_CELL_NET_RAT_CATM1, U_CELL_NET_RAT_NB1};
+    const uint64_t bandMask1[] = {pSnapshot->bandMask1CatM1, pSnapshot->bandMask1Nb1};
+    const uint64_t bandMask2[] = {pSnapshot->bandMask2CatM1, pSnapshot->bandMask2Nb1};
+    uint64_t readBandMask1;
+    uint64_t readBandMask2;
+
+    for (size_t x = 0; (x < sizeof(rat) / sizeof(rat[0])) && (errorCode == 0); x++) {
+        if ((bandMask1[x] != 0) || (bandMask2[x] != 0)) {
+            errorCode = uCellCfgGetBandMask(cellHandle, rat[x],
+                                            &readBandMask1, &readBandMask2);
+            if ((errorCode == 0) &&
+                ((readBandMask1 != bandMask1[x]) || (readBandMask2 != bandMask2[x]))) {
+                errorCode = uCellCfgSetBandMask(cellHandle, rat[x],
+                                                bandMask1[x], bandMask2[x]);
+                if (errorCode == 0) {
+                    errorCodeOrCount++;
+                }
+            }
+        }
+    }
+    if (errorCode < 0) {
+        errorCodeOrCount = errorCode;
+    }
+
+    return errorCodeOrCount;
+}
+
+// Write the "AT+UDCONF" settings of a snapshot to the module
+// where they differ from those already there, returning the
+// number of settings written or negative error code.
+static int32_t snapshotApplyUdconf(uDeviceHandle_t cellHandle,
+                                   const uCellCfgSnapshot_t *pSnapshot)
+{
+    int32_t errorCodeOrCount = 0;
+    int32_t errorCodeOrValue = 0;
+    const uCellCfgSnapshotUdconf_t *pUdconf;
+
+    for (size_t x = 0; (x < pSnapshot->numUdconf) && (errorCodeOrValue >= 0); x++) {
+        pUdconf = &(pSnapshot->udconf[x]);
+        errorCodeOrValue = uCellCfgGetUdconf(cellHandle, pUdconf->param1, pUdconf->param2);
+        if ((errorCodeOrValue >= 0) && (errorCodeOrValue != pUdconf->value)) {
+            if (pUdconf->param2 >= 0) {
+                errorCodeOrValue = uCellCfgSetUdconf(cellHandle, pUdconf->param1,
+                                                     pUdconf->param2, pUdconf->value);
+            } else {
+                errorCodeOrValue = uCellCfgSetUdconf(cellHandle, pUdconf->param1,
+                                                     pUdconf->value, -1);
+            }
+            if (errorCodeOrValue == 0) {
+                errorCodeOrCount++;
+            }
+        }
+    }
+    if (errorCodeOrValue < 0) {
+        errorCodeOrCount = errorCodeOrValue;
+    }
+
+    return errorCodeOrCount;
+}
+
+// Read back the settings managed by a snapshot and write just
+// those that differ, rebooting as necessary, returning the number
+// of settings written or negative error code.
+static int32_t snapshotApply(uDeviceHandle_t cellHandle,
+                             const uCellCfgSnapshot_t *pSnapshot,
+                             size_t maxNumRats)
+{
+    int32_t errorCodeOrCount = 0;
+    int32_t x;
+
+    if ((pSnapshot->mnoProfile >= 0) &&
+        (uCellCfgGetMnoProfile(cellHandle) != pSnapshot->mnoProfile)) {
+        // A new MNO profile may bring with it new RATs and band
+        // masks, so it has to be applied before they are checked
+        errorCodeOrCount = uCellCfgSetMnoProfile(cellHandle, pSnapshot->mnoProfile);
+        if (errorCodeOrCount == 0) {
+            errorCodeOrCount = uCellPwrReboot(cellHandle, NULL);
+            if (errorCodeOrCount == 0) {
+                errorCodeOrCount = 1;
+            }
+        }
+    }
+    if (errorCodeOrCount >= 0) {
+        x = snapshotApplyRats(cellHandle, pSnapshot, maxNumRats);
+        errorCodeOrCount = (x < 0) ? x : errorCodeOrCount + x;
+    }
+    if (errorCodeOrCount >= 0) {
+        x = snapshotApplyBandMasks(cellHandle, pSnapshot);
+        errorCodeOrCount = (x < 0) ? x : errorCodeOrCount + x;
+    }
+    if (errorCodeOrCount >= 0) {
+        x = snapshotApplyUdconf(cellHandle, pSnapshot);
+        errorCodeOrCount = (x < 0) ? x : errorCodeOrCount + x;
+    }
+    if ((errorCodeOrCount >= 0) && uCellPwrRebootIsRequired(cellHandle)) {
+        // One reboot for everything
+        x = uCellPwrReboot(cellHandle, NULL);
+        if (x < 0) {
+            errorCodeOrCount = x;
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -1912,4 +2121,99 @@ int32_t uCellCfgGetGnssProfile(uDeviceHandle_t cellHandle, char *pServerName,
     return errorCodeOrBitMap;
 }
 
+// Apply a configuration snapshot.
+int32_t uCellCfgSnapshotApply(uDeviceHandle_t cellHandle,
+                              const uCellCfgSnapshot_t *pSnapshot)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    int32_t mnoProfile = -1;
+    size_t maxNumRats = 0;
+    uint32_t fingerprint;
+    uint32_t storedFingerprint = 0;
+    bool fingerprintMatches = false;
+    char buffer[sizeof(fingerprint)];
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pSnapshot != NULL) &&
+            (pSnapshot->numUdconf <= sizeof(pSnapshot->udconf) / sizeof(pSnapshot->udconf[0]))) {
+            // The MNO profile is read at every power-on, so
+            // this check costs nothing
+            mnoProfile = pInstance->mnoProfile;
+            maxNumRats = pInstance->pModule->maxNumSimultaneousRats;
+            errorCodeOrCount = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    if (errorCodeOrCount == 0) {
+        fingerprint = snapshotFingerprint(pSnapshot);
+        // The fingerprint is stored least significant byte first
+        if (uCellFileRead(cellHandle, U_CELL_CFG_SNAPSHOT_FILE_NAME,
+                          buffer, sizeof(buffer)) == (int32_t) sizeof(buffer)) {
+            for (size_t x = 0; x < sizeof(buffer); x++) {
+                storedFingerprint |= ((uint32_t) (uint8_t) buffer[x]) << (x * 8);
+            }
+            fingerprintMatches = (storedFingerprint == fingerprint);
+        }
+        if (fingerprintMatches &&
+            ((pSnapshot->mnoProfile < 0) || (pSnapshot->mnoProfile == mnoProfile))) {
+            uPortLog("U_CELL_CFG: configuration snapshot 0x%08x already applied.\n",
+                     fingerprint);
+        } else {
+            // Forget the old fingerprint first, so that a partially
+            // applied snapshot can never be mistaken for a whole one
+            uCellFileDelete(cellHandle, U_CELL_CFG_SNAPSHOT_FILE_NAME);
+            errorCodeOrCount = snapshotApply(cellHandle, pSnapshot, maxNumRats);
+            if (errorCodeOrCount >= 0) {
+                uPortLog("U_CELL_CFG: configuration snapshot 0x%08x applied,"
+                         " %d setting(s) changed.\n", fingerprint, errorCodeOrCount);
+                for (size_t x = 0; x < sizeof(buffer); x++) {
+                    buffer[x] = (char) (fingerprint >> (x * 8));
+                }
+                if (uCellFileWrite(cellHandle, U_CELL_CFG_SNAPSHOT_FILE_NAME,
+                                   buffer, sizeof(buffer)) != (int32_t) sizeof(buffer)) {
+                    // Not fatal, we'll just have to check again next time
+                    uPortLog("U_CELL_CFG: unable to store configuration"
+                             " snapshot fingerprint.\n");
+                }
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Forget the last configuration snapshot.
+int32_t uCellCfgSnapshotForget(uDeviceHandle_t cellHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pUCellPrivateGetInstance(cellHandle) != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    if (errorCode == 0) {
+        // An error here most likely means that there was no file,
+        // which is fine
+        uCellFileDelete(cellHandle, U_CELL_CFG_SNAPSHOT_FILE_NAME);
+    }
+
+    return errorCode;
+}
+
 // End of file
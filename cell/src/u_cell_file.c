@@ -38,6 +38,7 @@
 #include "u_cfg_sw.h"
 #include "u_error_common.h"
 #include "u_port.h"
+#include "u_port_heap.h"
 #include "u_port_os.h"
 #include "u_at_client.h"
 #include "u_cell_module_type.h"
@@ -58,6 +59,142 @@ static uCellPrivateFileListContainer_t *gpFileList = NULL;
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Write a block of data to a file using AT+UDWNFILE; the AT client
+// must already be locked, the error state of the AT client is
+// left for the caller to check, the return value is the
+// number of bytes written.
+static size_t writeBlockLocked(const uCellPrivateInstance_t *pInstance,
+                               uAtClientHandle_t atHandle,
+                               const char *pFileName,
+                               const char *pData,
+                               size_t dataSize)
+{
+    size_t bytesWritten = 0;
+
+    uAtClientCommandStart(atHandle, "AT+UDWNFILE=");
+    // Write file name
+    uAtClientWriteString(atHandle, pFileName, true);
+    // Write size of data to be written into the file
+    uAtClientWriteInt(atHandle, (int32_t) dataSize);
+    if (pInstance->pFileSystemTag != NULL) {
+        // Write tag
+        uAtClientWriteString(atHandle, pInstance->pFileSystemTag, true);
+    }
+    uAtClientCommandStop(atHandle);
+    // Wait for the prompt
+    if (uAtClientWaitCharacter(atHandle, '>') == 0) {
+        // Allow plenty of time for this to complete
+        uAtClientTimeoutSet(atHandle, 10000);
+        uPortTaskBlock(50);
+        bytesWritten = uAtClientWriteBytes(atHandle, (const char *) pData,
+                                           dataSize, true);
+        // Restore at client timeout to default
+        uAtClientTimeoutSet(atHandle, U_AT_CLIENT_DEFAULT_TIMEOUT_MS);
+        // Grab the response
+        uAtClientCommandStopReadResponse(atHandle);
+    } else {
+        // Best to tidy whatever might have arrived instead
+        // of the prompt before exiting
+        uAtClientResponseStop(atHandle);
+    }
+
+    return bytesWritten;
+}
+
+// Read a block of data from a file using AT+URDBLOCK; the AT client
+// must already be locked, the error state of the AT client is
+// left for the caller to check, the return value is the
+// number of bytes read into pData.
+static int32_t readBlockLocked(const uCellPrivateInstance_t *pInstance,
+                               uAtClientHandle_t atHandle,
+                               const char *pFileName,
+                               char *pData,
+                               size_t offset,
+                               size_t dataSize)
+{
+    int32_t readSize;
+    int32_t indicatedReadSize;
+
+    uAtClientCommandStart(atHandle, "AT+URDBLOCK=");
+    // Write file name
+    uAtClientWriteString(atHandle, pFileName, true);
+    // Write offset in bytes from the beginning of the file
+    uAtClientWriteInt(atHandle, (int32_t) offset);
+    // Write size of data to be read from file
+    uAtClientWriteInt(atHandle, (int32_t) dataSize);
+    uAtClientCommandStop(atHandle);
+    // Grab the response
+    if (U_CELL_PRIVATE_MODULE_IS_SARA_R4(pInstance->pModule->moduleType)) {
+        // SARA-R4 only puts \n before the
+        // response, not \r\n as it should
+        uAtClientResponseStart(atHandle, "\n+URDBLOCK:");
+    } else {
+        uAtClientResponseStart(atHandle, "+URDBLOCK:");
+    }
+    // Skip the file name
+    uAtClientSkipParameters(atHandle, 1);
+    // Read the size
+    indicatedReadSize = uAtClientReadInt(atHandle);
+    readSize = indicatedReadSize;
+    if (readSize > (int32_t) dataSize) {
+        readSize = (int32_t) dataSize;
+    }
+    if (readSize < 0) {
+        readSize = 0;
+    }
+    // Don't stop for anything!
+    uAtClientIgnoreStopTag(atHandle);
+    // Get the leading quote mark out of the way
+    uAtClientReadBytes(atHandle, NULL, 1, true);
+    // Now read out all the actual data,
+    // first the bit we want
+    readSize = uAtClientReadBytes(atHandle, pData,
+                                  // Cast in two stages to keep Lint happy
+                                  (size_t) (unsigned) readSize,
+                                  true);
+    if (indicatedReadSize > readSize) {
+        //...and then the rest poured away to NULL
+        uAtClientReadBytes(atHandle, NULL,
+                           // Cast in two stages to keep Lint happy
+                           (size_t) (unsigned) (indicatedReadSize - readSize),
+                           true);
+    }
+    // Make sure to wait for the stop tag before
+    // we finish
+    uAtClientRestoreStopTag(atHandle);
+    uAtClientResponseStop(atHandle);
+
+    return readSize;
+}
+
+// Read the size of a file using AT+ULSTFILE; the AT client
+// must already be locked, the error state of the AT client is
+// left for the caller to check.
+static int32_t sizeLocked(const uCellPrivateInstance_t *pInstance,
+                          uAtClientHandle_t atHandle,
+                          const char *pFileName)
+{
+    int32_t size;
+
+    uAtClientCommandStart(atHandle, "AT+ULSTFILE=");
+    // Write get file size op_code
+    uAtClientWriteInt(atHandle, 2);
+    // Write file name
+    uAtClientWriteString(atHandle, pFileName, true);
+    if (pInstance->pFileSystemTag != NULL) {
+        // Write tag
+        uAtClientWriteString(atHandle, pInstance->pFileSystemTag, true);
+    }
+    uAtClientCommandStop(atHandle);
+    // Grab the response
+    uAtClientResponseStart(atHandle, "+ULSTFILE:");
+    // Read file size
+    size = uAtClientReadInt(atHandle);
+    uAtClientResponseStop(atHandle);
+
+    return size;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: WORKAROUND FOR LINKER ISSUE
  * -------------------------------------------------------------- */
@@ -143,35 +280,10 @@ int32_t uCellFileWrite(uDeviceHandle_t cellHandle,
             atHandle = pInstance->atHandle;
             // Do the UDWNFILE thang with the AT interface
             uAtClientLock(atHandle);
-            uAtClientCommandStart(atHandle, "AT+UDWNFILE=");
-            // Write file name
-            uAtClientWriteString(atHandle, pFileName, true);
-            // Write size of data to be written into the file
-            uAtClientWriteInt(atHandle, (int32_t) dataSize);
-            if (pInstance->pFileSystemTag != NULL) {
-                // Write tag
-                uAtClientWriteString(atHandle, pInstance->pFileSystemTag, true);
-            }
-            uAtClientCommandStop(atHandle);
-            // Wait for the prompt
-            if (uAtClientWaitCharacter(atHandle, '>') == 0) {
-                // Allow plenty of time for this to complete
-                uAtClientTimeoutSet(atHandle, 10000);
-                uPortTaskBlock(50);
-                bytesWritten = uAtClientWriteBytes(atHandle, (const char *) pData,
-                                                   dataSize, true);
-                // Restore at client timeout to default
-                uAtClientTimeoutSet(atHandle, U_AT_CLIENT_DEFAULT_TIMEOUT_MS);
-                // Grab the response
-                uAtClientCommandStopReadResponse(atHandle);
-                if (uAtClientUnlock(atHandle) == 0) {
-                    errorCode = (int32_t) bytesWritten;
-                }
-            } else {
-                // Best to tidy whatever might have arrived instead
-                // of the prompt before exiting
-                uAtClientResponseStop(atHandle);
-                errorCode = uAtClientUnlock(atHandle);
+            bytesWritten = writeBlockLocked(pInstance, atHandle, pFileName,
+                                            pData, dataSize);
+            if (uAtClientUnlock(atHandle) == 0) {
+                errorCode = (int32_t) bytesWritten;
             }
         }
 
@@ -273,7 +385,6 @@ int32_t uCellFileBlockRead(uDeviceHandle_t cellHandle,
     uCellPrivateInstance_t *pInstance;
     uAtClientHandle_t atHandle;
     int32_t readSize = 0;
-    int32_t indicatedReadSize = 0;
 
     if (gUCellPrivateMutex != NULL) {
 
@@ -292,54 +403,147 @@ int32_t uCellFileBlockRead(uDeviceHandle_t cellHandle,
                 atHandle = pInstance->atHandle;
                 // Do the URDBLOCK thang with the AT interface
                 uAtClientLock(atHandle);
-                uAtClientCommandStart(atHandle, "AT+URDBLOCK=");
-                // Write file name
-                uAtClientWriteString(atHandle, pFileName, true);
-                // Write offset in bytes from the beginning of the file
-                uAtClientWriteInt(atHandle, (int32_t) offset);
-                // Write size of data to be read from file
-                uAtClientWriteInt(atHandle, (int32_t) dataSize);
-                uAtClientCommandStop(atHandle);
-                // Grab the response
-                if (U_CELL_PRIVATE_MODULE_IS_SARA_R4(pInstance->pModule->moduleType)) {
-                    // SARA-R4 only puts \n before the
-                    // response, not \r\n as it should
-                    uAtClientResponseStart(atHandle, "\n+URDBLOCK:");
-                } else {
-                    uAtClientResponseStart(atHandle, "+URDBLOCK:");
+                readSize = readBlockLocked(pInstance, atHandle, pFileName,
+                                           pData, offset, dataSize);
+                if (uAtClientUnlock(atHandle) == 0) {
+                    errorCode = readSize;
                 }
-                // Skip the file name
-                uAtClientSkipParameters(atHandle, 1);
-                // Read the size
-                indicatedReadSize = uAtClientReadInt(atHandle);
-                readSize = indicatedReadSize;
-                if (readSize > (int32_t) dataSize) {
-                    readSize = (int32_t) dataSize;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Read a whole file, block by block, passing each block to a callback.
+int32_t uCellFileReadStream(uDeviceHandle_t cellHandle,
+                            const char *pFileName,
+                            size_t offset,
+                            uCellFileReadStreamCallback_t *pCallback,
+                            void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle;
+    char *pBuffer;
+    int32_t size;
+    int32_t readSize;
+    size_t thisSize;
+    size_t totalSize = 0;
+    bool keepGoing = true;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        // Check parameters
+        if ((pInstance != NULL) && (pCallback != NULL) && (pFileName != NULL) &&
+            (strlen(pFileName) <= U_CELL_FILE_NAME_MAX_LENGTH)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            // Block reads, which this is built on, don't support tags
+            if (pInstance->pFileSystemTag == NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pBuffer = (char *) pUPortMalloc(U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES);
+                if (pBuffer != NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+                    atHandle = pInstance->atHandle;
+                    // Hold the AT interface for the whole file so that
+                    // each AT+URDBLOCK follows on immediately from the
+                    // last, with no other traffic in between
+                    uAtClientLock(atHandle);
+                    size = sizeLocked(pInstance, atHandle, pFileName);
+                    while (keepGoing && (uAtClientErrorGet(atHandle) == 0) &&
+                           (size > 0) && (offset < (size_t) size)) {
+                        thisSize = (size_t) size - offset;
+                        if (thisSize > U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES) {
+                            thisSize = U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES;
+                        }
+                        readSize = readBlockLocked(pInstance, atHandle, pFileName,
+                                                   pBuffer, offset, thisSize);
+                        keepGoing = false;
+                        if ((uAtClientErrorGet(atHandle) == 0) && (readSize > 0)) {
+                            keepGoing = pCallback(cellHandle, pBuffer, (size_t) readSize,
+                                                  offset, pCallbackParam);
+                            offset += (size_t) readSize;
+                            totalSize += (size_t) readSize;
+                        }
+                    }
+                    if (uAtClientUnlock(atHandle) == 0) {
+                        errorCode = (int32_t) totalSize;
+                    }
+                    uPortFree(pBuffer);
                 }
-                // Don't stop for anything!
-                uAtClientIgnoreStopTag(atHandle);
-                // Get the leading quote mark out of the way
-                uAtClientReadBytes(atHandle, NULL, 1, true);
-                // Now read out all the actual data,
-                // first the bit we want
-                readSize = uAtClientReadBytes(atHandle, pData,
-                                              // Cast in two stages to keep Lint happy
-                                              (size_t) (unsigned) readSize,
-                                              true);
-                if (indicatedReadSize > readSize) {
-                    //...and then the rest poured away to NULL
-                    uAtClientReadBytes(atHandle, NULL,
-                                       // Cast in two stages to keep Lint happy
-                                       (size_t) (unsigned) (indicatedReadSize - readSize),
-                                       true);
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Write a file, block by block, with data obtained from a callback.
+int32_t uCellFileWriteStream(uDeviceHandle_t cellHandle,
+                             const char *pFileName,
+                             uCellFileWriteStreamCallback_t *pCallback,
+                             void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uAtClientHandle_t atHandle;
+    char *pBuffer;
+    int32_t thisSize = 1;
+    size_t bytesWritten;
+    size_t totalSize = 0;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        // Check parameters
+        if ((pInstance != NULL) && (pCallback != NULL) && (pFileName != NULL) &&
+            (strlen(pFileName) <= U_CELL_FILE_NAME_MAX_LENGTH)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pBuffer = (char *) pUPortMalloc(U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES);
+            if (pBuffer != NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+                atHandle = pInstance->atHandle;
+                // Hold the AT interface for the whole file, as for
+                // uCellFileReadStream(); each AT+UDWNFILE appends
+                // to what has gone before
+                uAtClientLock(atHandle);
+                while ((thisSize > 0) && (uAtClientErrorGet(atHandle) == 0)) {
+                    thisSize = pCallback(cellHandle, pBuffer,
+                                         U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES,
+                                         pCallbackParam);
+                    if (thisSize > U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES) {
+                        thisSize = U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES;
+                    }
+                    if (thisSize > 0) {
+                        bytesWritten = writeBlockLocked(pInstance, atHandle, pFileName,
+                                                        pBuffer, (size_t) thisSize);
+                        totalSize += bytesWritten;
+                        if (bytesWritten < (size_t) thisSize) {
+                            // Don't carry on past a short write,
+                            // the file would have a hole in it
+                            thisSize = 0;
+                        }
+                    }
                 }
-                // Make sure to wait for the stop tag before
-                // we finish
-                uAtClientRestoreStopTag(atHandle);
-                uAtClientResponseStop(atHandle);
                 if (uAtClientUnlock(atHandle) == 0) {
-                    errorCode = readSize;
+                    errorCode = (int32_t) totalSize;
+                    if (thisSize < 0) {
+                        // The callback asked us to abort
+                        errorCode = thisSize;
+                    }
                 }
+                uPortFree(pBuffer);
             }
         }
 
@@ -371,21 +575,7 @@ int32_t uCellFileSize(uDeviceHandle_t cellHandle,
             atHandle = pInstance->atHandle;
             // Do the ULSTFILE thang with the AT interface
             uAtClientLock(atHandle);
-            uAtClientCommandStart(atHandle, "AT+ULSTFILE=");
-            // Write get file size op_code
-            uAtClientWriteInt(atHandle, 2);
-            // Write file name
-            uAtClientWriteString(atHandle, pFileName, true);
-            if (pInstance->pFileSystemTag != NULL) {
-                // Write tag
-                uAtClientWriteString(atHandle, pInstance->pFileSystemTag, true);
-            }
-            uAtClientCommandStop(atHandle);
-            // Grab the response
-            uAtClientResponseStart(atHandle, "+ULSTFILE:");
-            // Read file size
-            size = uAtClientReadInt(atHandle);
-            uAtClientResponseStop(atHandle);
+            size = sizeLocked(pInstance, atHandle, pFileName);
             if (uAtClientUnlock(atHandle) == 0) {
                 errorCode = size;
             }
@@ -32,6 +32,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "string.h"    // memcmp()
 
 #include "u_cfg_sw.h"
 
@@ -40,6 +41,7 @@
 #include "u_port.h"
 #include "u_port_heap.h"
 #include "u_port_os.h"
+#include "u_port_crypto.h"
 
 #include "u_at_client.h"
 
@@ -118,6 +120,22 @@ static uCellFotaStatusInstallConvert_t gInstallStatus[] = {
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Fill in the throughput and ETA fields of a progress structure.
+static void updateImageProgress(uCellFotaImageProgress_t *pProgress,
+                                int32_t startTimeMs)
+{
+    pProgress->elapsedMs = uPortGetTickTimeMs() - startTimeMs;
+    if (pProgress->elapsedMs > 0) {
+        pProgress->bytesPerSecond = (int32_t) (((int64_t) pProgress->sizeBytes * 1000) /
+                                               pProgress->elapsedMs);
+    }
+    pProgress->etaSeconds = -1;
+    if (pProgress->bytesPerSecond > 0) {
+        pProgress->etaSeconds = (int32_t) ((pProgress->totalSizeBytes - pProgress->sizeBytes) /
+                                           (size_t) pProgress->bytesPerSecond);
+    }
+}
+
 // Convert a download status fail case number into our enum.
 static int32_t convertDownloadFailureStatus(int32_t atDownloadFailureStatus)
 {
@@ -267,6 +285,11 @@ static void UFWPREVAL_UUFWINSTALL_urc(uAtClientHandle_t atHandle,
     uCellPrivateInstance_t *pInstance = (uCellPrivateInstance_t *) pParameter;
 
     percentageOrStatusCode = uAtClientReadInt(atHandle);
+    if (type == U_CELL_FOTA_STATUS_TYPE_PERCENTAGE_INSTALL) {
+        // New firmware is going in: the firmware version, and
+        // anything else we've cached about the module, is stale
+        uCellPrivateIdentityInvalidate(pInstance, false);
+    }
     if (percentageOrStatusCode >= 0) {
         if (percentageOrStatusCode < U_CELL_FOTA_STATUS_INSTALL_MIN_NUM_UUFWINSTALL) {
             status.type = type;
@@ -401,4 +424,123 @@ int32_t uCellFotaSetStatusCallback(uDeviceHandle_t cellHandle,
     return errorCode;
 }
 
+// Download a module FW image into the module file system.
+int32_t uCellFotaImageDownload(uDeviceHandle_t cellHandle,
+                               const char *pFileName,
+                               size_t imageSizeBytes,
+                               const char *pSha256,
+                               uCellFotaImageSourceCallback_t *pSourceCallback,
+                               void *pSourceCallbackParam,
+                               uCellFotaImageProgressCallback_t *pProgressCallback,
+                               void *pProgressCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uCellFotaImageProgress_t progress = {0};
+    char *pBuffer;
+    void *pSha256Context = NULL;
+    char sha256[U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES];
+    size_t blockSize;
+    size_t fillSize;
+    int32_t x;
+    int32_t startTimeMs;
+    int32_t stallStartTimeMs = 0;
+    bool stalled = false;
+
+    // Note: this deliberately does not hold the cellular API
+    // mutex or the AT interface between blocks, since the source
+    // callback may well need them to read the image from the
+    // network through this same module
+    if ((pFileName != NULL) && (imageSizeBytes > 0) && (pSourceCallback != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pBuffer = (char *) pUPortMalloc(U_CELL_FOTA_IMAGE_BLOCK_LENGTH_BYTES);
+        if (pBuffer != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (pSha256 != NULL) {
+                errorCode = uPortCryptoSha256Init(&pSha256Context);
+            }
+            if (errorCode == 0) {
+                // Writes to a file append, so start with a clean sheet
+                uCellFileDelete(cellHandle, pFileName);
+                progress.totalSizeBytes = imageSizeBytes;
+                startTimeMs = uPortGetTickTimeMs();
+                while ((errorCode == 0) && (progress.sizeBytes < imageSizeBytes)) {
+                    blockSize = imageSizeBytes - progress.sizeBytes;
+                    if (blockSize > U_CELL_FOTA_IMAGE_BLOCK_LENGTH_BYTES) {
+                        blockSize = U_CELL_FOTA_IMAGE_BLOCK_LENGTH_BYTES;
+                    }
+                    // Fill a whole block before writing it: every write
+                    // costs an AT command turn-around so fewer, larger,
+                    // writes are quicker on a slow link
+                    fillSize = 0;
+                    while ((errorCode == 0) && (fillSize < blockSize)) {
+                        x = pSourceCallback(cellHandle, pBuffer + fillSize,
+                                            blockSize - fillSize, pSourceCallbackParam);
+                        if (x < 0) {
+                            errorCode = x;
+                        } else if (x == 0) {
+                            if (!stalled) {
+                                stalled = true;
+                                stallStartTimeMs = uPortGetTickTimeMs();
+                                progress.stallCount++;
+                            } else if (uPortGetTickTimeMs() - stallStartTimeMs >
+                                       U_CELL_FOTA_IMAGE_STALL_TIMEOUT_SECONDS * 1000) {
+                                errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+                            }
+                            uPortTaskBlock(U_CELL_FOTA_IMAGE_STALL_POLL_MS);
+                        } else {
+                            if (stalled) {
+                                stalled = false;
+                                progress.stallTotalMs += uPortGetTickTimeMs() - stallStartTimeMs;
+                            }
+                            if ((size_t) x > blockSize - fillSize) {
+                                x = (int32_t) (blockSize - fillSize);
+                            }
+                            fillSize += (size_t) x;
+                        }
+                    }
+                    if (errorCode == 0) {
+                        if (pSha256Context != NULL) {
+                            errorCode = uPortCryptoSha256Update(pSha256Context,
+                                                                pBuffer, fillSize);
+                        }
+                        if (errorCode == 0) {
+                            x = uCellFileWrite(cellHandle, pFileName, pBuffer, fillSize);
+                            if (x == (int32_t) fillSize) {
+                                progress.sizeBytes += fillSize;
+                                updateImageProgress(&progress, startTimeMs);
+                                if (pProgressCallback != NULL) {
+                                    pProgressCallback(cellHandle, &progress,
+                                                      pProgressCallbackParam);
+                                }
+                            } else {
+                                errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+                                if (x < 0) {
+                                    errorCode = x;
+                                }
+                            }
+                        }
+                    }
+                }
+                if (pSha256Context != NULL) {
+                    // Always call this, it frees the context
+                    x = uPortCryptoSha256Finish(pSha256Context, sha256);
+                    if ((errorCode == 0) &&
+                        ((x != 0) || (memcmp(sha256, pSha256, sizeof(sha256)) != 0))) {
+                        errorCode = (int32_t) U_ERROR_COMMON_AUTHENTICATION_FAILURE;
+                    }
+                }
+                if (errorCode == 0) {
+                    errorCode = (int32_t) progress.sizeBytes;
+                } else {
+                    // Don't leave a partial or bad image lying around
+                    uCellFileDelete(cellHandle, pFileName);
+                }
+            }
+            uPortFree(pBuffer);
+        }
+    }
+
+    return errorCode;
+}
+
 // End of file
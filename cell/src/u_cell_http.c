@@ -32,7 +32,7 @@
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
 #include "stdio.h"     // snprintf()
-#include "string.h"    // strlen()
+#include "string.h"    // strlen(), strchr()
 #include "ctype.h"     // isprint()
 
 #include "u_cfg_sw.h"
@@ -822,6 +822,45 @@ int32_t uCellHttpRequestFile(uDeviceHandle_t cellHandle, int32_t httpHandle,
     return errorCode;
 }
 
+// Set or remove a custom request header.
+int32_t uCellHttpSetRequestHeader(uDeviceHandle_t cellHandle, int32_t httpHandle,
+                                  int32_t headerId, const char *pName,
+                                  const char *pValue)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pCellInstance = NULL;
+    uCellHttpInstance_t *pHttpInstance = NULL;
+    // +3 for the ID, +2 for the colons, +1 for the terminator
+    char buffer[U_CELL_HTTP_REQUEST_HEADER_MAX_LENGTH_BYTES + 6];
+
+    U_CELL_HTTP_ENTRY_FUNCTION(cellHandle, httpHandle, &pCellInstance,
+                               &pHttpInstance, &errorCode);
+
+    if (errorCode == 0) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((headerId >= 0) && (headerId < U_CELL_HTTP_REQUEST_HEADER_MAX_NUM) &&
+            ((pName == NULL) ||
+             ((pValue != NULL) && (strchr(pName, ':') == NULL) &&
+              isAllowedHttpRequestStr(pName, U_CELL_HTTP_REQUEST_HEADER_MAX_LENGTH_BYTES) &&
+              isAllowedHttpRequestStr(pValue, U_CELL_HTTP_REQUEST_HEADER_MAX_LENGTH_BYTES -
+                                      strlen(pName))))) {
+            // The format is "<header_id>:<header_name>:<header_value>",
+            // just "<header_id>:" to remove a header
+            if (pName != NULL) {
+                snprintf(buffer, sizeof(buffer), "%d:%s:%s", (int) headerId, pName, pValue);
+            } else {
+                snprintf(buffer, sizeof(buffer), "%d:", (int) headerId);
+            }
+            errorCode = doUhttpString(pCellInstance->atHandle,
+                                      pHttpInstance->profileId, 9, buffer);
+        }
+    }
+
+    U_CELL_HTTP_EXIT_FUNCTION();
+
+    return errorCode;
+}
+
 // Get the last HTTP error code for the given HTTP instance.
 int32_t uCellHttpGetLastErrorCode(uDeviceHandle_t cellHandle,
                                   int32_t httpHandle)
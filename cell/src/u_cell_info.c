@@ -34,18 +34,21 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // strlen()
+#include "string.h"    // strlen(), memcpy(), memset()
 #include "time.h"      // struct tm
 #include "ctype.h"     // isdigit()
 
 #include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"  // For U_CFG_OS_YIELD_MS
 
 #include "u_error_common.h"
 
 #include "u_port_clib_platform_specific.h" // strtok_r() and, in some cases, isblank()
+#include "u_port.h"
 #include "u_port_clib_mktime64.h"
 #include "u_port_debug.h"
 #include "u_port_os.h"
+#include "u_port_heap.h"
 #include "u_port_uart.h"
 
 #include "u_at_client.h"
@@ -63,10 +66,45 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_CELL_INFO_SAMPLER_TASK_STACK_SIZE_BYTES
+/** The stack size of the radio sampler task.
+ */
+# define U_CELL_INFO_SAMPLER_TASK_STACK_SIZE_BYTES (1024 * 3)
+#endif
+
+#ifndef U_CELL_INFO_SAMPLER_TASK_PRIORITY
+/** The priority of the radio sampler task: low, it is only
+ * collecting data for charting.
+ */
+# define U_CELL_INFO_SAMPLER_TASK_PRIORITY (U_CFG_OS_PRIORITY_MIN + 1)
+#endif
+
+#ifndef U_CELL_INFO_SAMPLER_RETRY_MS
+/** How long the radio sampler waits before trying again if a
+ * sample could not be taken, e.g. because another cellular API
+ * call was in progress or the module was not registered.
+ */
+# define U_CELL_INFO_SAMPLER_RETRY_MS 1000
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Context for the radio sampler, hooked into pRadioSamplerContext
+ * of the instance.
+ */
+typedef struct {
+    uCellPrivateInstance_t *pInstance;
+    uCellInfoRadioRing_t *pRing;
+    int32_t periodMs;
+    int32_t lastSampleTimeMs;
+    uPortMutexHandle_t writeMutex;
+    uPortMutexHandle_t taskRunningMutex;
+    uPortQueueHandle_t taskExitQueue;
+    uPortTaskHandle_t taskHandle;
+} uCellInfoSamplerContext_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -188,6 +226,92 @@ static int32_t getString(uAtClientHandle_t atHandle,
     return errorCodeOrSize;
 }
 
+// Get the ICCID string from the cellular module.
+static int32_t getIccid(uAtClientHandle_t atHandle, char *pStr, size_t size)
+{
+    int32_t errorCodeOrSize;
+    int32_t bytesRead;
+
+    uAtClientLock(atHandle);
+    uAtClientCommandStart(atHandle, "AT+CCID");
+    uAtClientCommandStop(atHandle);
+    uAtClientResponseStart(atHandle, "+CCID:");
+    bytesRead = uAtClientReadString(atHandle, pStr, size, false);
+    uAtClientResponseStop(atHandle);
+    errorCodeOrSize = uAtClientUnlock(atHandle);
+    if ((bytesRead >= 0) && (errorCodeOrSize == 0)) {
+        errorCodeOrSize = bytesRead;
+        uPortLog("U_CELL_INFO: ICCID is %s.\n", pStr);
+    } else {
+        errorCodeOrSize = (int32_t) U_CELL_ERROR_AT;
+        uPortLog("U_CELL_INFO: unable to read ICCID.\n");
+    }
+
+    return errorCodeOrSize;
+}
+
+// Get the identity cache of an instance, allocating it if
+// necessary; returns NULL if there is no memory, in which case
+// the identity is simply read from the module every time.
+static uCellPrivateIdentity_t *pGetIdentity(uCellPrivateInstance_t *pInstance)
+{
+    uCellPrivateIdentity_t *pIdentity = pInstance->pIdentity;
+
+    if (pIdentity == NULL) {
+        pIdentity = (uCellPrivateIdentity_t *) pUPortMalloc(sizeof(uCellPrivateIdentity_t));
+        if (pIdentity != NULL) {
+            // Empty strings: nothing is cached
+            memset(pIdentity, 0, sizeof(uCellPrivateIdentity_t));
+            pInstance->pIdentity = pIdentity;
+        }
+    }
+
+    return pIdentity;
+}
+
+// Copy a cached identity string into the user's buffer, truncating
+// it as uAtClientReadString() would, and return its length.
+static int32_t copyIdentityString(const char *pCached, char *pStr, size_t size)
+{
+    size_t length = strlen(pCached);
+
+    if (length > size - 1) {
+        length = size - 1;
+    }
+    memcpy(pStr, pCached, length);
+    pStr[length] = 0;
+
+    return (int32_t) length;
+}
+
+// Get an ID string, from the identity cache if possible, else
+// from the module using getString(), filling the cache if it fits.
+static int32_t getCachedString(uCellPrivateInstance_t *pInstance,
+                               const char *pCmd, char *pCache,
+                               size_t cacheSize, char *pStr,
+                               size_t size)
+{
+    int32_t errorCodeOrSize = 0;
+
+    if ((pCache != NULL) && (*pCache == 0)) {
+        errorCodeOrSize = getString(pInstance->atHandle, pCmd, pCache, cacheSize);
+        if ((errorCodeOrSize >= 0) && ((size_t) errorCodeOrSize >= cacheSize - 1)) {
+            // Might have been truncated, don't cache it
+            *pCache = 0;
+            errorCodeOrSize = 0;
+        }
+    }
+    if (errorCodeOrSize >= 0) {
+        if ((pCache != NULL) && (*pCache != 0)) {
+            errorCodeOrSize = copyIdentityString(pCache, pStr, size);
+        } else {
+            errorCodeOrSize = getString(pInstance->atHandle, pCmd, pStr, size);
+        }
+    }
+
+    return errorCodeOrSize;
+}
+
 // Get SINR as an integer from a decimal (e.g -13.75) in a string,
 // or 0x7FFFFFFF if not known
 static int32_t getSinr(const char *pStr, int32_t divisor)
@@ -556,6 +680,211 @@ static int32_t getRadioParamsUcged5(uAtClientHandle_t atHandle,
     return uAtClientUnlock(atHandle);
 }
 
+// Refresh the radio parameters of the given instance: this does
+// not lock gUCellPrivateMutex, the caller must do that if required.
+static int32_t refreshRadioParameters(const uCellPrivateInstance_t *pInstance,
+                                      uCellPrivateRadioParameters_t *pRadioParameters,
+                                      int32_t pauseMs)
+{
+    int32_t errorCode = (int32_t) U_CELL_ERROR_NOT_REGISTERED;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    uCellNetRat_t rat;
+
+    uCellPrivateClearRadioParameters(pRadioParameters);
+    if (uCellPrivateIsRegistered(pInstance)) {
+        // The mechanisms to get the radio information
+        // are different between EUTRAN and GERAN but
+        // AT+CSQ works in all cases though it sometimes
+        // doesn't return a reading.  Collect what we can
+        // with it
+        errorCode = getRadioParamsCsq(atHandle, pRadioParameters);
+        // Note that AT+UCGED is used next rather than AT+CESQ
+        // as, in my experience, it is more reliable in
+        // reporting answers.
+        // Allow a little sleepy-byes here, don't want to overtask
+        // the module if this is being called repeatedly
+        uPortTaskBlock(pauseMs);
+        if (U_CELL_PRIVATE_HAS(pInstance->pModule, U_CELL_PRIVATE_FEATURE_UCGED5)) {
+            // SARA-R4 (except 422) only supports UCGED=5, and it only
+            // supports it in EUTRAN mode
+            rat = uCellPrivateGetActiveRat(pInstance);
+            if (U_CELL_PRIVATE_RAT_IS_EUTRAN(rat)) {
+                errorCode = getRadioParamsUcged5(atHandle, pRadioParameters);
+            } else {
+                // Can't use AT+UCGED, that's all we can get
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        } else {
+            // The AT+UCGED=2 formats are module-specific
+            switch (pInstance->pModule->moduleType) {
+                case U_CELL_MODULE_TYPE_SARA_R5:
+                    errorCode = getRadioParamsUcged2SaraR5(atHandle, pRadioParameters);
+                    break;
+                case U_CELL_MODULE_TYPE_SARA_R422:
+                    errorCode = getRadioParamsUcged2SaraR422(atHandle, pRadioParameters);
+                    break;
+                case U_CELL_MODULE_TYPE_LARA_R6:
+                    errorCode = getRadioParamsUcged2LaraR6(atHandle, pRadioParameters);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Write a set of radio parameters to the ring of the radio sampler.
+// The sequence number is odd while the write is in progress so that
+// readers, which take no lock, can tell that they need to try again.
+static void samplerWrite(uCellInfoSamplerContext_t *pContext,
+                         const uCellPrivateRadioParameters_t *pRadioParameters)
+{
+    uCellInfoRadioRing_t *pRing = pContext->pRing;
+    uCellInfoRadioSample_t *pSample;
+
+    U_PORT_MUTEX_LOCK(pContext->writeMutex);
+
+    pContext->lastSampleTimeMs = uPortGetTickTimeMs();
+    pSample = &(pRing->sample[pRing->numWritten % U_CELL_INFO_RADIO_RING_LENGTH]);
+    pRing->sequence++;
+    pSample->timeMs = pContext->lastSampleTimeMs;
+    pSample->rssiDbm = pRadioParameters->rssiDbm;
+    pSample->rsrpDbm = pRadioParameters->rsrpDbm;
+    pSample->rsrqDb = pRadioParameters->rsrqDb;
+    pSample->snrDb = pRadioParameters->snrDb;
+    pSample->cellId = pRadioParameters->cellId;
+    pSample->earfcn = pRadioParameters->earfcn;
+    pRing->numWritten++;
+    pRing->sequence++;
+
+    U_PORT_MUTEX_UNLOCK(pContext->writeMutex);
+}
+
+// Task which takes radio parameter samples.
+static void samplerTask(void *pParameters)
+{
+    uCellInfoSamplerContext_t *pContext = (uCellInfoSamplerContext_t *) pParameters;
+    uCellPrivateRadioParameters_t radioParameters;
+    int32_t waitMs = 0;
+    int32_t queueItem;
+
+    U_PORT_MUTEX_LOCK(pContext->taskRunningMutex);
+
+    // The exit queue doubles as our sleep
+    while (uPortQueueTryReceive(pContext->taskExitQueue, waitMs, &queueItem) < 0) {
+        waitMs = pContext->periodMs - (uPortGetTickTimeMs() - pContext->lastSampleTimeMs);
+        if (waitMs <= 0) {
+            waitMs = U_CELL_INFO_SAMPLER_RETRY_MS;
+            if (waitMs > pContext->periodMs) {
+                waitMs = pContext->periodMs;
+            }
+            // Only go ahead if no-one else is using this API right
+            // now, otherwise skip this sample; the mutex is held for
+            // the whole sample since the AT handle may be changed
+            // (e.g. by CMUX or a reboot) by any API call
+            if (uPortMutexTryLock(gUCellPrivateMutex, 0) == 0) {
+                if (uCellPrivateIsRegistered(pContext->pInstance) &&
+                    (refreshRadioParameters(pContext->pInstance,
+                                            &radioParameters, 0) == 0)) {
+                    samplerWrite(pContext, &radioParameters);
+                    waitMs = pContext->periodMs;
+                }
+                uPortMutexUnlock(gUCellPrivateMutex);
+            }
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pContext->taskRunningMutex);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+// Free the resources of a radio sampler context, stopping the task
+// if it is running.
+static void samplerFree(uCellInfoSamplerContext_t *pContext)
+{
+    int32_t queueItem = 0;
+
+    if (pContext->taskHandle != NULL) {
+        uPortQueueSend(pContext->taskExitQueue, &queueItem);
+        U_PORT_MUTEX_LOCK(pContext->taskRunningMutex);
+        U_PORT_MUTEX_UNLOCK(pContext->taskRunningMutex);
+        // Give the task a chance to delete itself
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+    }
+    if (pContext->taskExitQueue != NULL) {
+        uPortQueueDelete(pContext->taskExitQueue);
+    }
+    if (pContext->taskRunningMutex != NULL) {
+        uPortMutexDelete(pContext->taskRunningMutex);
+    }
+    if (pContext->writeMutex != NULL) {
+        uPortMutexDelete(pContext->writeMutex);
+    }
+    uPortFree(pContext);
+}
+
+// Wait for the sequence number of a ring to be even, i.e. for no
+// write to be in progress, and return it.
+static uint32_t ringSequenceGet(const uCellInfoRadioRing_t *pRing)
+{
+    uint32_t sequence = pRing->sequence;
+
+    while (sequence & 1) {
+        // Block rather than spin, the writer may be of lower priority
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        sequence = pRing->sequence;
+    }
+
+    return sequence;
+}
+
+// Add a value to a statistic, ignoring it if it is the "unknown" value.
+static void statisticAdd(uCellInfoRadioStatistic_t *pStatistic, int64_t *pSum,
+                         int32_t value, int32_t unknown)
+{
+    if (value != unknown) {
+        if ((pStatistic->numSamples == 0) || (value < pStatistic->min)) {
+            pStatistic->min = value;
+        }
+        if ((pStatistic->numSamples == 0) || (value > pStatistic->max)) {
+            pStatistic->max = value;
+        }
+        *pSum += value;
+        pStatistic->numSamples++;
+    }
+}
+
+// Work out the mean of a statistic.
+static void statisticMean(uCellInfoRadioStatistic_t *pStatistic, int64_t sum)
+{
+    if (pStatistic->numSamples > 0) {
+        pStatistic->mean = (int32_t) (sum / (int64_t) pStatistic->numSamples);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS THAT ARE PRIVATE TO CELLULAR
+ * -------------------------------------------------------------- */
+
+// Refresh the radio parameters stored in the instance.
+int32_t uCellPrivateRefreshRadioParameters(uCellPrivateInstance_t *pInstance)
+{
+    return refreshRadioParameters(pInstance, &(pInstance->radioParameters), 0);
+}
+
+// Stop the radio sampler and remove its context.
+void uCellPrivateSamplerRemoveContext(uCellPrivateInstance_t *pInstance)
+{
+    if ((pInstance != NULL) && (pInstance->pRadioSamplerContext != NULL)) {
+        samplerFree((uCellInfoSamplerContext_t *) pInstance->pRadioSamplerContext);
+        pInstance->pRadioSamplerContext = NULL;
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -566,8 +895,6 @@ int32_t uCellInfoRefreshRadioParameters(uDeviceHandle_t cellHandle)
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
     uCellPrivateRadioParameters_t *pRadioParameters;
-    uAtClientHandle_t atHandle;
-    uCellNetRat_t rat;
 
     if (gUCellPrivateMutex != NULL) {
 
@@ -576,52 +903,14 @@ int32_t uCellInfoRefreshRadioParameters(uDeviceHandle_t cellHandle)
         pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if (pInstance != NULL) {
-            errorCode = (int32_t) U_CELL_ERROR_NOT_REGISTERED;
-            atHandle = pInstance->atHandle;
             pRadioParameters = &(pInstance->radioParameters);
-            uCellPrivateClearRadioParameters(pRadioParameters);
-            if (uCellPrivateIsRegistered(pInstance)) {
-                // The mechanisms to get the radio information
-                // are different between EUTRAN and GERAN but
-                // AT+CSQ works in all cases though it sometimes
-                // doesn't return a reading.  Collect what we can
-                // with it
-                errorCode = getRadioParamsCsq(atHandle, pRadioParameters);
-                // Note that AT+UCGED is used next rather than AT+CESQ
-                // as, in my experience, it is more reliable in
-                // reporting answers.
-                // Allow a little sleepy-byes here, don't want to overtask
-                // the module if this is being called repeatedly
-                uPortTaskBlock(500);
-                if (U_CELL_PRIVATE_HAS(pInstance->pModule, U_CELL_PRIVATE_FEATURE_UCGED5)) {
-                    // SARA-R4 (except 422) only supports UCGED=5, and it only
-                    // supports it in EUTRAN mode
-                    rat = uCellPrivateGetActiveRat(pInstance);
-                    if (U_CELL_PRIVATE_RAT_IS_EUTRAN(rat)) {
-                        errorCode = getRadioParamsUcged5(atHandle, pRadioParameters);
-                    } else {
-                        // Can't use AT+UCGED, that's all we can get
-                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-                    }
-                } else {
-                    // The AT+UCGED=2 formats are module-specific
-                    switch (pInstance->pModule->moduleType) {
-                        case U_CELL_MODULE_TYPE_SARA_R5:
-                            errorCode = getRadioParamsUcged2SaraR5(atHandle, pRadioParameters);
-                            break;
-                        case U_CELL_MODULE_TYPE_SARA_R422:
-                            errorCode = getRadioParamsUcged2SaraR422(atHandle, pRadioParameters);
-                            break;
-                        case U_CELL_MODULE_TYPE_LARA_R6:
-                            errorCode = getRadioParamsUcged2LaraR6(atHandle, pRadioParameters);
-                            break;
-                        default:
-                            break;
-                    }
-                }
-            }
-
+            errorCode = refreshRadioParameters(pInstance, pRadioParameters, 500);
             if (errorCode == 0) {
+                if (pInstance->pRadioSamplerContext != NULL) {
+                    // This counts as a sample for the radio sampler
+                    samplerWrite((uCellInfoSamplerContext_t *) pInstance->pRadioSamplerContext,
+                                 pRadioParameters);
+                }
                 uPortLog("U_CELL_INFO: radio parameters refreshed:\n");
                 uPortLog("             RSSI:    %d dBm\n", pRadioParameters->rssiDbm);
                 uPortLog("             RSRP:    %d dBm\n", pRadioParameters->rsrpDbm);
@@ -890,6 +1179,7 @@ int32_t uCellInfoGetImei(uDeviceHandle_t cellHandle,
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
+    uCellPrivateIdentity_t *pIdentity;
 
     if (gUCellPrivateMutex != NULL) {
 
@@ -898,7 +1188,17 @@ int32_t uCellInfoGetImei(uDeviceHandle_t cellHandle,
         pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pImei != NULL)) {
-            errorCode = uCellPrivateGetImei(pInstance, pImei);
+            pIdentity = pGetIdentity(pInstance);
+            if ((pIdentity != NULL) && (pIdentity->imei[0] != 0)) {
+                memcpy(pImei, pIdentity->imei, U_CELL_INFO_IMEI_SIZE);
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            } else {
+                errorCode = uCellPrivateGetImei(pInstance, pImei);
+                if ((errorCode == 0) && (pIdentity != NULL)) {
+                    memcpy(pIdentity->imei, pImei, U_CELL_INFO_IMEI_SIZE);
+                    pIdentity->imei[U_CELL_INFO_IMEI_SIZE] = 0;
+                }
+            }
             if (errorCode == 0) {
                 uPortLog("U_CELL_INFO: IMEI is %.*s.\n",
                          U_CELL_INFO_IMEI_SIZE, pImei);
@@ -919,6 +1219,7 @@ int32_t uCellInfoGetImsi(uDeviceHandle_t cellHandle,
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
+    uCellPrivateIdentity_t *pIdentity;
 
     if (gUCellPrivateMutex != NULL) {
 
@@ -927,7 +1228,17 @@ int32_t uCellInfoGetImsi(uDeviceHandle_t cellHandle,
         pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pImsi != NULL)) {
-            errorCode = uCellPrivateGetImsi(pInstance, pImsi);
+            pIdentity = pGetIdentity(pInstance);
+            if ((pIdentity != NULL) && (pIdentity->imsi[0] != 0)) {
+                memcpy(pImsi, pIdentity->imsi, U_CELL_INFO_IMSI_SIZE);
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            } else {
+                errorCode = uCellPrivateGetImsi(pInstance, pImsi);
+                if ((errorCode == 0) && (pIdentity != NULL)) {
+                    memcpy(pIdentity->imsi, pImsi, U_CELL_INFO_IMSI_SIZE);
+                    pIdentity->imsi[U_CELL_INFO_IMSI_SIZE] = 0;
+                }
+            }
             if (errorCode == 0) {
                 uPortLog("U_CELL_INFO: IMSI is %.*s.\n",
                          U_CELL_INFO_IMSI_SIZE, pImsi);
@@ -948,8 +1259,7 @@ int32_t uCellInfoGetIccidStr(uDeviceHandle_t cellHandle,
 {
     int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
-    uAtClientHandle_t atHandle;
-    int32_t bytesRead;
+    uCellPrivateIdentity_t *pIdentity;
 
     if (gUCellPrivateMutex != NULL) {
 
@@ -958,20 +1268,18 @@ int32_t uCellInfoGetIccidStr(uDeviceHandle_t cellHandle,
         pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pStr != NULL) && (size > 0)) {
-            atHandle = pInstance->atHandle;
-            uAtClientLock(atHandle);
-            uAtClientCommandStart(atHandle, "AT+CCID");
-            uAtClientCommandStop(atHandle);
-            uAtClientResponseStart(atHandle, "+CCID:");
-            bytesRead = uAtClientReadString(atHandle, pStr, size, false);
-            uAtClientResponseStop(atHandle);
-            errorCodeOrSize = uAtClientUnlock(atHandle);
-            if ((bytesRead >= 0) && (errorCodeOrSize == 0)) {
-                errorCodeOrSize = bytesRead;
-                uPortLog("U_CELL_INFO: ICCID is %s.\n", pStr);
-            } else {
-                errorCodeOrSize = (int32_t) U_CELL_ERROR_AT;
-                uPortLog("U_CELL_INFO: unable to read ICCID.\n");
+            pIdentity = pGetIdentity(pInstance);
+            errorCodeOrSize = 0;
+            if ((pIdentity != NULL) && (pIdentity->iccid[0] == 0)) {
+                errorCodeOrSize = getIccid(pInstance->atHandle, pIdentity->iccid,
+                                           sizeof(pIdentity->iccid));
+            }
+            if (errorCodeOrSize >= 0) {
+                if ((pIdentity != NULL) && (pIdentity->iccid[0] != 0)) {
+                    errorCodeOrSize = copyIdentityString(pIdentity->iccid, pStr, size);
+                } else {
+                    errorCodeOrSize = getIccid(pInstance->atHandle, pStr, size);
+                }
             }
         }
 
@@ -987,6 +1295,7 @@ int32_t uCellInfoGetManufacturerStr(uDeviceHandle_t cellHandle,
 {
     int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
+    uCellPrivateIdentity_t *pIdentity;
 
     if (gUCellPrivateMutex != NULL) {
 
@@ -995,8 +1304,10 @@ int32_t uCellInfoGetManufacturerStr(uDeviceHandle_t cellHandle,
         pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pStr != NULL) && (size > 0)) {
-            errorCodeOrSize = getString(pInstance->atHandle, "AT+CGMI",
-                                        pStr, size);
+            pIdentity = pGetIdentity(pInstance);
+            errorCodeOrSize = getCachedString(pInstance, "AT+CGMI",
+                                              (pIdentity != NULL) ? pIdentity->manufacturer : NULL,
+                                              sizeof(pIdentity->manufacturer), pStr, size);
         }
 
         U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
@@ -1011,6 +1322,7 @@ int32_t uCellInfoGetModelStr(uDeviceHandle_t cellHandle,
 {
     int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
+    uCellPrivateIdentity_t *pIdentity;
 
     if (gUCellPrivateMutex != NULL) {
 
@@ -1019,8 +1331,10 @@ int32_t uCellInfoGetModelStr(uDeviceHandle_t cellHandle,
         pInstance = pUCellPrivateGetInstance(cellHandle);
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pStr != NULL) && (size > 0)) {
-            errorCodeOrSize = getString(pInstance->atHandle, "AT+CGMM",
-                                        pStr, size);
+            pIdentity = pGetIdentity(pInstance);
+            errorCodeOrSize = getCachedString(pInstance, "AT+CGMM",
+                                              (pIdentity != NULL) ? pIdentity->model : NULL,
+                                              sizeof(pIdentity->model), pStr, size);
         }
 
         U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
@@ -1035,6 +1349,7 @@ int32_t uCellInfoGetFirmwareVersionStr(uDeviceHandle_t cellHandle,
 {
     int32_t errorCodeOrSize = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
+    uCellPrivateIdentity_t *pIdentity;
 
     if (gUCellPrivateMutex != NULL) {
 
@@ -1044,8 +1359,11 @@ int32_t uCellInfoGetFirmwareVersionStr(uDeviceHandle_t cellHandle,
         errorCodeOrSize = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         if ((pInstance != NULL) && (pStr != NULL) && (size > 0)) {
             // Use ATI9 instead of AT+CGMR as it contains more information
-            errorCodeOrSize = getString(pInstance->atHandle, "ATI9",
-                                        pStr, size);
+            pIdentity = pGetIdentity(pInstance);
+            errorCodeOrSize = getCachedString(pInstance, "ATI9",
+                                              (pIdentity != NULL) ?
+                                              pIdentity->firmwareVersion : NULL,
+                                              sizeof(pIdentity->firmwareVersion), pStr, size);
         }
 
         U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
@@ -1256,4 +1574,152 @@ bool uCellInfoIsCtsFlowControlEnabled(uDeviceHandle_t cellHandle)
     return isEnabled;
 }
 
+// Start the radio sampler.
+int32_t uCellInfoSamplerStart(uDeviceHandle_t cellHandle, int32_t periodMs,
+                              uCellInfoRadioRing_t *pRing)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellInfoSamplerContext_t *pContext;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (periodMs > 0) && (pRing != NULL)) {
+            // Stop any existing sampler
+            uCellPrivateSamplerRemoveContext(pInstance);
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pContext = (uCellInfoSamplerContext_t *) pUPortMalloc(sizeof(*pContext));
+            if (pContext != NULL) {
+                memset(pContext, 0, sizeof(*pContext));
+                memset(pRing, 0, sizeof(*pRing));
+                pContext->pInstance = pInstance;
+                pContext->pRing = pRing;
+                pContext->periodMs = periodMs;
+                // Take the first sample straight away
+                pContext->lastSampleTimeMs = uPortGetTickTimeMs() - periodMs;
+                errorCode = uPortMutexCreate(&(pContext->writeMutex));
+                if (errorCode == 0) {
+                    errorCode = uPortMutexCreate(&(pContext->taskRunningMutex));
+                }
+                if (errorCode == 0) {
+                    errorCode = uPortQueueCreate(1, sizeof(int32_t),
+                                                 &(pContext->taskExitQueue));
+                }
+                if (errorCode == 0) {
+                    errorCode = uPortTaskCreate(samplerTask, "cellSampler",
+                                                U_CELL_INFO_SAMPLER_TASK_STACK_SIZE_BYTES,
+                                                pContext,
+                                                U_CELL_INFO_SAMPLER_TASK_PRIORITY,
+                                                &(pContext->taskHandle));
+                }
+                if (errorCode == 0) {
+                    // Wait for the task to lock its running mutex
+                    while (uPortMutexTryLock(pContext->taskRunningMutex, 0) == 0) {
+                        uPortMutexUnlock(pContext->taskRunningMutex);
+                        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                    }
+                    pInstance->pRadioSamplerContext = pContext;
+                } else {
+                    // Clean up on error
+                    samplerFree(pContext);
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Stop the radio sampler.
+void uCellInfoSamplerStop(uDeviceHandle_t cellHandle)
+{
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        uCellPrivateSamplerRemoveContext(pUCellPrivateGetInstance(cellHandle));
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+}
+
+// Read a sample from a radio ring.
+int32_t uCellInfoRadioRingRead(const uCellInfoRadioRing_t *pRing, size_t index,
+                               uCellInfoRadioSample_t *pSample)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uint32_t sequence;
+    uint32_t numWritten;
+
+    if ((pRing != NULL) && (pSample != NULL)) {
+        do {
+            sequence = ringSequenceGet(pRing);
+            numWritten = pRing->numWritten;
+            errorCode = (int32_t) U_ERROR_COMMON_EMPTY;
+            if ((index < U_CELL_INFO_RADIO_RING_LENGTH) && (index < numWritten)) {
+                *pSample = pRing->sample[(numWritten - 1 - index) % U_CELL_INFO_RADIO_RING_LENGTH];
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+            // Try again if a write happened while we were reading
+        } while (pRing->sequence != sequence);
+    }
+
+    return errorCode;
+}
+
+// Get summary statistics from a radio ring.
+int32_t uCellInfoRadioRingSummary(const uCellInfoRadioRing_t *pRing,
+                                  int32_t windowMs,
+                                  uCellInfoRadioSummary_t *pSummary)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uCellInfoRadioSample_t *pSample;
+    uint32_t sequence;
+    uint32_t numWritten;
+    int64_t sumRssi;
+    int64_t sumRsrp;
+    int64_t sumRsrq;
+    int64_t sumSnr;
+    int32_t nowMs;
+
+    if ((pRing != NULL) && (windowMs >= 0) && (pSummary != NULL)) {
+        nowMs = uPortGetTickTimeMs();
+        do {
+            memset(pSummary, 0, sizeof(*pSummary));
+            sumRssi = 0;
+            sumRsrp = 0;
+            sumRsrq = 0;
+            sumSnr = 0;
+            sequence = ringSequenceGet(pRing);
+            numWritten = pRing->numWritten;
+            // Work back from the newest sample
+            for (size_t x = 0; (x < U_CELL_INFO_RADIO_RING_LENGTH) && (x < numWritten); x++) {
+                pSample = &(pRing->sample[(numWritten - 1 - x) % U_CELL_INFO_RADIO_RING_LENGTH]);
+                if ((windowMs > 0) && (nowMs - pSample->timeMs > windowMs)) {
+                    break;
+                }
+                statisticAdd(&(pSummary->rssiDbm), &sumRssi, pSample->rssiDbm, 0);
+                statisticAdd(&(pSummary->rsrpDbm), &sumRsrp, pSample->rsrpDbm, 0);
+                statisticAdd(&(pSummary->rsrqDb), &sumRsrq, pSample->rsrqDb, 0x7FFFFFFF);
+                statisticAdd(&(pSummary->snrDb), &sumSnr, pSample->snrDb, 0x7FFFFFFF);
+                pSummary->numSamples++;
+            }
+            // Try again if a write happened while we were reading
+        } while (pRing->sequence != sequence);
+        statisticMean(&(pSummary->rssiDbm), sumRssi);
+        statisticMean(&(pSummary->rsrpDbm), sumRsrp);
+        statisticMean(&(pSummary->rsrqDb), sumRsrq);
+        statisticMean(&(pSummary->snrDb), sumSnr);
+        errorCodeOrCount = (int32_t) pSummary->numSamples;
+    }
+
+    return errorCodeOrCount;
+}
+
 // End of file
@@ -254,6 +254,18 @@ typedef struct {
     bool messageRead;
 } uCellMqttUrcMessage_t;
 
+/** Struct to hold a message published with uCellMqttPublishAsync()
+ * while it awaits a result from the module and then while that
+ * result awaits being passed to the callback.
+ */
+typedef struct {
+    int32_t token;
+    int32_t startTimeMs;
+    int32_t errorCode;
+    void (*pCallback) (int32_t, int32_t, void *);
+    void *pCallbackParam;
+} uCellMqttPublishInFlight_t;
+
 /** Struct bringing all of the above together.
  */
 typedef struct {
@@ -287,6 +299,22 @@ typedef struct {
                                                       required for SARA-R4. */
     size_t numTries; /**< The number of tries for a radio-related operation. */
     bool mqttSn; /**< true if this is an MQTT-SN session, else false. */
+    /** ring of messages published with uCellMqttPublishAsync(). */
+    uCellMqttPublishInFlight_t publishInFlight[U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM];
+    size_t publishOldest; /**< index of the oldest entry in publishInFlight. */
+    size_t publishNumDone; /**< the number of entries, starting with the oldest,
+                                that have a result waiting to be passed
+                                to their callback. */
+    size_t publishNumAwaiting; /**< the number of entries, following those
+                                    that are done, that are awaiting a
+                                    result from the module. */
+    size_t publishWindow; /**< the limit on publishNumDone + publishNumAwaiting. */
+    int32_t publishTimeoutMs; /**< how long a message may await a result. */
+    size_t publishNumStale; /**< the number of results that may yet arrive for
+                                 messages that have already been timed out. */
+    int32_t publishStaleTimeMs; /**< when publishNumStale was last changed. */
+    int32_t publishNextToken; /**< the token for the next call to
+                                   uCellMqttPublishAsync(). */
 } uCellMqttContext_t;
 
 /* ----------------------------------------------------------------
@@ -388,6 +416,153 @@ static void disconnectCallback(uAtClientHandle_t atHandle,
     U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
 }
 
+// Add a message published with uCellMqttPublishAsync() to the end
+// of the in-flight ring, awaiting a result; the caller must have
+// checked that there is room and must have the AT client locked.
+static void publishAsyncAdd(volatile uCellMqttContext_t *pContext,
+                            const uCellMqttPublishInFlight_t *pEntry)
+{
+    volatile uCellMqttPublishInFlight_t *pSlot;
+
+    pSlot = &(pContext->publishInFlight[(pContext->publishOldest +
+                                         pContext->publishNumDone +
+                                         pContext->publishNumAwaiting) %
+                                        U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM]);
+    pSlot->token = pEntry->token;
+    pSlot->startTimeMs = uPortGetTickTimeMs();
+    pSlot->errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+    pSlot->pCallback = pEntry->pCallback;
+    pSlot->pCallbackParam = pEntry->pCallbackParam;
+    pContext->publishNumAwaiting++;
+}
+
+// Set the result of the oldest message published with
+// uCellMqttPublishAsync() that is awaiting one; the module
+// reports results in the order that messages were sent.  Must be
+// called from a URC handler or with the AT client locked.
+static void publishAsyncDone(volatile uCellMqttContext_t *pContext,
+                             int32_t errorCode)
+{
+    if (pContext->publishNumAwaiting > 0) {
+        pContext->publishInFlight[(pContext->publishOldest +
+                                   pContext->publishNumDone) %
+                                  U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM].errorCode = errorCode;
+        pContext->publishNumDone++;
+        pContext->publishNumAwaiting--;
+    }
+}
+
+// Time out messages published with uCellMqttPublishAsync() that
+// have been waiting too long for a result, returning true if there
+// are results waiting to be passed to callbacks.  Since a result
+// does not say which message it is for, timing out just the oldest
+// message would credit its late result to the next one: instead all
+// of the messages awaiting a result are failed and the results that
+// may yet arrive for them are discarded, with nothing more published
+// until they have arrived or none has arrived for
+// #U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS.  Must be called with the AT
+// client locked.
+static bool publishAsyncExpire(volatile uCellMqttContext_t *pContext)
+{
+    volatile uCellMqttPublishInFlight_t *pSlot;
+
+    if ((pContext->publishNumStale > 0) &&
+        (uPortGetTickTimeMs() - pContext->publishStaleTimeMs >
+         (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000))) {
+        // Any results still to come are taken to have been lost
+        pContext->publishNumStale = 0;
+    }
+    if (pContext->publishNumAwaiting > 0) {
+        pSlot = &(pContext->publishInFlight[(pContext->publishOldest +
+                                             pContext->publishNumDone) %
+                                            U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM]);
+        if (uPortGetTickTimeMs() - pSlot->startTimeMs > pContext->publishTimeoutMs) {
+            pContext->publishNumStale += pContext->publishNumAwaiting;
+            pContext->publishStaleTimeMs = uPortGetTickTimeMs();
+            while (pContext->publishNumAwaiting > 0) {
+                publishAsyncDone(pContext, (int32_t) U_ERROR_COMMON_TIMEOUT);
+            }
+        }
+    }
+
+    return (pContext->publishNumDone > 0);
+}
+
+// A local "trampoline" for the callbacks of uCellMqttPublishAsync(),
+// here so that they can be called in a separate task; the callbacks
+// are called without any locks held.
+//lint -esym(818, pParam) Suppress "could be pointing to const",
+// gotta follow the function signature
+static void publishAsyncCallback(uAtClientHandle_t atHandle,
+                                 void *pParam)
+{
+    //lint -e(507) Suppress size incompatibility due to the compiler
+    // we use for Linting being a 64 bit one where the pointer
+    // is 64 bit.
+    const uCellPrivateInstance_t *pInstance = (const uCellPrivateInstance_t *) pParam;
+    volatile uCellMqttContext_t *pContext;
+    volatile uCellMqttPublishInFlight_t *pSlot;
+    uCellMqttPublishInFlight_t done[U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM];
+    size_t numDone = 0;
+
+    U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+    // The MQTT context may have gone while we were queued
+    pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+    if (pContext != NULL) {
+        uAtClientLock(atHandle);
+        while (pContext->publishNumDone > 0) {
+            pSlot = &(pContext->publishInFlight[pContext->publishOldest]);
+            done[numDone].token = pSlot->token;
+            done[numDone].errorCode = pSlot->errorCode;
+            done[numDone].pCallback = pSlot->pCallback;
+            done[numDone].pCallbackParam = pSlot->pCallbackParam;
+            numDone++;
+            pContext->publishOldest = (pContext->publishOldest + 1) %
+                                      U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM;
+            pContext->publishNumDone--;
+        }
+        uAtClientUnlock(atHandle);
+    }
+
+    U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+
+    for (size_t x = 0; x < numDone; x++) {
+        if (done[x].pCallback != NULL) {
+            done[x].pCallback(done[x].token, done[x].errorCode,
+                              done[x].pCallbackParam);
+        }
+    }
+}
+
+// Time out messages published with uCellMqttPublishAsync() that have
+// been waiting too long for a result, launch the callbacks of those
+// that have a result and return the number that are outstanding;
+// pResyncing is set to true if results for messages that have been
+// timed out may yet arrive, in which case nothing may be published.
+static size_t publishAsyncUpdate(const uCellPrivateInstance_t *pInstance,
+                                 bool *pResyncing)
+{
+    volatile uCellMqttContext_t *pContext;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    size_t numOutstanding;
+    bool resultsWaiting;
+
+    pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+    uAtClientLock(atHandle);
+    resultsWaiting = publishAsyncExpire(pContext);
+    numOutstanding = pContext->publishNumDone + pContext->publishNumAwaiting;
+    *pResyncing = (pContext->publishNumStale > 0);
+    uAtClientUnlock(atHandle);
+    if (resultsWaiting) {
+        //lint -e(1773) Suppress complaints about
+        // passing the pointer as non-volatile
+        uAtClientCallback(atHandle, publishAsyncCallback, (void *) pInstance);
+    }
+
+    return numOutstanding;
+}
+
 // "+UUMQTTC:"/"+UUMQTTSNC" URC handler, called by the UUMQTT_urc()
 // URC handler..
 static void UUMQTTC_UUMQTTSNC_urc(uAtClientHandle_t atHandle,
@@ -424,6 +599,17 @@ static void UUMQTTC_UUMQTTSNC_urc(uAtClientHandle_t atHandle,
                                   (void *) pInstance);
             }
             pContext->connected = false;
+            // Nothing more will be heard of any outstanding publishes
+            pContext->publishNumStale = 0;
+            if (pContext->publishNumAwaiting > 0) {
+                while (pContext->publishNumAwaiting > 0) {
+                    publishAsyncDone(pContext, (int32_t) U_ERROR_COMMON_DEVICE_ERROR);
+                }
+                //lint -e(1773) Suppress complaints about
+                // passing the pointer as non-volatile
+                uAtClientCallback(atHandle, publishAsyncCallback,
+                                  (void *) pInstance);
+            }
             // Keep alive returns to "off" when the session ends,
             // it must be set afresh each time
             pContext->keptAlive = false;
@@ -449,11 +635,27 @@ static void UUMQTTC_UUMQTTSNC_urc(uAtClientHandle_t atHandle,
     } else if ((urcType == MQTT_COMMAND_OPCODE_PUBLISH_STRING(mqttSn)) ||
                (!mqttSn && (urcType == 9))) {
         // Publish hex or binary, 1 means success
-        if (urcParam1 == 1) {
-            // Published
-            pUrcStatus->flagsBitmap |= 1 << U_CELL_MQTT_URC_FLAG_PUBLISH_SUCCESS;
+        if (pContext->publishNumAwaiting > 0) {
+            // This is the result for the oldest message sent with
+            // uCellMqttPublishAsync()
+            publishAsyncDone(pContext, (urcParam1 == 1) ? 0 :
+                             (int32_t) U_ERROR_COMMON_DEVICE_ERROR);
+            //lint -e(1773) Suppress complaints about
+            // passing the pointer as non-volatile
+            uAtClientCallback(atHandle, publishAsyncCallback,
+                              (void *) pInstance);
+        } else if (pContext->publishNumStale > 0) {
+            // The late result of a message published with
+            // uCellMqttPublishAsync() that has been timed out
+            pContext->publishNumStale--;
+            pContext->publishStaleTimeMs = uPortGetTickTimeMs();
+        } else {
+            if (urcParam1 == 1) {
+                // Published
+                pUrcStatus->flagsBitmap |= 1 << U_CELL_MQTT_URC_FLAG_PUBLISH_SUCCESS;
+            }
+            pUrcStatus->flagsBitmap |= 1 << U_CELL_MQTT_URC_FLAG_PUBLISH_UPDATED;
         }
-        pUrcStatus->flagsBitmap |= 1 << U_CELL_MQTT_URC_FLAG_PUBLISH_UPDATED;
     } else if (urcType == MQTT_COMMAND_OPCODE_SUBSCRIBE(mqttSn)) {
         // Subscribe
         // Get the QoS
@@ -1486,13 +1688,17 @@ static int32_t mqttSnTopicNameToStr(const uCellMqttSnTopicName_t *pTopicName,
  * STATIC FUNCTIONS: PUBLISH/SUBSCRIBE/UNSUBSCRIBE/READ
  * -------------------------------------------------------------- */
 
-// Publish a message, MQTT or MQTT-SN style.
+// Publish a message, MQTT or MQTT-SN style; if pAsync is non-NULL
+// then, rather than waiting for the result, the message is added
+// to the in-flight ring of uCellMqttPublishAsync() once the module
+// has accepted it.
 static int32_t publish(const uCellPrivateInstance_t *pInstance,
                        const char *pTopicNameStr,
                        int32_t topicNameType,
                        const char *pMessage,
                        size_t messageSizeBytes,
-                       uCellMqttQos_t qos, bool retain)
+                       uCellMqttQos_t qos, bool retain,
+                       const uCellMqttPublishInFlight_t *pAsync)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     volatile uCellMqttContext_t *pContext;
@@ -1501,20 +1707,30 @@ static int32_t publish(const uCellPrivateInstance_t *pInstance,
     uAtClientHandle_t atHandle;
     char *pTextMessage = NULL;
     int32_t status = 1;
-    bool isAscii;
+    bool isAscii = false;
+    bool isBinary;
     bool messageWritten = false;
     int32_t startTimeMs;
     int32_t promptTimeoutSeconds = U_CELL_MQTT_PROMPT_TIMEOUT_NORMAL_SECONDS;
     size_t tryCount = 0;
+    bool asyncAdded = false;
+    bool oldSyntax = U_CELL_PRIVATE_HAS(pInstance->pModule,
+                                        U_CELL_PRIVATE_FEATURE_MQTT_SARA_R4_OLD_SYNTAX);
 
     pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
     mqttSn = pContext->mqttSn;
     pUrcStatus = &(pContext->urcStatus);
+    // Binary mode, where the message is written as-is after a
+    // prompt, is supported by everything except SARA-R41x, but
+    // never by the MQTT-SN AT interface
+    isBinary = U_CELL_PRIVATE_HAS(pInstance->pModule,
+                                  U_CELL_PRIVATE_FEATURE_MQTT_BINARY_PUBLISH) &&
+               !mqttSn;
     if (mqttSn) {
         isAscii = isAllowedMqttSn(pMessage, messageSizeBytes);
-    } else {
-        // This will be ignored for module types that support binary
-        // publish, which eveything except SARA-R41x does
+    } else if (!isBinary) {
+        // Only worth checking the content of the message if
+        // it is to be sent as a string
         isAscii = isAllowedMqttSaraR41x(pMessage, messageSizeBytes);
     }
     //lint -e(568) Suppress value never being negative, who knows
@@ -1532,11 +1748,7 @@ static int32_t publish(const uCellPrivateInstance_t *pInstance,
           ((isAscii && (messageSizeBytes <= U_CELL_MQTT_PUBLISH_HEX_MAX_LENGTH_BYTES * 2)) ||
            (messageSizeBytes <= U_CELL_MQTT_PUBLISH_HEX_MAX_LENGTH_BYTES))))) {
         errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-        if (!U_CELL_PRIVATE_HAS(pInstance->pModule,
-                                U_CELL_PRIVATE_FEATURE_MQTT_BINARY_PUBLISH) ||
-            mqttSn) {
-            // Note: the MQTT-SN AT interface never supports binary
-            // publishing (even where the MQTT one does)
+        if (!isBinary) {
             // If we aren't able to publish a message as a binary
             // blob then allocate space to publish it as a string,
             // either as hex or as ASCII with a terminator added
@@ -1558,9 +1770,7 @@ static int32_t publish(const uCellPrivateInstance_t *pInstance,
             }
         }
 
-        if ((pTextMessage != NULL) ||
-            U_CELL_PRIVATE_HAS(pInstance->pModule,
-                               U_CELL_PRIVATE_FEATURE_MQTT_BINARY_PUBLISH)) {
+        if ((pTextMessage != NULL) || isBinary) {
             errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
             atHandle = pInstance->atHandle;
             // We retry this if the failure was due to radio conditions
@@ -1653,10 +1863,28 @@ static int32_t publish(const uCellPrivateInstance_t *pInstance,
                 // up any rubbish lying around in the AT buffer
                 uAtClientResponseStop(atHandle);
 
+                if ((pAsync != NULL) && (status == 1) &&
+                    (uAtClientErrorGet(atHandle) == 0)) {
+                    // Add the message to the in-flight ring before the
+                    // AT client is unlocked so that the URC carrying
+                    // the result can't beat us to it; with the old
+                    // SARA-R4 syntax there is no URC, the result is
+                    // already known
+                    publishAsyncAdd(pContext, pAsync);
+                    if (oldSyntax) {
+                        publishAsyncDone(pContext, 0);
+                        //lint -e(1773) Suppress complaints about
+                        // passing the pointer as non-volatile
+                        uAtClientCallback(atHandle, publishAsyncCallback,
+                                          (void *) pInstance);
+                    }
+                    asyncAdded = true;
+                }
+
                 if ((uAtClientUnlock(atHandle) == 0) && (status == 1)) {
-                    if (U_CELL_PRIVATE_HAS(pInstance->pModule,
-                                           U_CELL_PRIVATE_FEATURE_MQTT_SARA_R4_OLD_SYNTAX)) {
-                        // For the old SARA-R4 syntax, that's it
+                    if (oldSyntax || asyncAdded) {
+                        // For the old SARA-R4 syntax, or if the result
+                        // is to be handled asynchronously, that's it
                         errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                     } else {
                         // Wait for a URC to say that the publish
@@ -1880,6 +2108,133 @@ static int32_t unsubscribe(const uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+// Read one message, new syntax, MQTT or MQTT-SN style; the AT
+// client must already be locked.  Returns zero, or
+// U_ERROR_COMMON_TRUNCATED if the message did not fit, else
+// U_ERROR_COMMON_EMPTY if there is no message or the AT client
+// has an error.
+static int32_t readMessageLocked(volatile uCellMqttContext_t *pContext,
+                                 uAtClientHandle_t atHandle,
+                                 char *pTopicNameStr,
+                                 size_t topicNameSizeBytes,
+                                 int32_t *pTopicNameType,
+                                 char *pMessage, size_t *pMessageSizeBytes,
+                                 uCellMqttQos_t *pQos)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_EMPTY;
+    bool mqttSn = pContext->mqttSn;
+    size_t messageSizeBytes = 0;
+    uCellMqttQos_t qos;
+    int32_t topicNameType = -1;
+    int32_t topicNameBytesRead = -1;
+    int32_t messageBytesAvailable;
+    int32_t messageBytesRead = 0;
+    int32_t topicBytesAvailable;
+    bool truncated = false;
+
+    if (pMessageSizeBytes != NULL) {
+        messageSizeBytes = *pMessageSizeBytes;
+    }
+    uAtClientCommandStart(atHandle, MQTT_COMMAND_AT_COMMAND_STRING(mqttSn));
+    uAtClientWriteInt(atHandle, MQTT_COMMAND_OPCODE_READ(mqttSn));
+    // We want just the one message
+    uAtClientWriteInt(atHandle, 1);
+    uAtClientCommandStop(atHandle);
+    uAtClientResponseStart(atHandle, MQTT_COMMAND_AT_RESPONSE_STRING(mqttSn));
+    // The message now arrives directly
+    // Skip the first parameter, which is just
+    // our UMQTTC command number again
+    uAtClientSkipParameters(atHandle, 1);
+    // Next should come the QoS: if it is not there
+    // then there are no messages
+    qos = (uCellMqttQos_t) uAtClientReadInt(atHandle);
+    if (qos >= 0) {
+        if (mqttSn) {
+            // For MQTT-SN retrieve the topic name type
+            topicNameType = uAtClientReadInt(atHandle);
+        }
+        // Then we can skip the length of
+        // the topic and message added together
+        uAtClientSkipParameters(atHandle, 1);
+        // Read the topic name length
+        topicBytesAvailable = uAtClientReadInt(atHandle);
+        // Now read the part of the topic name string
+        // we can absorb
+        if ((int32_t) topicNameSizeBytes > topicBytesAvailable) {
+            topicNameSizeBytes = topicBytesAvailable;
+        }
+        topicNameBytesRead = uAtClientReadString(atHandle,
+                                                 pTopicNameStr,
+                                                 topicNameSizeBytes + 1, // +1 for terminator
+                                                 false);
+        // Read the number of message bytes to follow
+        messageBytesAvailable = uAtClientReadInt(atHandle);
+        if (messageBytesAvailable > 0) {
+            if ((int32_t) messageSizeBytes > messageBytesAvailable) {
+                messageSizeBytes = messageBytesAvailable;
+            }
+            // Now read the message bytes, being careful
+            // to not look for stop tags as this can be
+            // a binary message
+            uAtClientIgnoreStopTag(atHandle);
+            // Get the leading quote mark out of the way
+            uAtClientReadBytes(atHandle, NULL, 1, true);
+            // Now read out all the actual data,
+            // first the bit we want
+            messageBytesRead = uAtClientReadBytes(atHandle, pMessage,
+                                                  messageSizeBytes, true);
+            if (messageBytesAvailable > messageBytesRead) {
+                //...and then the rest poured away to NULL
+                truncated = true;
+                uAtClientReadBytes(atHandle, NULL,
+                                   // Cast in two stages to keep Lint happy
+                                   (size_t) (unsigned) (messageBytesAvailable -
+                                                        messageBytesRead), false);
+            }
+        }
+        // Make sure to wait for the stop tag before
+        // we finish
+        uAtClientRestoreStopTag(atHandle);
+    }
+    uAtClientResponseStop(atHandle);
+    // Now have all the bits, check them
+    if ((uAtClientErrorGet(atHandle) == 0) &&
+        (topicNameBytesRead >= 0) &&
+        //lint -e(568) Suppress value never being negative
+        ((int32_t) qos >= 0) &&
+        (qos < U_CELL_MQTT_QOS_MAX_NUM) &&
+        //lint -e(568) Suppress value never being negative
+        (!mqttSn || ((topicNameType >= 0) &&
+                     (topicNameType < (int32_t) U_CELL_MQTT_SN_TOPIC_NAME_TYPE_MAX_NUM)))) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        // Good.  Topic and message have
+        // already been done above,
+        // now fill in the other bits
+        if (pMessageSizeBytes != NULL) {
+            *pMessageSizeBytes = messageBytesRead;
+        }
+        if (pQos != NULL) {
+            *pQos = qos;
+        }
+        if (pTopicNameType != NULL) {
+            *pTopicNameType = topicNameType;
+        }
+        // Decrement only if the number of unread messages was 1, because
+        // pContext->numUnreadMessages would be updated in UUMQTTC callback
+        // handler after a successful read of a message. However, when
+        // number of unread messages is 1, then, no URC is received against
+        // the reading of that one message.
+        if (pContext->numUnreadMessages == 1) {
+            pContext->numUnreadMessages--;
+        }
+        if (truncated) {
+            errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
+        }
+    }
+
+    return errorCode;
+}
+
 // Read a message, MQTT or MQTT-SN style.
 static int32_t readMessage(const uCellPrivateInstance_t *pInstance,
                            char *pTopicNameStr,
@@ -1896,13 +2251,6 @@ static int32_t readMessage(const uCellPrivateInstance_t *pInstance,
     size_t messageSizeBytes = 0;
     int32_t status;
     int32_t startTimeMs;
-    uCellMqttQos_t qos;
-    int32_t topicNameType = -1;
-    int32_t topicNameBytesRead;
-    int32_t messageBytesAvailable;
-    int32_t messageBytesRead = 0;
-    int32_t topicBytesAvailable;
-    bool truncated = false;
 
     pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
     mqttSn = pContext->mqttSn;
@@ -1913,6 +2261,7 @@ static int32_t readMessage(const uCellPrivateInstance_t *pInstance,
             messageSizeBytes = *pMessageSizeBytes;
         }
         errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+        atHandle = pInstance->atHandle;
         if (U_CELL_PRIVATE_HAS(pInstance->pModule,
                                U_CELL_PRIVATE_FEATURE_MQTT_SARA_R4_OLD_SYNTAX)) {
             U_ASSERT(pUrcMessage != NULL);
@@ -1923,13 +2272,9 @@ static int32_t readMessage(const uCellPrivateInstance_t *pInstance,
             pUrcMessage->topicNameSizeBytes = (int32_t) topicNameSizeBytes;
             pUrcMessage->pMessage = pMessage;
             pUrcMessage->messageSizeBytes = (int32_t) messageSizeBytes;
-        }
-        atHandle = pInstance->atHandle;
-        uAtClientLock(atHandle);
-        uAtClientCommandStart(atHandle, MQTT_COMMAND_AT_COMMAND_STRING(mqttSn));
-        uAtClientWriteInt(atHandle, MQTT_COMMAND_OPCODE_READ(mqttSn));
-        if (U_CELL_PRIVATE_HAS(pInstance->pModule,
-                               U_CELL_PRIVATE_FEATURE_MQTT_SARA_R4_OLD_SYNTAX)) {
+            uAtClientLock(atHandle);
+            uAtClientCommandStart(atHandle, MQTT_COMMAND_AT_COMMAND_STRING(mqttSn));
+            uAtClientWriteInt(atHandle, MQTT_COMMAND_OPCODE_READ(mqttSn));
             // We get a standard indication of success here then we need
             // to wait for a URC to get the message
             uAtClientCommandStop(atHandle);
@@ -1973,102 +2318,11 @@ static int32_t readMessage(const uCellPrivateInstance_t *pInstance,
                 }
             }
         } else {
-            // We want just the one message
-            errorCode = (int32_t) U_ERROR_COMMON_EMPTY;
-            uAtClientWriteInt(atHandle, 1);
-            uAtClientCommandStop(atHandle);
-            uAtClientResponseStart(atHandle, MQTT_COMMAND_AT_RESPONSE_STRING(mqttSn));
-            // The message now arrives directly
-            // Skip the first parameter, which is just
-            // our UMQTTC command number again
-            uAtClientSkipParameters(atHandle, 1);
-            // Next should come the QoS: if it is not there
-            // then there are no messages
-            qos = (uCellMqttQos_t) uAtClientReadInt(atHandle);
-            if (qos >= 0) {
-                if (mqttSn) {
-                    // For MQTT-SN retrieve the topic name type
-                    topicNameType = uAtClientReadInt(atHandle);
-                }
-                // Then we can skip the length of
-                // the topic and message added together
-                uAtClientSkipParameters(atHandle, 1);
-                // Read the topic name length
-                topicBytesAvailable = uAtClientReadInt(atHandle);
-                // Now read the part of the topic name string
-                // we can absorb
-                if ((int32_t) topicNameSizeBytes > topicBytesAvailable) {
-                    topicNameSizeBytes = topicBytesAvailable;
-                }
-                topicNameBytesRead = uAtClientReadString(atHandle,
-                                                         pTopicNameStr,
-                                                         topicNameSizeBytes + 1, // +1 for terminator
-                                                         false);
-                // Read the number of message bytes to follow
-                messageBytesAvailable = uAtClientReadInt(atHandle);
-                if (messageBytesAvailable > 0) {
-                    if ((int32_t) messageSizeBytes > messageBytesAvailable) {
-                        messageSizeBytes = messageBytesAvailable;
-                    }
-                    // Now read the message bytes, being careful
-                    // to not look for stop tags as this can be
-                    // a binary message
-                    uAtClientIgnoreStopTag(atHandle);
-                    // Get the leading quote mark out of the way
-                    uAtClientReadBytes(atHandle, NULL, 1, true);
-                    // Now read out all the actual data,
-                    // first the bit we want
-                    messageBytesRead = uAtClientReadBytes(atHandle, pMessage,
-                                                          messageSizeBytes, true);
-                    if (messageBytesAvailable > messageBytesRead) {
-                        //...and then the rest poured away to NULL
-                        truncated = true;
-                        uAtClientReadBytes(atHandle, NULL,
-                                           // Cast in two stages to keep Lint happy
-                                           (size_t) (unsigned) (messageBytesAvailable -
-                                                                messageBytesRead), false);
-                    }
-                }
-                // Make sure to wait for the stop tag before
-                // we finish
-                uAtClientRestoreStopTag(atHandle);
-            }
-            uAtClientResponseStop(atHandle);
-            if (uAtClientUnlock(atHandle) == 0) {
-                // Now have all the bits, check them
-                if ((topicNameBytesRead >= 0) &&
-                    //lint -e(568) Suppress value never being negative
-                    ((int32_t) qos >= 0) &&
-                    (qos < U_CELL_MQTT_QOS_MAX_NUM) &&
-                    //lint -e(568) Suppress value never being negative
-                    (!mqttSn || ((topicNameType >= 0) &&
-                                 (topicNameType < (int32_t) U_CELL_MQTT_SN_TOPIC_NAME_TYPE_MAX_NUM)))) {
-                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-                    // Good.  Topic and message have
-                    // already been done above,
-                    // now fill in the other bits
-                    if (pMessageSizeBytes != NULL) {
-                        *pMessageSizeBytes = messageBytesRead;
-                    }
-                    if (pQos != NULL) {
-                        *pQos = qos;
-                    }
-                    if (pTopicNameType != NULL) {
-                        *pTopicNameType = topicNameType;
-                    }
-                    // Decrement only if the number of unread messages was 1, because
-                    // pContext->numUnreadMessages would be updated in UUMQTTC callback
-                    // handler after a successful read of a message. However, when
-                    // number of unread messages is 1, then, no URC is received against
-                    // the reading of that one message.
-                    if (pContext->numUnreadMessages == 1) {
-                        pContext->numUnreadMessages--;
-                    }
-                    if (truncated) {
-                        errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
-                    }
-                }
-            } else {
+            uAtClientLock(atHandle);
+            errorCode = readMessageLocked(pContext, atHandle, pTopicNameStr,
+                                          topicNameSizeBytes, pTopicNameType,
+                                          pMessage, pMessageSizeBytes, pQos);
+            if (uAtClientUnlock(atHandle) != 0) {
                 printErrorCodes(pInstance);
             }
         }
@@ -2077,6 +2331,66 @@ static int32_t readMessage(const uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+// Read as many messages as will fit into pMessages, MQTT style,
+// all under one AT client lock.
+static int32_t readMessages(const uCellPrivateInstance_t *pInstance,
+                            uCellMqttMessage_t *pMessages,
+                            size_t numMessages)
+{
+    int32_t errorCodeOrNum = 0;
+    volatile uCellMqttContext_t *pContext;
+    uAtClientHandle_t atHandle;
+    uCellMqttMessage_t *pMessage;
+    int32_t errorCode;
+
+    pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+    if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+                           U_CELL_PRIVATE_FEATURE_MQTT_SARA_R4_OLD_SYNTAX)) {
+        // Messages arrive by URC, one at a time, so no batching is possible
+        for (size_t x = 0; (x < numMessages) && (errorCodeOrNum == (int32_t) x); x++) {
+            pMessage = pMessages + x;
+            errorCode = readMessage(pInstance, pMessage->pTopicNameStr,
+                                    pMessage->topicNameSizeBytes, NULL,
+                                    pMessage->pMessage, &(pMessage->messageSizeBytes),
+                                    &(pMessage->qos));
+            if ((errorCode == 0) || (errorCode == (int32_t) U_ERROR_COMMON_TRUNCATED)) {
+                pMessage->errorCode = errorCode;
+                errorCodeOrNum++;
+            } else if (errorCodeOrNum == 0) {
+                errorCodeOrNum = errorCode;
+            }
+        }
+    } else {
+        // Note: the module can be asked to return all of its unread
+        // messages in one go (AT+UMQTTC=6 without the one-message flag),
+        // but the number returned cannot then be bounded by numMessages
+        // and any that did not fit would be lost, hence the command is
+        // repeated for one message at a time, without letting go of the
+        // AT client in between
+        atHandle = pInstance->atHandle;
+        uAtClientLock(atHandle);
+        for (size_t x = 0; (x < numMessages) && (errorCodeOrNum == (int32_t) x); x++) {
+            pMessage = pMessages + x;
+            errorCode = readMessageLocked(pContext, atHandle,
+                                          pMessage->pTopicNameStr,
+                                          pMessage->topicNameSizeBytes, NULL,
+                                          pMessage->pMessage,
+                                          &(pMessage->messageSizeBytes),
+                                          &(pMessage->qos));
+            if ((errorCode == 0) || (errorCode == (int32_t) U_ERROR_COMMON_TRUNCATED)) {
+                pMessage->errorCode = errorCode;
+                errorCodeOrNum++;
+            }
+        }
+        uAtClientUnlock(atHandle);
+        if (errorCodeOrNum == 0) {
+            errorCodeOrNum = (int32_t) U_ERROR_COMMON_EMPTY;
+        }
+    }
+
+    return errorCodeOrNum;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: WORKAROUND FOR LINKER ISSUE
  * -------------------------------------------------------------- */
@@ -2138,6 +2452,13 @@ int32_t uCellMqttInit(uDeviceHandle_t cellHandle, const char *pBrokerNameStr,
                     pContext->pUrcMessage = NULL;
                     pContext->numTries = U_CELL_MQTT_RETRIES_DEFAULT + 1;
                     pContext->mqttSn = mqttSn;
+                    pContext->publishOldest = 0;
+                    pContext->publishNumDone = 0;
+                    pContext->publishNumAwaiting = 0;
+                    pContext->publishWindow = U_CELL_MQTT_PUBLISH_WINDOW_DEFAULT;
+                    pContext->publishTimeoutMs = U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000;
+                    pContext->publishNumStale = 0;
+                    pContext->publishNextToken = 0;
                     pInstance->pMqttContext = pContext;
                     if (U_CELL_PRIVATE_MODULE_IS_SARA_R4(pInstance->pModule->moduleType)) {
                         // SARA-R4 requires a pUrcMessage as well
@@ -3180,6 +3501,7 @@ int32_t uCellMqttPublish(uDeviceHandle_t cellHandle,
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance = NULL;
     volatile uCellMqttContext_t *pContext;
+    bool resyncing;
 
     U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, &pInstance, &errorCode, true);
 
@@ -3189,8 +3511,14 @@ int32_t uCellMqttPublish(uDeviceHandle_t cellHandle,
         if (U_CELL_PRIVATE_HAS(pInstance->pModule,
                                U_CELL_PRIVATE_FEATURE_MQTT) &&
             !pContext->mqttSn) {
-            errorCode = publish(pInstance, pTopicNameStr, -1,
-                                pMessage, messageSizeBytes, qos, retain);
+            // A result could not be told apart from one for a message
+            // published with uCellMqttPublishAsync(), so wait for those
+            errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+            if ((publishAsyncUpdate(pInstance, &resyncing) == 0) && !resyncing) {
+                errorCode = publish(pInstance, pTopicNameStr, -1,
+                                    pMessage, messageSizeBytes, qos, retain,
+                                    NULL);
+            }
         }
     }
 
@@ -3199,6 +3527,123 @@ int32_t uCellMqttPublish(uDeviceHandle_t cellHandle,
     return errorCode;
 }
 
+// Publish an MQTT message without waiting for the result.
+int32_t uCellMqttPublishAsync(uDeviceHandle_t cellHandle,
+                              const char *pTopicNameStr,
+                              const char *pMessage,
+                              size_t messageSizeBytes,
+                              uCellMqttQos_t qos, bool retain,
+                              void (*pCallback) (int32_t, int32_t, void *),
+                              void *pCallbackParam)
+{
+    int32_t errorCodeOrToken = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance = NULL;
+    volatile uCellMqttContext_t *pContext;
+    uCellMqttPublishInFlight_t entry;
+    bool resyncing;
+
+    U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, &pInstance, &errorCodeOrToken, true);
+
+    if ((errorCodeOrToken == 0) && (pInstance != NULL)) {
+        errorCodeOrToken = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+        if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+                               U_CELL_PRIVATE_FEATURE_MQTT) &&
+            !pContext->mqttSn) {
+            // Make room for anything that has waited too long
+            errorCodeOrToken = (int32_t) U_ERROR_COMMON_BUSY;
+            if ((publishAsyncUpdate(pInstance, &resyncing) < pContext->publishWindow) &&
+                !resyncing) {
+                entry.token = pContext->publishNextToken;
+                entry.pCallback = pCallback;
+                entry.pCallbackParam = pCallbackParam;
+                errorCodeOrToken = publish(pInstance, pTopicNameStr, -1,
+                                           pMessage, messageSizeBytes, qos,
+                                           retain, &entry);
+                if (errorCodeOrToken == 0) {
+                    errorCodeOrToken = entry.token;
+                    if (pContext->publishNextToken < INT32_MAX) {
+                        pContext->publishNextToken++;
+                    } else {
+                        pContext->publishNextToken = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    U_CELL_MQTT_EXIT_FUNCTION();
+
+    return errorCodeOrToken;
+}
+
+// Set the publish window of uCellMqttPublishAsync().
+int32_t uCellMqttSetPublishWindow(uDeviceHandle_t cellHandle,
+                                  size_t windowSize)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance = NULL;
+    volatile uCellMqttContext_t *pContext;
+
+    U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, &pInstance, &errorCode, true);
+
+    if ((errorCode == 0) && (pInstance != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((windowSize > 0) &&
+            (windowSize <= U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM)) {
+            pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+            pContext->publishWindow = windowSize;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    U_CELL_MQTT_EXIT_FUNCTION();
+
+    return errorCode;
+}
+
+// Set how long a uCellMqttPublishAsync() message may await a result.
+int32_t uCellMqttSetPublishTimeout(uDeviceHandle_t cellHandle,
+                                   int32_t timeoutMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance = NULL;
+    volatile uCellMqttContext_t *pContext;
+
+    U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, &pInstance, &errorCode, true);
+
+    if ((errorCode == 0) && (pInstance != NULL)) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (timeoutMs > 0) {
+            pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+            pContext->publishTimeoutMs = timeoutMs;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    U_CELL_MQTT_EXIT_FUNCTION();
+
+    return errorCode;
+}
+
+// Get the number of outstanding uCellMqttPublishAsync() messages.
+int32_t uCellMqttGetPublishInFlight(uDeviceHandle_t cellHandle)
+{
+    int32_t errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance = NULL;
+    bool resyncing;
+
+    U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, &pInstance, &errorCodeOrNumber, true);
+
+    if ((errorCodeOrNumber == 0) && (pInstance != NULL)) {
+        errorCodeOrNumber = (int32_t) publishAsyncUpdate(pInstance, &resyncing);
+    }
+
+    U_CELL_MQTT_EXIT_FUNCTION();
+
+    return errorCodeOrNumber;
+}
+
 // Subscribe to an MQTT topic.
 int32_t uCellMqttSubscribe(uDeviceHandle_t cellHandle,
                            const char *pTopicFilterStr,
@@ -3281,6 +3726,40 @@ int32_t uCellMqttMessageRead(uDeviceHandle_t cellHandle,
     return errorCode;
 }
 
+// Read many MQTT messages.
+int32_t uCellMqttMessageReadBulk(uDeviceHandle_t cellHandle,
+                                 uCellMqttMessage_t *pMessages,
+                                 size_t numMessages)
+{
+    int32_t errorCodeOrNum = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance = NULL;
+    volatile uCellMqttContext_t *pContext;
+    bool valid;
+
+    U_CELL_MQTT_ENTRY_FUNCTION(cellHandle, &pInstance, &errorCodeOrNum, true);
+
+    if ((errorCodeOrNum == 0) && (pInstance != NULL)) {
+        errorCodeOrNum = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        valid = (pMessages != NULL) && (numMessages > 0);
+        for (size_t x = 0; valid && (x < numMessages); x++) {
+            valid = ((pMessages + x)->pTopicNameStr != NULL);
+        }
+        if (valid) {
+            errorCodeOrNum = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            pContext = (volatile uCellMqttContext_t *) pInstance->pMqttContext;
+            if (U_CELL_PRIVATE_HAS(pInstance->pModule,
+                                   U_CELL_PRIVATE_FEATURE_MQTT) &&
+                !pContext->mqttSn) {
+                errorCodeOrNum = readMessages(pInstance, pMessages, numMessages);
+            }
+        }
+    }
+
+    U_CELL_MQTT_EXIT_FUNCTION();
+
+    return errorCodeOrNum;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: MQTT-SN ONLY
  * -------------------------------------------------------------- */
@@ -3394,7 +3873,7 @@ int32_t uCellMqttSnPublish(uDeviceHandle_t cellHandle,
             if (topicNameType >= 0) {
                 errorCode = publish(pInstance, topicNameStr,
                                     topicNameType, pMessage,
-                                    messageSizeBytes, qos, retain);
+                                    messageSizeBytes, qos, retain, NULL);
             }
         }
     }
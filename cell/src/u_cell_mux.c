@@ -55,7 +55,8 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // memcpy()
+#include "stdlib.h"    // strtol()
+#include "string.h"    // memcpy(), strchr()
 #include "ctype.h"
 
 #include "u_cfg_sw.h"
@@ -337,6 +338,126 @@ static int32_t serialReadInnards(volatile uCellMuxPrivateTraffic_t *pTraffic,
     return totalRead;
 }
 
+// Return true if the given channel is the one that should transmit
+// next, see uCellMuxPrivateTxScheduleNext(); channels that have been
+// flow controlled off by the far end are not considered.
+// Note: pContext->txMutex must be locked before this is called.
+static bool txScheduleIsNext(uCellMuxPrivateContext_t *pContext,
+                             uCellMuxPrivateChannelContext_t *pChannelContext)
+{
+    uCellMuxPrivateChannelContext_t *pOther[U_CELL_MUX_MAX_CHANNELS];
+    uCellMuxPrivateTxSchedule_t *pSchedule[U_CELL_MUX_MAX_CHANNELS];
+    int32_t next;
+
+    for (size_t y = 0; y < U_CELL_MUX_MAX_CHANNELS; y++) {
+        pOther[y] = (uCellMuxPrivateChannelContext_t *)
+                    pUInterfaceContext(pContext->pDeviceSerial[y]);
+        pSchedule[y] = NULL;
+        if ((pOther[y] != NULL) && !pOther[y]->markedForDeletion &&
+            !pOther[y]->traffic.txIsFlowControlledOff) {
+            pSchedule[y] = &(pOther[y]->txSchedule);
+        }
+    }
+    next = uCellMuxPrivateTxScheduleNext(pSchedule, U_CELL_MUX_MAX_CHANNELS,
+                                         pContext->txVirtualTime);
+
+    return (next >= 0) && (pOther[next] == pChannelContext);
+}
+
+// Wait for the given channel's turn to transmit sizeBytes of encoded
+// CMUX frames, returning true when it has the UART or false on
+// timeout; the control channel is not scheduled, it always goes
+// immediately.  If this returns true then txScheduleRelease() must
+// be called once the frames have been sent.
+static bool txScheduleAcquire(uCellMuxPrivateChannelContext_t *pChannelContext,
+                              size_t sizeBytes, int32_t startTimeMs)
+{
+    bool acquired = false;
+    uCellMuxPrivateContext_t *pContext = pChannelContext->pContext;
+    uCellMuxPrivateTxSchedule_t *pTxSchedule = &(pChannelContext->txSchedule);
+    int32_t latencyMs;
+
+    if (pChannelContext->channel == U_CELL_MUX_PRIVATE_CHANNEL_ID_CONTROL) {
+        acquired = true;
+    } else {
+        U_PORT_MUTEX_LOCK(pContext->txMutex);
+        pTxSchedule->waiting = true;
+        pTxSchedule->waitStartTimeMs = uPortGetTickTimeMs();
+        U_PORT_MUTEX_UNLOCK(pContext->txMutex);
+        while (!acquired &&
+               (uPortGetTickTimeMs() - startTimeMs < U_CELL_MUX_WRITE_TIMEOUT_MS)) {
+            U_PORT_MUTEX_LOCK(pContext->txMutex);
+            if (!pContext->txBusy && txScheduleIsNext(pContext, pChannelContext)) {
+                pContext->txBusy = true;
+                uCellMuxPrivateTxScheduleStart(pTxSchedule, &(pContext->txVirtualTime),
+                                               sizeBytes);
+                latencyMs = uPortGetTickTimeMs() - pTxSchedule->waitStartTimeMs;
+                pTxSchedule->latencyTotalMs += latencyMs;
+                if (latencyMs > pTxSchedule->latencyMaxMs) {
+                    pTxSchedule->latencyMaxMs = latencyMs;
+                }
+                acquired = true;
+            }
+            U_PORT_MUTEX_UNLOCK(pContext->txMutex);
+            if (!acquired) {
+                uPortTaskBlock(U_CELL_MUX_PRIVATE_TX_SCHEDULE_POLL_MS);
+            }
+        }
+        U_PORT_MUTEX_LOCK(pContext->txMutex);
+        pTxSchedule->waiting = false;
+        U_PORT_MUTEX_UNLOCK(pContext->txMutex);
+    }
+
+    return acquired;
+}
+
+// Give back the UART after txScheduleAcquire(), updating the
+// statistics with the number of user bytes that were sent.
+static void txScheduleRelease(uCellMuxPrivateChannelContext_t *pChannelContext,
+                              size_t sentBytes)
+{
+    uCellMuxPrivateContext_t *pContext = pChannelContext->pContext;
+    uCellMuxPrivateTxSchedule_t *pTxSchedule = &(pChannelContext->txSchedule);
+
+    U_PORT_MUTEX_LOCK(pContext->txMutex);
+    if (pChannelContext->channel != U_CELL_MUX_PRIVATE_CHANNEL_ID_CONTROL) {
+        pContext->txBusy = false;
+    }
+    pTxSchedule->sentBytes += sentBytes;
+    pTxSchedule->numBatches++;
+    if (pTxSchedule->queuedBytes > sentBytes) {
+        pTxSchedule->queuedBytes -= sentBytes;
+    } else {
+        pTxSchedule->queuedBytes = 0;
+    }
+    U_PORT_MUTEX_UNLOCK(pContext->txMutex);
+}
+
+// Given a buffer of CMUX frames encoded by uCellMuxPrivateEncodeBatch()
+// from pFrames, return true if offset falls between two frames, i.e.
+// the UART could be given to another channel without breaking a frame,
+// setting pNumFrames to the number of whole frames before offset.
+static bool txIsFrameBoundary(const uCellMuxPrivateFrame_t *pFrames,
+                              size_t numFrames, size_t offset,
+                              size_t *pNumFrames)
+{
+    size_t frameOffset = 0;
+    size_t x = 0;
+
+    while ((x < numFrames) && (frameOffset < offset)) {
+        frameOffset += pFrames[x].informationLengthBytes +
+                       U_CELL_MUX_PRIVATE_FRAME_MIN_LENGTH_BYTES;
+        if (pFrames[x].informationLengthBytes > 0x7F) {
+            // Two length bytes
+            frameOffset++;
+        }
+        x++;
+    }
+    *pNumFrames = x;
+
+    return (frameOffset == offset);
+}
+
 // The innards of serialWrite(), brough out separately here so that
 // controlChannelInformation() can respond to MSC commands.
 static int32_t serialWriteInnards(struct uDeviceSerial_t *pDeviceSerial,
@@ -347,22 +468,39 @@ static int32_t serialWriteInnards(struct uDeviceSerial_t *pDeviceSerial,
                                                        pUInterfaceContext(pDeviceSerial);
     uCellPrivateInstance_t *pInstance = pChannelContext->pContext->pInstance;
     char *pBufferEncoded;
-    size_t chunkSize = U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES;
-    size_t thisChunkSize;
+    uCellMuxPrivateFrame_t frames[U_CELL_MUX_PRIVATE_TX_BATCH_MAX_FRAMES];
+    size_t numFrames;
+    size_t chunkSize = pChannelContext->pContext->informationLengthMaxBytes;
+    size_t bufferEncodedLength;
+    size_t thisBatchSize;
+    size_t numFramesSent;
+    size_t numFramesAtBoundary;
+    size_t sentSize;
     size_t sizeWritten = 0;
     int32_t thisLengthWritten;
     size_t lengthWritten;
     int32_t startTimeMs;
     bool activityPinIsSet = false;
+    bool isScheduled;
 
-    // Encode the CMUX frame in chunks of the maximum information
-    // length using a temporary buffer
+    // Encode the CMUX frames in chunks of the maximum information
+    // length, up to U_CELL_MUX_PRIVATE_TX_BATCH_MAX_FRAMES of them
+    // at a time, into a temporary buffer so that each batch of
+    // frames can go to the UART in a single write
     if (chunkSize > sizeBytes) {
         chunkSize = sizeBytes;
     }
-    pBufferEncoded = (char *) pUPortMalloc(chunkSize + U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES);
+    numFrames = U_CELL_MUX_PRIVATE_TX_BATCH_MAX_FRAMES;
+    if ((chunkSize > 0) && (numFrames > (sizeBytes + chunkSize - 1) / chunkSize)) {
+        numFrames = (sizeBytes + chunkSize - 1) / chunkSize;
+    }
+    bufferEncodedLength = (chunkSize + U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES) * numFrames;
+    pBufferEncoded = (char *) pUPortMalloc(bufferEncodedLength);
     if (pBufferEncoded != NULL) {
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        U_PORT_MUTEX_LOCK(pChannelContext->pContext->txMutex);
+        pChannelContext->txSchedule.queuedBytes += sizeBytes;
+        U_PORT_MUTEX_UNLOCK(pChannelContext->pContext->txMutex);
         if (pInstance->pinDtrPowerSaving >= 0) {
             activityPinIsSet = true;
             uCellPrivateSetPinDtr(pInstance, true);
@@ -370,18 +508,30 @@ static int32_t serialWriteInnards(struct uDeviceSerial_t *pDeviceSerial,
         startTimeMs = uPortGetTickTimeMs();
         while ((sizeWritten < sizeBytes) && (sizeOrErrorCode >= 0) &&
                (uPortGetTickTimeMs() - startTimeMs < U_CELL_MUX_WRITE_TIMEOUT_MS)) {
-            // Encode a chunk as UIH
-            thisChunkSize = sizeBytes - sizeWritten;
-            if (thisChunkSize > U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES) {
-                thisChunkSize = U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES;
+            // Set up a batch of chunks to be encoded as UIH
+            thisBatchSize = 0;
+            for (numFrames = 0; (numFrames < sizeof(frames) / sizeof(frames[0])) &&
+                 (sizeWritten + thisBatchSize < sizeBytes); numFrames++) {
+                frames[numFrames].address = pChannelContext->channel;
+                frames[numFrames].type = U_CELL_MUX_PRIVATE_FRAME_TYPE_UIH;
+                frames[numFrames].pollFinal = false;
+                frames[numFrames].pInformation = ((const char *) pBuffer) + sizeWritten +
+                                                 thisBatchSize;
+                frames[numFrames].informationLengthBytes = sizeBytes - sizeWritten - thisBatchSize;
+                if (frames[numFrames].informationLengthBytes > chunkSize) {
+                    frames[numFrames].informationLengthBytes = chunkSize;
+                }
+                thisBatchSize += frames[numFrames].informationLengthBytes;
             }
-            sizeOrErrorCode = uCellMuxPrivateEncode(pChannelContext->channel,
-                                                    U_CELL_MUX_PRIVATE_FRAME_TYPE_UIH,
-                                                    false, ((const char *) pBuffer) + sizeWritten,
-                                                    thisChunkSize, pBufferEncoded);
+            sizeOrErrorCode = uCellMuxPrivateEncodeBatch(frames, numFrames, pBufferEncoded,
+                                                         bufferEncodedLength, &numFrames);
             if (sizeOrErrorCode >= 0) {
+                // Wait for our turn at the UART
+                isScheduled = txScheduleAcquire(pChannelContext, sizeOrErrorCode, startTimeMs);
                 lengthWritten = 0;
-                while ((sizeOrErrorCode >= 0) && (lengthWritten < (size_t) sizeOrErrorCode) &&
+                numFramesSent = 0;
+                while (isScheduled && (sizeOrErrorCode >= 0) &&
+                       (lengthWritten < (size_t) sizeOrErrorCode) &&
                        (uPortGetTickTimeMs() - startTimeMs < U_CELL_MUX_WRITE_TIMEOUT_MS)) {
                     if (!pChannelContext->traffic.txIsFlowControlledOff) {
                         // Send the data
@@ -393,7 +543,23 @@ static int32_t serialWriteInnards(struct uDeviceSerial_t *pDeviceSerial,
                         } else {
                             sizeOrErrorCode = thisLengthWritten;
                         }
+                    } else if (txIsFrameBoundary(frames, numFrames, lengthWritten,
+                                                 &numFramesAtBoundary)) {
+                        // Flow controlled off between frames: rather than
+                        // sit on the UART, hand it to the other channels
+                        // and wait our turn again, which won't come until
+                        // the far end lets us send; the batch has already
+                        // been charged for, hence zero size
+                        sentSize = 0;
+                        for (size_t x = numFramesSent; x < numFramesAtBoundary; x++) {
+                            sentSize += frames[x].informationLengthBytes;
+                        }
+                        numFramesSent = numFramesAtBoundary;
+                        sizeWritten += sentSize;
+                        txScheduleRelease(pChannelContext, sentSize);
+                        isScheduled = txScheduleAcquire(pChannelContext, 0, startTimeMs);
                     } else {
+                        // Part way through a frame, which must be finished
                         uPortTaskBlock(10);
                     }
                 }
@@ -415,11 +581,27 @@ static int32_t serialWriteInnards(struct uDeviceSerial_t *pDeviceSerial,
                     uPortLog(".\n");
                 }
 #endif
-                // Keep track of the amount of user information written
-                sizeWritten += thisChunkSize;
+                if (isScheduled) {
+                    // Keep track of the amount of user information written
+                    sentSize = 0;
+                    for (size_t x = numFramesSent; x < numFrames; x++) {
+                        sentSize += frames[x].informationLengthBytes;
+                    }
+                    sizeWritten += sentSize;
+                    txScheduleRelease(pChannelContext, sentSize);
+                }
             }
         }
 
+        // Anything not sent is no longer queued
+        U_PORT_MUTEX_LOCK(pChannelContext->pContext->txMutex);
+        if (pChannelContext->txSchedule.queuedBytes > sizeBytes - sizeWritten) {
+            pChannelContext->txSchedule.queuedBytes -= sizeBytes - sizeWritten;
+        } else {
+            pChannelContext->txSchedule.queuedBytes = 0;
+        }
+        U_PORT_MUTEX_UNLOCK(pChannelContext->pContext->txMutex);
+
         if (activityPinIsSet) {
             uCellPrivateSetPinDtr(pInstance, false);
         }
@@ -1022,6 +1204,182 @@ static uint8_t getChannelGnss(const uCellPrivateInstance_t *pInstance)
     return channel;
 }
 
+// Get the receive buffer length for a user channel, four times the
+// maximum information field length in use, for the reasons given in
+// the description of U_CELL_MUX_PRIVATE_VIRTUAL_SERIAL_BUFFER_LENGTH_BYTES.
+static size_t getVirtualSerialBufferLength(const uCellMuxPrivateContext_t *pContext)
+{
+    size_t lengthBytes = U_CELL_MUX_PRIVATE_VIRTUAL_SERIAL_BUFFER_LENGTH_BYTES;
+
+    if (pContext->informationLengthMaxBytes * 4 > lengthBytes) {
+        lengthBytes = pContext->informationLengthMaxBytes * 4;
+    }
+
+    return lengthBytes;
+}
+
+// Make sure that the ring buffer and scratch buffer of the context
+// are big enough for the given maximum information field length,
+// (re)allocating them if not.  Must only be called while CMUX is
+// not running.
+static int32_t ensureBuffers(uCellMuxPrivateContext_t *pContext,
+                             size_t informationLengthMaxBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    size_t linearBufferSizeBytes = U_CELL_MUX_PRIVATE_BUFFER_LENGTH_BYTES;
+    size_t scratchSizeBytes = U_CELL_MUX_PRIVATE_SCRATCH_BUFFER_LENGTH_BYTES;
+    char *pLinearBuffer;
+    char *pScratch;
+
+    // Enough for one maximum-length frame on each channel
+    if ((informationLengthMaxBytes + U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES) *
+        U_CELL_MUX_MAX_CHANNELS > linearBufferSizeBytes) {
+        linearBufferSizeBytes = (informationLengthMaxBytes +
+                                 U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES) *
+                                U_CELL_MUX_MAX_CHANNELS;
+    }
+    // +1 since we lose one byte in the ring buffer
+    linearBufferSizeBytes++;
+
+    if ((pContext->pLinearBuffer == NULL) ||
+        (pContext->linearBufferSizeBytes < linearBufferSizeBytes) ||
+        (pContext->scratchSizeBytes < scratchSizeBytes)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pLinearBuffer = (char *) pUPortMalloc(linearBufferSizeBytes);
+        pScratch = (char *) pUPortMalloc(scratchSizeBytes);
+        if ((pLinearBuffer != NULL) && (pScratch != NULL)) {
+            if (pContext->pLinearBuffer != NULL) {
+                // Out with the old
+                uRingBufferGiveReadHandle(&(pContext->ringBuffer), pContext->readHandle);
+                uRingBufferDelete(&(pContext->ringBuffer));
+                uPortFree(pContext->pLinearBuffer);
+                pContext->pLinearBuffer = NULL;
+                uPortFree(pContext->pScratch);
+                pContext->pScratch = NULL;
+            }
+            if (uRingBufferCreateWithReadHandle(&(pContext->ringBuffer),
+                                                pLinearBuffer,
+                                                linearBufferSizeBytes, 1) == 0) {
+                uRingBufferSetReadRequiresHandle(&(pContext->ringBuffer), true);
+                pContext->readHandle = uRingBufferTakeReadHandle(&(pContext->ringBuffer));
+                pContext->pLinearBuffer = pLinearBuffer;
+                pContext->linearBufferSizeBytes = linearBufferSizeBytes;
+                pContext->pScratch = pScratch;
+                pContext->scratchSizeBytes = scratchSizeBytes;
+                pLinearBuffer = NULL;
+                pScratch = NULL;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+        // Clean up anything that was not used
+        uPortFree(pLinearBuffer);
+        uPortFree(pScratch);
+    }
+
+    return errorCode;
+}
+
+// Get the maximum information field length (N1) the module supports
+// from the response to AT+CMUX=?, which is of the form:
+//
+// +CMUX: (0),(0),(1-5),(1-1509),(1-255),(0-100),(2-255),(1-255),(1-7)
+//
+// Returns zero if the value could not be determined.
+static size_t getInformationLengthMaxModule(uAtClientHandle_t atHandle)
+{
+    size_t lengthBytes = 0;
+    char buffer[16];
+    const char *pTmp = NULL;
+    int32_t x;
+
+    uAtClientCommandStart(atHandle, "AT+CMUX=?");
+    uAtClientCommandStop(atHandle);
+    uAtClientResponseStart(atHandle, "+CMUX:");
+    // Skip mode, subset and port speed
+    uAtClientSkipParameters(atHandle, 3);
+    x = uAtClientReadString(atHandle, buffer, sizeof(buffer), false);
+    uAtClientResponseStop(atHandle);
+    if ((uAtClientErrorGet(atHandle) == 0) && (x > 0)) {
+        // Take the upper end of the range or, if there
+        // is no range, the single value
+        pTmp = strchr(buffer, '-');
+        if (pTmp == NULL) {
+            pTmp = strchr(buffer, '(');
+        }
+    }
+    if (pTmp != NULL) {
+        x = strtol(pTmp + 1, NULL, 10);
+        if (x > 0) {
+            lengthBytes = (size_t) x;
+        }
+    }
+    // Don't let a module that doesn't support the test
+    // command prevent us from continuing
+    uAtClientClearError(atHandle);
+
+    return lengthBytes;
+}
+
+// Send AT+CMUX to put the module into CMUX mode, with the given
+// maximum information field length.
+static int32_t sendCmux(uAtClientHandle_t atHandle, size_t informationLengthMaxBytes)
+{
+    uAtClientCommandStart(atHandle, "AT+CMUX=");
+    // Only basic mode and only UIH frames are supported by any
+    // of the cellular modules we support
+    uAtClientWriteInt(atHandle, 0);
+    uAtClientWriteInt(atHandle, 0);
+    // As advised in the u-blox multiplexer document, port
+    // speed is left empty for max compatibility
+    uAtClientWriteString(atHandle, "", false);
+    // Set the information field length
+    uAtClientWriteInt(atHandle, (int32_t) informationLengthMaxBytes);
+    // Everything else is left at defaults for max compatibility
+    uAtClientCommandStopReadResponse(atHandle);
+    // Not unlocking here, just check for errors
+    return uAtClientErrorGet(atHandle);
+}
+
+// Create the CMUX context for a cellular instance, if there isn't one.
+static uCellMuxPrivateContext_t *pCreateContext(uCellPrivateInstance_t *pInstance)
+{
+    uCellMuxPrivateContext_t *pContext;
+
+    if (pInstance->pMuxContext == NULL) {
+        // Allocate memory for our CMUX context; this will be
+        // deallocated only when the cellular instance is removed
+        pInstance->pMuxContext = pUPortMalloc(sizeof(uCellMuxPrivateContext_t));
+        if (pInstance->pMuxContext != NULL) {
+            pContext = (uCellMuxPrivateContext_t *) pInstance->pMuxContext;
+            memset(pContext, 0, sizeof(*pContext));
+            // The ring buffer is created when CMUX is enabled, once
+            // we know the maximum information field length
+            pContext->readHandle = -1;
+            // To save memory, we use a single event queue for all callbacks
+            // from the CMUX channels, re-using the AT client sizes
+            pContext->eventQueueHandle = uPortEventQueueOpen(eventHandler, "cmuxCallbacks",
+                                                             sizeof(uCellMuxEvenTrampoline_t),
+                                                             U_CELL_MUX_CALLBACK_TASK_STACK_SIZE_BYTES,
+                                                             U_CELL_MUX_CALLBACK_TASK_PRIORITY,
+                                                             U_CELL_MUX_CALLBACK_QUEUE_LENGTH);
+            if (pContext->eventQueueHandle >= 0) {
+                if (uPortMutexCreate(&(pContext->txMutex)) != 0) {
+                    // Clean up on error
+                    uPortEventQueueClose(pContext->eventQueueHandle);
+                    uPortFree(pInstance->pMuxContext);
+                    pInstance->pMuxContext = NULL;
+                }
+            } else {
+                // Clean up on error
+                uPortFree(pInstance->pMuxContext);
+                pInstance->pMuxContext = NULL;
+            }
+        }
+    }
+
+    return (uCellMuxPrivateContext_t *) pInstance->pMuxContext;
+}
+
 // Open a CMUX channel.
 static int32_t openChannel(uCellMuxPrivateContext_t *pContext,
                            uint8_t channel, size_t receiveBufferSizeBytes)
@@ -1077,6 +1435,10 @@ static int32_t openChannel(uCellMuxPrivateContext_t *pContext,
                 pChannelContext->markedForDeletion = false;
                 memset(&(pChannelContext->traffic), 0, sizeof(pChannelContext->traffic));
                 memset(&(pChannelContext->eventCallback), 0, sizeof(pChannelContext->eventCallback));
+                memset(&(pChannelContext->txSchedule), 0, sizeof(pChannelContext->txSchedule));
+                pChannelContext->txSchedule.priority = U_CELL_MUX_TX_PRIORITY_DEFAULT;
+                pChannelContext->txSchedule.weight = U_CELL_MUX_TX_WEIGHT_DEFAULT;
+                pChannelContext->txSchedule.virtualFinish = pContext->txVirtualTime;
                 errorCode = pDeviceSerial->open(pDeviceSerial, NULL, receiveBufferSizeBytes);
                 // Don't clean up on error here - the serial device will be re-used if
                 // the user tries again and this ensures thread-safety.
@@ -1185,8 +1547,8 @@ static void cmuxDecodeControl(uCellMuxPrivateContext_t *pContext)
         // into the information buffer
         parserContext.type = U_CELL_MUX_PRIVATE_FRAME_TYPE_NONE;
         parserContext.address = U_CELL_MUX_PRIVATE_CHANNEL_ID_CONTROL;
-        parserContext.pInformation = pContext->scratch;
-        parserContext.informationLengthBytes = sizeof(pContext->scratch);
+        parserContext.pInformation = pContext->pScratch;
+        parserContext.informationLengthBytes = pContext->scratchSizeBytes;
         while ((parserContext.bufferIndex < parserContext.bufferSize) &&
                (errorCode != (int32_t) U_ERROR_COMMON_TIMEOUT)) {
             errorCode = uCellMuxPrivateParseCmux(NULL, &parserContext);
@@ -1210,10 +1572,10 @@ static void cmuxDecodeControl(uCellMuxPrivateContext_t *pContext)
                         //fall-through
                         case U_CELL_MUX_PRIVATE_FRAME_TYPE_UI:
                             // This must be MSC, the flow control stuff
-                            if (parserContext.informationLengthBytes > sizeof(pContext->scratch)) {
-                                parserContext.informationLengthBytes = sizeof(pContext->scratch);
+                            if (parserContext.informationLengthBytes > pContext->scratchSizeBytes) {
+                                parserContext.informationLengthBytes = pContext->scratchSizeBytes;
                             }
-                            controlChannelInformation(pContext, (uint8_t *) pContext->scratch,
+                            controlChannelInformation(pContext, (uint8_t *) pContext->pScratch,
                                                       parserContext.informationLengthBytes);
                             break;
                         case U_CELL_MUX_PRIVATE_FRAME_TYPE_UA_RESPONSE:
@@ -1251,6 +1613,56 @@ static void cmuxDecodeControl(uCellMuxPrivateContext_t *pContext)
     }
 }
 
+// Copy the information field of a CMUX frame, which begins offset
+// bytes from the read pointer of our handle on the ring buffer, directly
+// into the receive buffer of a channel, i.e. without first copying it
+// to scratch; the channel's receive buffer must have room for
+// lengthBytes.
+static void rxInformationToChannel(uCellMuxPrivateContext_t *pContext,
+                                   uCellMuxPrivateTraffic_t *pTraffic,
+                                   size_t offset, size_t lengthBytes)
+{
+    const char *pSpan = NULL;
+    size_t spanLength = 0;
+    size_t x;
+
+    if (lengthBytes > 0) {
+        spanLength = uRingBufferPeekSpanHandle(&(pContext->ringBuffer),
+                                               pContext->readHandle,
+                                               &pSpan, offset);
+    }
+    while (spanLength > 0) {
+        if (spanLength > lengthBytes) {
+            spanLength = lengthBytes;
+        }
+        offset += spanLength;
+        lengthBytes -= spanLength;
+        while (spanLength > 0) {
+            // Write up to the end of the channel's buffer, wrapping as necessary
+            x = pTraffic->pRxBufferStart + pTraffic->rxBufferSizeBytes - pTraffic->pRxBufferWrite;
+            if (x > spanLength) {
+                x = spanLength;
+            }
+            memcpy(pTraffic->pRxBufferWrite, pSpan, x);
+            pSpan += x;
+            spanLength -= x;
+            // Moving the write pointer on makes the data available to the reader
+            if (pTraffic->pRxBufferWrite + x >= pTraffic->pRxBufferStart +
+                pTraffic->rxBufferSizeBytes) {
+                pTraffic->pRxBufferWrite = pTraffic->pRxBufferStart;
+            } else {
+                pTraffic->pRxBufferWrite += x;
+            }
+        }
+        // The information field may wrap around the end of the ring buffer
+        if (lengthBytes > 0) {
+            spanLength = uRingBufferPeekSpanHandle(&(pContext->ringBuffer),
+                                                   pContext->readHandle,
+                                                   &pSpan, offset);
+        }
+    }
+}
+
 // Decode received CMUX frames, just the non-control-channel ones, from
 // the ring buffer.
 static void cmuxDecode(uCellMuxPrivateContext_t *pContext, uint32_t eventBitMap)
@@ -1261,12 +1673,10 @@ static void cmuxDecode(uCellMuxPrivateContext_t *pContext, uint32_t eventBitMap)
     uCellMuxPrivateChannelContext_t *pChannelContext;
     uCellMuxPrivateTraffic_t *pTraffic;
     U_RING_BUFFER_PARSER_f parserList[] = {uCellMuxPrivateParseCmux, NULL};
-    size_t offset;
     bool stalled = false;
     size_t bufferLength;
     size_t discardLength;
     size_t x;
-    const char *pRxBufferRead;
 
     if (pContext != NULL) {
         // Try to decode new CMUX messages from the ring buffer
@@ -1311,22 +1721,11 @@ static void cmuxDecode(uCellMuxPrivateContext_t *pContext, uint32_t eventBitMap)
                                     // We have user information, work out how much we can cope with
                                     // -1 below to avoid pointer wrap
                                     bufferLength  = pTraffic->rxBufferSizeBytes - serialGetReceiveSizeInnards(pDeviceSerial) - 1;
-                                    if (bufferLength > sizeof(pContext->scratch)) {
-                                        bufferLength = sizeof(pContext->scratch);
-                                    }
                                     if (parserContext.informationLengthBytes > bufferLength) {
                                         discardLength = parserContext.informationLengthBytes - bufferLength;
                                         parserContext.informationLengthBytes = bufferLength;
                                     }
                                     if ((discardLength == 0) || pTraffic->discardOnOverflow) {
-                                        // Re-parse the buffer to actually get the information field
-                                        parserContext.pInformation = pContext->scratch;
-                                        uRingBufferParseHandle(&(pContext->ringBuffer),
-                                                               pContext->readHandle,
-                                                               parserList, &parserContext);
-                                        if (parserContext.informationLengthBytes > bufferLength) {
-                                            parserContext.informationLengthBytes = bufferLength;
-                                        }
 #ifdef U_CELL_MUX_ENABLE_DEBUG
                                         uPortLog("U_CELL_CMUX_%d: writing %d byte(s) of decode I-field, buffer %d/%d.\n",
                                                  pChannelContext->channel,
@@ -1334,51 +1733,11 @@ static void cmuxDecode(uCellMuxPrivateContext_t *pContext, uint32_t eventBitMap)
                                                  serialGetReceiveSizeInnards(pDeviceSerial),
                                                  pTraffic->rxBufferSizeBytes);
 #endif
-                                        //  Move the user's information-field bytes into the main buffer
-                                        pRxBufferRead = pTraffic->pRxBufferRead;
-                                        if (pTraffic->pRxBufferWrite >= pRxBufferRead) {
-                                            // Write pointer is equal to or ahead of read,
-                                            // start by adding up to the end of the buffer
-                                            offset = pTraffic->pRxBufferStart +
-                                                     pTraffic->rxBufferSizeBytes - pTraffic->pRxBufferWrite;
-                                            if (offset > parserContext.informationLengthBytes) {
-                                                offset = parserContext.informationLengthBytes;
-                                            }
-                                            memcpy(pTraffic->pRxBufferWrite, pContext->scratch, offset);
-                                            parserContext.informationLengthBytes -= offset;
-                                            // Move the write pointer on, wrapping as necessary
-                                            pTraffic->pRxBufferWrite += offset;
-                                            if (pTraffic->pRxBufferWrite >= pTraffic->pRxBufferStart +
-                                                pTraffic->rxBufferSizeBytes) {
-                                                pTraffic->pRxBufferWrite = pTraffic->pRxBufferStart;
-                                            }
-                                            // If there is still stuff to write, continue writing
-                                            // up to just before the read pointer
-                                            if (parserContext.informationLengthBytes > 0) {
-                                                x = pRxBufferRead - pTraffic->pRxBufferWrite;
-                                                if (x > 0) {
-                                                    x--;
-                                                }
-                                                if (x > parserContext.informationLengthBytes) {
-                                                    x = parserContext.informationLengthBytes;
-                                                }
-                                                memcpy(pTraffic->pRxBufferWrite, pContext->scratch + offset, x);
-                                                pTraffic->pRxBufferWrite += x;
-                                            }
-                                        } else {
-                                            // Write pointer is behind read, just write as much as we can
-                                            x = pRxBufferRead - pTraffic->pRxBufferWrite;
-                                            if (x > parserContext.informationLengthBytes) {
-                                                x = parserContext.informationLengthBytes;
-                                            }
-                                            memcpy(pTraffic->pRxBufferWrite, pContext->scratch, x);
-                                            pTraffic->pRxBufferWrite += x;
-                                        }
-                                        // Wrap the write pointer if necessary
-                                        if (pTraffic->pRxBufferWrite >= pTraffic->pRxBufferStart +
-                                            pTraffic->rxBufferSizeBytes) {
-                                            pTraffic->pRxBufferWrite = pTraffic->pRxBufferStart;
-                                        }
+                                        // Move the user's information-field bytes straight
+                                        // from the ring buffer into the channel's buffer
+                                        rxInformationToChannel(pContext, pTraffic,
+                                                               parserContext.informationOffset,
+                                                               parserContext.informationLengthBytes);
                                         // Having decoded what we can, do any discarding
                                         if (discardLength > 0) {
                                             uRingBufferReadHandle(&(pContext->ringBuffer), pContext->readHandle,
@@ -1507,7 +1866,7 @@ static void cmuxReceiveCallback(int32_t streamHandle, uint32_t eventBitMap,
                          pContext->holdingBufferIndex,
                          sizeof(pContext->holdingBuffer),
                          uRingBufferDataSizeHandle(&(pContext->ringBuffer), pContext->readHandle),
-                         sizeof(pContext->linearBuffer) - 1);
+                         pContext->linearBufferSizeBytes - 1);
 #endif
 
                 // Decode control and then data
@@ -1551,6 +1910,8 @@ int32_t uCellMuxEnable(uDeviceHandle_t cellHandle)
     uDeviceSerial_t *pDeviceSerial;
     int32_t cmeeMode = 2;
     char tempBuffer[32];
+    size_t informationLengthMaxBytes;
+    size_t x;
 
     if (gUCellPrivateMutex != NULL) {
 
@@ -1563,44 +1924,9 @@ int32_t uCellMuxEnable(uDeviceHandle_t cellHandle)
             if (U_CELL_PRIVATE_HAS(pInstance->pModule, U_CELL_PRIVATE_FEATURE_CMUX)) {
                 errorCode = (int32_t) U_CELL_ERROR_TEMPORARY_FAILURE;
                 if (pInstance->pSecurityC2cContext == NULL) {
-                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-                    if (pInstance->pMuxContext == NULL) {
-                        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-                        // Allocate memory for our CMUX context; this will be
-                        // deallocated only when the cellular instance is removed
-                        pInstance->pMuxContext = pUPortMalloc(sizeof(uCellMuxPrivateContext_t));
-                        if (pInstance->pMuxContext != NULL) {
-                            pContext = (uCellMuxPrivateContext_t *) pInstance->pMuxContext;
-                            memset(pContext, 0, sizeof(*pContext));
-                            // To save memory, we use a single event queue for all callbacks
-                            // from the CMUX channels, re-using the AT client sizes
-                            pContext->eventQueueHandle = uPortEventQueueOpen(eventHandler,
-                                                                             "cmuxCallbacks",
-                                                                             sizeof(uCellMuxEvenTrampoline_t),
-                                                                             U_CELL_MUX_CALLBACK_TASK_STACK_SIZE_BYTES,
-                                                                             U_CELL_MUX_CALLBACK_TASK_PRIORITY,
-                                                                             U_CELL_MUX_CALLBACK_QUEUE_LENGTH);
-                            if (pContext->eventQueueHandle >= 0) {
-                                if (uRingBufferCreateWithReadHandle(&(pContext->ringBuffer),
-                                                                    pContext->linearBuffer,
-                                                                    sizeof(pContext->linearBuffer), 1) == 0) {
-                                    uRingBufferSetReadRequiresHandle(&(pContext->ringBuffer), true);
-                                    pContext->readHandle = uRingBufferTakeReadHandle(&(pContext->ringBuffer));
-                                } else {
-                                    // Clean up on error
-                                    uPortEventQueueClose(pContext->eventQueueHandle);
-                                    uPortFree(pInstance->pMuxContext);
-                                    pInstance->pMuxContext = NULL;
-                                }
-                            } else {
-                                // Clean up on error
-                                uPortFree(pInstance->pMuxContext);
-                                pInstance->pMuxContext = NULL;
-                            }
-                        }
-                    }
-                    if (pInstance->pMuxContext != NULL) {
-                        pContext = (uCellMuxPrivateContext_t *) pInstance->pMuxContext;
+                    errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                    pContext = pCreateContext(pInstance);
+                    if (pContext != NULL) {
                         errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                         if (pContext->savedAtHandle == NULL) {
                             // Initialise the other parts of [an existing] context
@@ -1610,24 +1936,36 @@ int32_t uCellMuxEnable(uDeviceHandle_t cellHandle)
                             // Initiate CMUX
                             atHandle = pInstance->atHandle;
                             uAtClientLock(atHandle);
-                            streamHandle = uAtClientStreamGet(atHandle, &streamType);
-                            uRingBufferFlushHandle(&(pContext->ringBuffer), pContext->readHandle);
-                            pContext->underlyingStreamHandle = streamHandle;
-                            uAtClientCommandStart(atHandle, "AT+CMUX=");
-                            // Only basic mode and only UIH frames are supported by any
-                            // of the cellular modules we support
-                            uAtClientWriteInt(atHandle, 0);
-                            uAtClientWriteInt(atHandle, 0);
-                            // As advised in the u-blox multiplexer document, port
-                            // speed is left empty for max compatibility
-                            uAtClientWriteString(atHandle, "", false);
-                            // Set the information field length
-                            uAtClientWriteInt(atHandle,
-                                              U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES);
-                            // Everything else is left at defaults for max compatibility
-                            uAtClientCommandStopReadResponse(atHandle);
-                            // Not unlocking here, just check for errors
-                            errorCode = uAtClientErrorGet(atHandle);
+                            // Work out the information field length to ask for,
+                            // limiting any non-default request to what the
+                            // module says it can do
+                            informationLengthMaxBytes = U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES;
+                            if ((pContext->informationLengthMaxRequestedBytes > 0) &&
+                                (pContext->informationLengthMaxRequestedBytes !=
+                                 informationLengthMaxBytes)) {
+                                informationLengthMaxBytes = pContext->informationLengthMaxRequestedBytes;
+                                x = getInformationLengthMaxModule(atHandle);
+                                if ((x > 0) && (informationLengthMaxBytes > x)) {
+                                    informationLengthMaxBytes = x;
+                                }
+                            }
+                            errorCode = ensureBuffers(pContext, informationLengthMaxBytes);
+                            if (errorCode == 0) {
+                                streamHandle = uAtClientStreamGet(atHandle, &streamType);
+                                uRingBufferFlushHandle(&(pContext->ringBuffer), pContext->readHandle);
+                                pContext->underlyingStreamHandle = streamHandle;
+                                errorCode = sendCmux(atHandle, informationLengthMaxBytes);
+                                if ((errorCode < 0) &&
+                                    (informationLengthMaxBytes != U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES)) {
+                                    // Module didn't like that, try again with the
+                                    // default, for which the buffers are already
+                                    // big enough
+                                    uAtClientClearError(atHandle);
+                                    informationLengthMaxBytes = U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES;
+                                    errorCode = sendCmux(atHandle, informationLengthMaxBytes);
+                                }
+                                pContext->informationLengthMaxBytes = informationLengthMaxBytes;
+                            }
                             if (errorCode == 0) {
                                 // Leave the AT client locked to stop it reacting to stuff coming
                                 // back over the UART, which will shortly become the MUX
@@ -1650,7 +1988,7 @@ int32_t uCellMuxEnable(uDeviceHandle_t cellHandle)
                                     // we will need a data buffer for the information field carrying the
                                     // user data (i.e. AT commands)
                                     errorCode = openChannel(pContext, U_CELL_MUX_PRIVATE_CHANNEL_ID_AT,
-                                                            U_CELL_MUX_PRIVATE_VIRTUAL_SERIAL_BUFFER_LENGTH_BYTES);
+                                                            getVirtualSerialBufferLength(pContext));
                                     if (errorCode == 0) {
 #ifdef U_CELL_MUX_ENABLE_DEBUG
                                         uPortLog("U_CELL_CMUX_1: AT channel open, flushing stored URCs...\n");
@@ -1747,6 +2085,73 @@ bool uCellMuxIsEnabled(uDeviceHandle_t cellHandle)
     return isEnabled;
 }
 
+// Set the maximum information field length to request.
+int32_t uCellMuxSetInformationLengthMax(uDeviceHandle_t cellHandle,
+                                        size_t lengthBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellMuxPrivateContext_t *pContext;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        if ((pInstance != NULL) &&
+            (lengthBytes <= U_CELL_MUX_PRIVATE_INFORMATION_MAX_LENGTH_BYTES)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (U_CELL_PRIVATE_HAS(pInstance->pModule, U_CELL_PRIVATE_FEATURE_CMUX)) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pContext = pCreateContext(pInstance);
+                if (pContext != NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+                    if (pContext->savedAtHandle == NULL) {
+                        pContext->informationLengthMaxRequestedBytes = lengthBytes;
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Get the maximum information field length.
+int32_t uCellMuxGetInformationLengthMax(uDeviceHandle_t cellHandle)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellMuxPrivateContext_t *pContext;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        if (pInstance != NULL) {
+            errorCodeOrLength = U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES;
+            pContext = (uCellMuxPrivateContext_t *) pInstance->pMuxContext;
+            if (pContext != NULL) {
+                if (pContext->savedAtHandle != NULL) {
+                    errorCodeOrLength = (int32_t) pContext->informationLengthMaxBytes;
+                } else if (pContext->informationLengthMaxRequestedBytes > 0) {
+                    errorCodeOrLength = (int32_t) pContext->informationLengthMaxRequestedBytes;
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCodeOrLength;
+}
+
 // Add a multiplexer channel.
 int32_t uCellMuxAddChannel(uDeviceHandle_t cellHandle,
                            int32_t channel,
@@ -1775,7 +2180,7 @@ int32_t uCellMuxAddChannel(uDeviceHandle_t cellHandle,
                         channel = pContext->channelGnss;
                     }
                     errorCode = openChannel(pContext, channel,
-                                            U_CELL_MUX_PRIVATE_VIRTUAL_SERIAL_BUFFER_LENGTH_BYTES);
+                                            getVirtualSerialBufferLength(pContext));
                     if (errorCode == 0) {
 #ifdef U_CELL_MUX_ENABLE_DEBUG
                         uPortLog("U_CELL_CMUX_%d: channel added.\n", channel);
@@ -1826,6 +2231,102 @@ uDeviceSerial_t *pUCellMuxChannelGetDeviceSerial(uDeviceHandle_t cellHandle,
     return pDeviceSerial;
 }
 
+// Set the transmit priority and weight of a channel.
+int32_t uCellMuxSetChannelTxPriority(uDeviceHandle_t cellHandle,
+                                     int32_t channel, int32_t priority,
+                                     int32_t weight)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellMuxPrivateContext_t *pContext;
+    uCellMuxPrivateChannelContext_t *pChannelContext;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        if ((pInstance != NULL) && (channel != U_CELL_MUX_PRIVATE_CHANNEL_ID_CONTROL) &&
+            ((channel <= U_CELL_MUX_PRIVATE_ADDRESS_MAX) ||
+             (channel == U_CELL_MUX_CHANNEL_ID_GNSS)) &&
+            (weight > 0) && (weight <= U_CELL_MUX_TX_WEIGHT_MAX)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+            pContext = (uCellMuxPrivateContext_t *) pInstance->pMuxContext;
+            if ((pContext != NULL) && (pContext->savedAtHandle != NULL)) {
+                if (channel == U_CELL_MUX_CHANNEL_ID_GNSS) {
+                    channel = pContext->channelGnss;
+                }
+                pChannelContext = (uCellMuxPrivateChannelContext_t *) pUInterfaceContext(
+                                      pUCellMuxPrivateGetDeviceSerial(pContext, (uint8_t) channel));
+                if (pChannelContext != NULL) {
+                    U_PORT_MUTEX_LOCK(pContext->txMutex);
+                    pChannelContext->txSchedule.priority = priority;
+                    pChannelContext->txSchedule.weight = weight;
+                    U_PORT_MUTEX_UNLOCK(pContext->txMutex);
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Get the transmit statistics for a channel.
+int32_t uCellMuxGetChannelStats(uDeviceHandle_t cellHandle,
+                                int32_t channel,
+                                uCellMuxChannelStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellMuxPrivateContext_t *pContext;
+    uCellMuxPrivateChannelContext_t *pChannelContext;
+    uCellMuxPrivateTxSchedule_t *pTxSchedule;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        if ((pInstance != NULL) && (pStats != NULL) &&
+            ((channel <= U_CELL_MUX_PRIVATE_ADDRESS_MAX) ||
+             (channel == U_CELL_MUX_CHANNEL_ID_GNSS))) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+            pContext = (uCellMuxPrivateContext_t *) pInstance->pMuxContext;
+            if ((pContext != NULL) && (pContext->savedAtHandle != NULL)) {
+                if (channel == U_CELL_MUX_CHANNEL_ID_GNSS) {
+                    channel = pContext->channelGnss;
+                }
+                pChannelContext = (uCellMuxPrivateChannelContext_t *) pUInterfaceContext(
+                                      pUCellMuxPrivateGetDeviceSerial(pContext, (uint8_t) channel));
+                if (pChannelContext != NULL) {
+                    pTxSchedule = &(pChannelContext->txSchedule);
+                    U_PORT_MUTEX_LOCK(pContext->txMutex);
+                    pStats->queuedBytes = pTxSchedule->queuedBytes;
+                    pStats->sentBytes = pTxSchedule->sentBytes;
+                    pStats->numBatches = pTxSchedule->numBatches;
+                    pStats->latencyAverageMs = 0;
+                    if (pTxSchedule->numBatches > 0) {
+                        pStats->latencyAverageMs = (int32_t) (pTxSchedule->latencyTotalMs /
+                                                              pTxSchedule->numBatches);
+                    }
+                    pStats->latencyMaxMs = pTxSchedule->latencyMaxMs;
+                    U_PORT_MUTEX_UNLOCK(pContext->txMutex);
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCode;
+}
+
 // Remove a multiplexer channel.
 int32_t uCellMuxRemoveChannel(uDeviceHandle_t cellHandle,
                               uDeviceSerial_t *pDeviceSerial)
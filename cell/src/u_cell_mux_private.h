@@ -48,6 +48,9 @@ extern "C" {
  * pouring received data into since the multiplexing protocol serialises
  * several things and, if one of them gets "stuck" because it has nowhere
  * to put its data, the ones that follow will be stuck also. So we use 128.
+ * This is the default: a different value may be requested at run-time
+ * with uCellMuxSetInformationLengthMax(), in which case the buffers
+ * below that are sized from this value are sized from that instead.
  */
 # define U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES 128
 #endif
@@ -64,6 +67,25 @@ extern "C" {
 # define U_CELL_MUX_PRIVATE_VIRTUAL_SERIAL_BUFFER_LENGTH_BYTES (U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES * 4)
 #endif
 
+#ifndef U_CELL_MUX_PRIVATE_TX_BATCH_MAX_FRAMES
+/** The maximum number of CMUX frames that a write to a virtual
+ * serial port will encode into a single buffer and send to the
+ * UART with one write; batching frames in this way saves a UART
+ * write per frame, at the cost of a buffer of up to this many
+ * times (#U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES +
+ * #U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES) bytes being
+ * allocated for the duration of the write.
+ */
+# define U_CELL_MUX_PRIVATE_TX_BATCH_MAX_FRAMES 4
+#endif
+
+#ifndef U_CELL_MUX_PRIVATE_TX_SCHEDULE_POLL_MS
+/** How long a channel that is waiting for its turn to transmit
+ * blocks for between checks.
+ */
+# define U_CELL_MUX_PRIVATE_TX_SCHEDULE_POLL_MS 2
+#endif
+
 /** The maximum overhead, on top of the information field length, for
  * a CMUX frame, consisting of 1 byte each for the opening and closing
  * flags, 1 byte for the address, 1 byte for control, up to 2 bytes
@@ -102,7 +124,9 @@ extern "C" {
 
 #ifndef U_CELL_MUX_PRIVATE_BUFFER_LENGTH_BYTES
 /** The length of the raw buffer, enough to store at least
- * one maximum-length CMUX frame on each channel.
+ * one maximum-length CMUX frame on each channel; if a larger
+ * maximum information field length is agreed with the module
+ * at run-time the buffer will be made larger to suit.
  */
 # define U_CELL_MUX_PRIVATE_BUFFER_LENGTH_BYTES ((U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES +  \
                                                   U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES)       \
@@ -151,11 +175,14 @@ extern "C" {
 #endif
 
 #ifndef U_CELL_MUX_PRIVATE_SCRATCH_BUFFER_LENGTH_BYTES
-/** A scratch buffer, used by the message decoders.  This is created
- * as part of the multiplexer context to be used like a stack variable
- * by any multiplexer function, avoiding putting a largish buffer on
- * the stack.  It must be at least as big as the maximum information
- * field length and the maximum control channel buffer length.
+/** A scratch buffer, used by the control channel decoder.  This is
+ * created as part of the multiplexer context to be used like a stack
+ * variable by any multiplexer function, avoiding putting a largish
+ * buffer on the stack.  It must be at least as big as the maximum
+ * control channel buffer length; it does not need to grow if a larger
+ * information field length is agreed since the information fields of
+ * user data are copied directly from the ring buffer into the receive
+ * buffer of the channel.
  */
 # if U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES > U_CELL_MUX_PRIVATE_CONTROL_CHANNEL_BUFFER_LENGTH_BYTES
 #  define U_CELL_MUX_PRIVATE_SCRATCH_BUFFER_LENGTH_BYTES U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES
@@ -215,6 +242,18 @@ typedef enum {
     U_CELL_MUX_PRIVATE_CHANNEL_STATE_MAX_NUM
 } uCellMuxPrivateChannelState_t;
 
+/** A CMUX frame to be encoded, as passed to uCellMuxPrivateEncodeBatch().
+ */
+typedef struct {
+    uint8_t address;                 /**< the address of the data link. */
+    uCellMuxPrivateFrameType_t type; /**< the frame type to encode. */
+    bool pollFinal;                  /**< the state of the poll/final bit to encode. */
+    const char *pInformation;        /**< the contents for the information field;
+                                          must be non-NULL if informationLengthBytes
+                                          is not zero. */
+    size_t informationLengthBytes;   /**< the number of bytes at pInformation. */
+} uCellMuxPrivateFrame_t;
+
 /** The input/output structure for parsing some input data in search of a CMUX frame.
  */
 typedef struct {
@@ -237,6 +276,12 @@ typedef struct {
                                         This may be more than the size of pInformation,
                                         though the buffer size of pInformation will always
                                         be respected. */
+    size_t informationOffset; /**< the decoding process will set this to the offset
+                                   of the information field from the start of the
+                                   decoded CMUX frame, allowing the information field
+                                   to be read directly from the source, e.g. with
+                                   uRingBufferPeekSpanHandle(), rather than being
+                                   copied to pInformation. */
     char *pBuffer;       /**< a buffer to be decoded; may be NULL if the source of
                               information to be decoded is actually a ring-buffer (which
                               works differently, see uCellMuxPrivateParseCmux()). */
@@ -257,18 +302,29 @@ typedef struct {
     uDeviceSerial_t *pDeviceSerial[U_CELL_MUX_MAX_CHANNELS]; /**< the channels. */
     uRingBuffer_t ringBuffer; /**< the ring buffer where we put the stream from the cellular module,
                                    generic version. */
-    char linearBuffer[U_CELL_MUX_PRIVATE_BUFFER_LENGTH_BYTES + 1];  /**< the linear buffer that will be
-                                                                         used by ringBuffer, +1 since we
-                                                                         lose one byte in the ring buffer. */
+    char *pLinearBuffer; /**< the linear buffer that will be used by ringBuffer, sized
+                              from informationLengthMaxBytes, NULL until CMUX is
+                              first enabled. */
+    size_t linearBufferSizeBytes; /**< the size of pLinearBuffer. */
     char holdingBuffer[U_CELL_MUX_PRIVATE_HOLDING_BUFFER_LENGTH_BYTES];   /**< a temporary buffer, used to get
                                                                                stuff into ringBuffer and
                                                                                in which we hold partially
                                                                                decoded control channel stuff. */
     size_t holdingBufferIndex;                                    /**< where we are in holdingBuffer.*/
-    char scratch[U_CELL_MUX_PRIVATE_SCRATCH_BUFFER_LENGTH_BYTES]; /** a scratch buffer that may be used like
-                                                                      a stack variable. */
+    char *pScratch; /**< a scratch buffer that may be used like a stack variable,
+                         allocated along with pLinearBuffer. */
+    size_t scratchSizeBytes; /**< the size of pScratch. */
+    size_t informationLengthMaxRequestedBytes; /**< the maximum information field
+                                                    length (N1) to request when CMUX
+                                                    is next enabled, zero for the
+                                                    default. */
+    size_t informationLengthMaxBytes; /**< the maximum information field length
+                                           (N1) agreed with the module. */
     int32_t readHandle;
     int32_t eventQueueHandle; /** an event queue to carry callbacks from the channels. */
+    uPortMutexHandle_t txMutex; /**< protects the transmit scheduling fields. */
+    bool txBusy; /**< true while a channel has been given the UART to transmit on. */
+    uint32_t txVirtualTime; /**< the virtual time of weighted fair transmit scheduling. */
 } uCellMuxPrivateContext_t;
 
 /** Structure to hold the user event callback for a CMUX channel.
@@ -295,6 +351,24 @@ typedef struct {
     bool rxIsFlowControlledOff; /**< we don't want the remote-end to send stuff to us. */
 } uCellMuxPrivateTraffic_t;
 
+/** Structure to hold the transmit scheduling state and the transmit
+ * statistics of a channel.
+ */
+typedef struct {
+    int32_t priority;          /**< higher priority channels transmit first. */
+    int32_t weight;            /**< share of the UART between channels of
+                                    equal priority. */
+    uint32_t virtualFinish;    /**< the virtual time at which the last batch
+                                    sent by this channel finished. */
+    bool waiting;              /**< true while a batch is waiting to be sent. */
+    int32_t waitStartTimeMs;   /**< when the waiting batch started waiting. */
+    size_t queuedBytes;        /**< user bytes passed to write() but not yet sent. */
+    uint32_t sentBytes;        /**< total user bytes sent. */
+    uint32_t numBatches;       /**< the number of batches sent. */
+    uint32_t latencyTotalMs;   /**< the sum of the time each batch waited. */
+    int32_t latencyMaxMs;      /**< the longest time a batch waited. */
+} uCellMuxPrivateTxSchedule_t;
+
 /** The context data for a single CMUX channel.
  */
 typedef struct {
@@ -305,6 +379,7 @@ typedef struct {
     uPortMutexHandle_t mutex;
     uCellMuxPrivateTraffic_t traffic;
     uCellMuxPrivateEventCallback_t eventCallback;
+    uCellMuxPrivateTxSchedule_t txSchedule;
 } uCellMuxPrivateChannelContext_t;
 
 /* ----------------------------------------------------------------
@@ -333,6 +408,31 @@ int32_t uCellMuxPrivateEncode(uint8_t address, uCellMuxPrivateFrameType_t type,
                               bool pollFinal, const char *pInformation,
                               size_t informationLengthBytes, char *pBuffer);
 
+/** Encode several 3GPP 27.010 mux frames, back to back, into a
+ * single buffer so that they may be sent with one write.  Frames
+ * are encoded in order until either all are done or the next
+ * frame would not fit into the remaining space in pBuffer.
+ *
+ * @param[in] pFrames             an array of frames to encode; cannot
+ *                                be NULL.
+ * @param numFrames               the number of elements in pFrames.
+ * @param[out] pBuffer            a pointer to a place to put the encoded
+ *                                CMUX frames; cannot be NULL.
+ * @param bufferLengthBytes       the amount of storage at pBuffer; a
+ *                                frame requires its informationLengthBytes
+ *                                + #U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES
+ *                                of space.
+ * @param[out] pNumFramesEncoded  a pointer to a place to put the number
+ *                                of frames from pFrames that were
+ *                                encoded; may be NULL.
+ * @return                        on success the number of bytes written
+ *                                to pBuffer, else negative error code.
+ */
+int32_t uCellMuxPrivateEncodeBatch(const uCellMuxPrivateFrame_t *pFrames,
+                                   size_t numFrames, char *pBuffer,
+                                   size_t bufferLengthBytes,
+                                   size_t *pNumFramesEncoded);
+
 /** Parse [a ring-buffer] for a CMUX frame.  The function signature is such that
  * this can be used as a ring-buffer parser; pUserParam MUST be a pointer
  * to a structure of type #uCellMuxPrivateParserContext_t.  However, if
@@ -363,6 +463,44 @@ int32_t uCellMuxPrivateEncode(uint8_t address, uCellMuxPrivateFrameType_t type,
  */
 int32_t uCellMuxPrivateParseCmux(uParseHandle_t parseHandle, void *pUserParam);
 
+/* ----------------------------------------------------------------
+ * FUNCTIONS: TRANSMIT SCHEDULING
+ * -------------------------------------------------------------- */
+
+/** Decide which of a set of channels should transmit next: of those
+ * that are waiting to transmit, the one with the highest priority
+ * and then, for equal priority, the one with the lowest virtual
+ * start time (start-time fair queuing), where the virtual start
+ * time is the later of the channel's virtual finish time and the
+ * current virtual time.
+ *
+ * @param[in] ppSchedules  an array of pointers to the transmit
+ *                         schedules of the channels; an entry that
+ *                         is NULL, e.g. for a channel that has been
+ *                         flow controlled off, is ignored.
+ * @param numSchedules     the number of entries in ppSchedules.
+ * @param virtualTime      the current virtual time.
+ * @return                 the index into ppSchedules of the channel
+ *                         that should transmit next, or -1 if none
+ *                         is waiting.
+ */
+int32_t uCellMuxPrivateTxScheduleNext(uCellMuxPrivateTxSchedule_t *const *ppSchedules,
+                                      size_t numSchedules, uint32_t virtualTime);
+
+/** Account for a channel starting to transmit sizeBytes: the virtual
+ * time moves on to the start of the transmission and the virtual
+ * finish time of the channel is set to that plus sizeBytes divided
+ * by the weight of the channel, so that a more heavily weighted
+ * channel will get its next turn sooner.
+ *
+ * @param[in,out] pSchedule    the transmit schedule of the channel;
+ *                             cannot be NULL.
+ * @param[in,out] pVirtualTime the virtual time; cannot be NULL.
+ * @param sizeBytes            the number of bytes to be transmitted.
+ */
+void uCellMuxPrivateTxScheduleStart(uCellMuxPrivateTxSchedule_t *pSchedule,
+                                    uint32_t *pVirtualTime, size_t sizeBytes);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MISC
  * -------------------------------------------------------------- */
@@ -74,6 +74,32 @@
  */
 #define U_CELL_NET_SCAN_LENGTH_BYTES (128 * 10)
 
+/** The length of temporary buffer to use when reading a single
+ * network scan result in an asynchronous scan, sufficient to store:
+ *
+ * (stat,long_name,short_name,numeric[,AcT])
+ */
+#define U_CELL_NET_SCAN_ITEM_LENGTH_BYTES 128
+
+#ifndef U_CELL_NET_SCAN_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that runs an asynchronous network
+ * scan; note that the scan callback is called from this task.
+ */
+# define U_CELL_NET_SCAN_TASK_STACK_SIZE_BYTES (1024 * 3)
+#endif
+
+/** How often the asynchronous scan task checks whether it has
+ * been asked to exit while it is waiting for the cellular API
+ * mutex.
+ */
+#define U_CELL_NET_SCAN_API_LOCK_POLL_MS 100
+
+#ifndef U_CELL_NET_SCAN_TASK_PRIORITY
+/** The priority of the task that runs an asynchronous network scan.
+ */
+# define U_CELL_NET_SCAN_TASK_PRIORITY (U_CFG_OS_PRIORITY_MIN + 2)
+#endif
+
 /** The type of CEREG to request; 4 to get the 3GPP sleep parameters
  * also.
  * IMPORTANT: if this value ever needs to change, because of the
@@ -134,6 +160,33 @@ typedef struct {
     void *pCallbackParam;
 } uCellNet3gppPowerSavingCallback_t;
 
+/** Context for an asynchronous network scan, hooked into
+ * pScanAsyncContext of the instance.
+ */
+typedef struct {
+    uCellPrivateInstance_t *pInstance;
+    void (*pCallback) (uDeviceHandle_t, const char *, const char *,
+                       uCellNetRat_t, int32_t, void *);
+    void *pCallbackParameter;
+    int32_t cFunMode;
+    bool exitRequested;
+    uPortMutexHandle_t taskRunningMutex;
+    uPortQueueHandle_t taskExitQueue;
+    uPortTaskHandle_t taskHandle;
+    char item[U_CELL_NET_SCAN_ITEM_LENGTH_BYTES];
+} uCellNetScanContext_t;
+
+/** Context for the last good network callbacks, hooked into
+ * pLastGoodContext of the instance.
+ */
+typedef struct {
+    bool (*pLoad) (uDeviceHandle_t, uCellNetLastGood_t *, void *);
+    void (*pSave) (uDeviceHandle_t, const uCellNetLastGood_t *, void *);
+    void *pCallbackParameter;
+    bool attemptTimed;
+    int32_t attemptStopTimeMs;
+} uCellNetLastGoodContext_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -391,6 +444,16 @@ static void setNetworkStatus(uCellPrivateInstance_t *pInstance,
     // Set the sleep state based on this new RAT state
     uCellPrivateSetDeepSleepState(pInstance);
 
+    if (fromUrc) {
+        // This module does send +CxREG URCs, so they can be waited for
+        pInstance->registrationUrcSeen = true;
+        if (pInstance->registrationSemaphore != NULL) {
+            // Wake up anyone waiting for the registration status to change;
+            // don't care if it is already given
+            uPortSemaphoreGive(pInstance->registrationSemaphore);
+        }
+    }
+
     if (pInstance->pRegistrationStatusCallback != NULL) {
         // If the user has a callback for this, put all the
         // data in a struct and pass a pointer to it to our
@@ -671,10 +734,30 @@ static void UUPSDD_urc(uAtClientHandle_t atHandle,
  * STATIC FUNCTIONS: REGISTRATION RELATED
  * -------------------------------------------------------------- */
 
+// Wait until it is time to query the registration status again,
+// returning early if a +CxREG URC arrives; the wait is only long
+// once this module has been seen to send +CxREG URCs, otherwise
+// we must keep polling.
+static void waitRegistrationChange(const uCellPrivateInstance_t *pInstance)
+{
+    int32_t timeoutMs = U_CELL_NET_REGISTRATION_POLL_INTERVAL_MS;
+
+    if (pInstance->registrationUrcSeen) {
+        timeoutMs = U_CELL_NET_REGISTRATION_URC_POLL_INTERVAL_MS;
+    }
+    if (pInstance->registrationSemaphore != NULL) {
+        uPortSemaphoreTryTake(pInstance->registrationSemaphore, timeoutMs);
+    } else {
+        uPortTaskBlock(timeoutMs);
+    }
+}
+
 // Callback function for the cellular connection process.
 static bool keepGoingLocalCb(const uCellPrivateInstance_t *pInstance)
 {
     bool keepGoing = true;
+    const uCellNetLastGoodContext_t *pLastGood = (const uCellNetLastGoodContext_t *)
+                                                 pInstance->pLastGoodContext;
 
     if (pInstance->pKeepGoingCallback != NULL) {
         keepGoing = pInstance->pKeepGoingCallback(pInstance->cellHandle);
@@ -685,6 +768,11 @@ static bool keepGoingLocalCb(const uCellPrivateInstance_t *pInstance)
             keepGoing = false;
         }
     }
+    if (keepGoing && (pLastGood != NULL) && pLastGood->attemptTimed &&
+        (uPortGetTickTimeMs() - pLastGood->attemptStopTimeMs > 0)) {
+        // Out of time for an attempt on the last good network
+        keepGoing = false;
+    }
 
     return keepGoing;
 }
@@ -701,10 +789,7 @@ static int32_t radioOff(uCellPrivateInstance_t *pInstance)
     pInstance->profileState = U_CELL_PRIVATE_PROFILE_STATE_SHOULD_BE_DOWN;
     for (size_t x = 3; (x > 0) && (errorCode < 0); x--) {
         // Wait for flip time to expire
-        while (uPortGetTickTimeMs() - pInstance->lastCfunFlipTimeMs <
-               (U_CELL_PRIVATE_AT_CFUN_FLIP_DELAY_SECONDS * 1000)) {
-            uPortTaskBlock(1000);
-        }
+        uCellPrivateCFunFlipWait(pInstance);
         uAtClientLock(atHandle);
         uAtClientCommandStart(atHandle, "AT+CFUN=");
         uAtClientWriteInt(atHandle,
@@ -772,6 +857,12 @@ static int32_t prepareConnect(uCellPrivateInstance_t *pInstance)
 
     uPortLog("U_CELL_NET: preparing to register/connect...\n");
 
+    if (pInstance->registrationSemaphore == NULL) {
+        // Create the semaphore that the +CxREG URCs give;
+        // if this fails we will simply fall back to polling
+        uPortSemaphoreCreate(&(pInstance->registrationSemaphore), 0, 1);
+    }
+
     // Register the URC handlers
     uAtClientSetUrcHandler(atHandle, "+CREG:", CREG_urc, pInstance);
     uAtClientSetUrcHandler(atHandle, "+CGREG:", CGREG_urc, pInstance);
@@ -865,15 +956,12 @@ static int32_t setAutomaticMode(const uCellPrivateInstance_t *pInstance)
     return errorCode;
 }
 
-// Store a network scan result and return the
-// number stored
-static int32_t storeNextScanItem(uCellPrivateInstance_t *pInstance,
-                                 char *pBuffer)
+// Parse a network scan result into pNet, returning true on success;
+// pBuffer is modified in the process.
+static bool parseScanItem(const uCellPrivateInstance_t *pInstance,
+                          char *pBuffer, uCellPrivateNet_t *pNet)
 {
-    int32_t count = 0;
     bool success = false;
-    uCellPrivateNet_t *pNet;
-    uCellPrivateNet_t **ppTmp;
     int32_t copsRat;
     size_t x;
     char *pSaved;
@@ -887,71 +975,86 @@ static int32_t storeNextScanItem(uCellPrivateInstance_t *pInstance,
     // ...may appear there, so check for errors;
     // the <stat> and <numeric> fields must be present, the
     // rest could be absent or zero length strings
-    // Malloc() memory to store this item
-    pNet = (uCellPrivateNet_t *) pUPortMalloc(sizeof(*pNet));
-    if (pNet != NULL) {
-        // Check that "(<stat>" is there and throw it away
-        pStr = strtok_r(pBuffer, ",", &pSaved);
-        success = ((pStr != NULL) && (*pStr == '('));
-        if (success) {
-            success = false;
-            // Grab <long_name> and put it in name
-            pStr = strtok_r(NULL, ",", &pSaved);
-            if (pStr != NULL) {
-                x = strlen(pStr);
-                pNet->name[0] = '\0';
-                if (x > 1) {
-                    // > 1 since "" is the minimum we can have
-                    snprintf(pNet->name, sizeof(pNet->name), "%.*s",
-                             x - 2, pStr + 1);
-                    success = true;
-                }
-            }
-        }
-        if (success) {
-            // Check if <short_name> is there but
-            // don't store it
-            pStr = strtok_r(NULL, ",", &pSaved);
-            success = ((pStr != NULL) && (strlen(pStr) > 1));
-        }
-        if (success) {
-            success = false;
-            // Grab <numeric> and pluck the MCC/MNC from it
-            pStr = strtok_r(NULL, ",", &pSaved);
-            pNet->mcc = 0;
-            pNet->mnc = 0;
-            // +2 for the quotes at each end
-            if ((pStr != NULL) && (strlen(pStr) >= 5 + 2)) {
-                // +1 for the initial quotation mark
-                pNet->mnc = atoi(pStr + 3 + 1);
-                *(pStr + 3 + 1) = 0;
-                pNet->mcc = atoi(pStr + 1);
+    // Check that "(<stat>" is there and throw it away
+    pStr = strtok_r(pBuffer, ",", &pSaved);
+    success = ((pStr != NULL) && (*pStr == '('));
+    if (success) {
+        success = false;
+        // Grab <long_name> and put it in name
+        pStr = strtok_r(NULL, ",", &pSaved);
+        if (pStr != NULL) {
+            x = strlen(pStr);
+            pNet->name[0] = '\0';
+            if (x > 1) {
+                // > 1 since "" is the minimum we can have
+                snprintf(pNet->name, sizeof(pNet->name), "%.*s",
+                         x - 2, pStr + 1);
                 success = true;
             }
         }
-        if (success) {
-            // See if <AcT> is there
-            pNet->rat = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
-            pStr = strtok_r(NULL, ",", &pSaved);
-            if (pStr != NULL) {
-                // If it is convert it into a RAT value
-                copsRat = atoi(pStr);
-                if ((copsRat >= 0) &&
-                    (copsRat < (int32_t) (sizeof(g3gppRatToCellRat) /
-                                          sizeof(g3gppRatToCellRat[0])))) {
-                    pNet->rat = g3gppRatToCellRat[copsRat];
-                    if ((pNet->rat == U_CELL_NET_RAT_LTE) &&
-                        !(pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_LTE)) &&
-                        (pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_CATM1))) {
-                        // The RAT on the end of the network status indication doesn't
-                        // differentiate between LTE and Cat-M1 so, if the device doesn't
-                        // support LTE but does support Cat-M1, switch it
-                        pNet->rat = U_CELL_NET_RAT_CATM1;
-                    }
+    }
+    if (success) {
+        // Check if <short_name> is there but
+        // don't store it
+        pStr = strtok_r(NULL, ",", &pSaved);
+        success = ((pStr != NULL) && (strlen(pStr) > 1));
+    }
+    if (success) {
+        success = false;
+        // Grab <numeric> and pluck the MCC/MNC from it
+        pStr = strtok_r(NULL, ",", &pSaved);
+        pNet->mcc = 0;
+        pNet->mnc = 0;
+        // +2 for the quotes at each end
+        if ((pStr != NULL) && (strlen(pStr) >= 5 + 2)) {
+            // +1 for the initial quotation mark
+            pNet->mnc = atoi(pStr + 3 + 1);
+            *(pStr + 3 + 1) = 0;
+            pNet->mcc = atoi(pStr + 1);
+            success = true;
+        }
+    }
+    if (success) {
+        // See if <AcT> is there
+        pNet->rat = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+        pStr = strtok_r(NULL, ",", &pSaved);
+        if (pStr != NULL) {
+            // If it is convert it into a RAT value
+            copsRat = atoi(pStr);
+            if ((copsRat >= 0) &&
+                (copsRat < (int32_t) (sizeof(g3gppRatToCellRat) /
+                                      sizeof(g3gppRatToCellRat[0])))) {
+                pNet->rat = g3gppRatToCellRat[copsRat];
+                if ((pNet->rat == U_CELL_NET_RAT_LTE) &&
+                    !(pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_LTE)) &&
+                    (pInstance->pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_CATM1))) {
+                    // The RAT on the end of the network status indication doesn't
+                    // differentiate between LTE and Cat-M1 so, if the device doesn't
+                    // support LTE but does support Cat-M1, switch it
+                    pNet->rat = U_CELL_NET_RAT_CATM1;
                 }
             }
         }
-        pNet->pNext = NULL;
+    }
+    pNet->pNext = NULL;
+
+    return success;
+}
+
+// Store a network scan result and return the
+// number stored
+static int32_t storeNextScanItem(uCellPrivateInstance_t *pInstance,
+                                 char *pBuffer)
+{
+    int32_t count = 0;
+    bool success = false;
+    uCellPrivateNet_t *pNet;
+    uCellPrivateNet_t **ppTmp;
+
+    // Malloc() memory to store this item
+    pNet = (uCellPrivateNet_t *) pUPortMalloc(sizeof(*pNet));
+    if (pNet != NULL) {
+        success = parseScanItem(pInstance, pBuffer, pNet);
     }
 
     // Count the number of things already
@@ -1011,9 +1114,12 @@ static int32_t readNextScanItem(uCellPrivateInstance_t *pInstance,
     return errorCodeOrNumber;
 }
 
-// Register with the cellular network
+// Register with the cellular network; if pMccMnc is given and
+// fallback is true then the module may fall back to automatic
+// network selection should that network be lost.
 static int32_t registerNetwork(uCellPrivateInstance_t *pInstance,
-                               const char *pMccMnc)
+                               const char *pMccMnc, uCellNetRat_t wantedRat,
+                               bool fallback)
 {
     int32_t errorCode;
     uAtClientHandle_t atHandle = pInstance->atHandle;
@@ -1030,15 +1136,16 @@ static int32_t registerNetwork(uCellPrivateInstance_t *pInstance,
 
     // Come out of airplane mode and try to register
     // Wait for flip time to expire first though
-    while (uPortGetTickTimeMs() - pInstance->lastCfunFlipTimeMs <
-           (U_CELL_PRIVATE_AT_CFUN_FLIP_DELAY_SECONDS * 1000)) {
-        uPortTaskBlock(1000);
-    }
+    uCellPrivateCFunFlipWait(pInstance);
     // Reset the current registration status
     for (size_t x = 0; x < sizeof(pInstance->networkStatus) /
          sizeof(pInstance->networkStatus[0]); x++) {
         pInstance->networkStatus[x] = U_CELL_NET_STATUS_UNKNOWN;
     }
+    if (pInstance->registrationSemaphore != NULL) {
+        // Throw away any stale URC indication
+        uPortSemaphoreTryTake(pInstance->registrationSemaphore, 0);
+    }
     uAtClientLock(atHandle);
     uAtClientCommandStart(atHandle, "AT+CFUN=1");
     uAtClientCommandStopReadResponse(atHandle);
@@ -1055,12 +1162,26 @@ static int32_t registerNetwork(uCellPrivateInstance_t *pInstance,
         uAtClientLock(atHandle);
         uAtClientTimeoutSet(atHandle, 1000);
         uAtClientCommandStart(atHandle, "AT+COPS=");
-        // Manual mode
-        uAtClientWriteInt(atHandle, 1);
+        // Manual mode or, where this is only a preference, manual
+        // mode with automatic fallback, so that the module is not
+        // stuck on a network it can no longer see once it has moved
+        uAtClientWriteInt(atHandle, fallback ? 4 : 1);
         // Numeric format
         uAtClientWriteInt(atHandle, 2);
         // The network
         uAtClientWriteString(atHandle, pMccMnc, true);
+        if (wantedRat == U_CELL_NET_RAT_CATM1) {
+            // Cat-M1 is LTE as far as AT+COPS is concerned
+            wantedRat = U_CELL_NET_RAT_LTE;
+        }
+        for (size_t x = 0; (wantedRat != U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) &&
+             (x < sizeof(g3gppRatToCellRat) / sizeof(g3gppRatToCellRat[0])); x++) {
+            if (g3gppRatToCellRat[x] == wantedRat) {
+                // The RAT to register on
+                uAtClientWriteInt(atHandle, (int32_t) x);
+                wantedRat = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+            }
+        }
         uAtClientCommandStop(atHandle);
         // Loop until either we give up or we get a response
         while (keepGoing && keepGoingLocalCb(pInstance) && !deviceErrorDetected) {
@@ -1196,8 +1317,8 @@ static int32_t registerNetwork(uCellPrivateInstance_t *pInstance,
                     if (errorCount > 10) {
                         keepGoing = false;
                     }
-                } else {
-                    uPortTaskBlock(300);
+                } else if (!uCellPrivateIsRegistered(pInstance)) {
+                    waitRegistrationChange(pInstance);
                 }
             }
             // Next AT+CxREG? type
@@ -1243,6 +1364,159 @@ static int32_t attachNetwork(const uCellPrivateInstance_t *pInstance)
     return errorCode;
 }
 
+// Read the MCC/MNC of the network we are registered on as a string
+// into pBuffer, which must be of length U_CELL_NET_MCC_MNC_LENGTH_BYTES,
+// returning the number of characters read or negative error code.
+static int32_t getMccMncStr(const uCellPrivateInstance_t *pInstance,
+                            char *pBuffer)
+{
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    int32_t errorCodeOrLength;
+    int32_t bytesRead;
+
+    uAtClientLock(atHandle);
+    // First set numeric format
+    uAtClientCommandStart(atHandle, "AT+COPS=3,2");
+    uAtClientCommandStopReadResponse(atHandle);
+    // Then read the network name
+    uAtClientCommandStart(atHandle, "AT+COPS?");
+    uAtClientCommandStop(atHandle);
+    uAtClientResponseStart(atHandle, "+COPS:");
+    // Skip past <mode> and <format>
+    uAtClientSkipParameters(atHandle, 2);
+    // Read the operator name, which will be
+    // as MCC/MNC
+    bytesRead = uAtClientReadString(atHandle, pBuffer,
+                                    U_CELL_NET_MCC_MNC_LENGTH_BYTES,
+                                    false);
+    uAtClientResponseStop(atHandle);
+    errorCodeOrLength = uAtClientUnlock(atHandle);
+    if (errorCodeOrLength == 0) {
+        errorCodeOrLength = bytesRead;
+    }
+
+    return errorCodeOrLength;
+}
+
+// Save a new last good network record, if it has changed.
+static void saveLastGood(uCellPrivateInstance_t *pInstance,
+                         const uCellNetLastGoodContext_t *pContext,
+                         const uCellNetLastGood_t *pLoaded)
+{
+    uCellNetLastGood_t lastGood;
+
+    memset(&lastGood, 0, sizeof(lastGood));
+    if (getMccMncStr(pInstance, lastGood.mccMnc) >= 5) {
+        lastGood.rat = uCellPrivateGetActiveRat(pInstance);
+        lastGood.earfcn = -1;
+        lastGood.cellId = -1;
+        if (uCellPrivateRefreshRadioParameters(pInstance) == 0) {
+            lastGood.earfcn = pInstance->radioParameters.earfcn;
+            lastGood.cellId = pInstance->radioParameters.cellId;
+        }
+        if ((pLoaded == NULL) ||
+            (strcmp(lastGood.mccMnc, pLoaded->mccMnc) != 0) ||
+            (lastGood.rat != pLoaded->rat) ||
+            (lastGood.earfcn != pLoaded->earfcn) ||
+            (lastGood.cellId != pLoaded->cellId)) {
+            pContext->pSave(pInstance->cellHandle, &lastGood,
+                            pContext->pCallbackParameter);
+        }
+    }
+}
+
+// Register with and attach to the cellular network, first trying
+// the last good network, if there is one and no network was given,
+// and recording the time taken by each attempt.
+static int32_t registerAndAttach(uCellPrivateInstance_t *pInstance,
+                                 const char *pMccMnc)
+{
+    int32_t errorCode = (int32_t) U_CELL_ERROR_NOT_REGISTERED;
+    uCellNetLastGoodContext_t *pContext = (uCellNetLastGoodContext_t *)
+                                          pInstance->pLastGoodContext;
+    uCellNetAttachAttempt_t *pAttempt;
+    uCellNetLastGood_t lastGood;
+    bool lastGoodLoaded = false;
+    bool lastGoodUsed = false;
+    int32_t startTimeMs;
+
+    pInstance->numAttachAttempts = 0;
+    memset(&lastGood, 0, sizeof(lastGood));
+    if ((pMccMnc == NULL) && (pContext != NULL) && (pContext->pLoad != NULL)) {
+        lastGoodLoaded = pContext->pLoad(pInstance->cellHandle, &lastGood,
+                                         pContext->pCallbackParameter);
+        lastGood.mccMnc[sizeof(lastGood.mccMnc) - 1] = 0;
+        if (lastGoodLoaded && (strlen(lastGood.mccMnc) >= 5)) {
+            uPortLog("U_CELL_NET: trying last good network %s first...\n",
+                     lastGood.mccMnc);
+            pAttempt = &(pInstance->attachAttempt[pInstance->numAttachAttempts]);
+            pInstance->numAttachAttempts++;
+            pAttempt->lastGood = true;
+            startTimeMs = uPortGetTickTimeMs();
+            pContext->attemptStopTimeMs = startTimeMs +
+                                          (U_CELL_NET_LAST_GOOD_TIMEOUT_SECONDS * 1000);
+            pContext->attemptTimed = true;
+            errorCode = registerNetwork(pInstance, lastGood.mccMnc, lastGood.rat, true);
+            if (errorCode == 0) {
+                errorCode = attachNetwork(pInstance);
+            }
+            lastGoodUsed = (errorCode == 0);
+            pContext->attemptTimed = false;
+            pAttempt->timeMs = uPortGetTickTimeMs() - startTimeMs;
+            pAttempt->errorCode = errorCode;
+            if ((errorCode != 0) && keepGoingLocalCb(pInstance)) {
+                uPortLog("U_CELL_NET: last good network not available after"
+                         " %d ms.\n", pAttempt->timeMs);
+                // Don't check error code here, see uCellNetConnect()
+                setAutomaticMode(pInstance);
+            }
+        }
+    }
+
+    if ((pInstance->numAttachAttempts == 0) ||
+        ((errorCode != 0) && keepGoingLocalCb(pInstance))) {
+        pAttempt = &(pInstance->attachAttempt[pInstance->numAttachAttempts]);
+        pInstance->numAttachAttempts++;
+        pAttempt->lastGood = false;
+        startTimeMs = uPortGetTickTimeMs();
+        errorCode = registerNetwork(pInstance, pMccMnc,
+                                    U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED, false);
+        if (errorCode == 0) {
+            // This step _shouldn't_ be necessary.  However,
+            // for reasons I don't understand, SARA-R4 can be
+            // registered but not attached (i.e. AT+CGATT
+            // returns 0) on both RATs (unh?).  Phil Ware, who
+            // knows about these things, always goes through
+            // (a) register, (b) wait for AT+CGATT to return 1
+            // and then (c) check that a context is active
+            // with AT+CGACT or using AT+UPSD (even for EUTRAN).
+            // Since this sequence works for both RANs, it is
+            // best to be consistent.
+            errorCode = attachNetwork(pInstance);
+        }
+        pAttempt->timeMs = uPortGetTickTimeMs() - startTimeMs;
+        pAttempt->errorCode = errorCode;
+    }
+
+    if (errorCode == 0) {
+        // Remember the MCC/MNC in case we need to deactivate
+        // and reactivate context later and that causes
+        // de/re-registration.
+        memset(pInstance->mccMnc, 0, sizeof(pInstance->mccMnc));
+        pInstance->mccMncFallback = lastGoodUsed;
+        if (pMccMnc != NULL) {
+            memcpy(pInstance->mccMnc, pMccMnc, sizeof(pInstance->mccMnc));
+        } else if (lastGoodUsed) {
+            memcpy(pInstance->mccMnc, lastGood.mccMnc, sizeof(pInstance->mccMnc));
+        }
+        if ((pContext != NULL) && (pContext->pSave != NULL)) {
+            saveLastGood(pInstance, pContext, lastGoodLoaded ? &lastGood : NULL);
+        }
+    }
+
+    return errorCode;
+}
+
 // Disconnect from the network.
 static int32_t disconnectNetwork(uCellPrivateInstance_t *pInstance,
                                  bool (pKeepGoingCallback) (uDeviceHandle_t cellHandle))
@@ -1287,7 +1561,7 @@ static int32_t disconnectNetwork(uCellPrivateInstance_t *pInstance,
                     uAtClientResponseStop(atHandle);
                     uAtClientUnlock(atHandle);
                 }
-                uPortTaskBlock(300);
+                waitRegistrationChange(pInstance);
             }
             // There is a corner case that has occurred
             // on SARA-R412M-02B when operating on an NB1 network
@@ -2015,6 +2289,240 @@ static int32_t getDnsStrUpsd(const uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+// Check if the asynchronous scan task has been asked to exit,
+// waiting up to waitMs for that to happen.
+static bool scanTaskExitRequested(uCellNetScanContext_t *pContext,
+                                  int32_t waitMs)
+{
+    int32_t queueItem;
+
+    if (!pContext->exitRequested &&
+        (uPortQueueTryReceive(pContext->taskExitQueue, waitMs, &queueItem) == 0)) {
+        pContext->exitRequested = true;
+    }
+
+    return pContext->exitRequested;
+}
+
+// Lock the cellular API mutex from the asynchronous scan task,
+// giving up if the task is asked to exit: whoever asks may be
+// holding the mutex while waiting for the task to finish.  Returns
+// true if the mutex has been locked, in which case the task has
+// not been asked to exit.
+static bool scanTaskLockApi(uCellNetScanContext_t *pContext)
+{
+    bool locked = false;
+
+    while (!locked && !scanTaskExitRequested(pContext, 0)) {
+        locked = (uPortMutexTryLock(gUCellPrivateMutex,
+                                    U_CELL_NET_SCAN_API_LOCK_POLL_MS) == 0);
+        if (locked && scanTaskExitRequested(pContext, 0)) {
+            uPortMutexUnlock(gUCellPrivateMutex);
+            locked = false;
+        }
+    }
+
+    return locked;
+}
+
+// Read the remainder of a +COPS response line, after the prefix, one
+// byte at a time, parsing each network as soon as its closing bracket
+// has arrived and passing it to the callback; the cellular API mutex
+// and the AT client are locked by the caller.  Returns the number of
+// networks found and sets *pBytesRead to the number of bytes read.
+static int32_t scanReadNetworks(uCellNetScanContext_t *pContext,
+                                int32_t *pBytesRead)
+{
+    uCellPrivateInstance_t *pInstance = pContext->pInstance;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    int32_t count = 0;
+    size_t length = 0;
+    bool inItem = false;
+    bool inQuotes = false;
+    bool done = false;
+    uCellPrivateNet_t net;
+    char mccMnc[U_CELL_NET_MCC_MNC_LENGTH_BYTES];
+    // Room for the stop tag since a partial match of it may be
+    // written to the buffer by uAtClientReadBytes()
+    char buffer[1 + U_AT_CLIENT_CRLF_LENGTH_BYTES];
+    int32_t bytesRead;
+    char c;
+
+    *pBytesRead = 0;
+    while (!done && !scanTaskExitRequested(pContext, 0) &&
+           (uPortGetTickTimeMs() - startTimeMs < (U_CELL_NET_SCAN_TIME_SECONDS * 1000))) {
+        bytesRead = uAtClientReadBytes(atHandle, buffer, 1, true);
+        if (bytesRead == 1) {
+            (*pBytesRead)++;
+            c = buffer[0];
+            if (c == '\"') {
+                inQuotes = !inQuotes;
+            }
+            if (!inQuotes && (c == '(')) {
+                // Start of a new network (or of some gunk on the end)
+                inItem = true;
+                length = 0;
+            }
+            if (inItem) {
+                if (!inQuotes && (c == ')')) {
+                    inItem = false;
+                    pContext->item[length] = 0;
+                    if (parseScanItem(pInstance, pContext->item, &net)) {
+                        count++;
+                        snprintf(mccMnc, sizeof(mccMnc), "%03d%02d",
+                                 (int) net.mcc, (int) net.mnc);
+                        pContext->pCallback(pInstance->cellHandle, net.name, mccMnc,
+                                            net.rat, count, pContext->pCallbackParameter);
+                    }
+                } else if (length < sizeof(pContext->item) - 1) {
+                    pContext->item[length] = c;
+                    length++;
+                }
+            }
+        } else if (bytesRead == 0) {
+            // Reached the end of the line
+            done = true;
+        } else {
+            // Nothing has arrived yet, go around again
+            uAtClientClearError(atHandle);
+        }
+    }
+
+    return count;
+}
+
+// Task which runs an asynchronous network scan.
+static void scanTask(void *pParameters)
+{
+    uCellNetScanContext_t *pContext = (uCellNetScanContext_t *) pParameters;
+    uCellPrivateInstance_t *pInstance = pContext->pInstance;
+    uDeviceHandle_t cellHandle = pInstance->cellHandle;
+    uAtClientHandle_t atHandle;
+    int32_t errorCodeOrNumber = (int32_t) U_CELL_ERROR_TEMPORARY_FAILURE;
+    int32_t bytesRead;
+    int32_t innerStartTimeMs;
+    uAtClientDeviceError_t deviceError;
+    bool gotPrefix;
+    bool gotAnswer = false;
+
+    U_PORT_MUTEX_LOCK(pContext->taskRunningMutex);
+
+    // See uCellNetScanGetFirst() for why this is done more than once;
+    // the cellular API mutex is held for each attempt, and the AT
+    // handle read afresh, since CMUX may have been switched on or
+    // off in between
+    for (size_t x = U_CELL_NET_SCAN_RETRIES + 1;
+         (x > 0) && (errorCodeOrNumber <= 0) && scanTaskLockApi(pContext);
+         x--) {
+        atHandle = pInstance->atHandle;
+        uAtClientLock(atHandle);
+        // Set the timeout to a second so that we
+        // can spin around the loop
+        gotAnswer = false;
+        gotPrefix = false;
+        bytesRead = -1;
+        uAtClientTimeoutSet(atHandle, 1000);
+        uAtClientCommandStart(atHandle, "AT+COPS=?");
+        uAtClientCommandStop(atHandle);
+        // The AT client has to stay locked while the scan is in
+        // progress: the module treats any character sent to it
+        // as a request to abort the scan
+        innerStartTimeMs = uPortGetTickTimeMs();
+        while (!gotPrefix && !gotAnswer &&
+               (uPortGetTickTimeMs() - innerStartTimeMs <
+                (U_CELL_NET_SCAN_TIME_SECONDS * 1000)) &&
+               !scanTaskExitRequested(pContext, 0)) {
+            uAtClientResponseStart(atHandle, "+COPS:");
+            gotPrefix = (uAtClientErrorGet(atHandle) == 0);
+            uAtClientDeviceErrorGet(atHandle, &deviceError);
+            if (deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR) {
+                // An error has been returned by the module, e.g.
+                // +CME ERROR: Temporary Failure, try AT+COPS=? again
+                gotAnswer = true;
+            }
+            if (!gotPrefix) {
+                uAtClientClearError(atHandle);
+            }
+        }
+        if (gotPrefix) {
+            errorCodeOrNumber = scanReadNetworks(pContext, &bytesRead);
+            if (bytesRead > 0) {
+                // Got _something_ back, but it may still be the
+                // "test" response
+                gotAnswer = true;
+            }
+            if (bytesRead <= 12) {
+                errorCodeOrNumber = (int32_t) U_CELL_ERROR_TEMPORARY_FAILURE;
+            }
+        }
+        uAtClientResponseStop(atHandle);
+        uAtClientUnlock(atHandle);
+        if (!gotAnswer) {
+            // If we never got an answer, abort the
+            // command first.
+            abortCommand(pInstance);
+        }
+        uPortMutexUnlock(gUCellPrivateMutex);
+    }
+
+    if (scanTaskLockApi(pContext)) {
+        // Put the mode back if it was not already 1; if we've
+        // been asked to exit uCellNetScanStop() does this instead
+        if ((pContext->cFunMode >= 0) && (pContext->cFunMode != 1)) {
+            uCellPrivateCFunMode(pInstance, pContext->cFunMode);
+        }
+        pContext->cFunMode = -1;
+        uPortMutexUnlock(gUCellPrivateMutex);
+        if (!gotAnswer) {
+            errorCodeOrNumber = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        }
+        pContext->pCallback(cellHandle, NULL, NULL,
+                            U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED,
+                            errorCodeOrNumber, pContext->pCallbackParameter);
+    }
+
+    U_PORT_MUTEX_UNLOCK(pContext->taskRunningMutex);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+// Free an asynchronous scan context, stopping the scan if it is
+// running.
+static void scanFree(uCellNetScanContext_t *pContext)
+{
+    int32_t queueItem = 0;
+
+    if (pContext->taskHandle != NULL) {
+        uPortQueueSend(pContext->taskExitQueue, &queueItem);
+        U_PORT_MUTEX_LOCK(pContext->taskRunningMutex);
+        U_PORT_MUTEX_UNLOCK(pContext->taskRunningMutex);
+        // Give the task a chance to delete itself
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+    }
+    if (pContext->taskExitQueue != NULL) {
+        uPortQueueDelete(pContext->taskExitQueue);
+    }
+    if (pContext->taskRunningMutex != NULL) {
+        uPortMutexDelete(pContext->taskRunningMutex);
+    }
+    uPortFree(pContext);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS THAT ARE PRIVATE TO CELLULAR
+ * -------------------------------------------------------------- */
+
+// Stop any asynchronous network scan and remove its context.
+void uCellPrivateScanAsyncRemoveContext(uCellPrivateInstance_t *pInstance)
+{
+    if ((pInstance != NULL) && (pInstance->pScanAsyncContext != NULL)) {
+        scanFree((uCellNetScanContext_t *) pInstance->pScanAsyncContext);
+        pInstance->pScanAsyncContext = NULL;
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -2125,8 +2633,8 @@ int32_t uCellNetConnect(uDeviceHandle_t cellHandle,
                                 // have the radio off (but they still obey)
                                 setAutomaticMode(pInstance);
                             }
-                            // Register
-                            errorCode = registerNetwork(pInstance, pMccMnc);
+                            // Register and attach
+                            errorCode = registerAndAttach(pInstance, pMccMnc);
                             if (errorCode == 0) {
                                 // Print the network name for debug purposes
                                 if (uCellPrivateGetOperatorStr(pInstance,
@@ -2148,19 +2656,6 @@ int32_t uCellNetConnect(uDeviceHandle_t cellHandle,
                                 }
                             }
                         }
-                        if (errorCode == 0) {
-                            // This step _shouldn't_ be necessary.  However,
-                            // for reasons I don't understand, SARA-R4 can be
-                            // registered but not attached (i.e. AT+CGATT
-                            // returns 0) on both RATs (unh?).  Phil Ware, who
-                            // knows about these things, always goes through
-                            // (a) register, (b) wait for AT+CGATT to return 1
-                            // and then (c) check that a context is active
-                            // with AT+CGACT or using AT+UPSD (even for EUTRAN).
-                            // Since this sequence works for both RANs, it is
-                            // best to be consistent.
-                            errorCode = attachNetwork(pInstance);
-                        }
                         if (errorCode == 0) {
                             // Activate the context
                             if (U_CELL_PRIVATE_HAS(pInstance->pModule,
@@ -2191,13 +2686,6 @@ int32_t uCellNetConnect(uDeviceHandle_t cellHandle,
                              (*pApnConfig != '\0') && keepGoingLocalCb(pInstance));
 
                     if (errorCode == 0) {
-                        // Remember the MCC/MNC in case we need to deactivate
-                        // and reactivate context later and that causes
-                        // de/re-registration.
-                        memset(pInstance->mccMnc, 0, sizeof(pInstance->mccMnc));
-                        if (pMccMnc != NULL) {
-                            memcpy(pInstance->mccMnc, pMccMnc, sizeof(pInstance->mccMnc));
-                        }
                         pInstance->profileState = U_CELL_PRIVATE_PROFILE_STATE_SHOULD_BE_UP;
                         pInstance->connectedAtMs = uPortGetTickTimeMs();
                         uPortLog("U_CELL_NET: connected after %d second(s).\n",
@@ -2257,8 +2745,8 @@ int32_t uCellNetRegister(uDeviceHandle_t cellHandle,
                     // have the radio off (but they still obey)
                     setAutomaticMode(pInstance);
                 }
-                // Register
-                errorCode = registerNetwork(pInstance, pMccMnc);
+                // Register and attach
+                errorCode = registerAndAttach(pInstance, pMccMnc);
                 if (errorCode == 0) {
                     if (uCellPrivateGetOperatorStr(pInstance,
                                                    buffer,
@@ -2268,21 +2756,8 @@ int32_t uCellNetRegister(uDeviceHandle_t cellHandle,
                 } else {
                     uPortLog("U_CELL_NET: unable to register with the network.\n");
                 }
-                if (errorCode == 0) {
-                    // This step _shouldn't_ be necessary.  However,
-                    // for reasons I don't understand, SARA-R4 can
-                    // be registered but not attached.
-                    errorCode = attachNetwork(pInstance);
-                }
 
                 if (errorCode == 0) {
-                    // Remember the MCC/MNC in case we need to deactivate
-                    // and reactivate context later and that causes
-                    // de/re-registration.
-                    memset(pInstance->mccMnc, 0, sizeof(pInstance->mccMnc));
-                    if (pMccMnc != NULL) {
-                        memcpy(pInstance->mccMnc, pMccMnc, sizeof(pInstance->mccMnc));
-                    }
                     uPortLog("U_CELL_NET: registered after %d second(s).\n",
                              (int32_t) ((uPortGetTickTimeMs() -
                                          pInstance->startTimeMs) / 1000));
@@ -2389,7 +2864,9 @@ int32_t uCellNetActivate(uDeviceHandle_t cellHandle,
                                     if (strlen(pInstance->mccMnc) > 0) {
                                         pMccMnc = pInstance->mccMnc;
                                     }
-                                    errorCode = registerNetwork(pInstance, pMccMnc);
+                                    errorCode = registerNetwork(pInstance, pMccMnc,
+                                                                U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED,
+                                                                pInstance->mccMncFallback);
                                     if (errorCode == 0) {
                                         // This step _shouldn't_ be necessary.  However,
                                         // for reasons I don't understand, SARA-R4 can
@@ -2726,6 +3203,213 @@ void uCellNetScanGetLast(uDeviceHandle_t cellHandle)
     }
 }
 
+// Start an asynchronous network scan.
+int32_t uCellNetScanStart(uDeviceHandle_t cellHandle,
+                          void (*pCallback) (uDeviceHandle_t,
+                                             const char *,
+                                             const char *,
+                                             uCellNetRat_t,
+                                             int32_t,
+                                             void *),
+                          void *pCallbackParameter)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellNetScanContext_t *pContext;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pCallback != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            pContext = (uCellNetScanContext_t *) pInstance->pScanAsyncContext;
+            if (pContext != NULL) {
+                // The task holds its running mutex until the scan is over
+                if (uPortMutexTryLock(pContext->taskRunningMutex, 0) == 0) {
+                    uPortMutexUnlock(pContext->taskRunningMutex);
+                    uCellPrivateScanAsyncRemoveContext(pInstance);
+                } else {
+                    errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+                }
+            }
+            if (errorCode == 0) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pContext = (uCellNetScanContext_t *) pUPortMalloc(sizeof(*pContext));
+                if (pContext != NULL) {
+                    memset(pContext, 0, sizeof(*pContext));
+                    pContext->pInstance = pInstance;
+                    pContext->pCallback = pCallback;
+                    pContext->pCallbackParameter = pCallbackParameter;
+                    // Ensure that we're powered up
+                    pContext->cFunMode = uCellPrivateCFunOne(pInstance);
+                    errorCode = uPortMutexCreate(&(pContext->taskRunningMutex));
+                    if (errorCode == 0) {
+                        errorCode = uPortQueueCreate(1, sizeof(int32_t),
+                                                     &(pContext->taskExitQueue));
+                    }
+                    if (errorCode == 0) {
+                        pInstance->startTimeMs = uPortGetTickTimeMs();
+                        errorCode = uPortTaskCreate(scanTask, "cellScan",
+                                                    U_CELL_NET_SCAN_TASK_STACK_SIZE_BYTES,
+                                                    pContext,
+                                                    U_CELL_NET_SCAN_TASK_PRIORITY,
+                                                    &(pContext->taskHandle));
+                    }
+                    if (errorCode == 0) {
+                        // Wait for the task to lock its running mutex
+                        while (uPortMutexTryLock(pContext->taskRunningMutex, 0) == 0) {
+                            uPortMutexUnlock(pContext->taskRunningMutex);
+                            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                        }
+                        pInstance->pScanAsyncContext = pContext;
+                    } else {
+                        // Clean up on error
+                        if ((pContext->cFunMode >= 0) && (pContext->cFunMode != 1)) {
+                            uCellPrivateCFunMode(pInstance, pContext->cFunMode);
+                        }
+                        scanFree(pContext);
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Stop an asynchronous network scan.
+void uCellNetScanStop(uDeviceHandle_t cellHandle)
+{
+    uCellPrivateInstance_t *pInstance;
+    uCellNetScanContext_t *pContext = NULL;
+    int32_t queueItem = 0;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        if (pInstance != NULL) {
+            // Take the context away from the instance, so that no-one
+            // else can free it, and ask the task to exit
+            pContext = (uCellNetScanContext_t *) pInstance->pScanAsyncContext;
+            pInstance->pScanAsyncContext = NULL;
+            if ((pContext != NULL) && (pContext->taskHandle != NULL)) {
+                uPortQueueSend(pContext->taskExitQueue, &queueItem);
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+
+        if (pContext != NULL) {
+            // Wait for the task to exit with the mutex released, since
+            // the task needs the mutex to finish any attempt in progress;
+            // it checks for exit at least once a second
+            U_PORT_MUTEX_LOCK(pContext->taskRunningMutex);
+            U_PORT_MUTEX_UNLOCK(pContext->taskRunningMutex);
+            // Give the task a chance to delete itself
+            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+            pContext->taskHandle = NULL;
+
+            U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+            // If the task didn't get to put the mode back, do it here
+            pInstance = pUCellPrivateGetInstance(cellHandle);
+            if ((pInstance != NULL) &&
+                (pContext->cFunMode >= 0) && (pContext->cFunMode != 1)) {
+                uCellPrivateCFunMode(pInstance, pContext->cFunMode);
+            }
+
+            U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+
+            scanFree(pContext);
+        }
+    }
+}
+
+// Set the last good network callbacks.
+int32_t uCellNetSetLastGoodCallbacks(uDeviceHandle_t cellHandle,
+                                     bool (*pLoad) (uDeviceHandle_t,
+                                                    uCellNetLastGood_t *,
+                                                    void *),
+                                     void (*pSave) (uDeviceHandle_t,
+                                                    const uCellNetLastGood_t *,
+                                                    void *),
+                                     void *pCallbackParameter)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    uCellNetLastGoodContext_t *pContext;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if ((pLoad == NULL) && (pSave == NULL)) {
+                uPortFree(pInstance->pLastGoodContext);
+                pInstance->pLastGoodContext = NULL;
+            } else {
+                pContext = (uCellNetLastGoodContext_t *) pInstance->pLastGoodContext;
+                if (pContext == NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                    pContext = (uCellNetLastGoodContext_t *) pUPortMalloc(sizeof(*pContext));
+                    if (pContext != NULL) {
+                        memset(pContext, 0, sizeof(*pContext));
+                        pInstance->pLastGoodContext = pContext;
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    }
+                }
+                if (pContext != NULL) {
+                    pContext->pLoad = pLoad;
+                    pContext->pSave = pSave;
+                    pContext->pCallbackParameter = pCallbackParameter;
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Get the outcome of the attach attempts.
+int32_t uCellNetGetAttachAttempts(uDeviceHandle_t cellHandle,
+                                  uCellNetAttachAttempt_t *pAttempts,
+                                  size_t maxNum)
+{
+    int32_t errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+    size_t x = 0;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        errorCodeOrNumber = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pInstance != NULL) && (pAttempts != NULL)) {
+            for (x = 0; (x < pInstance->numAttachAttempts) && (x < maxNum); x++) {
+                *(pAttempts + x) = pInstance->attachAttempt[x];
+            }
+            errorCodeOrNumber = (int32_t) x;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCodeOrNumber;
+}
+
 // Enable or disable the registration status call-back.
 int32_t uCellNetSetRegistrationStatusCallback(uDeviceHandle_t cellHandle,
                                               void (*pCallback) (uCellNetRegDomain_t,
@@ -2908,7 +3592,6 @@ int32_t uCellNetGetMccMnc(uDeviceHandle_t cellHandle,
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uCellPrivateInstance_t *pInstance;
-    uAtClientHandle_t atHandle;
     char buffer[U_CELL_NET_MCC_MNC_LENGTH_BYTES];
     int32_t bytesRead;
 
@@ -2921,24 +3604,9 @@ int32_t uCellNetGetMccMnc(uDeviceHandle_t cellHandle,
         if ((pInstance != NULL) && (pMcc != NULL) && (pMnc != NULL)) {
             errorCode = (int32_t) U_CELL_ERROR_NOT_REGISTERED;
             if (uCellPrivateIsRegistered(pInstance)) {
-                atHandle = pInstance->atHandle;
-                uAtClientLock(atHandle);
-                // First set numeric format
-                uAtClientCommandStart(atHandle, "AT+COPS=3,2");
-                uAtClientCommandStopReadResponse(atHandle);
-                // Then read the network name
-                uAtClientCommandStart(atHandle, "AT+COPS?");
-                uAtClientCommandStop(atHandle);
-                uAtClientResponseStart(atHandle, "+COPS:");
-                // Skip past <mode> and <format>
-                uAtClientSkipParameters(atHandle, 2);
-                // Read the operator name, which will be
-                // as MCC/MNC
-                bytesRead = uAtClientReadString(atHandle, buffer,
-                                                sizeof(buffer), false);
-                uAtClientResponseStop(atHandle);
-                errorCode = uAtClientUnlock(atHandle);
-                if ((errorCode == 0) && (bytesRead >= 5)) {
+                bytesRead = getMccMncStr(pInstance, buffer);
+                if (bytesRead >= 5) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                     // Should now have a string something like "255255"
                     // The first three digits are the MCC, the next two or
                     // three the MNC
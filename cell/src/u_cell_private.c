@@ -635,6 +635,27 @@ void uCellPrivateClearDynamicParameters(uCellPrivateInstance_t *pInstance)
         pInstance->rat[x] = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
     }
     uCellPrivateClearRadioParameters(&(pInstance->radioParameters));
+    uCellPrivateIdentityInvalidate(pInstance, false);
+}
+
+// Invalidate the cached identity of the module.
+void uCellPrivateIdentityInvalidate(uCellPrivateInstance_t *pInstance,
+                                    bool simOnly)
+{
+    uCellPrivateIdentity_t *pIdentity = pInstance->pIdentity;
+
+    if (pIdentity != NULL) {
+        // Only the first character is written so that this is
+        // safe to do from a URC
+        pIdentity->imsi[0] = 0;
+        pIdentity->iccid[0] = 0;
+        if (!simOnly) {
+            pIdentity->imei[0] = 0;
+            pIdentity->manufacturer[0] = 0;
+            pIdentity->model[0] = 0;
+            pIdentity->firmwareVersion[0] = 0;
+        }
+    }
 }
 
 // Get the current CFUN mode.
@@ -658,6 +679,19 @@ int32_t uCellPrivateCFunGet(const uCellPrivateInstance_t *pInstance)
     return errorCodeOrMode;
 }
 
+// Wait for the AT+CFUN flip time to expire.
+void uCellPrivateCFunFlipWait(const uCellPrivateInstance_t *pInstance)
+{
+    int64_t waitMs = (U_CELL_PRIVATE_AT_CFUN_FLIP_DELAY_SECONDS * 1000) -
+                     (uPortGetTickTimeMs() - pInstance->lastCfunFlipTimeMs);
+
+    // Wait for exactly the time remaining, rather than in whole
+    // seconds, so as not to hang around any longer than necessary
+    if (waitMs > 0) {
+        uPortTaskBlock((int32_t) waitMs);
+    }
+}
+
 // Ensure that a module is powered up.
 int32_t  uCellPrivateCFunOne(uCellPrivateInstance_t *pInstance)
 {
@@ -674,10 +708,7 @@ int32_t  uCellPrivateCFunOne(uCellPrivateInstance_t *pInstance)
     // Set powered-up mode if it wasn't already
     if (errorCodeOrMode != 1) {
         // Wait for flip time to expire
-        while (uPortGetTickTimeMs() - pInstance->lastCfunFlipTimeMs <
-               (U_CELL_PRIVATE_AT_CFUN_FLIP_DELAY_SECONDS * 1000)) {
-            uPortTaskBlock(1000);
-        }
+        uCellPrivateCFunFlipWait(pInstance);
         uAtClientLock(atHandle);
         uAtClientCommandStart(atHandle, "AT+CFUN=1");
         uAtClientCommandStopReadResponse(atHandle);
@@ -699,10 +730,7 @@ void uCellPrivateCFunMode(uCellPrivateInstance_t *pInstance,
     uAtClientHandle_t atHandle = pInstance->atHandle;
 
     // Wait for flip time to expire
-    while (uPortGetTickTimeMs() - pInstance->lastCfunFlipTimeMs <
-           (U_CELL_PRIVATE_AT_CFUN_FLIP_DELAY_SECONDS * 1000)) {
-        uPortTaskBlock(1000);
-    }
+    uCellPrivateCFunFlipWait(pInstance);
     uAtClientLock(atHandle);
     if (mode != 1) {
         // If we're doing anything other than powering up,
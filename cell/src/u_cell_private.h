@@ -120,6 +120,14 @@ extern "C" {
 #define U_CELL_PRIVATE_GREETING_STR "Module has booted."
 #endif
 
+#ifndef U_CELL_PRIVATE_IDENTITY_STRING_MAX_LEN_BYTES
+/** The storage for each of the manufacturer, model and firmware
+ * version strings in the identity cache, including room for a null
+ * terminator; a string that does not fit is simply not cached.
+ */
+# define U_CELL_PRIVATE_IDENTITY_STRING_MAX_LEN_BYTES 64
+#endif
+
 #ifndef U_CELL_PRIVATE_UART_WAKE_UP_RETRIES
 /** The number of times to retry poking the AT interface
  * to wake the module up from UART power saving.
@@ -300,6 +308,19 @@ typedef struct {
     int32_t snrDb;   /**< The SINR as reported by the module (LTE only). */
 } uCellPrivateRadioParameters_t;
 
+/** The cache of the static identity of a module, see u_cell_info.c;
+ * each entry is a null-terminated string, an empty string meaning
+ * that the entry is not cached.
+ */
+typedef struct {
+    char imei[15 + 1]; /**< U_CELL_INFO_IMEI_SIZE plus a terminator. */
+    char imsi[15 + 1]; /**< U_CELL_INFO_IMSI_SIZE plus a terminator. */
+    char iccid[21];    /**< U_CELL_INFO_ICCID_BUFFER_SIZE. */
+    char manufacturer[U_CELL_PRIVATE_IDENTITY_STRING_MAX_LEN_BYTES];
+    char model[U_CELL_PRIVATE_IDENTITY_STRING_MAX_LEN_BYTES];
+    char firmwareVersion[U_CELL_PRIVATE_IDENTITY_STRING_MAX_LEN_BYTES];
+} uCellPrivateIdentity_t;
+
 /** Structure to hold a network name, MCC/MNC and RAT
  * as part of a linked list.
  */
@@ -410,6 +431,9 @@ typedef struct uCellPrivateInstance_t {
                                                        been requested (set
                                                        to zeroes for automatic
                                                        mode). */
+    bool mccMncFallback; /**< true if mccMnc is that of a last good
+                              network, in which case the module may
+                              fall back to automatic network selection. */
     int64_t lastCfunFlipTimeMs; /**< The last time a flip of state from
                                      "off" (AT+CFUN=0/4) to "on" (AT+CFUN=1)
                                      or back was performed. */
@@ -433,7 +457,18 @@ typedef struct uCellPrivateInstance_t {
     void *pConnectionStatusCallbackParameter;
     void (*pGreetingCallback) (uDeviceHandle_t, void *);
     void *pGreetingCallbackParameter;
+    volatile bool greetingSeen; /**< Set by the greeting URC handler, used
+                                     as a readiness indication by fast boot. */
+    bool fastBoot; /**< Set by uCellPwrSetFastBoot(). */
     uCellPrivateNet_t *pScanResults;    /**< Anchor for list of network scan results. */
+    void *pScanAsyncContext;            /**< Asynchronous network scan context, lodged
+                                             here as a void * to keep the types
+                                             private to u_cell_net.c. */
+    void *pLastGoodContext;             /**< Last good network callbacks, lodged
+                                             here as a void * to keep the types
+                                             private to u_cell_net.c. */
+    uCellNetAttachAttempt_t attachAttempt[U_CELL_NET_ATTACH_ATTEMPTS_MAX_NUM];
+    size_t numAttachAttempts;
     int32_t sockNextLocalPort;
     void *pSecurityC2cContext;  /**< Hook for a chip to chip security context. */
     volatile void *pMqttContext; /**< Hook for MQTT context, volatile as it
@@ -452,6 +487,18 @@ typedef struct uCellPrivateInstance_t {
     void *pHttpContext;  /**< Hook for a HTTP context. */
     void *pMuxContext; /**< CMUX context, lodged here as a void * to
                             avoid spreading its types all over. */
+    uPortSemaphoreHandle_t registrationSemaphore; /**< Given on every +CxREG URC so that
+                                                       registration can wake up on a
+                                                       change rather than waiting out a
+                                                       poll; NULL if not available. */
+    bool registrationUrcSeen; /**< True once a +CxREG URC has arrived from
+                                   the module, after which it is safe to
+                                   poll less often while registering. */
+    uCellPrivateIdentity_t *pIdentity; /**< Cache of the static identity of the
+                                            module, allocated on first use. */
+    void *pRadioSamplerContext; /**< Radio sampler context, lodged here as a
+                                     void * to keep the types private to
+                                     u_cell_info.c. */
     struct uCellPrivateInstance_t *pNext;
 } uCellPrivateInstance_t;
 
@@ -506,13 +553,25 @@ uCellPrivateInstance_t *pUCellPrivateGetInstance(uDeviceHandle_t cellHandle);
 void uCellPrivateClearRadioParameters(uCellPrivateRadioParameters_t *pParameters);
 
 /** Clear the dynamic parameters of an instance, so the network
- * status, the active RAT and the radio parameters.  This should
+ * status, the active RAT, the radio parameters and the cached
+ * identity of the module.  This should
  * be called when the module is being rebooted or powered off.
  *
  * @param pInstance a pointer to the instance.
  */
 void uCellPrivateClearDynamicParameters(uCellPrivateInstance_t *pInstance);
 
+/** Invalidate the cached identity of the module, see u_cell_info.c.
+ * This is called by uCellPrivateClearDynamicParameters() and may
+ * also be called from a URC.
+ *
+ * @param pInstance a pointer to the instance.
+ * @param simOnly   if true then only the entries that come from
+ *                  the SIM (the IMSI and ICCID) are invalidated.
+ */
+void uCellPrivateIdentityInvalidate(uCellPrivateInstance_t *pInstance,
+                                    bool simOnly);
+
 /** Get the current AT+CFUN mode of the module.
  *
  * @param pInstance  pointer to the cellular instance.
@@ -520,6 +579,14 @@ void uCellPrivateClearDynamicParameters(uCellPrivateInstance_t *pInstance);
  */
 int32_t uCellPrivateCFunGet(const uCellPrivateInstance_t *pInstance);
 
+/** Wait until #U_CELL_PRIVATE_AT_CFUN_FLIP_DELAY_SECONDS have
+ * passed since the last AT+CFUN state flip; returns immediately
+ * if they already have.
+ *
+ * @param pInstance  pointer to the cellular instance.
+ */
+void uCellPrivateCFunFlipWait(const uCellPrivateInstance_t *pInstance);
+
 /** Ensure that a module is powerered up if it isn't already
  * and return the AT+CFUN mode it was originally in so that
  * uCellPrivateCFunMode() can be called subseqently to put it
@@ -641,6 +708,34 @@ void uCellPrivateC2cRemoveContext(uCellPrivateInstance_t *pInstance);
  */
 void uCellPrivateLocRemoveContext(uCellPrivateInstance_t *pInstance);
 
+/** Stop the radio sampler, if running, and remove its context for
+ * the given instance; implemented in u_cell_info.c.
+ *
+ * Note: gUCellPrivateMutex should be locked before this is called.
+ *
+ * @param pInstance   a pointer to the cellular instance.
+ */
+void uCellPrivateSamplerRemoveContext(uCellPrivateInstance_t *pInstance);
+
+/** Refresh the radio parameters stored in the given instance;
+ * implemented in u_cell_info.c.
+ *
+ * Note: gUCellPrivateMutex should be locked before this is called.
+ *
+ * @param pInstance   a pointer to the cellular instance.
+ * @return            zero on success else negative error code.
+ */
+int32_t uCellPrivateRefreshRadioParameters(uCellPrivateInstance_t *pInstance);
+
+/** Stop any asynchronous network scan and remove its context for
+ * the given instance; implemented in u_cell_net.c.
+ *
+ * Note: gUCellPrivateMutex should be locked before this is called.
+ *
+ * @param pInstance   a pointer to the cellular instance.
+ */
+void uCellPrivateScanAsyncRemoveContext(uCellPrivateInstance_t *pInstance);
+
 /** Remove the sleep context for the given instance.
  *
  * Note: gUCellPrivateMutex should be locked before this is called.
@@ -70,6 +70,29 @@
  */
 #define U_CELL_PWR_IS_ALIVE_ATTEMPTS_POWER_ON 10
 
+#ifndef U_CELL_PWR_FAST_BOOT_PROBE_START_MS
+/** When fast boot is on, the time to wait for a response to the
+ * first "AT" probe of a booting module; this is doubled for each
+ * subsequent probe up to #U_CELL_PWR_FAST_BOOT_PROBE_MAX_MS.
+ */
+# define U_CELL_PWR_FAST_BOOT_PROBE_START_MS 100
+#endif
+
+#ifndef U_CELL_PWR_FAST_BOOT_PROBE_MAX_MS
+/** When fast boot is on, the maximum time to wait for a response
+ * to an "AT" probe of a booting module.
+ */
+# define U_CELL_PWR_FAST_BOOT_PROBE_MAX_MS 1600
+#endif
+
+#ifndef U_CELL_PWR_FAST_BOOT_REBOOT_SETTLE_MS
+/** When fast boot is on, how long to wait after a reboot command
+ * or a reset before probing the module, to be sure that it has
+ * actually gone down and isn't answering on its way out.
+ */
+# define U_CELL_PWR_FAST_BOOT_REBOOT_SETTLE_MS 1000
+#endif
+
 /** The number of time to try a configuration AT command by default.
  */
 #define U_CELL_PWR_CONFIGURATION_COMMAND_TRIES 3
@@ -853,6 +876,16 @@ static void UUPSMR_urc(uAtClientHandle_t atHandle, void *pParameter)
     }
 }
 
+// URC for a change in SIM status (which is emitted if SIM status
+// reporting has been switched on with AT+USIMSTAT): the SIM may
+// have been swapped so forget what we know of it.
+static void UUSIMSTAT_urc(uAtClientHandle_t atHandle, void *pParameter)
+{
+    (void) atHandle;
+
+    uCellPrivateIdentityInvalidate((uCellPrivateInstance_t *) pParameter, true);
+}
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS: POWERING UP/DOWN
  * -------------------------------------------------------------- */
@@ -902,6 +935,64 @@ static int32_t moduleIsAlive(uCellPrivateInstance_t *pInstance,
     return errorCode;
 }
 
+// Wait for a module that is booting to respond, for fast boot: probe
+// with "AT" at exponentially increasing intervals, starting short,
+// and stop as soon as the module answers, up to a maximum of maxWaitMs.
+// The greeting URC, if the user has set one up, also counts as
+// a sign that the module is ready, at which point we go straight
+// to a probe with the full response time.
+// The caller must set pInstance->greetingSeen to false before
+// starting the module booting.
+static int32_t waitForBoot(uCellPrivateInstance_t *pInstance,
+                           int32_t maxWaitMs,
+                           bool (*pKeepGoingCallback) (uDeviceHandle_t))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_RESPONDING;
+    uAtClientDeviceError_t deviceError;
+    uAtClientHandle_t atHandle = pInstance->atHandle;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    int32_t probeTimeoutMs = U_CELL_PWR_FAST_BOOT_PROBE_START_MS;
+
+    while ((errorCode != 0) && (uPortGetTickTimeMs() - startTimeMs < maxWaitMs) &&
+           ((pKeepGoingCallback == NULL) || pKeepGoingCallback(pInstance->cellHandle))) {
+        if (pInstance->greetingSeen) {
+            probeTimeoutMs = pInstance->pModule->responseMaxWaitMs;
+        }
+        uAtClientLock(atHandle);
+        uAtClientTimeoutSet(atHandle, probeTimeoutMs);
+        uAtClientCommandStart(atHandle, "AT");
+        uAtClientCommandStopReadResponse(atHandle);
+        uAtClientDeviceErrorGet(atHandle, &deviceError);
+        if ((uAtClientUnlock(atHandle) == 0) ||
+            (deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        } else if (probeTimeoutMs < U_CELL_PWR_FAST_BOOT_PROBE_MAX_MS) {
+            probeTimeoutMs *= 2;
+            if (probeTimeoutMs > U_CELL_PWR_FAST_BOOT_PROBE_MAX_MS) {
+                probeTimeoutMs = U_CELL_PWR_FAST_BOOT_PROBE_MAX_MS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Wait for a module to boot after a reboot command or reset, using
+// fast boot if it is switched on, else the fixed wait.
+static void waitForReboot(uCellPrivateInstance_t *pInstance, int32_t waitMs,
+                          bool (*pKeepGoingCallback) (uDeviceHandle_t))
+{
+    if (pInstance->fastBoot) {
+        uPortTaskBlock(U_CELL_PWR_FAST_BOOT_REBOOT_SETTLE_MS);
+        // If this fails, moduleIsAlive(), which always follows,
+        // will have another go with the normal timing
+        waitForBoot(pInstance, waitMs - U_CELL_PWR_FAST_BOOT_REBOOT_SETTLE_MS,
+                    pKeepGoingCallback);
+    } else {
+        uPortTaskBlock(waitMs);
+    }
+}
+
 // Configure one item in the cellular module.
 static bool moduleConfigureOne(uAtClientHandle_t atHandle,
                                const char *pAtString,
@@ -1078,6 +1169,10 @@ static int32_t moduleConfigure(uCellPrivateInstance_t *pInstance,
                                        UUPSMR_urc, pInstance);
             }
         }
+        // Catch SIM status changes, which invalidate the cached
+        // SIM identity; this has no effect if it was already there
+        uAtClientSetUrcHandler(pInstance->atHandle, "+UUSIMSTAT:",
+                               UUSIMSTAT_urc, pInstance);
         // Update the sleep parameters; note that we ask for the
         // requested 3GPP power saving state here, rather than the
         // assigned, since it might not be assigned by the network
@@ -1126,10 +1221,7 @@ static int32_t moduleConfigure(uCellPrivateInstance_t *pInstance,
         if (andRadioOff) {
             // Switch the radio off until commanded to connect
             // Wait for flip time to expire
-            while (uPortGetTickTimeMs() - pInstance->lastCfunFlipTimeMs <
-                   (U_CELL_PRIVATE_AT_CFUN_FLIP_DELAY_SECONDS * 1000)) {
-                uPortTaskBlock(1000);
-            }
+            uCellPrivateCFunFlipWait(pInstance);
             uAtClientLock(atHandle);
             uAtClientCommandStart(atHandle, "AT+CFUN=");
             uAtClientWriteInt(atHandle,
@@ -1291,6 +1383,11 @@ int32_t uCellPwrPrivateOn(uCellPrivateInstance_t *pInstance,
     // correctly once more
     pInstance->deepSleepState = U_CELL_PRIVATE_DEEP_SLEEP_STATE_UNKNOWN;
     pInstance->deepSleepBlockedBy = -1;
+    if (!asleepAtStart) {
+        // The SIM may have been changed while we were off: the
+        // identity of the module will be read afresh
+        uCellPrivateIdentityInvalidate(pInstance, false);
+    }
 
     if (pInstance->pinEnablePower >= 0) {
         enablePowerAtStart = uPortGpioGet(pInstance->pinEnablePower);
@@ -1342,6 +1439,7 @@ int32_t uCellPwrPrivateOn(uCellPrivateInstance_t *pInstance,
             // Wait for things to settle
             uPortTaskBlock(100);
 
+            pInstance->greetingSeen = false;
             if (pInstance->pinPwrOn >= 0) {
                 // Power the module on by holding the PWR_ON pin in
                 // the relevant state for the correct number of milliseconds
@@ -1362,6 +1460,14 @@ int32_t uCellPwrPrivateOn(uCellPrivateInstance_t *pInstance,
                     }
                 }
             }
+            if (pInstance->fastBoot) {
+                // Catch the module as soon as it is ready rather than
+                // waiting out a full response time on each probe;
+                // if this fails the loop below has a go as normal
+                errorCode = waitForBoot(pInstance,
+                                        pInstance->pModule->bootWaitSeconds * 1000,
+                                        pKeepGoingCallback);
+            }
             // Cellular module should be up, see if it's there
             // and, if so, configure it
             for (size_t y = U_CELL_PWR_IS_ALIVE_ATTEMPTS_POWER_ON;
@@ -1925,10 +2031,7 @@ int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
         if (pInstance != NULL) {
             uPortLog("U_CELL_PWR: rebooting.\n");
             // Wait for flip time to expire
-            while (uPortGetTickTimeMs() - pInstance->lastCfunFlipTimeMs <
-                   (U_CELL_PRIVATE_AT_CFUN_FLIP_DELAY_SECONDS * 1000)) {
-                uPortTaskBlock(1000);
-            }
+            uCellPrivateCFunFlipWait(pInstance);
             // Sleep is no longer available
             pInstance->deepSleepState = U_CELL_PRIVATE_DEEP_SLEEP_STATE_UNAVAILABLE;
             // Need to disable mux mode
@@ -1939,6 +2042,7 @@ int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
                                 U_CELL_PRIVATE_AT_CFUN_OFF_RESPONSE_TIME_SECONDS * 1000);
             // Clear the dynamic parameters
             uCellPrivateClearDynamicParameters(pInstance);
+            pInstance->greetingSeen = false;
             uAtClientCommandStart(atHandle, "AT+CFUN=");
             if (pInstance->pModule->moduleType == U_CELL_MODULE_TYPE_SARA_R5) {
                 // SARA-R5 doesn't support 15 (which doesn't reset the SIM)
@@ -1954,7 +2058,8 @@ int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
                 // We have rebooted
                 pInstance->rebootIsRequired = false;
                 // Wait for the module to boot
-                uPortTaskBlock(pInstance->pModule->rebootCommandWaitSeconds * 1000);
+                waitForReboot(pInstance, pInstance->pModule->rebootCommandWaitSeconds * 1000,
+                              pKeepGoingCallback);
                 // Two goes at this with a power-off inbetween,
                 // 'cos I've seen some modules
                 // fail during initial configuration.
@@ -2013,12 +2118,18 @@ int32_t uCellPwrReboot(uDeviceHandle_t cellHandle,
                             uPortTaskBlock(100);
                         }
                         if (pInstance->pinPwrOn >= 0) {
+                            pInstance->greetingSeen = false;
                             uPortGpioSet(pInstance->pinPwrOn,
                                          U_CELL_PRIVATE_PWR_ON_PIN_TOGGLE_TO_STATE(pInstance->pinStates));
                             uPortTaskBlock(pInstance->pModule->powerOnPullMs);
                             uPortGpioSet(pInstance->pinPwrOn,
                                          (int32_t) !U_CELL_PRIVATE_PWR_ON_PIN_TOGGLE_TO_STATE(pInstance->pinStates));
-                            uPortTaskBlock(pInstance->pModule->bootWaitSeconds * 1000);
+                            if (pInstance->fastBoot) {
+                                waitForBoot(pInstance, pInstance->pModule->bootWaitSeconds * 1000,
+                                            pKeepGoingCallback);
+                            } else {
+                                uPortTaskBlock(pInstance->pModule->bootWaitSeconds * 1000);
+                            }
                         }
                     }
                 }
@@ -2091,6 +2202,8 @@ int32_t uCellPwrResetHard(uDeviceHandle_t cellHandle, int32_t pinReset)
                 if (platformError == 0) {
                     // Remove any security context as these disappear at reboot
                     uCellPrivateC2cRemoveContext(pInstance);
+                    // The identity of the module will be read afresh
+                    uCellPrivateIdentityInvalidate(pInstance, false);
                     // We have rebooted
                     pInstance->rebootIsRequired = false;
                     startTime = uPortGetTickTimeMs();
@@ -2101,9 +2214,11 @@ int32_t uCellPwrResetHard(uDeviceHandle_t cellHandle, int32_t pinReset)
                     // Note: not checking for errors here, it would have
                     // barfed above if there were a problem and there's
                     // nothing we can do about it anyway
+                    pInstance->greetingSeen = false;
                     uPortGpioSet(pinReset, (int32_t) !U_CELL_RESET_PIN_TOGGLE_TO_STATE);
                     // Wait for the module to boot
-                    uPortTaskBlock(pInstance->pModule->rebootCommandWaitSeconds * 1000);
+                    waitForReboot(pInstance, pInstance->pModule->rebootCommandWaitSeconds * 1000,
+                                  NULL);
                     if (pInstance->pModule->moduleType == U_CELL_MODULE_TYPE_SARA_R5) {
                         // SARA-R5 chucks out a load of stuff after
                         // boot in its development version: flush it away
@@ -2213,6 +2328,50 @@ int32_t uCellPwrGetDtrPowerSavingPin(uDeviceHandle_t cellHandle)
     return errorCodeOrPin;
 }
 
+// Switch fast boot on or off.
+int32_t uCellPwrSetFastBoot(uDeviceHandle_t cellHandle, bool onNotOff)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uCellPrivateInstance_t *pInstance;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (pInstance != NULL) {
+            pInstance->fastBoot = onNotOff;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Get whether fast boot is on or off.
+bool uCellPwrGetFastBoot(uDeviceHandle_t cellHandle)
+{
+    bool fastBoot = false;
+    uCellPrivateInstance_t *pInstance;
+
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        if (pInstance != NULL) {
+            fastBoot = pInstance->fastBoot;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+
+    return fastBoot;
+}
+
 // Set the requested 3GPP power saving parameters.
 int32_t  uCellPwrSetRequested3gppPowerSaving(uDeviceHandle_t cellHandle,
                                              uCellNetRat_t rat,
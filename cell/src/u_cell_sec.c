@@ -706,6 +706,7 @@ int32_t uCellSecC2cOpen(uDeviceHandle_t cellHandle,
                                          (x > 0) && !pContext->isV2; x--) {
                                         pContext->isV2 = (pContext->hmacKey[x] != 0);
                                     }
+                                    uCellSecC2cContextPrepare(pContext);
                                     // Hook the intercept functions into the AT handler
                                     uAtClientStreamInterceptTx(atHandle, pUCellSecC2cInterceptTx,
                                                                (void *) pContext);
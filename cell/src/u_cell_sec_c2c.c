@@ -70,16 +70,23 @@
  */
 #define U_CELL_SEC_C2C_FRAME_MARKER 0xf9
 
+/** The value XORed with the HMAC key to form the inner key pad.
+ */
+#define U_CELL_SEC_C2C_HMAC_INNER_PAD 0x36
+
+/** The value XORed with the HMAC key to form the outer key pad.
+ */
+#define U_CELL_SEC_C2C_HMAC_OUTER_PAD 0x5c
+
 // Check that an array of size U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES
 // is big enough to hold an IV also
 #if U_CELL_SEC_C2C_IV_LENGTH_BYTES > U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES
 # error U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES must be at least as big as U_CELL_SEC_C2C_IV_LENGTH_BYTES since we size a local array below on U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES and it is used for both.
 #endif
 
-// Check that U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES is at least as
-// big as U_SECURITY_C2C_TE_SECRET_LENGTH_BYTES
-#if U_SECURITY_C2C_TE_SECRET_LENGTH_BYTES > U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES
-# error U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES must be at least as big as U_SECURITY_C2C_TE_SECRET_LENGTH_BYTES since a TE secret is temporarily written to the space a truncated MAC would occupy during V2 encoding.
+// Check that the HMAC key fits into a HMAC block without hashing
+#if U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES > U_CELL_SEC_C2C_HMAC_BLOCK_LENGTH_BYTES
+# error U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES must be no bigger than U_CELL_SEC_C2C_HMAC_BLOCK_LENGTH_BYTES since the HMAC key is used directly to form the key pads.
 #endif
 
 /* ----------------------------------------------------------------
@@ -190,6 +197,58 @@ static size_t unpad(const char *pBuffer, size_t bufferLength)
     return bufferLength;
 }
 
+// Perform the V2 HMAC SHA256 calculation, across pInput followed
+// by the TE secret, using the key pads precomputed in the context;
+// the pieces are fed to the hash in turn so that nothing needs to
+// be copied to make them contiguous.
+static int32_t hmacSha256(const uCellSecC2cContext_t *pContext,
+                          const char *pInput, size_t inputLengthBytes,
+                          char *pOutput)
+{
+    int32_t errorCode;
+    int32_t finishErrorCode;
+    void *pSha256Context = NULL;
+    char innerHash[U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES];
+
+    // The inner hash: inner key pad, input, TE secret
+    errorCode = uPortCryptoSha256Init(&pSha256Context);
+    if (errorCode == 0) {
+        errorCode = uPortCryptoSha256Update(pSha256Context, pContext->hmacInnerPad,
+                                            sizeof(pContext->hmacInnerPad));
+        if (errorCode == 0) {
+            errorCode = uPortCryptoSha256Update(pSha256Context, pInput,
+                                                inputLengthBytes);
+        }
+        if (errorCode == 0) {
+            errorCode = uPortCryptoSha256Update(pSha256Context, pContext->teSecret,
+                                                sizeof(pContext->teSecret));
+        }
+        // Always finish, to free the context
+        finishErrorCode = uPortCryptoSha256Finish(pSha256Context, innerHash);
+        if (errorCode == 0) {
+            errorCode = finishErrorCode;
+        }
+    }
+    if (errorCode == 0) {
+        // The outer hash: outer key pad, inner hash
+        errorCode = uPortCryptoSha256Init(&pSha256Context);
+        if (errorCode == 0) {
+            errorCode = uPortCryptoSha256Update(pSha256Context, pContext->hmacOuterPad,
+                                                sizeof(pContext->hmacOuterPad));
+            if (errorCode == 0) {
+                errorCode = uPortCryptoSha256Update(pSha256Context, innerHash,
+                                                    sizeof(innerHash));
+            }
+            finishErrorCode = uPortCryptoSha256Finish(pSha256Context, pOutput);
+            if (errorCode == 0) {
+                errorCode = finishErrorCode;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
 #ifdef U_CELL_SEC_C2C_DETAILED_DEBUG
 #if U_CFG_ENABLE_LOGGING
 // Print out text.
@@ -355,24 +414,12 @@ static size_t encode(const uCellSecC2cContext_t *pContext)
                                         pTx->txOut + 3 + x) == 0) {
             x += pTx->txInLength;
             // Next we need to create a HMAC tag across the
-            // encrypted text, the IV and the TE Secret.
-            // The simplest way to do this is to copy
-            // the TE Secret into the output buffer, perform
-            // the calculation (putting the result into the
-            // local variable ivOrMac) and then we overwrite
-            // where it is in the buffer with the truncated MAC
-            // (which is at least as big, as checked with
-            // a #error above)
-            memcpy(pTx->txOut + 3 + x, pContext->teSecret,
-                   sizeof(pContext->teSecret));
-            if (uPortCryptoHmacSha256(pContext->hmacKey,
-                                      sizeof(pContext->hmacKey),
-                                      pTx->txOut + 3,
-                                      x + sizeof(pContext->teSecret),
-                                      ivOrMac) == 0) {
+            // encrypted text, the IV and the TE Secret,
+            // putting the result into the local variable
+            // ivOrMac
+            if (hmacSha256(pContext, pTx->txOut + 3, x, ivOrMac) == 0) {
                 // Now copy the first 16 bytes of the
-                // generated HMAC tag into the output,
-                // overwriting the TE Secret
+                // generated HMAC tag into the output
                 memcpy(pTx->txOut + 3 + x,
                        ivOrMac, U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES);
                 // Account for its length
@@ -464,6 +511,7 @@ static size_t decode(const uCellSecC2cContext_t *pContext)
     size_t chunkLengthLimit;
     uint16_t y;
     char *pData = pRx->pRxIn;
+    char mac[U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES];
 #ifdef U_CELL_SEC_C2C_DETAILED_DEBUG
     size_t z = 0;
 #endif
@@ -576,9 +624,6 @@ static size_t decode(const uCellSecC2cContext_t *pContext)
                     // encrypted text (i.e. minus the
                     // HMAC tag that forms part of
                     // the payload) plus the TE Secret.
-                    // To do this concatenate the two
-                    // into rxOut (there is enough room
-                    // to do so).
 #ifdef U_CELL_SEC_C2C_DETAILED_DEBUG
                     uPortLog("U_CELL_SEC_C2C_DECODE: version 2.\n");
 
@@ -593,22 +638,12 @@ static size_t decode(const uCellSecC2cContext_t *pContext)
 #endif
                     x = chunkLength -
                         U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES;
-                    memcpy(pRx->rxOut, pData, x);
-                    memcpy(pRx->rxOut + x, pContext->teSecret,
-                           sizeof(pContext->teSecret));
-                    // Compute the HMAC SHA256 of this block
-                    // using the HMAC tag as the key and put it
-                    // on the end of rxOut as temporary storage.
-                    if (uPortCryptoHmacSha256(pContext->hmacKey,
-                                              sizeof(pContext->hmacKey),
-                                              pRx->rxOut,
-                                              x + sizeof(pContext->teSecret),
-                                              pRx->rxOut +
-                                              x + sizeof(pContext->teSecret)) == 0) {
+                    // Compute the HMAC SHA256 of this block,
+                    // where it sits, using the HMAC tag as the key.
+                    if (hmacSha256(pContext, pData, x, mac) == 0) {
                         // Compare the first 16 bytes of
                         // it with the truncated MAC we received.
-                        if (memcmp(pData + x, pRx->rxOut + x +
-                                   sizeof(pContext->teSecret),
+                        if (memcmp(pData + x, mac,
                                    U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES) == 0) {
                             // The MAC's match, decrypt the contents
                             // into rxOut using the key and the IV from the
@@ -847,6 +882,23 @@ static size_t decode(const uCellSecC2cContext_t *pContext)
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Prepare the per-session state of a chip to chip security context.
+void uCellSecC2cContextPrepare(uCellSecC2cContext_t *pContext)
+{
+    size_t x = 0;
+
+    // The HMAC key is shorter than a block so it is zero-padded
+    // to the block length and then XORed with the pad values
+    for (; x < sizeof(pContext->hmacKey); x++) {
+        pContext->hmacInnerPad[x] = (char) (pContext->hmacKey[x] ^ U_CELL_SEC_C2C_HMAC_INNER_PAD);
+        pContext->hmacOuterPad[x] = (char) (pContext->hmacKey[x] ^ U_CELL_SEC_C2C_HMAC_OUTER_PAD);
+    }
+    for (; x < sizeof(pContext->hmacInnerPad); x++) {
+        pContext->hmacInnerPad[x] = (char) U_CELL_SEC_C2C_HMAC_INNER_PAD;
+        pContext->hmacOuterPad[x] = (char) U_CELL_SEC_C2C_HMAC_OUTER_PAD;
+    }
+}
+
 // Transmit intercept function.
 const char *pUCellSecC2cInterceptTx(uAtClientHandle_t atHandle,
                                     const char **ppData,
@@ -73,6 +73,11 @@ extern "C" {
  */
 #define U_CELL_SEC_C2C_MAX_PAD_LENGTH_BYTES 16
 
+/** The block length of SHA256, which is also the length of
+ * the inner and outer key pads of a HMAC SHA256 calculation.
+ */
+#define U_CELL_SEC_C2C_HMAC_BLOCK_LENGTH_BYTES 64
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -116,6 +121,10 @@ typedef struct {
     char teSecret[U_SECURITY_C2C_TE_SECRET_LENGTH_BYTES];
     char key[U_SECURITY_C2C_ENCRYPTION_KEY_LENGTH_BYTES];
     char hmacKey[U_SECURITY_C2C_HMAC_TAG_LENGTH_BYTES];
+    // The HMAC key XORed with the inner and outer pad
+    // values, populated by uCellSecC2cContextPrepare()
+    char hmacInnerPad[U_CELL_SEC_C2C_HMAC_BLOCK_LENGTH_BYTES];
+    char hmacOuterPad[U_CELL_SEC_C2C_HMAC_BLOCK_LENGTH_BYTES];
     uCellSecC2cContextTx_t *pTx;
     uCellSecC2cContextRx_t *pRx;
 } uCellSecC2cContext_t;
@@ -124,6 +133,16 @@ typedef struct {
  * FUNCTIONS
  * -------------------------------------------------------------- */
 
+/** Prepare the per-session state of a chip to chip security
+ * context, i.e. the HMAC key pads, so that they need not be
+ * worked out again for every frame.  This must be called once
+ * hmacKey has been populated and before the context is passed
+ * to the intercept functions.
+ *
+ * @param pContext  a pointer to the context; cannot be NULL.
+ */
+void uCellSecC2cContextPrepare(uCellSecC2cContext_t *pContext);
+
 /** Transmit intercept function, suitable for hooking
  * into the AT stream with uAtClientStreamInterceptTx().
  *
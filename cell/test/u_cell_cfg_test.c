@@ -776,6 +776,109 @@ U_PORT_TEST_FUNCTION("[cellCfg]", "cellCfgUdconf")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+/** Test configuration snapshots; the snapshot is first made to
+ * match what the module already has, so that nothing is changed,
+ * then one setting is made to differ, so that exactly that one
+ * setting is written, after which it is put back.
+ */
+U_PORT_TEST_FUNCTION("[cellCfg]", "cellCfgSnapshot")
+{
+    uDeviceHandle_t cellHandle;
+    const uCellPrivateModule_t *pModule;
+    uCellCfgSnapshot_t snapshot = U_CELL_CFG_SNAPSHOT_DEFAULTS;
+    int32_t startTimeMs;
+    int32_t timeColdMs;
+    int32_t timeWarmMs;
+    int32_t udconfValue;
+    int32_t heapUsed;
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Do the standard preamble
+    U_PORT_TEST_ASSERT(uCellTestPrivatePreamble(U_CFG_TEST_CELL_MODULE_TYPE,
+                                                &gHandles, true) == 0);
+    cellHandle = gHandles.cellHandle;
+
+    // Get the private module data as we need it for testing
+    pModule = pUCellPrivateGetModule(cellHandle);
+    U_PORT_TEST_ASSERT(pModule != NULL);
+    //lint -esym(613, pModule) Suppress possible use of NULL pointer
+    // for pModule from now on
+
+    // Make the snapshot match what is in the module
+    if (U_CELL_PRIVATE_HAS(pModule, U_CELL_PRIVATE_FEATURE_MNO_PROFILE)) {
+        snapshot.mnoProfile = uCellCfgGetMnoProfile(cellHandle);
+        U_PORT_TEST_ASSERT(snapshot.mnoProfile >= 0);
+    }
+    for (size_t x = 0; (x < pModule->maxNumSimultaneousRats) &&
+         (x < sizeof(snapshot.rat) / sizeof(snapshot.rat[0])); x++) {
+        snapshot.rat[x] = uCellCfgGetRat(cellHandle, (int32_t) x);
+        if ((int32_t) snapshot.rat[x] < 0) {
+            snapshot.rat[x] = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+        }
+    }
+    if (pModule->supportedRatsBitmap & (1UL << (int32_t) U_CELL_NET_RAT_CATM1)) {
+        U_PORT_TEST_ASSERT(uCellCfgGetBandMask(cellHandle, U_CELL_NET_RAT_CATM1,
+                                               &snapshot.bandMask1CatM1,
+                                               &snapshot.bandMask2CatM1) == 0);
+    }
+    // All modules support AT+UDCONF=1
+    snapshot.udconf[0].param1 = 1;
+    snapshot.udconf[0].param2 = -1;
+    snapshot.udconf[0].value = uCellCfgGetUdconf(cellHandle, 1, -1);
+    U_PORT_TEST_ASSERT(snapshot.udconf[0].value >= 0);
+    snapshot.numUdconf = 1;
+
+    U_PORT_TEST_ASSERT(uCellCfgSnapshotForget(cellHandle) == 0);
+    U_TEST_PRINT_LINE("applying snapshot with no fingerprint...");
+    startTimeMs = uPortGetTickTimeMs();
+    U_PORT_TEST_ASSERT(uCellCfgSnapshotApply(cellHandle, &snapshot) == 0);
+    timeColdMs = uPortGetTickTimeMs() - startTimeMs;
+    U_PORT_TEST_ASSERT(!uCellPwrRebootIsRequired(cellHandle));
+    U_TEST_PRINT_LINE("applying snapshot again...");
+    startTimeMs = uPortGetTickTimeMs();
+    U_PORT_TEST_ASSERT(uCellCfgSnapshotApply(cellHandle, &snapshot) == 0);
+    timeWarmMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("applying the snapshot took %d ms without a fingerprint,"
+                      " %d ms with.", timeColdMs, timeWarmMs);
+
+    // Now make the AT+UDCONF=1 setting (0 or 1) differ: only
+    // that one setting should be written
+    udconfValue = snapshot.udconf[0].value;
+    snapshot.udconf[0].value = (udconfValue == 0) ? 1 : 0;
+    U_TEST_PRINT_LINE("applying snapshot with AT+UDCONF=1 changed from %d to %d...",
+                      udconfValue, snapshot.udconf[0].value);
+    U_PORT_TEST_ASSERT(uCellCfgSnapshotApply(cellHandle, &snapshot) == 1);
+    U_PORT_TEST_ASSERT(uCellCfgGetUdconf(cellHandle, 1, -1) == snapshot.udconf[0].value);
+    // Applying it again should write nothing, both with the
+    // fingerprint and, having forgotten it, when reading back
+    U_PORT_TEST_ASSERT(uCellCfgSnapshotApply(cellHandle, &snapshot) == 0);
+    U_PORT_TEST_ASSERT(uCellCfgSnapshotForget(cellHandle) == 0);
+    U_PORT_TEST_ASSERT(uCellCfgSnapshotApply(cellHandle, &snapshot) == 0);
+    U_PORT_TEST_ASSERT(uCellCfgGetUdconf(cellHandle, 1, -1) == snapshot.udconf[0].value);
+
+    // Put the original setting back
+    snapshot.udconf[0].value = udconfValue;
+    U_PORT_TEST_ASSERT(uCellCfgSnapshotApply(cellHandle, &snapshot) == 1);
+    U_PORT_TEST_ASSERT(uCellCfgGetUdconf(cellHandle, 1, -1) == udconfValue);
+    U_PORT_TEST_ASSERT(uCellCfgSnapshotForget(cellHandle) == 0);
+
+    // Do the standard postamble, leaving the module on for the next
+    // test to speed things up
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 /** Test setting auto-bauding off and on.
  * IMPORTANT: this test leaves auto-bauding OFF afterwards.
  * This is because that way, during automated testing, we will
@@ -98,6 +98,15 @@
  */
 #define U_CELL_FILE_TEST_REENTRANT_STRING_SIZE 9
 
+/** The name of the file to use when testing streaming.
+ */
+#define U_CELL_FILE_TEST_STREAM_FILE_NAME "stream"
+
+/** The size of the file to use when testing streaming: a few
+ * whole blocks plus an odd bit on the end.
+ */
+#define U_CELL_FILE_TEST_STREAM_SIZE_BYTES ((U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES * 3) + 17)
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -110,6 +119,14 @@
 */
 static uCellTestPrivate_t gHandles = U_CELL_TEST_PRIVATE_DEFAULTS;
 
+/** The number of bytes handled by the stream callbacks.
+ */
+static size_t gStreamSizeBytes = 0;
+
+/** The number of errors seen by the stream callbacks.
+ */
+static int32_t gStreamErrorCount = 0;
+
 /* ----------------------------------------------------------------
 * STATIC FUNCTIONS
 * -------------------------------------------------------------- */
@@ -141,6 +158,55 @@ static bool checkTracker(bool *pTracker, size_t size)
     return isGood;
 }
 
+// The contents of the stream test file at a given offset.
+static char streamByte(size_t offset)
+{
+    // 251 is prime, so the pattern won't line up with the blocks
+    return (char) (offset % 251);
+}
+
+// Callback supplying data for uCellFileWriteStream().
+static int32_t writeStreamCallback(uDeviceHandle_t cellHandle,
+                                   char *pBuffer, size_t bufferSize,
+                                   void *pCallbackParam)
+{
+    size_t size = U_CELL_FILE_TEST_STREAM_SIZE_BYTES - gStreamSizeBytes;
+
+    (void) cellHandle;
+    if (pCallbackParam != &gStreamSizeBytes) {
+        gStreamErrorCount++;
+    }
+    if (size > bufferSize) {
+        size = bufferSize;
+    }
+    for (size_t x = 0; x < size; x++) {
+        *(pBuffer + x) = streamByte(gStreamSizeBytes + x);
+    }
+    gStreamSizeBytes += size;
+
+    return (int32_t) size;
+}
+
+// Callback receiving data from uCellFileReadStream().
+static bool readStreamCallback(uDeviceHandle_t cellHandle,
+                               const char *pData, size_t dataSize,
+                               size_t offset, void *pCallbackParam)
+{
+    (void) cellHandle;
+    if ((pCallbackParam != &gStreamSizeBytes) || (offset != gStreamSizeBytes) ||
+        (dataSize > U_CELL_FILE_STREAM_BLOCK_LENGTH_BYTES)) {
+        gStreamErrorCount++;
+    }
+    for (size_t x = 0; x < dataSize; x++) {
+        if (*(pData + x) != streamByte(offset + x)) {
+            gStreamErrorCount++;
+        }
+    }
+    gStreamSizeBytes += dataSize;
+
+    return true;
+}
+
 /* ----------------------------------------------------------------
 * PUBLIC FUNCTIONS
 * -------------------------------------------------------------- */
@@ -422,6 +488,85 @@ U_PORT_TEST_FUNCTION("[cellFile]", "cellFileRead")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+/** Test streaming a larger file in and out.
+ */
+U_PORT_TEST_FUNCTION("[cellFile]", "cellFileStream")
+{
+    int32_t heapUsed;
+    uDeviceHandle_t cellHandle;
+    int32_t result;
+    int32_t startTimeMs;
+    int32_t durationMs;
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Do the standard preamble
+    U_PORT_TEST_ASSERT(uCellTestPrivatePreamble(U_CFG_TEST_CELL_MODULE_TYPE,
+                                                &gHandles, true) == 0);
+    cellHandle = gHandles.cellHandle;
+
+    // Make sure we start with an empty file since writes append
+    uCellFileDelete(cellHandle, U_CELL_FILE_TEST_STREAM_FILE_NAME);
+
+    U_TEST_PRINT_LINE("stream-writing %d byte(s) to file...",
+                      U_CELL_FILE_TEST_STREAM_SIZE_BYTES);
+    gStreamSizeBytes = 0;
+    gStreamErrorCount = 0;
+    startTimeMs = uPortGetTickTimeMs();
+    result = uCellFileWriteStream(cellHandle, U_CELL_FILE_TEST_STREAM_FILE_NAME,
+                                  writeStreamCallback, &gStreamSizeBytes);
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("wrote %d byte(s) in %d ms.", result, durationMs);
+    if (durationMs > 0) {
+        U_TEST_PRINT_LINE("write throughput %d byte(s)/second.",
+                          (result * 1000) / durationMs);
+    }
+    U_PORT_TEST_ASSERT(result == U_CELL_FILE_TEST_STREAM_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(gStreamErrorCount == 0);
+    U_PORT_TEST_ASSERT(uCellFileSize(cellHandle,
+                                     U_CELL_FILE_TEST_STREAM_FILE_NAME) == result);
+
+    U_TEST_PRINT_LINE("stream-reading file...");
+    gStreamSizeBytes = 0;
+    startTimeMs = uPortGetTickTimeMs();
+    result = uCellFileReadStream(cellHandle, U_CELL_FILE_TEST_STREAM_FILE_NAME, 0,
+                                 readStreamCallback, &gStreamSizeBytes);
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("read %d byte(s) in %d ms.", result, durationMs);
+    if (durationMs > 0) {
+        U_TEST_PRINT_LINE("read throughput %d byte(s)/second.",
+                          (result * 1000) / durationMs);
+    }
+    U_PORT_TEST_ASSERT(result == U_CELL_FILE_TEST_STREAM_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(gStreamSizeBytes == U_CELL_FILE_TEST_STREAM_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(gStreamErrorCount == 0);
+
+    // Read again from part-way through a block
+    gStreamSizeBytes = U_CELL_FILE_TEST_STREAM_SIZE_BYTES - 100;
+    result = uCellFileReadStream(cellHandle, U_CELL_FILE_TEST_STREAM_FILE_NAME,
+                                 gStreamSizeBytes, readStreamCallback,
+                                 &gStreamSizeBytes);
+    U_PORT_TEST_ASSERT(result == 100);
+    U_PORT_TEST_ASSERT(gStreamErrorCount == 0);
+
+    U_PORT_TEST_ASSERT(uCellFileDelete(cellHandle, U_CELL_FILE_TEST_STREAM_FILE_NAME) == 0);
+
+    // Do the standard postamble, leaving the module on for the next
+    // test to speed things up
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 /** Test list all files.
  */
 U_PORT_TEST_FUNCTION("[cellFile]", "cellFileListAll")
@@ -533,7 +678,7 @@ U_PORT_TEST_FUNCTION("[cellFile]", "cellFileListAllReentrant")
     // Write the files we need to list
     for (size_t x = 0; (x < U_CELL_FILE_TEST_REENTRANT_NUM) &&
          (result == U_CELL_FILE_TEST_REENTRANT_STRING_SIZE); x++) {
-        snprintf(buffer, sizeof(buffer), "%s%1d", U_CELL_FILE_TEST_FILE_NAME, x);
+        snprintf(buffer, sizeof(buffer), "%s%1d", U_CELL_FILE_TEST_FILE_NAME, (int32_t) x);
         U_TEST_PRINT_LINE("writing file %s...", buffer);
         result = uCellFileWrite(cellHandle, buffer,
                                 U_CELL_FILE_TEST_REENTRANT_STRING,
@@ -567,7 +712,7 @@ U_PORT_TEST_FUNCTION("[cellFile]", "cellFileListAllReentrant")
 
     // Delete the files again, for tidiness
     for (size_t x = 0; x < U_CELL_FILE_TEST_REENTRANT_NUM; x++) {
-        snprintf(buffer, sizeof(buffer), "%s%1d", U_CELL_FILE_TEST_FILE_NAME, x);
+        snprintf(buffer, sizeof(buffer), "%s%1d", U_CELL_FILE_TEST_FILE_NAME, (int32_t) x);
         U_TEST_PRINT_LINE("deleting file %s...", buffer);
         U_PORT_TEST_ASSERT(uCellFileDelete(cellHandle, buffer) == 0);
     }
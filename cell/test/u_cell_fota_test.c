@@ -38,6 +38,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "string.h"    // memset()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_os_platform_specific.h"
@@ -47,8 +48,10 @@
 #include "u_error_common.h"
 
 #include "u_port.h"
+#include "u_port_heap.h"
 #include "u_port_debug.h"
 #include "u_port_os.h"   // Required by u_cell_private.h
+#include "u_port_crypto.h"
 
 #include "u_at_client.h"
 
@@ -74,6 +77,20 @@
  */
 #define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
 
+/** The name of the file to use when testing image download.
+ */
+#define U_CELL_FOTA_TEST_IMAGE_FILE_NAME "fota_test_image"
+
+/** The size of image to use when testing image download: a couple
+ * of blocks plus an odd bit.
+ */
+#define U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES ((U_CELL_FOTA_IMAGE_BLOCK_LENGTH_BYTES * 2) + 100)
+
+/** The most the test image source callback will return at once,
+ * deliberately not a factor of the block size.
+ */
+#define U_CELL_FOTA_TEST_IMAGE_CHUNK_BYTES 300
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -86,6 +103,26 @@
  */
 static uCellTestPrivate_t gHandles = U_CELL_TEST_PRIVATE_DEFAULTS;
 
+/** The image for the image download test.
+ */
+static char *gpImage = NULL;
+
+/** How much of gpImage has been passed to the source callback.
+ */
+static size_t gImageOffset = 0;
+
+/** The number of calls to the image source callback.
+ */
+static size_t gImageSourceCallCount = 0;
+
+/** The number of calls to the image progress callback.
+ */
+static size_t gImageProgressCallCount = 0;
+
+/** The last progress seen by the image progress callback.
+ */
+static uCellFotaImageProgress_t gImageProgress;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -102,6 +139,46 @@ void fotaStatusCallback(uDeviceHandle_t cellHandle,
     (void) pParameter;
 }
 
+// Image source callback: dribbles out the image in small chunks,
+// with one stall thrown in.
+static int32_t imageSourceCallback(uDeviceHandle_t cellHandle,
+                                   char *pBuffer, size_t bufferSize,
+                                   void *pCallbackParam)
+{
+    size_t size = U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES - gImageOffset;
+
+    (void) cellHandle;
+    (void) pCallbackParam;
+
+    gImageSourceCallCount++;
+    if (gImageSourceCallCount == 2) {
+        // Pretend to stall
+        size = 0;
+    }
+    if (size > bufferSize) {
+        size = bufferSize;
+    }
+    if (size > U_CELL_FOTA_TEST_IMAGE_CHUNK_BYTES) {
+        size = U_CELL_FOTA_TEST_IMAGE_CHUNK_BYTES;
+    }
+    memcpy(pBuffer, gpImage + gImageOffset, size);
+    gImageOffset += size;
+
+    return (int32_t) size;
+}
+
+// Image progress callback.
+static void imageProgressCallback(uDeviceHandle_t cellHandle,
+                                  const uCellFotaImageProgress_t *pProgress,
+                                  void *pCallbackParam)
+{
+    (void) cellHandle;
+    (void) pCallbackParam;
+
+    gImageProgressCallCount++;
+    gImageProgress = *pProgress;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -180,6 +257,99 @@ U_PORT_TEST_FUNCTION("[cellFota]", "cellFotaVeryBasicIndeed")
     U_PORT_TEST_ASSERT(heapUsed <= heapFotaInitLoss);
 }
 
+/** Test downloading an image into the module file system; this
+ * doesn't need the module to support FOTA, it only exercises
+ * getting the image into the file system.
+ */
+U_PORT_TEST_FUNCTION("[cellFota]", "cellFotaImageDownload")
+{
+    uDeviceHandle_t cellHandle;
+    int32_t heapUsed;
+    int32_t x;
+    char sha256[U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES];
+    const char *pSha256 = sha256;
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    // Do the standard preamble
+    U_PORT_TEST_ASSERT(uCellTestPrivatePreamble(U_CFG_TEST_CELL_MODULE_TYPE,
+                                                &gHandles, true) == 0);
+    cellHandle = gHandles.cellHandle;
+
+    // Make up an image and work out its hash
+    gpImage = (char *) pUPortMalloc(U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(gpImage != NULL);
+    for (size_t y = 0; y < U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES; y++) {
+        *(gpImage + y) = (char) (y * 7);
+    }
+    x = uPortCryptoSha256(gpImage, U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES, sha256);
+    if (x == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_TEST_PRINT_LINE("SHA256 not supported, image will not be verified.");
+        pSha256 = NULL;
+    } else {
+        U_PORT_TEST_ASSERT(x == 0);
+    }
+
+    U_TEST_PRINT_LINE("downloading a %d byte image...",
+                      U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES);
+    gImageOffset = 0;
+    gImageSourceCallCount = 0;
+    gImageProgressCallCount = 0;
+    memset(&gImageProgress, 0, sizeof(gImageProgress));
+    x = uCellFotaImageDownload(cellHandle, U_CELL_FOTA_TEST_IMAGE_FILE_NAME,
+                               U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES, pSha256,
+                               imageSourceCallback, NULL,
+                               imageProgressCallback, NULL);
+    U_TEST_PRINT_LINE("returned %d after %d ms (%d byte(s)/second, %d stall(s)"
+                      " totalling %d ms).", x, gImageProgress.elapsedMs,
+                      gImageProgress.bytesPerSecond, gImageProgress.stallCount,
+                      gImageProgress.stallTotalMs);
+    U_PORT_TEST_ASSERT(x == U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES);
+    // One progress report per block
+    U_PORT_TEST_ASSERT(gImageProgressCallCount == 3);
+    U_PORT_TEST_ASSERT(gImageProgress.sizeBytes == U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(gImageProgress.totalSizeBytes == U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(gImageProgress.etaSeconds <= 0);
+    U_PORT_TEST_ASSERT(gImageProgress.stallCount == 1);
+    U_PORT_TEST_ASSERT(uCellFileSize(cellHandle,
+                                     U_CELL_FOTA_TEST_IMAGE_FILE_NAME) == x);
+
+    if (pSha256 != NULL) {
+        U_TEST_PRINT_LINE("downloading again with a bad hash...");
+        sha256[0] = ~sha256[0];
+        gImageOffset = 0;
+        gImageSourceCallCount = 0;
+        x = uCellFotaImageDownload(cellHandle, U_CELL_FOTA_TEST_IMAGE_FILE_NAME,
+                                   U_CELL_FOTA_TEST_IMAGE_SIZE_BYTES, pSha256,
+                                   imageSourceCallback, NULL, NULL, NULL);
+        U_PORT_TEST_ASSERT(x == (int32_t) U_ERROR_COMMON_AUTHENTICATION_FAILURE);
+        // The bad image should have been deleted
+        U_PORT_TEST_ASSERT(uCellFileSize(cellHandle,
+                                         U_CELL_FOTA_TEST_IMAGE_FILE_NAME) < 0);
+    } else {
+        U_PORT_TEST_ASSERT(uCellFileDelete(cellHandle,
+                                           U_CELL_FOTA_TEST_IMAGE_FILE_NAME) == 0);
+    }
+
+    uPortFree(gpImage);
+    gpImage = NULL;
+
+    // Do the standard postamble, leaving the module on for the next
+    // test to speed things up
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -190,6 +360,9 @@ U_PORT_TEST_FUNCTION("[cellFota]", "cellFotaCleanUp")
 
     uCellTestPrivateCleanup(&gHandles);
 
+    uPortFree(gpImage);
+    gpImage = NULL;
+
     x = uPortTaskStackMinFree(NULL);
     if (x != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
         U_TEST_PRINT_LINE("main task stack had a minimum of %d"
@@ -442,6 +442,18 @@ U_PORT_TEST_FUNCTION("[cellHttp]", "cellHttp")
     // Note: we don't test with HTTPS here, that's done when the
     // code is tested from the common HTTP Client level.
 
+    // Check that a custom request header can be set and removed,
+    // and that obviously bad ones are rejected
+    U_PORT_TEST_ASSERT(uCellHttpSetRequestHeader(cellHandle, httpHandle,
+                                                 U_CELL_HTTP_REQUEST_HEADER_MAX_NUM,
+                                                 "Range", "bytes=0-9") < 0);
+    U_PORT_TEST_ASSERT(uCellHttpSetRequestHeader(cellHandle, httpHandle, 0,
+                                                 "Ra:nge", "bytes=0-9") < 0);
+    U_PORT_TEST_ASSERT(uCellHttpSetRequestHeader(cellHandle, httpHandle, 0,
+                                                 "Range", "bytes=0-9") == 0);
+    U_PORT_TEST_ASSERT(uCellHttpSetRequestHeader(cellHandle, httpHandle, 0,
+                                                 NULL, NULL) == 0);
+
     // POST something
     gCallbackData.pExpectedFirstLine = U_CELL_HTTP_TEST_FIRST_LINE_200;
     snprintf(pathBuffer, sizeof(pathBuffer), "/%s.html", imeiBuffer);
@@ -38,7 +38,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // memset()
+#include "string.h"    // memset(), strcmp(), strlen()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_os_platform_specific.h"
@@ -99,6 +99,16 @@ static int64_t gStopTimeMs;
  */
 static uCellTestPrivate_t gHandles = U_CELL_TEST_PRIVATE_DEFAULTS;
 
+/** Storage for the radio sampler.
+ */
+static uCellInfoRadioRing_t gRadioRing;
+
+/** The identity of the module as first read, and as read again,
+ * for comparison.
+ */
+static uCellPrivateIdentity_t gIdentity;
+static uCellPrivateIdentity_t gIdentityAgain;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -117,6 +127,34 @@ static bool keepGoingCallback(uDeviceHandle_t unused)
     return keepGoing;
 }
 
+// Read the identity of the module into pIdentity, null-terminating
+// the IMEI and IMSI, and check that it is the same as gIdentity.
+static void readAndCheckIdentity(uDeviceHandle_t cellHandle,
+                                 uCellPrivateIdentity_t *pIdentity)
+{
+    memset(pIdentity, 0, sizeof(*pIdentity));
+    U_PORT_TEST_ASSERT(uCellInfoGetImei(cellHandle, pIdentity->imei) == 0);
+    U_PORT_TEST_ASSERT(strcmp(pIdentity->imei, gIdentity.imei) == 0);
+    U_PORT_TEST_ASSERT(uCellInfoGetImsi(cellHandle, pIdentity->imsi) == 0);
+    U_PORT_TEST_ASSERT(strcmp(pIdentity->imsi, gIdentity.imsi) == 0);
+    U_PORT_TEST_ASSERT(uCellInfoGetIccidStr(cellHandle, pIdentity->iccid,
+                                            sizeof(pIdentity->iccid)) ==
+                       (int32_t) strlen(gIdentity.iccid));
+    U_PORT_TEST_ASSERT(strcmp(pIdentity->iccid, gIdentity.iccid) == 0);
+    U_PORT_TEST_ASSERT(uCellInfoGetManufacturerStr(cellHandle, pIdentity->manufacturer,
+                                                   sizeof(pIdentity->manufacturer)) ==
+                       (int32_t) strlen(gIdentity.manufacturer));
+    U_PORT_TEST_ASSERT(strcmp(pIdentity->manufacturer, gIdentity.manufacturer) == 0);
+    U_PORT_TEST_ASSERT(uCellInfoGetModelStr(cellHandle, pIdentity->model,
+                                            sizeof(pIdentity->model)) ==
+                       (int32_t) strlen(gIdentity.model));
+    U_PORT_TEST_ASSERT(strcmp(pIdentity->model, gIdentity.model) == 0);
+    U_PORT_TEST_ASSERT(uCellInfoGetFirmwareVersionStr(cellHandle, pIdentity->firmwareVersion,
+                                                      sizeof(pIdentity->firmwareVersion)) ==
+                       (int32_t) strlen(gIdentity.firmwareVersion));
+    U_PORT_TEST_ASSERT(strcmp(pIdentity->firmwareVersion, gIdentity.firmwareVersion) == 0);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -130,8 +168,10 @@ static bool keepGoingCallback(uDeviceHandle_t unused)
 U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoImeiEtc")
 {
     uDeviceHandle_t cellHandle;
+    uCellPrivateInstance_t *pInstance;
     char buffer[64];
     int32_t bytesRead;
+    int32_t startTimeMs;
     int32_t heapUsed;
 #if defined(U_CFG_APP_PIN_CELL_RTS_GET) || defined(U_CFG_APP_PIN_CELL_CTS_GET)
     bool isEnabled;
@@ -226,6 +266,43 @@ U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoImeiEtc")
                                             sizeof(buffer)) >= 0);
     U_PORT_TEST_ASSERT(strlen(buffer) <= U_CELL_INFO_ICCID_BUFFER_SIZE);
 
+    // All of the above should now be cached: keep a copy of
+    // what is there and check that reading the identity again
+    // gives the same answers, from the cache
+    U_TEST_PRINT_LINE("checking that the identity is cached...");
+    pInstance = pUCellPrivateGetInstance(cellHandle);
+    U_PORT_TEST_ASSERT(pInstance != NULL);
+    U_PORT_TEST_ASSERT(pInstance->pIdentity != NULL);
+    gIdentity = *(pInstance->pIdentity);
+    U_PORT_TEST_ASSERT(strlen(gIdentity.imei) == U_CELL_INFO_IMEI_SIZE);
+    U_PORT_TEST_ASSERT(strlen(gIdentity.imsi) == U_CELL_INFO_IMSI_SIZE);
+    U_PORT_TEST_ASSERT(strcmp(gIdentity.iccid, buffer) == 0);
+    U_PORT_TEST_ASSERT(strlen(gIdentity.manufacturer) > 0);
+    U_PORT_TEST_ASSERT(strlen(gIdentity.model) > 0);
+    U_PORT_TEST_ASSERT(strlen(gIdentity.firmwareVersion) > 0);
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < 10; x++) {
+        readAndCheckIdentity(cellHandle, &gIdentityAgain);
+    }
+    U_TEST_PRINT_LINE("10 reads of the identity took %d ms.",
+                      uPortGetTickTimeMs() - startTimeMs);
+
+    // Rebooting the module should empty the cache, so that the
+    // identity is read afresh from the module, and it should
+    // of course still be the same
+    U_TEST_PRINT_LINE("checking that the identity is read again after a reboot...");
+    U_PORT_TEST_ASSERT(uCellPwrReboot(cellHandle, NULL) == 0);
+    U_PORT_TEST_ASSERT(pInstance->pIdentity->imei[0] == 0);
+    U_PORT_TEST_ASSERT(pInstance->pIdentity->imsi[0] == 0);
+    U_PORT_TEST_ASSERT(pInstance->pIdentity->iccid[0] == 0);
+    U_PORT_TEST_ASSERT(pInstance->pIdentity->manufacturer[0] == 0);
+    U_PORT_TEST_ASSERT(pInstance->pIdentity->model[0] == 0);
+    U_PORT_TEST_ASSERT(pInstance->pIdentity->firmwareVersion[0] == 0);
+    readAndCheckIdentity(cellHandle, &gIdentityAgain);
+    // ...and the cache should be full again
+    U_PORT_TEST_ASSERT(strcmp(pInstance->pIdentity->imei, gIdentity.imei) == 0);
+    U_PORT_TEST_ASSERT(strcmp(pInstance->pIdentity->iccid, gIdentity.iccid) == 0);
+
 #ifdef U_CFG_APP_PIN_CELL_RTS_GET
     U_TEST_PRINT_LINE("checking RTS...");
     isEnabled = uCellInfoIsRtsFlowControlEnabled(cellHandle);
@@ -276,6 +353,8 @@ U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoRadioParameters")
     int32_t x;
     int32_t snrDb;
     size_t count;
+    uCellInfoRadioSample_t sample;
+    uCellInfoRadioSummary_t summary;
     int32_t heapUsed;
 
     // In case a previous test failed
@@ -346,6 +425,35 @@ U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoRadioParameters")
                            (x == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED));
     }
 
+    U_TEST_PRINT_LINE("checking the radio sampler...");
+    U_PORT_TEST_ASSERT(uCellInfoSamplerStart(cellHandle, 0, &gRadioRing) < 0);
+    U_PORT_TEST_ASSERT(uCellInfoSamplerStart(cellHandle, 1000, NULL) < 0);
+    U_PORT_TEST_ASSERT(uCellInfoSamplerStart(cellHandle, 2000, &gRadioRing) == 0);
+    U_PORT_TEST_ASSERT(uCellInfoRadioRingRead(&gRadioRing, U_CELL_INFO_RADIO_RING_LENGTH,
+                                              &sample) == (int32_t) U_ERROR_COMMON_EMPTY);
+    // Wait for a few samples to arrive
+    for (count = 30; (gRadioRing.numWritten < 3) && (count > 0); count--) {
+        uPortTaskBlock(1000);
+    }
+    // A refresh by us should count as a sample and must not be
+    // upset by the sampler
+    U_PORT_TEST_ASSERT(uCellInfoRefreshRadioParameters(cellHandle) == 0);
+    uCellInfoSamplerStop(cellHandle);
+    U_TEST_PRINT_LINE("%d radio sample(s) taken.", gRadioRing.numWritten);
+    U_PORT_TEST_ASSERT(gRadioRing.numWritten >= 3);
+    U_PORT_TEST_ASSERT(uCellInfoRadioRingRead(&gRadioRing, 0, &sample) == 0);
+    U_PORT_TEST_ASSERT(uPortGetTickTimeMs() - sample.timeMs < 10000);
+    U_PORT_TEST_ASSERT(uCellInfoRadioRingSummary(&gRadioRing, 0, &summary) ==
+                       (int32_t) gRadioRing.numWritten);
+    U_TEST_PRINT_LINE("RSSI min %d, max %d, mean %d dBm.", summary.rssiDbm.min,
+                      summary.rssiDbm.max, summary.rssiDbm.mean);
+    U_PORT_TEST_ASSERT(summary.rssiDbm.min <= summary.rssiDbm.mean);
+    U_PORT_TEST_ASSERT(summary.rssiDbm.mean <= summary.rssiDbm.max);
+    // No samples should be added now that the sampler is stopped
+    x = (int32_t) gRadioRing.numWritten;
+    uPortTaskBlock(3000);
+    U_PORT_TEST_ASSERT(x == (int32_t) gRadioRing.numWritten);
+
     // Disconnect
     U_PORT_TEST_ASSERT(uCellNetDisconnect(cellHandle, NULL) == 0);
 
@@ -361,6 +469,86 @@ U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoRadioParameters")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+/** Test the summary statistics of a radio ring, feeding it known
+ * values; no module is required.
+ */
+U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoRadioRing")
+{
+    uCellInfoRadioSample_t *pSample;
+    uCellInfoRadioSummary_t summary;
+    uCellInfoRadioSample_t sample;
+    int32_t nowMs = uPortGetTickTimeMs();
+    int64_t sumRssi = 0;
+    int64_t sumRsrq = 0;
+    int32_t numRsrq = 0;
+    int32_t rsrqMin = INT32_MAX;
+    int32_t rsrqMax = INT32_MIN;
+
+    memset(&gRadioRing, 0, sizeof(gRadioRing));
+    U_PORT_TEST_ASSERT(uCellInfoRadioRingSummary(&gRadioRing, 0, &summary) == 0);
+    // Write two more samples than the ring can hold: the first two,
+    // which have wild values, must be overwritten and so not count;
+    // the older half of the rest are outside the window used later
+    for (int32_t x = 0; x < U_CELL_INFO_RADIO_RING_LENGTH + 2; x++) {
+        pSample = &(gRadioRing.sample[gRadioRing.numWritten % U_CELL_INFO_RADIO_RING_LENGTH]);
+        memset(pSample, 0, sizeof(*pSample));
+        pSample->timeMs = nowMs;
+        pSample->rssiDbm = -200;
+        pSample->rsrqDb = 100;
+        pSample->snrDb = 0x7FFFFFFF;
+        if (x >= 2) {
+            pSample->rssiDbm = -50 - x;
+            sumRssi += pSample->rssiDbm;
+            // Only every other RSRQ is known
+            pSample->rsrqDb = 0x7FFFFFFF;
+            if (x & 1) {
+                pSample->rsrqDb = x - 20;
+                sumRsrq += pSample->rsrqDb;
+                numRsrq++;
+                if (pSample->rsrqDb < rsrqMin) {
+                    rsrqMin = pSample->rsrqDb;
+                }
+                if (pSample->rsrqDb > rsrqMax) {
+                    rsrqMax = pSample->rsrqDb;
+                }
+            }
+            if (x < (U_CELL_INFO_RADIO_RING_LENGTH / 2) + 2) {
+                pSample->timeMs = nowMs - 100000;
+            }
+        }
+        gRadioRing.numWritten++;
+    }
+
+    U_PORT_TEST_ASSERT(uCellInfoRadioRingSummary(&gRadioRing, 0, &summary) ==
+                       U_CELL_INFO_RADIO_RING_LENGTH);
+    U_PORT_TEST_ASSERT(summary.numSamples == U_CELL_INFO_RADIO_RING_LENGTH);
+    U_PORT_TEST_ASSERT(summary.rssiDbm.numSamples == U_CELL_INFO_RADIO_RING_LENGTH);
+    U_PORT_TEST_ASSERT(summary.rssiDbm.min == -50 - (U_CELL_INFO_RADIO_RING_LENGTH + 1));
+    U_PORT_TEST_ASSERT(summary.rssiDbm.max == -52);
+    U_PORT_TEST_ASSERT(summary.rssiDbm.mean ==
+                       (int32_t) (sumRssi / U_CELL_INFO_RADIO_RING_LENGTH));
+    U_PORT_TEST_ASSERT(summary.rsrqDb.numSamples == (size_t) numRsrq);
+    U_PORT_TEST_ASSERT(summary.rsrqDb.min == rsrqMin);
+    U_PORT_TEST_ASSERT(summary.rsrqDb.max == rsrqMax);
+    U_PORT_TEST_ASSERT(summary.rsrqDb.mean == (int32_t) (sumRsrq / numRsrq));
+    // All RSRP and SNR values are "unknown"
+    U_PORT_TEST_ASSERT(summary.rsrpDbm.numSamples == 0);
+    U_PORT_TEST_ASSERT(summary.snrDb.numSamples == 0);
+
+    // Now only the newer half of the ring
+    U_PORT_TEST_ASSERT(uCellInfoRadioRingSummary(&gRadioRing, 50000, &summary) ==
+                       U_CELL_INFO_RADIO_RING_LENGTH / 2);
+    U_PORT_TEST_ASSERT(summary.rssiDbm.min == -50 - (U_CELL_INFO_RADIO_RING_LENGTH + 1));
+    U_PORT_TEST_ASSERT(summary.rssiDbm.max == -50 - ((U_CELL_INFO_RADIO_RING_LENGTH / 2) + 2));
+
+    // The newest sample is at index 0
+    U_PORT_TEST_ASSERT(uCellInfoRadioRingRead(&gRadioRing, 0, &sample) == 0);
+    U_PORT_TEST_ASSERT(sample.rssiDbm == -50 - (U_CELL_INFO_RADIO_RING_LENGTH + 1));
+    U_PORT_TEST_ASSERT(uCellInfoRadioRingRead(&gRadioRing, U_CELL_INFO_RADIO_RING_LENGTH - 1,
+                                              &sample) == 0);
+    U_PORT_TEST_ASSERT(sample.rssiDbm == -52);
+}
+
 /** Test fetching the time.
  */
 U_PORT_TEST_FUNCTION("[cellInfo]", "cellInfoTime")
@@ -116,6 +116,27 @@
 # define U_CELL_MQTT_TEST_MQTTSN_SERVER_IP_ADDRESS_SECURED  ubxlib.redirectme.net:8883
 #endif
 
+#ifndef U_CELL_MQTT_TEST_BINARY_WAIT_SECONDS
+/** How long to wait for a binary message sent to ourselves to
+ * come back.
+ */
+# define U_CELL_MQTT_TEST_BINARY_WAIT_SECONDS 30
+#endif
+
+#ifndef U_CELL_MQTT_TEST_PUBLISH_ASYNC_WAIT_SECONDS
+/** How long to wait for the result of a message published with
+ * uCellMqttPublishAsync(); also used as the publish timeout once
+ * the timeout test is over, hence should be at least
+ * #U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS.
+ */
+# define U_CELL_MQTT_TEST_PUBLISH_ASYNC_WAIT_SECONDS 60
+#endif
+
+/** The prefix of the topic that binary messages are sent to; the
+ * client ID is appended.
+ */
+#define U_CELL_MQTT_TEST_BINARY_TOPIC_PREFIX "ubx_test/bin/"
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -132,6 +153,18 @@ static int64_t gStopTimeMs;
  */
 static uCellTestPrivate_t gHandles = U_CELL_TEST_PRIVATE_DEFAULTS;
 
+/** The number of results received by publishAsyncCallback().
+ */
+static volatile int32_t gPublishAsyncNumResults = 0;
+
+/** The token of the last result received by publishAsyncCallback().
+ */
+static volatile int32_t gPublishAsyncToken = -1;
+
+/** The error code of the last result received by publishAsyncCallback().
+ */
+static volatile int32_t gPublishAsyncErrorCode = 0;
+
 #ifdef U_CELL_MQTT_TEST_ENABLE_WILL_TEST
 /** A string of all possible characters, including strings
  * that might appear as terminators in an AT interface, that
@@ -167,6 +200,30 @@ static bool keepGoingCallback(uDeviceHandle_t unused)
     return keepGoing;
 }
 
+// Callback for the results of uCellMqttPublishAsync().
+static void publishAsyncCallback(int32_t token, int32_t errorCode, void *pParam)
+{
+    (void) pParam;
+
+    gPublishAsyncToken = token;
+    gPublishAsyncErrorCode = errorCode;
+    gPublishAsyncNumResults++;
+}
+
+// Wait for publishAsyncCallback() to have been called numResults times.
+static bool publishAsyncWait(int32_t numResults)
+{
+    int32_t startTimeMs = uPortGetTickTimeMs();
+
+    while ((gPublishAsyncNumResults < numResults) &&
+           (uPortGetTickTimeMs() - startTimeMs <
+            (U_CELL_MQTT_TEST_PUBLISH_ASYNC_WAIT_SECONDS * 1000))) {
+        uPortTaskBlock(100);
+    }
+
+    return (gPublishAsyncNumResults == numResults);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -194,6 +251,13 @@ U_PORT_TEST_FUNCTION("[cellMqtt]", "cellMqtt")
     bool retained = false;
     char *pBuffer;
 #endif
+    char topicOut[sizeof(U_CELL_MQTT_TEST_BINARY_TOPIC_PREFIX) + sizeof(buffer1)];
+    char topicIn[sizeof(topicOut)];
+    char *pMessageOut;
+    char *pMessageIn;
+    size_t maxLength;
+    size_t length;
+    int32_t startTimeMs;
 
     // In case a previous test failed
     uCellTestPrivateCleanup(&gHandles);
@@ -408,6 +472,126 @@ U_PORT_TEST_FUNCTION("[cellMqtt]", "cellMqtt")
         U_TEST_PRINT_LINE("connecting to broker \"%s\"...", pServerAddress);
         U_PORT_TEST_ASSERT(uCellMqttConnect(cellHandle) == 0);
 
+        // Send random binary messages of up to the maximum length
+        // to ourselves and check that they come back intact: where
+        // the module supports it these go as-is, with no hex stage
+        maxLength = U_CELL_MQTT_PUBLISH_HEX_MAX_LENGTH_BYTES;
+        if (U_CELL_PRIVATE_HAS(pModule, U_CELL_PRIVATE_FEATURE_MQTT_BINARY_PUBLISH)) {
+            maxLength = U_CELL_MQTT_PUBLISH_BIN_MAX_LENGTH_BYTES;
+        }
+        pMessageOut = (char *) pUPortMalloc(maxLength);
+        U_PORT_TEST_ASSERT(pMessageOut != NULL);
+        pMessageIn = (char *) pUPortMalloc(maxLength);
+        U_PORT_TEST_ASSERT(pMessageIn != NULL);
+        memset(topicOut, 0, sizeof(topicOut));
+        strncpy(topicOut, U_CELL_MQTT_TEST_BINARY_TOPIC_PREFIX, sizeof(topicOut) - 1);
+        strncat(topicOut, buffer1, sizeof(topicOut) - strlen(topicOut) - 1);
+        U_TEST_PRINT_LINE("sending binary messages of up to %d byte(s) to \"%s\"...",
+                          maxLength, topicOut);
+        U_PORT_TEST_ASSERT(uCellMqttSubscribe(cellHandle, topicOut,
+                                              U_CELL_MQTT_QOS_AT_LEAST_ONCE) >= 0);
+        z = 1;
+        while (z > 0) {
+            for (size_t w = 0; w < z; w++) {
+                *(pMessageOut + w) = (char) rand();
+            }
+            U_PORT_TEST_ASSERT(uCellMqttPublish(cellHandle, topicOut, pMessageOut, z,
+                                                U_CELL_MQTT_QOS_AT_LEAST_ONCE, false) == 0);
+            startTimeMs = uPortGetTickTimeMs();
+            while ((uCellMqttGetUnread(cellHandle) == 0) &&
+                   (uPortGetTickTimeMs() - startTimeMs <
+                    (U_CELL_MQTT_TEST_BINARY_WAIT_SECONDS * 1000))) {
+                uPortTaskBlock(100);
+            }
+            length = maxLength;
+            memset(topicIn, 0, sizeof(topicIn));
+            U_PORT_TEST_ASSERT(uCellMqttMessageRead(cellHandle, topicIn, sizeof(topicIn),
+                                                    pMessageIn, &length, NULL) == 0);
+            U_TEST_PRINT_LINE("sent %d byte(s), received %d byte(s).", z, length);
+            U_PORT_TEST_ASSERT(strcmp(topicIn, topicOut) == 0);
+            U_PORT_TEST_ASSERT(length == z);
+            U_PORT_TEST_ASSERT(memcmp(pMessageIn, pMessageOut, z) == 0);
+            // Lengths go up by a factor of eight, ending with the maximum
+            if (z < maxLength) {
+                z *= 8;
+                if (z > maxLength) {
+                    z = maxLength;
+                }
+            } else {
+                z = 0;
+            }
+        }
+        U_PORT_TEST_ASSERT(uCellMqttUnsubscribe(cellHandle, topicOut) == 0);
+        uPortFree(pMessageIn);
+        uPortFree(pMessageOut);
+
+        if (!U_CELL_PRIVATE_HAS(pModule, U_CELL_PRIVATE_FEATURE_MQTT_SARA_R4_OLD_SYNTAX)) {
+            // With a window of one, while a message published with
+            // uCellMqttPublishAsync() is outstanding, nothing else may
+            // be published, asynchronously or otherwise
+            U_TEST_PRINT_LINE("testing asynchronous publish with a full window...");
+            gPublishAsyncNumResults = 0;
+            U_PORT_TEST_ASSERT(uCellMqttSetPublishTimeout(cellHandle, 0) < 0);
+            U_PORT_TEST_ASSERT(uCellMqttSetPublishWindow(cellHandle, 1) == 0);
+            x = uCellMqttPublishAsync(cellHandle, topicOut, "one", 3,
+                                      U_CELL_MQTT_QOS_AT_LEAST_ONCE, false,
+                                      publishAsyncCallback, NULL);
+            U_PORT_TEST_ASSERT(x >= 0);
+            U_PORT_TEST_ASSERT(uCellMqttPublishAsync(cellHandle, topicOut, "two", 3,
+                                                     U_CELL_MQTT_QOS_AT_LEAST_ONCE, false,
+                                                     publishAsyncCallback,
+                                                     NULL) == (int32_t) U_ERROR_COMMON_BUSY);
+            U_PORT_TEST_ASSERT(uCellMqttPublish(cellHandle, topicOut, "two", 3,
+                                                U_CELL_MQTT_QOS_AT_LEAST_ONCE,
+                                                false) == (int32_t) U_ERROR_COMMON_BUSY);
+            U_PORT_TEST_ASSERT(publishAsyncWait(1));
+            U_PORT_TEST_ASSERT(gPublishAsyncToken == x);
+            U_PORT_TEST_ASSERT(gPublishAsyncErrorCode == 0);
+            U_PORT_TEST_ASSERT(uCellMqttGetPublishInFlight(cellHandle) == 0);
+
+            // With a timeout too short for the result to make it in time
+            // the message must be failed and then nothing may be published
+            // until its late result has been soaked up; the result of the
+            // next message must then go to that message
+            U_TEST_PRINT_LINE("testing asynchronous publish timeout...");
+            U_PORT_TEST_ASSERT(uCellMqttSetPublishTimeout(cellHandle, 1) == 0);
+            x = uCellMqttPublishAsync(cellHandle, topicOut, "three", 5,
+                                      U_CELL_MQTT_QOS_AT_LEAST_ONCE, false,
+                                      publishAsyncCallback, NULL);
+            U_PORT_TEST_ASSERT(x >= 0);
+            uPortTaskBlock(10);
+            // This call notices the timeout
+            uCellMqttGetPublishInFlight(cellHandle);
+            U_PORT_TEST_ASSERT(publishAsyncWait(2));
+            U_PORT_TEST_ASSERT(gPublishAsyncToken == x);
+            U_PORT_TEST_ASSERT(gPublishAsyncErrorCode == (int32_t) U_ERROR_COMMON_TIMEOUT);
+            U_PORT_TEST_ASSERT(uCellMqttGetPublishInFlight(cellHandle) == 0);
+            x = U_CELL_MQTT_TEST_PUBLISH_ASYNC_WAIT_SECONDS * 1000;
+            U_PORT_TEST_ASSERT(uCellMqttSetPublishTimeout(cellHandle, x) == 0);
+            startTimeMs = uPortGetTickTimeMs();
+            do {
+                y = uCellMqttPublish(cellHandle, topicOut, "four", 4,
+                                     U_CELL_MQTT_QOS_AT_LEAST_ONCE, false);
+                if (y == (int32_t) U_ERROR_COMMON_BUSY) {
+                    uPortTaskBlock(100);
+                }
+            } while ((y == (int32_t) U_ERROR_COMMON_BUSY) &&
+                     (uPortGetTickTimeMs() - startTimeMs <
+                      (U_CELL_MQTT_TEST_PUBLISH_ASYNC_WAIT_SECONDS * 1000)));
+            U_TEST_PRINT_LINE("resynchronised after %d ms.",
+                              (int32_t) (uPortGetTickTimeMs() - startTimeMs));
+            U_PORT_TEST_ASSERT(y == 0);
+            x = uCellMqttPublishAsync(cellHandle, topicOut, "five", 4,
+                                      U_CELL_MQTT_QOS_AT_LEAST_ONCE, false,
+                                      publishAsyncCallback, NULL);
+            U_PORT_TEST_ASSERT(x >= 0);
+            U_PORT_TEST_ASSERT(publishAsyncWait(3));
+            U_PORT_TEST_ASSERT(gPublishAsyncToken == x);
+            U_PORT_TEST_ASSERT(gPublishAsyncErrorCode == 0);
+            U_PORT_TEST_ASSERT(uCellMqttSetPublishWindow(cellHandle,
+                                                         U_CELL_MQTT_PUBLISH_WINDOW_DEFAULT) == 0);
+        }
+
         if (U_CELL_PRIVATE_HAS(pModule, U_CELL_PRIVATE_FEATURE_MQTT_KEEP_ALIVE)) {
             // Try to set keep-alive on
             U_TEST_PRINT_LINE("trying to set keep-alive on (should fail)...");
@@ -96,6 +96,42 @@
 # define U_CELL_MUX_PRIVATE_TEST_MAX_INFORMATION_SIZE_BYTES (U_CELL_MUX_PRIVATE_TEST_MAX_FRAME_SIZE_BYTES - U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES)
 #endif
 
+#ifndef U_CELL_MUX_PRIVATE_TEST_BATCH_ITERATIONS
+/** The number of batches to encode and decode when measuring
+ * the throughput of the batched encoder.
+ */
+# define U_CELL_MUX_PRIVATE_TEST_BATCH_ITERATIONS 1000
+#endif
+
+#ifndef U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES
+/** The amount of user data to send through the simulated CMUX
+ * peer for each information field length when comparing
+ * throughput.
+ */
+# define U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES (1024 * 16)
+#endif
+
+#ifndef U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_CHUNK_BYTES
+/** The size of the chunks in which the encoded CMUX stream is
+ * delivered to the receiving side, like a UART driver would.
+ */
+# define U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_CHUNK_BYTES 64
+#endif
+
+#ifndef U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_BAUD_RATE
+/** The baud rate to use when working out how long the encoded
+ * CMUX stream would take to send over a UART.
+ */
+# define U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_BAUD_RATE 115200
+#endif
+
+#ifndef U_CELL_MUX_PRIVATE_TEST_TX_SCHEDULE_BATCHES
+/** The number of batches to run through the transmit scheduler
+ * when checking that channels get their fair share.
+ */
+# define U_CELL_MUX_PRIVATE_TEST_TX_SCHEDULE_BATCHES 400
+#endif
+
 #ifndef U_CELL_MUX_PRIVATE_TEST_FILL_CHAR
 /** Character to use as fill in the mux buffer so that we
  * can check it has been written for the correct length by
@@ -133,6 +169,11 @@ static bool gCommandResponse[] = {true,  // U_CELL_MUX_PRIVATE_FRAME_TYPE_SABM_C
                                   true   // U_CELL_MUX_PRIVATE_FRAME_TYPE_UI
                                  };
 
+/** The maximum information field lengths (N1) to compare
+ * throughput for.
+ */
+static const size_t gInformationLengthMax[] = {31, 64, 128, 256, 512, 1024, 1509};
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -143,6 +184,25 @@ const char *pBool(bool isTrue)
     return isTrue ? "true" : "false";
 }
 
+// Run numBatches batches through the transmit scheduler for the
+// schedules at ppSchedules, where each channel sends batches of the
+// size given by the corresponding entry of pSizeBytes, adding the
+// number of bytes sent by each channel to pSentBytes.
+static void txScheduleRun(uCellMuxPrivateTxSchedule_t *const *ppSchedules,
+                          size_t numSchedules, const size_t *pSizeBytes,
+                          uint32_t *pVirtualTime, size_t numBatches,
+                          size_t *pSentBytes)
+{
+    int32_t next;
+
+    for (size_t x = 0; x < numBatches; x++) {
+        next = uCellMuxPrivateTxScheduleNext(ppSchedules, numSchedules, *pVirtualTime);
+        U_PORT_TEST_ASSERT((next >= 0) && (next < (int32_t) numSchedules));
+        uCellMuxPrivateTxScheduleStart(ppSchedules[next], pVirtualTime, pSizeBytes[next]);
+        pSentBytes[next] += pSizeBytes[next];
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -295,4 +355,408 @@ U_PORT_TEST_FUNCTION("[cellMuxPrivate]", "cellMuxPrivateBackToBack")
 # endif
 }
 
+/** Test the batched mux encoder against a loopback decoder,
+ * checking that it produces exactly what encoding the frames
+ * one at a time would, and measure the frames per second that
+ * can be encoded and decoded.
+ *
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the
+ * U_PORT_TEST_FUNCTION() macro.
+ */
+U_PORT_TEST_FUNCTION("[cellMuxPrivate]", "cellMuxPrivateBatch")
+{
+    int32_t heapUsed;
+    uCellMuxPrivateFrame_t frames[U_CELL_MUX_PRIVATE_TX_BATCH_MAX_FRAMES];
+    size_t bufferLength = (U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES +
+                           U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES) *
+                          (sizeof(frames) / sizeof(frames[0]));
+    char *pInformation;
+    char *pBuffer;
+    char *pInformationDecoded;
+    uCellMuxPrivateParserContext_t parserContext = {0};
+    size_t numFramesEncoded = 0;
+    size_t numFramesDecoded = 0;
+    size_t offset = 0;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    int32_t x;
+    int32_t y;
+
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    pInformation = (char *) pUPortMalloc(U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES);
+    U_PORT_TEST_ASSERT(pInformation != NULL);
+    pInformationDecoded = (char *) pUPortMalloc(U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES);
+    U_PORT_TEST_ASSERT(pInformationDecoded != NULL);
+    // Twice the length so that the frames encoded one at a time
+    // can be put alongside for comparison
+    pBuffer = (char *) pUPortMalloc(bufferLength * 2);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    for (size_t z = 0; z < U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES; z++) {
+        *(pInformation + z) = (char) z;
+    }
+
+    // Set up a batch of frames of different lengths, addresses and types
+    for (size_t z = 0; z < sizeof(frames) / sizeof(frames[0]); z++) {
+        frames[z].address = (uint8_t) (z + 1);
+        frames[z].type = gType[z % (sizeof(gType) / sizeof(gType[0]))];
+        frames[z].pollFinal = ((z & 1) != 0);
+        frames[z].pInformation = pInformation;
+        frames[z].informationLengthBytes = U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES >> z;
+    }
+
+    // Check the error cases
+    U_PORT_TEST_ASSERT(uCellMuxPrivateEncodeBatch(NULL, 1, pBuffer, bufferLength,
+                                                  NULL) < 0);
+    U_PORT_TEST_ASSERT(uCellMuxPrivateEncodeBatch(frames, 1, NULL, bufferLength,
+                                                  NULL) < 0);
+
+    // A buffer too short for all of the frames should get only
+    // the ones that fit
+    x = uCellMuxPrivateEncodeBatch(frames, sizeof(frames) / sizeof(frames[0]), pBuffer,
+                                   frames[0].informationLengthBytes +
+                                   U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES,
+                                   &numFramesEncoded);
+    U_TEST_PRINT_LINE("short buffer: %d byte(s), %d frame(s) encoded.", x, numFramesEncoded);
+    U_PORT_TEST_ASSERT(numFramesEncoded == 1);
+    U_PORT_TEST_ASSERT(x > 0);
+
+    // Encode the lot and compare with encoding them one at a time
+    x = uCellMuxPrivateEncodeBatch(frames, sizeof(frames) / sizeof(frames[0]), pBuffer,
+                                   bufferLength, &numFramesEncoded);
+    U_PORT_TEST_ASSERT(numFramesEncoded == sizeof(frames) / sizeof(frames[0]));
+    U_PORT_TEST_ASSERT(x > 0);
+    for (size_t z = 0; z < sizeof(frames) / sizeof(frames[0]); z++) {
+        y = uCellMuxPrivateEncode(frames[z].address, frames[z].type, frames[z].pollFinal,
+                                  frames[z].pInformation, frames[z].informationLengthBytes,
+                                  pBuffer + bufferLength + offset);
+        U_PORT_TEST_ASSERT(y > 0);
+        offset += y;
+    }
+    U_PORT_TEST_ASSERT(offset == (size_t) x);
+    U_PORT_TEST_ASSERT(memcmp(pBuffer, pBuffer + bufferLength, offset) == 0);
+
+    // Now encode and decode, back to back, lots of batches, timing it
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t z = 0; z < U_CELL_MUX_PRIVATE_TEST_BATCH_ITERATIONS; z++) {
+        x = uCellMuxPrivateEncodeBatch(frames, sizeof(frames) / sizeof(frames[0]), pBuffer,
+                                       bufferLength, &numFramesEncoded);
+        U_PORT_TEST_ASSERT(x > 0);
+        parserContext.pBuffer = pBuffer;
+        parserContext.bufferSize = x;
+        parserContext.bufferIndex = 0;
+        for (size_t w = 0; w < numFramesEncoded; w++) {
+            parserContext.address = U_CELL_MUX_PRIVATE_ADDRESS_ANY;
+            parserContext.type = U_CELL_MUX_PRIVATE_FRAME_TYPE_NONE;
+            parserContext.pInformation = pInformationDecoded;
+            parserContext.informationLengthBytes = U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES;
+            y = uCellMuxPrivateParseCmux(NULL, &parserContext);
+            U_PORT_TEST_ASSERT(y == 0);
+            U_PORT_TEST_ASSERT(parserContext.address == frames[w].address);
+            U_PORT_TEST_ASSERT(parserContext.type == frames[w].type);
+            U_PORT_TEST_ASSERT(parserContext.pollFinal == frames[w].pollFinal);
+            U_PORT_TEST_ASSERT(parserContext.informationLengthBytes ==
+                               frames[w].informationLengthBytes);
+            U_PORT_TEST_ASSERT(memcmp(pInformationDecoded, frames[w].pInformation,
+                                      frames[w].informationLengthBytes) == 0);
+            numFramesDecoded++;
+        }
+        U_PORT_TEST_ASSERT(parserContext.bufferIndex == parserContext.bufferSize);
+        if (z % 100 == 0) {
+            // Give any task watchdog a bone
+            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        }
+    }
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("%d frame(s) encoded in batches of %d and decoded in %d ms.",
+                      numFramesDecoded, sizeof(frames) / sizeof(frames[0]), durationMs);
+    if (durationMs > 0) {
+        U_TEST_PRINT_LINE("that is %d frame(s) per second.",
+                          (int32_t) ((numFramesDecoded * 1000) / durationMs));
+    }
+    U_PORT_TEST_ASSERT(numFramesDecoded == U_CELL_MUX_PRIVATE_TEST_BATCH_ITERATIONS *
+                       (sizeof(frames) / sizeof(frames[0])));
+
+    // Free memory
+    uPortFree(pBuffer);
+    uPortFree(pInformationDecoded);
+    uPortFree(pInformation);
+
+    uPortDeinit();
+
+# ifndef __XTENSA__
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+# else
+    (void) heapUsed;
+# endif
+}
+
+/** Compare the throughput of CMUX for a range of maximum information
+ * field lengths by sending a block of user data through a simulated
+ * 27.010 peer: the data is encoded into UIH frames, the stream is
+ * pushed in UART-sized chunks into a ring buffer, the frames
+ * are parsed out of the ring buffer and the information fields
+ * copied directly out of the ring buffer as cmuxDecode() would.
+ *
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the
+ * U_PORT_TEST_FUNCTION() macro.
+ */
+U_PORT_TEST_FUNCTION("[cellMuxPrivate]", "cellMuxPrivateThroughput")
+{
+    int32_t heapUsed;
+    char *pPayload;
+    char *pReceived;
+    char *pEncoded;
+    char *pLinearBuffer;
+    const char *pSpan = NULL;
+    size_t spanLength;
+    size_t offset;
+    uRingBuffer_t ringBuffer;
+    int32_t readHandle;
+    U_RING_BUFFER_PARSER_f parserList[] = {uCellMuxPrivateParseCmux, NULL};
+    uCellMuxPrivateParserContext_t parserContext;
+    uCellMuxPrivateFrame_t frame = {0};
+    size_t informationLengthMax;
+    size_t ringBufferLength;
+    size_t encodedLength;
+    size_t sent;
+    size_t received;
+    size_t wireBytes;
+    size_t wireBytesPrevious = 0;
+    size_t numFrames;
+    size_t x;
+    int32_t y;
+    int32_t startTimeMs;
+    int32_t durationMs;
+
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    informationLengthMax = 0;
+    for (size_t z = 0; z < sizeof(gInformationLengthMax) / sizeof(gInformationLengthMax[0]); z++) {
+        if (gInformationLengthMax[z] > informationLengthMax) {
+            informationLengthMax = gInformationLengthMax[z];
+        }
+    }
+    pPayload = (char *) pUPortMalloc(U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES);
+    U_PORT_TEST_ASSERT(pPayload != NULL);
+    pReceived = (char *) pUPortMalloc(U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES);
+    U_PORT_TEST_ASSERT(pReceived != NULL);
+    pEncoded = (char *) pUPortMalloc(informationLengthMax +
+                                     U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES);
+    U_PORT_TEST_ASSERT(pEncoded != NULL);
+    for (size_t z = 0; z < U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES; z++) {
+        *(pPayload + z) = (char) z;
+    }
+
+    U_TEST_PRINT_LINE("sending %d byte(s) of user data, %d baud UART assumed:",
+                      U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES,
+                      U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_BAUD_RATE);
+    for (size_t z = 0; z < sizeof(gInformationLengthMax) / sizeof(gInformationLengthMax[0]); z++) {
+        informationLengthMax = gInformationLengthMax[z];
+        // Size the receive ring buffer as uCellMuxEnable() would
+        ringBufferLength = ((informationLengthMax + U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES) *
+                            U_CELL_MUX_MAX_CHANNELS) + 1;
+        pLinearBuffer = (char *) pUPortMalloc(ringBufferLength);
+        U_PORT_TEST_ASSERT(pLinearBuffer != NULL);
+        U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, pLinearBuffer,
+                                                           ringBufferLength, 1) == 0);
+        uRingBufferSetReadRequiresHandle(&ringBuffer, true);
+        readHandle = uRingBufferTakeReadHandle(&ringBuffer);
+        U_PORT_TEST_ASSERT(readHandle >= 0);
+        memset(pReceived, 0, U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES);
+        frame.address = U_CELL_MUX_PRIVATE_CHANNEL_ID_AT;
+        frame.type = U_CELL_MUX_PRIVATE_FRAME_TYPE_UIH;
+        sent = 0;
+        received = 0;
+        wireBytes = 0;
+        numFrames = 0;
+        startTimeMs = uPortGetTickTimeMs();
+        while (received < U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES) {
+            // Transmit side: encode a frame of user data
+            frame.pInformation = pPayload + sent;
+            frame.informationLengthBytes = U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES - sent;
+            if (frame.informationLengthBytes > informationLengthMax) {
+                frame.informationLengthBytes = informationLengthMax;
+            }
+            y = uCellMuxPrivateEncodeBatch(&frame, 1, pEncoded,
+                                           informationLengthMax +
+                                           U_CELL_MUX_PRIVATE_FRAME_OVERHEAD_MAX_BYTES, NULL);
+            U_PORT_TEST_ASSERT(y > 0);
+            encodedLength = (size_t) y;
+            sent += frame.informationLengthBytes;
+            wireBytes += encodedLength;
+            numFrames++;
+            // Deliver the stream in chunks, decoding as we go
+            for (size_t w = 0; w < encodedLength; w += x) {
+                x = encodedLength - w;
+                if (x > U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_CHUNK_BYTES) {
+                    x = U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_CHUNK_BYTES;
+                }
+                U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, pEncoded + w, x));
+                // Receive side: parse to find the frame then copy the
+                // information field straight out of the ring buffer
+                memset(&parserContext, 0, sizeof(parserContext));
+                parserContext.type = U_CELL_MUX_PRIVATE_FRAME_TYPE_NONE;
+                parserContext.address = U_CELL_MUX_PRIVATE_ADDRESS_ANY;
+                y = uRingBufferParseHandle(&ringBuffer, readHandle, parserList, &parserContext);
+                if (y > 0) {
+                    U_PORT_TEST_ASSERT(parserContext.type == U_CELL_MUX_PRIVATE_FRAME_TYPE_UIH);
+                    U_PORT_TEST_ASSERT(parserContext.address == U_CELL_MUX_PRIVATE_CHANNEL_ID_AT);
+                    U_PORT_TEST_ASSERT(parserContext.informationOffset +
+                                       parserContext.informationLengthBytes < (size_t) y);
+                    U_PORT_TEST_ASSERT(received + parserContext.informationLengthBytes <=
+                                       U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES);
+                    offset = parserContext.informationOffset;
+                    while (parserContext.informationLengthBytes > 0) {
+                        spanLength = uRingBufferPeekSpanHandle(&ringBuffer, readHandle,
+                                                               &pSpan, offset);
+                        U_PORT_TEST_ASSERT(spanLength > 0);
+                        if (spanLength > parserContext.informationLengthBytes) {
+                            spanLength = parserContext.informationLengthBytes;
+                        }
+                        memcpy(pReceived + received, pSpan, spanLength);
+                        received += spanLength;
+                        offset += spanLength;
+                        parserContext.informationLengthBytes -= spanLength;
+                    }
+                    uRingBufferReadHandle(&ringBuffer, readHandle, NULL, y);
+                }
+            }
+        }
+        durationMs = uPortGetTickTimeMs() - startTimeMs;
+        U_PORT_TEST_ASSERT(memcmp(pReceived, pPayload,
+                                  U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_PAYLOAD_BYTES) == 0);
+        // 10 bits per byte on the UART
+        U_TEST_PRINT_LINE("N1 %4d: %4d frame(s), %6d byte(s) on the wire (%d%% efficient),"
+                          " %d ms at %d baud, %d ms to encode/decode.",
+                          informationLengthMax, numFrames, wireBytes,
+                          (int32_t) ((received * 100) / wireBytes),
+                          (int32_t) (((uint64_t) wireBytes * 10 * 1000) /
+                                     U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_BAUD_RATE),
+                          U_CELL_MUX_PRIVATE_TEST_THROUGHPUT_BAUD_RATE, durationMs);
+        // Bigger frames must never cost more on the wire
+        U_PORT_TEST_ASSERT((wireBytesPrevious == 0) || (wireBytes <= wireBytesPrevious));
+        wireBytesPrevious = wireBytes;
+        uRingBufferGiveReadHandle(&ringBuffer, readHandle);
+        uRingBufferDelete(&ringBuffer);
+        uPortFree(pLinearBuffer);
+        // Give any task watchdog a bone
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+    }
+
+    // Free memory
+    uPortFree(pEncoded);
+    uPortFree(pReceived);
+    uPortFree(pPayload);
+
+    uPortDeinit();
+
+# ifndef __XTENSA__
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+# else
+    (void) heapUsed;
+# endif
+}
+
+/** Check that the transmit scheduler gives the UART to the waiting
+ * channel of highest priority and, between two channels of equal
+ * priority, shares it in proportion to their weights, whatever
+ * the size of their batches, without a channel that was idle or
+ * flow controlled off being able to catch up in a burst.
+ *
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the
+ * U_PORT_TEST_FUNCTION() macro.
+ */
+U_PORT_TEST_FUNCTION("[cellMuxPrivate]", "cellMuxPrivateTxSchedule")
+{
+    uCellMuxPrivateTxSchedule_t schedule[2];
+    uCellMuxPrivateTxSchedule_t *pSchedules[2] = {&(schedule[0]), &(schedule[1])};
+    size_t sizeBytes[2];
+    size_t sentBytes[2];
+    uint32_t virtualTime = 0;
+    size_t batches = U_CELL_MUX_PRIVATE_TEST_TX_SCHEDULE_BATCHES;
+
+    memset(schedule, 0, sizeof(schedule));
+
+    // Nothing waiting, nothing to send
+    U_PORT_TEST_ASSERT(uCellMuxPrivateTxScheduleNext(pSchedules, 2, virtualTime) < 0);
+
+    // Equal priority and weight, equal batch sizes: strict alternation
+    schedule[0].weight = 1;
+    schedule[1].weight = 1;
+    schedule[0].waiting = true;
+    schedule[1].waiting = true;
+    sizeBytes[0] = 100;
+    sizeBytes[1] = 100;
+    memset(sentBytes, 0, sizeof(sentBytes));
+    txScheduleRun(pSchedules, 2, sizeBytes, &virtualTime, batches, sentBytes);
+    U_TEST_PRINT_LINE("equal weights: %d and %d byte(s).", sentBytes[0], sentBytes[1]);
+    U_PORT_TEST_ASSERT(sentBytes[0] == sentBytes[1]);
+
+    // Weights of one and three: a quarter and three quarters, give
+    // or take a batch
+    schedule[1].weight = 3;
+    memset(sentBytes, 0, sizeof(sentBytes));
+    txScheduleRun(pSchedules, 2, sizeBytes, &virtualTime, batches, sentBytes);
+    U_TEST_PRINT_LINE("weights 1:3: %d and %d byte(s).", sentBytes[0], sentBytes[1]);
+    U_PORT_TEST_ASSERT(sentBytes[0] + sizeBytes[0] >= (batches / 4) * sizeBytes[0]);
+    U_PORT_TEST_ASSERT(sentBytes[0] <= (batches / 4) * sizeBytes[0] + sizeBytes[0]);
+
+    // Equal weights, one channel with batches ten times the size of
+    // the other: the bytes sent, not the batches, should be equal,
+    // give or take the larger batch
+    schedule[1].weight = 1;
+    sizeBytes[0] = 1000;
+    memset(sentBytes, 0, sizeof(sentBytes));
+    txScheduleRun(pSchedules, 2, sizeBytes, &virtualTime, batches, sentBytes);
+    U_TEST_PRINT_LINE("batch sizes 10:1: %d and %d byte(s).", sentBytes[0], sentBytes[1]);
+    U_PORT_TEST_ASSERT(sentBytes[0] <= sentBytes[1] + sizeBytes[0]);
+    U_PORT_TEST_ASSERT(sentBytes[1] <= sentBytes[0] + sizeBytes[0]);
+
+    // A higher priority channel always goes first while it is waiting,
+    // however much it has sent
+    sizeBytes[0] = 100;
+    schedule[0].priority = 1;
+    memset(sentBytes, 0, sizeof(sentBytes));
+    txScheduleRun(pSchedules, 2, sizeBytes, &virtualTime, batches, sentBytes);
+    U_PORT_TEST_ASSERT(sentBytes[0] == batches * sizeBytes[0]);
+    U_PORT_TEST_ASSERT(sentBytes[1] == 0);
+    // ...but not when it is not waiting or is flow controlled off
+    schedule[0].waiting = false;
+    U_PORT_TEST_ASSERT(uCellMuxPrivateTxScheduleNext(pSchedules, 2, virtualTime) == 1);
+    schedule[0].waiting = true;
+    pSchedules[0] = NULL;
+    U_PORT_TEST_ASSERT(uCellMuxPrivateTxScheduleNext(pSchedules, 2, virtualTime) == 1);
+
+    // While channel 0 is flow controlled off channel 1 has the UART
+    // to itself; when channel 0 comes back, at equal priority, it
+    // must not be able to make up for lost time in a burst
+    schedule[0].priority = 0;
+    memset(sentBytes, 0, sizeof(sentBytes));
+    txScheduleRun(pSchedules, 2, sizeBytes, &virtualTime, batches, sentBytes);
+    U_PORT_TEST_ASSERT(sentBytes[1] == batches * sizeBytes[1]);
+    pSchedules[0] = &(schedule[0]);
+    memset(sentBytes, 0, sizeof(sentBytes));
+    txScheduleRun(pSchedules, 2, sizeBytes, &virtualTime, 10, sentBytes);
+    U_TEST_PRINT_LINE("after flow control: %d and %d byte(s).", sentBytes[0], sentBytes[1]);
+    // Give or take a batch each way
+    U_PORT_TEST_ASSERT(sentBytes[0] <= sentBytes[1] + (sizeBytes[0] * 2));
+    U_PORT_TEST_ASSERT(sentBytes[1] <= sentBytes[0] + (sizeBytes[1] * 2));
+}
+
 // End of file
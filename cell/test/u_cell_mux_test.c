@@ -109,6 +109,13 @@
 # define U_CELL_MUX_TEST_BASIC_NUM_ITERATIONS 10
 #endif
 
+#ifndef U_CELL_MUX_TEST_INFORMATION_LENGTH_MAX_BYTES
+/** The larger maximum information field length to ask for when
+ * testing that.
+ */
+# define U_CELL_MUX_TEST_INFORMATION_LENGTH_MAX_BYTES 512
+#endif
+
 #ifndef U_CELL_MUX_TEST_MQTT_SERVER_IP_ADDRESS
 /** Server to use for the MQTT part of the mux test.
  */
@@ -447,6 +454,8 @@ U_PORT_TEST_FUNCTION("[cellMux]", "cellMuxBasic")
     // +1 and zero init so that we can treat it as a string
     char buffer1[U_CELL_INFO_IMEI_SIZE + 1] = {0};
     char buffer2[U_CELL_INFO_IMEI_SIZE + 1] = {0};
+    int32_t y;
+    uCellMuxChannelStats_t channelStats;
 
     // In case a previous test failed
     uCellTestPrivateCleanup(&gHandles);
@@ -495,6 +504,42 @@ U_PORT_TEST_FUNCTION("[cellMux]", "cellMuxBasic")
             uPortLog(U_TEST_PREFIX_BASE "_%d: IMEI read after disabling CMUX gives %s.\n", x + 1, buffer2);
             U_PORT_TEST_ASSERT(strncmp(buffer1, buffer2, sizeof(buffer1)) == 0);
         }
+
+        // Do it again with a larger information field length
+        y = uCellMuxSetInformationLengthMax(cellHandle, U_CELL_MUX_TEST_INFORMATION_LENGTH_MAX_BYTES);
+        U_PORT_TEST_ASSERT(y == 0);
+        U_PORT_TEST_ASSERT(uCellMuxGetInformationLengthMax(cellHandle) ==
+                           U_CELL_MUX_TEST_INFORMATION_LENGTH_MAX_BYTES);
+        U_TEST_PRINT_LINE("enabling CMUX asking for an information field length of %d.",
+                          U_CELL_MUX_TEST_INFORMATION_LENGTH_MAX_BYTES);
+        U_PORT_TEST_ASSERT(uCellMuxEnable(cellHandle) == 0);
+        y = uCellMuxGetInformationLengthMax(cellHandle);
+        U_TEST_PRINT_LINE("agreed information field length is %d.", y);
+        U_PORT_TEST_ASSERT((y > 0) && (y <= U_CELL_MUX_TEST_INFORMATION_LENGTH_MAX_BYTES));
+        // Can't change it while CMUX is running
+        U_PORT_TEST_ASSERT(uCellMuxSetInformationLengthMax(cellHandle, 0) < 0);
+        // Check transmit priority/weight setting and the statistics of the AT channel
+        U_PORT_TEST_ASSERT(uCellMuxSetChannelTxPriority(cellHandle, 0, 1, 1) < 0);
+        U_PORT_TEST_ASSERT(uCellMuxSetChannelTxPriority(cellHandle, 1, 1, 0) < 0);
+        U_PORT_TEST_ASSERT(uCellMuxSetChannelTxPriority(cellHandle, 1, 1,
+                                                        U_CELL_MUX_TX_WEIGHT_MAX + 1) < 0);
+        U_PORT_TEST_ASSERT(uCellMuxSetChannelTxPriority(cellHandle, 1, 1, 2) == 0);
+        U_PORT_TEST_ASSERT(uCellInfoGetImei(cellHandle, buffer2) == 0);
+        U_PORT_TEST_ASSERT(strncmp(buffer1, buffer2, sizeof(buffer1)) == 0);
+        U_PORT_TEST_ASSERT(uCellMuxGetChannelStats(cellHandle, 1, &channelStats) == 0);
+        U_TEST_PRINT_LINE("AT channel sent %d byte(s) in %d batch(es), average latency"
+                          " %d ms, max %d ms.", channelStats.sentBytes,
+                          channelStats.numBatches, channelStats.latencyAverageMs,
+                          channelStats.latencyMaxMs);
+        U_PORT_TEST_ASSERT(channelStats.sentBytes > 0);
+        U_PORT_TEST_ASSERT(channelStats.numBatches > 0);
+        U_PORT_TEST_ASSERT(channelStats.queuedBytes == 0);
+        U_PORT_TEST_ASSERT(uCellMuxSetChannelTxPriority(cellHandle, 1,
+                                                        U_CELL_MUX_TX_PRIORITY_DEFAULT,
+                                                        U_CELL_MUX_TX_WEIGHT_DEFAULT) == 0);
+        U_PORT_TEST_ASSERT(uCellMuxDisable(cellHandle) == 0);
+        U_PORT_TEST_ASSERT(uCellMuxGetChannelStats(cellHandle, 1, &channelStats) < 0);
+        U_PORT_TEST_ASSERT(uCellMuxSetInformationLengthMax(cellHandle, 0) == 0);
     } else {
         U_TEST_PRINT_LINE("CMUX is not supported, not running tests.");
         U_PORT_TEST_ASSERT(uCellMuxEnable(cellHandle) < 0);
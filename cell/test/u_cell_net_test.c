@@ -79,6 +79,26 @@
  */
 #define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
 
+#ifndef U_CELL_NET_TEST_AT_SERVER_TASK_STACK_SIZE_BYTES
+/** The stack size for the task that runs the scripted AT server
+ * of cellNetRegUrc.
+ */
+# define U_CELL_NET_TEST_AT_SERVER_TASK_STACK_SIZE_BYTES 2304
+#endif
+
+#ifndef U_CELL_NET_TEST_AT_SERVER_TASK_PRIORITY
+/** The priority for the task that runs the scripted AT server
+ * of cellNetRegUrc, re-using the URC task priority for convenience.
+ */
+# define U_CELL_NET_TEST_AT_SERVER_TASK_PRIORITY U_AT_CLIENT_URC_TASK_PRIORITY
+#endif
+
+/** The number of AT+CxREG? queries the scripted AT server of
+ * cellNetRegUrc answers before it sends the +CEREG URC that
+ * indicates registration.
+ */
+#define U_CELL_NET_TEST_AT_SERVER_QUERIES_BEFORE_URC 6
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -112,6 +132,46 @@ static bool gHasBeenConnected = false;
  */
 static int32_t gCallbackErrorCode = 0;
 
+/** The number of networks passed to scanCallback.
+ */
+static volatile int32_t gScanNumNetworks = 0;
+
+/** The outcome passed to scanCallback at the end of a scan, 1 while
+ * the scan is still going.
+ */
+static volatile int32_t gScanErrorCodeOrNumber = 1;
+
+/** Storage for the last good network record.
+ */
+static uCellNetLastGood_t gLastGood;
+
+/** The number of times lastGoodSave() has been called.
+ */
+static size_t gLastGoodSaveCount = 0;
+
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+/** UART handle for the AT server of cellNetRegUrc.
+ */
+static int32_t gUartBHandle = -1;
+
+/** Buffer for the command line being received by the AT server.
+ */
+static char gAtServerLine[32];
+
+/** The number of characters in gAtServerLine.
+ */
+static size_t gAtServerLineLength = 0;
+
+/** The number of AT+CxREG? queries the AT server has answered.
+ */
+static size_t gAtServerQueryCount = 0;
+
+/** The time at which the AT server sent the URC indicating
+ * registration, zero if it has not been sent.
+ */
+static volatile int64_t gAtServerUrcTimeMs = 0;
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -181,6 +241,134 @@ static void connectCallback(bool isConnected, void *pParameter)
     }
 }
 
+// Callback for an asynchronous network scan.
+static void scanCallback(uDeviceHandle_t cellHandle, const char *pName,
+                         const char *pMccMnc, uCellNetRat_t rat,
+                         int32_t errorCodeOrNumber, void *pParameter)
+{
+    // Note: not using asserts here as, when they go
+    // off, the seem to cause stack overruns
+    if (cellHandle != gHandles.cellHandle) {
+        gCallbackErrorCode = 9;
+    }
+    if ((pParameter == NULL) || (strcmp((char *) pParameter, "Bish!") != 0)) {
+        gCallbackErrorCode = 10;
+    }
+    if (pMccMnc != NULL) {
+        gScanNumNetworks++;
+        // The AcT field is optional so the RAT may be unknown
+        if ((pName == NULL) || (strlen(pMccMnc) == 0) ||
+            (rat < U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED) ||
+            (rat >= U_CELL_NET_RAT_MAX_NUM) ||
+            (errorCodeOrNumber != gScanNumNetworks)) {
+            gCallbackErrorCode = 11;
+        }
+        U_TEST_PRINT_LINE("async scan found \"%s\", MCC/MNC %s (%s).", pName,
+                          pMccMnc, pUCellTestPrivateRatStr(rat));
+    } else {
+        gScanErrorCodeOrNumber = errorCodeOrNumber;
+    }
+}
+
+// Callback to load the last good network record.
+static bool lastGoodLoad(uDeviceHandle_t cellHandle,
+                         uCellNetLastGood_t *pLastGood,
+                         void *pParameter)
+{
+    if ((cellHandle != gHandles.cellHandle) || (pParameter != &gLastGood)) {
+        gCallbackErrorCode = 12;
+    }
+    *pLastGood = gLastGood;
+
+    return (gLastGoodSaveCount > 0);
+}
+
+// Callback to save the last good network record.
+static void lastGoodSave(uDeviceHandle_t cellHandle,
+                         const uCellNetLastGood_t *pLastGood,
+                         void *pParameter)
+{
+    if ((cellHandle != gHandles.cellHandle) || (pParameter != &gLastGood)) {
+        gCallbackErrorCode = 13;
+    }
+    gLastGood = *pLastGood;
+    gLastGoodSaveCount++;
+}
+
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+// Send a string from the AT server.
+static void atServerSend(int32_t uartHandle, const char *pStr)
+{
+    uPortUartWrite(uartHandle, pStr, strlen(pStr));
+}
+
+// Answer a command line received by the AT server.  The server
+// plays the part of a module which reports "searching" to every
+// AT+CxREG? query, so that registration can only complete through
+// a +CEREG URC; it sends one URC that is also "searching" part
+// way through, so that the poll changes to the URC poll interval,
+// and then, a while after a later query, the URC that indicates
+// registration.
+static void atServerAnswer(int32_t uartHandle, const char *pLine)
+{
+    const char *pResponse = "\r\nOK\r\n";
+    bool isQuery = false;
+
+    if (strcmp(pLine, "AT+CREG?") == 0) {
+        pResponse = "\r\n+CREG: 2,2\r\n\r\nOK\r\n";
+        isQuery = true;
+    } else if (strcmp(pLine, "AT+CGREG?") == 0) {
+        pResponse = "\r\n+CGREG: 2,2\r\n\r\nOK\r\n";
+        isQuery = true;
+    } else if (strcmp(pLine, "AT+CEREG?") == 0) {
+        pResponse = "\r\n+CEREG: 4,2\r\n\r\nOK\r\n";
+        isQuery = true;
+    } else if (strcmp(pLine, "AT+CIMI") == 0) {
+        pResponse = "\r\n001010123456789\r\n\r\nOK\r\n";
+    } else if (strcmp(pLine, "AT+COPS?") == 0) {
+        pResponse = "\r\n+COPS: 0,0,\"Test\",7\r\n\r\nOK\r\n";
+    } else if (strcmp(pLine, "AT+CGATT?") == 0) {
+        pResponse = "\r\n+CGATT: 1\r\n\r\nOK\r\n";
+    }
+    atServerSend(uartHandle, pResponse);
+
+    if (isQuery) {
+        gAtServerQueryCount++;
+        if (gAtServerQueryCount == 3) {
+            atServerSend(uartHandle, "\r\n+CEREG: 2\r\n");
+        } else if (gAtServerQueryCount == U_CELL_NET_TEST_AT_SERVER_QUERIES_BEFORE_URC) {
+            // Let the registration loop settle into its wait
+            uPortTaskBlock(U_CELL_NET_REGISTRATION_POLL_INTERVAL_MS);
+            gAtServerUrcTimeMs = uPortGetTickTimeMs();
+            atServerSend(uartHandle, "\r\n+CEREG: 1\r\n");
+        }
+    }
+}
+
+// Callback for the AT server, assembling command lines.
+static void atServerCallback(int32_t uartHandle, uint32_t eventBitmask,
+                             void *pParameters)
+{
+    char c;
+
+    (void) pParameters;
+
+    if (eventBitmask & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) {
+        while (uPortUartRead(uartHandle, &c, 1) > 0) {
+            if (c == U_AT_CLIENT_COMMAND_DELIMITER[0]) {
+                gAtServerLine[gAtServerLineLength] = 0;
+                atServerAnswer(uartHandle, gAtServerLine);
+                gAtServerLineLength = 0;
+            } else if ((c != '\n') &&
+                       (gAtServerLineLength < sizeof(gAtServerLine) - 1)) {
+                gAtServerLine[gAtServerLineLength] = c;
+                gAtServerLineLength++;
+            }
+        }
+    }
+}
+#endif
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -469,7 +657,9 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetScanRegActDeact")
     int32_t mnc = 0;
     int32_t y = 0;
     uCellNetRat_t rat = U_CELL_NET_RAT_UNKNOWN_OR_NOT_USED;
+    uCellNetAttachAttempt_t attachAttempts[U_CELL_NET_ATTACH_ATTEMPTS_MAX_NUM];
     int32_t heapUsed;
+    int64_t startTimeMs;
 
     // In case a previous test failed
     uCellTestPrivateCleanup(&gHandles);
@@ -526,15 +716,45 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetScanRegActDeact")
     // Must be at least one, can't guarantee more than that
     U_PORT_TEST_ASSERT(y > 0);
 
+    // Do the same with an asynchronous scan, again giving it several goes
+    U_PORT_TEST_ASSERT(uCellNetScanStart(cellHandle, NULL, NULL) < 0);
+    gCallbackErrorCode = 0;
+    gScanErrorCodeOrNumber = 0;
+    for (size_t x = 5; (x > 0) && (gScanErrorCodeOrNumber <= 0); x--) {
+        U_TEST_PRINT_LINE("scanning for networks asynchronously...");
+        gScanNumNetworks = 0;
+        gScanErrorCodeOrNumber = 1;
+        U_PORT_TEST_ASSERT(uCellNetScanStart(cellHandle, scanCallback, "Bish!") == 0);
+        U_PORT_TEST_ASSERT(uCellNetScanStart(cellHandle, scanCallback,
+                                             "Bish!") == (int32_t) U_ERROR_COMMON_BUSY);
+        startTimeMs = uPortGetTickTimeMs();
+        while ((gScanErrorCodeOrNumber == 1) &&
+               (uPortGetTickTimeMs() - startTimeMs <
+                (U_CELL_TEST_CFG_CONNECT_TIMEOUT_SECONDS * 1000))) {
+            uPortTaskBlock(1000);
+        }
+        uCellNetScanStop(cellHandle);
+        if (gScanErrorCodeOrNumber <= 0) {
+            U_TEST_PRINT_LINE("*** WARNING *** RETRY SCAN.");
+            uPortTaskBlock(5000);
+        }
+    }
+    U_TEST_PRINT_LINE("%d network(s) found asynchronously.", gScanNumNetworks);
+    U_PORT_TEST_ASSERT(gCallbackErrorCode == 0);
+    U_PORT_TEST_ASSERT(gScanErrorCodeOrNumber > 0);
+    U_PORT_TEST_ASSERT(gScanErrorCodeOrNumber == gScanNumNetworks);
+
     // Register with a very short time-out to show that aborts work
     gStopTimeMs = uPortGetTickTimeMs() + 1000;
     U_PORT_TEST_ASSERT(uCellNetRegister(cellHandle, NULL, keepGoingCallback) < 0);
 
     // Now register with a sensible timeout
     U_TEST_PRINT_LINE("registering...");
-    gStopTimeMs = uPortGetTickTimeMs() +
-                  (U_CELL_TEST_CFG_CONNECT_TIMEOUT_SECONDS * 1000);
+    startTimeMs = uPortGetTickTimeMs();
+    gStopTimeMs = startTimeMs + (U_CELL_TEST_CFG_CONNECT_TIMEOUT_SECONDS * 1000);
     U_PORT_TEST_ASSERT(uCellNetRegister(cellHandle, NULL, keepGoingCallback) == 0);
+    U_TEST_PRINT_LINE("registration took %d ms.",
+                      (int32_t) (uPortGetTickTimeMs() - startTimeMs));
 
     // Check that we're registered
     U_PORT_TEST_ASSERT(uCellNetIsRegistered(cellHandle));
@@ -798,6 +1018,48 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetScanRegActDeact")
     U_TEST_PRINT_LINE("disconnecting...");
     U_PORT_TEST_ASSERT(uCellNetDisconnect(cellHandle, NULL) == 0);
 
+    // Register with a last good record: the first time there
+    // is nothing to load so only automatic selection should be
+    // tried and the record should then be saved
+    U_TEST_PRINT_LINE("registering with last good callbacks...");
+    gCallbackErrorCode = 0;
+    gLastGoodSaveCount = 0;
+    U_PORT_TEST_ASSERT(uCellNetSetLastGoodCallbacks(cellHandle, lastGoodLoad,
+                                                    lastGoodSave, &gLastGood) == 0);
+    gStopTimeMs = uPortGetTickTimeMs() +
+                  (U_CELL_TEST_CFG_CONNECT_TIMEOUT_SECONDS * 1000);
+    U_PORT_TEST_ASSERT(uCellNetRegister(cellHandle, NULL, keepGoingCallback) == 0);
+    U_PORT_TEST_ASSERT(uCellNetGetAttachAttempts(cellHandle, attachAttempts,
+                                                 sizeof(attachAttempts) /
+                                                 sizeof(attachAttempts[0])) == 1);
+    U_PORT_TEST_ASSERT(!attachAttempts[0].lastGood);
+    U_PORT_TEST_ASSERT(attachAttempts[0].errorCode == 0);
+    U_TEST_PRINT_LINE("attach took %d ms.", attachAttempts[0].timeMs);
+    U_PORT_TEST_ASSERT(gLastGoodSaveCount == 1);
+    U_TEST_PRINT_LINE("last good network %s.", gLastGood.mccMnc);
+    U_PORT_TEST_ASSERT(strlen(gLastGood.mccMnc) >= 5);
+    U_PORT_TEST_ASSERT(gLastGood.rat == uCellNetGetActiveRat(cellHandle));
+    U_PORT_TEST_ASSERT(uCellNetDisconnect(cellHandle, NULL) == 0);
+
+    // The second time the last good network should be tried first
+    U_TEST_PRINT_LINE("registering again with last good callbacks...");
+    gStopTimeMs = uPortGetTickTimeMs() +
+                  (U_CELL_TEST_CFG_CONNECT_TIMEOUT_SECONDS * 1000);
+    U_PORT_TEST_ASSERT(uCellNetRegister(cellHandle, NULL, keepGoingCallback) == 0);
+    y = uCellNetGetAttachAttempts(cellHandle, attachAttempts,
+                                  sizeof(attachAttempts) / sizeof(attachAttempts[0]));
+    U_PORT_TEST_ASSERT((y == 1) || (y == 2));
+    U_PORT_TEST_ASSERT(attachAttempts[0].lastGood);
+    for (int32_t x = 0; x < y; x++) {
+        U_TEST_PRINT_LINE("attempt %d (%s) took %d ms, error code %d.", x + 1,
+                          attachAttempts[x].lastGood ? "last good" : "automatic",
+                          attachAttempts[x].timeMs, attachAttempts[x].errorCode);
+    }
+    U_PORT_TEST_ASSERT(attachAttempts[y - 1].errorCode == 0);
+    U_PORT_TEST_ASSERT(gCallbackErrorCode == 0);
+    U_PORT_TEST_ASSERT(uCellNetSetLastGoodCallbacks(cellHandle, NULL, NULL, NULL) == 0);
+    U_PORT_TEST_ASSERT(uCellNetDisconnect(cellHandle, NULL) == 0);
+
     // Do the standard postamble, leaving the module on for the next
     // test to speed things up
     uCellTestPrivatePostamble(&gHandles, false);
@@ -810,6 +1072,113 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetScanRegActDeact")
     U_PORT_TEST_ASSERT(heapUsed <= 0);
 }
 
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+/** Test that registration completes as soon as a +CEREG URC
+ * arrives, rather than at the next poll, using a scripted AT
+ * server on UART B playing the part of the module.
+ *
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the
+ * U_PORT_TEST_FUNCTION() macro.
+ */
+U_PORT_TEST_FUNCTION("[cellNet]", "cellNetRegUrc")
+{
+    uCellPrivateInstance_t *pInstance;
+    int32_t heapUsed;
+    int32_t timeMs;
+
+    // In case a previous test failed
+    uCellTestPrivateCleanup(&gHandles);
+
+    // Obtain the initial heap size
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    gHandles.uartHandle = uPortUartOpen(U_CFG_TEST_UART_A,
+                                        U_CFG_TEST_BAUD_RATE,
+                                        NULL,
+                                        U_CELL_UART_BUFFER_LENGTH_BYTES,
+                                        U_CFG_TEST_PIN_UART_A_TXD,
+                                        U_CFG_TEST_PIN_UART_A_RXD,
+                                        U_CFG_TEST_PIN_UART_A_CTS,
+                                        U_CFG_TEST_PIN_UART_A_RTS);
+    U_PORT_TEST_ASSERT(gHandles.uartHandle >= 0);
+
+    gUartBHandle = uPortUartOpen(U_CFG_TEST_UART_B,
+                                 U_CFG_TEST_BAUD_RATE,
+                                 NULL,
+                                 U_CELL_UART_BUFFER_LENGTH_BYTES,
+                                 U_CFG_TEST_PIN_UART_B_TXD,
+                                 U_CFG_TEST_PIN_UART_B_RXD,
+                                 U_CFG_TEST_PIN_UART_B_CTS,
+                                 U_CFG_TEST_PIN_UART_B_RTS);
+    U_PORT_TEST_ASSERT(gUartBHandle >= 0);
+
+    U_TEST_PRINT_LINE("cellular API on UART %d, scripted AT server on UART %d,"
+                      " make sure these are cross-connected.",
+                      U_CFG_TEST_UART_A, U_CFG_TEST_UART_B);
+
+    gAtServerLineLength = 0;
+    gAtServerQueryCount = 0;
+    gAtServerUrcTimeMs = 0;
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackSet(gUartBHandle,
+                                                 U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                 atServerCallback, NULL,
+                                                 U_CELL_NET_TEST_AT_SERVER_TASK_STACK_SIZE_BYTES,
+                                                 U_CELL_NET_TEST_AT_SERVER_TASK_PRIORITY) == 0);
+
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+    gHandles.atClientHandle = uAtClientAdd(gHandles.uartHandle,
+                                           U_AT_CLIENT_STREAM_TYPE_UART,
+                                           NULL, U_CELL_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(gHandles.atClientHandle != NULL);
+
+    U_PORT_TEST_ASSERT(uCellInit() == 0);
+    U_PORT_TEST_ASSERT(uCellAdd(U_CELL_MODULE_TYPE_SARA_R5, gHandles.atClientHandle,
+                                -1, -1, -1, false, &gHandles.cellHandle) == 0);
+    pInstance = pUCellPrivateGetInstance(gHandles.cellHandle);
+    U_PORT_TEST_ASSERT(pInstance != NULL);
+    //lint -esym(613, pInstance) Suppress possible use of NULL pointer
+    // for pInstance from now on
+    U_PORT_TEST_ASSERT(!pInstance->registrationUrcSeen);
+
+    // The AT server never reports registration in response to
+    // AT+CxREG?, only in a URC, so success means that the URC
+    // was acted upon
+    U_TEST_PRINT_LINE("registering...");
+    gCallbackErrorCode = 0;
+    gStopTimeMs = uPortGetTickTimeMs() + 30000;
+    U_PORT_TEST_ASSERT(uCellNetRegister(gHandles.cellHandle, NULL,
+                                        keepGoingCallback) == 0);
+    U_PORT_TEST_ASSERT(gAtServerUrcTimeMs > 0);
+    timeMs = (int32_t) (uPortGetTickTimeMs() - gAtServerUrcTimeMs);
+    U_TEST_PRINT_LINE("registration complete %d ms after the URC.", timeMs);
+    U_PORT_TEST_ASSERT(pInstance->registrationUrcSeen);
+    U_PORT_TEST_ASSERT(uCellNetIsRegistered(gHandles.cellHandle));
+    // The URC arrived part way into a wait of
+    // U_CELL_NET_REGISTRATION_URC_POLL_INTERVAL_MS, so registration
+    // must have completed before the next AT+CxREG? query was due
+    U_PORT_TEST_ASSERT(timeMs < U_CELL_NET_REGISTRATION_URC_POLL_INTERVAL_MS -
+                       U_CELL_NET_REGISTRATION_POLL_INTERVAL_MS);
+    U_PORT_TEST_ASSERT(gAtServerQueryCount == U_CELL_NET_TEST_AT_SERVER_QUERIES_BEFORE_URC);
+    U_PORT_TEST_ASSERT(gCallbackErrorCode == 0);
+
+    uPortUartClose(gUartBHandle);
+    gUartBHandle = -1;
+
+    // Do the standard postamble, which also closes UART A
+    uCellTestPrivatePostamble(&gHandles, false);
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+}
+#endif
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -819,6 +1188,12 @@ U_PORT_TEST_FUNCTION("[cellNet]", "cellNetCleanUp")
     int32_t x;
 
     uCellTestPrivateCleanup(&gHandles);
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
+    if (gUartBHandle >= 0) {
+        uPortUartClose(gUartBHandle);
+        gUartBHandle = -1;
+    }
+#endif
 
     x = uPortTaskStackMinFree(NULL);
     if (x != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
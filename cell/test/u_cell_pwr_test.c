@@ -794,6 +794,9 @@ U_PORT_TEST_FUNCTION("[cellPwr]", "cellPwrReboot")
 {
     int32_t heapUsed;
     int32_t heapClibLossOffset = (int32_t) gSystemHeapLost;
+    int32_t startTimeMs;
+    int32_t timeNormalMs;
+    int32_t timeFastMs;
 
     // In case a previous test failed
     uCellTestPrivateCleanup(&gHandles);
@@ -809,14 +812,33 @@ U_PORT_TEST_FUNCTION("[cellPwr]", "cellPwrReboot")
     // that is ephemeral so that we know whether a reboot has
     // occurred.  Anyway, this will be tested in those tests that
     // change bandmask and RAT.
+    U_PORT_TEST_ASSERT(!uCellPwrGetFastBoot(gHandles.cellHandle));
     U_TEST_PRINT_LINE("rebooting cellular...");
+    startTimeMs = uPortGetTickTimeMs();
     U_PORT_TEST_ASSERT(uCellPwrReboot(gHandles.cellHandle, NULL) == 0);
+    timeNormalMs = uPortGetTickTimeMs() - startTimeMs;
 #ifdef U_CELL_TEST_MUX_ALWAYS
     U_PORT_TEST_ASSERT(uCellMuxEnable(gHandles.cellHandle) == 0);
 #endif
 
     U_PORT_TEST_ASSERT(uCellPwrIsAlive(gHandles.cellHandle));
 
+    // Do it again with fast boot switched on
+    U_PORT_TEST_ASSERT(uCellPwrSetFastBoot(gHandles.cellHandle, true) == 0);
+    U_PORT_TEST_ASSERT(uCellPwrGetFastBoot(gHandles.cellHandle));
+    U_TEST_PRINT_LINE("rebooting cellular with fast boot on...");
+    startTimeMs = uPortGetTickTimeMs();
+    U_PORT_TEST_ASSERT(uCellPwrReboot(gHandles.cellHandle, NULL) == 0);
+    timeFastMs = uPortGetTickTimeMs() - startTimeMs;
+#ifdef U_CELL_TEST_MUX_ALWAYS
+    U_PORT_TEST_ASSERT(uCellMuxEnable(gHandles.cellHandle) == 0);
+#endif
+    U_PORT_TEST_ASSERT(uCellPwrIsAlive(gHandles.cellHandle));
+    U_TEST_PRINT_LINE("reboot took %d ms normally, %d ms with fast boot.",
+                      timeNormalMs, timeFastMs);
+    U_PORT_TEST_ASSERT(uCellPwrSetFastBoot(gHandles.cellHandle, false) == 0);
+    U_PORT_TEST_ASSERT(!uCellPwrGetFastBoot(gHandles.cellHandle));
+
     // Do the standard postamble, leaving the module on for the next
     // test to speed things up
     uCellTestPrivatePostamble(&gHandles, false);
@@ -149,6 +149,13 @@
 # define U_CELL_SEC_C2C_TEST_TASK_PRIORITY U_AT_CLIENT_URC_TASK_PRIORITY
 #endif
 
+#ifndef U_CELL_SEC_C2C_TEST_THROUGHPUT_ITERATIONS
+/** The number of maximum-length chunks to pass through the
+ * intercept functions when measuring throughput.
+ */
+# define U_CELL_SEC_C2C_TEST_THROUGHPUT_ITERATIONS 1000
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -1290,6 +1297,7 @@ U_PORT_TEST_FUNCTION("[cellSecC2c]", "cellSecC2cIntercept")
             memcpy(gContext.hmacKey, pTestData->pHmacTag,
                    sizeof(gContext.hmacKey));
         }
+        uCellSecC2cContextPrepare(&gContext);
         gContext.pTx->txInLength = 0;
         gContext.pTx->txInLimit = pTestData->chunkLengthMax;
 
@@ -1356,6 +1364,97 @@ U_PORT_TEST_FUNCTION("[cellSecC2c]", "cellSecC2cIntercept")
 #endif
 }
 
+/** Measure the throughput of the intercept functions: maximum-length
+ * chunks are encrypted with the transmit intercept function and
+ * then decrypted with the receive intercept function, for both V1
+ * and V2.
+ */
+U_PORT_TEST_FUNCTION("[cellSecC2c]", "cellSecC2cThroughput")
+{
+    const char *pData;
+    const char *pOut;
+    char *pIn;
+    size_t clearLength = U_CELL_SEC_C2C_USER_MAX_TX_LENGTH_BYTES -
+                         U_CELL_SEC_C2C_MAX_PAD_LENGTH_BYTES;
+    size_t length;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    int32_t heapUsed;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+
+    // As in cellSecC2cIntercept, make a call to one of
+    // the crypto functions to get any one-off allocations
+    // out of the way
+    uPortCryptoSha256(NULL, 0, gBufferA);
+
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    for (size_t x = 0; x < clearLength; x++) {
+        gBufferA[x] = (char) x;
+    }
+
+    gContext.pTx = &gContextTx;
+    gContext.pRx = &gContextRx;
+    memcpy(gContext.teSecret, U_CELL_SEC_C2C_TEST_TE_SECRET,
+           sizeof(gContext.teSecret));
+    memcpy(gContext.key, U_CELL_SEC_C2C_TEST_KEY, sizeof(gContext.key));
+    memcpy(gContext.hmacKey, U_CELL_SEC_C2C_TEST_HMAC_TAG,
+           sizeof(gContext.hmacKey));
+    uCellSecC2cContextPrepare(&gContext);
+    gContext.pTx->txInLimit = U_CELL_SEC_C2C_USER_MAX_TX_LENGTH_BYTES;
+
+    for (size_t v = 0; v < 2; v++) {
+        gContext.isV2 = (v > 0);
+        gContext.pTx->txInLength = 0;
+        startTimeMs = (int32_t) uPortGetTickTimeMs();
+        for (size_t x = 0; x < U_CELL_SEC_C2C_TEST_THROUGHPUT_ITERATIONS; x++) {
+            // Encrypt a chunk, flushing it out
+            pData = gBufferA;
+            length = clearLength;
+            pOut = pUCellSecC2cInterceptTx(0, &pData, &length, &gContext);
+            U_PORT_TEST_ASSERT(length == 0);
+            pOut = pUCellSecC2cInterceptTx(0, NULL, &length, &gContext);
+            U_PORT_TEST_ASSERT((pOut != NULL) && (length > clearLength));
+            // Copy it to the receive buffer, as the AT client
+            // would have received it, and decrypt it
+            memcpy(gBufferB, pOut, length);
+            pIn = gBufferB;
+            pIn = pUCellSecC2cInterceptRx(0, &pIn, &length, &gContext);
+            U_PORT_TEST_ASSERT(pIn != NULL);
+            U_PORT_TEST_ASSERT(length == clearLength);
+        }
+        durationMs = ((int32_t) uPortGetTickTimeMs()) - startTimeMs;
+        U_PORT_TEST_ASSERT(memcmp(pIn, gBufferA, clearLength) == 0);
+        U_TEST_PRINT_LINE("V%d: %d chunk(s) of %d byte(s) encrypted and"
+                          " decrypted in %d ms.", v + 1,
+                          U_CELL_SEC_C2C_TEST_THROUGHPUT_ITERATIONS,
+                          clearLength, durationMs);
+        if (durationMs > 0) {
+            U_TEST_PRINT_LINE("V%d: throughput %d byte(s)/second.", v + 1,
+                              (int32_t) ((((int64_t) clearLength) *
+                                          U_CELL_SEC_C2C_TEST_THROUGHPUT_ITERATIONS *
+                                          1000) / durationMs));
+        }
+    }
+
+    uPortDeinit();
+
+#ifndef __XTENSA__
+    // Check for memory leaks; see cellSecC2cIntercept
+    // for why this is not done on ESP32
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+#else
+    (void) heapUsed;
+#endif
+}
+
 #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B >= 0)
 
 /** Test use of the intercept functions inside the AT client
@@ -1484,6 +1583,7 @@ U_PORT_TEST_FUNCTION("[cellSecC2c]", "cellSecC2cAtClient")
             memcpy(gContext.hmacKey, pTestAt->pHmacTag,
                    sizeof(gContext.hmacKey));
         }
+        uCellSecC2cContextPrepare(&gContext);
         gContext.pTx->txInLimit = pTestAt->chunkLengthMax;
 
         // Copy this into the AT server-side chip to chip
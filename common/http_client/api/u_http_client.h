@@ -65,6 +65,24 @@ extern "C" {
 # define U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES (64 + 1)
 #endif
 
+#ifndef U_HTTP_CLIENT_DOWNLOAD_RANGES_MAX_NUM
+/** The maximum number of ranges that uHttpClientDownload() will
+ * divide a download into; if the range size passed to
+ * uHttpClientDownload() would result in more ranges than this then
+ * the range size is increased to fit.  This determines the size of
+ * #uHttpClientDownloadState_t.
+ */
+# define U_HTTP_CLIENT_DOWNLOAD_RANGES_MAX_NUM 256
+#endif
+
+#ifndef U_HTTP_CLIENT_DOWNLOAD_FAILURES_MAX_NUM
+/** The number of consecutive failed range requests after which
+ * uHttpClientDownload() will give up and return, leaving the
+ * download to be resumed later.
+ */
+# define U_HTTP_CLIENT_DOWNLOAD_FAILURES_MAX_NUM 5
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -100,6 +118,30 @@ typedef void (uHttpClientResponseCallback_t)(uDeviceHandle_t devHandle,
                                              size_t responseSize,
                                              void *pResponseCallbackParam);
 
+/** Callback that will be called with the body of an HTTP response,
+ * a chunk at a time, when uHttpClientGetRequestStream() is used.
+ *
+ * @param devHandle               the device handle.
+ * @param[in] pData               a pointer to the next chunk of the
+ *                                body; this is valid only for the
+ *                                duration of the callback, the data
+ *                                must be copied out if it is to be kept.
+ * @param size                    the number of bytes at pData.
+ * @param offset                  the offset of pData from the start
+ *                                of the body.
+ * @param[in] pBodyCallbackParam  the pBodyCallbackParam pointer that
+ *                                was passed to uHttpClientGetRequestStream().
+ * @return                        true to carry on receiving the body,
+ *                                false to stop; see
+ *                                uHttpClientGetRequestStream() for what
+ *                                is then reported.
+ */
+typedef bool (uHttpClientBodyCallback_t)(uDeviceHandle_t devHandle,
+                                         const char *pData,
+                                         size_t size,
+                                         size_t offset,
+                                         void *pBodyCallbackParam);
+
 /** HTTP client connection information.  Note that the maximum length
  * of the string fields may differ between modules.
  * NOTE: if this structure is modified be sure to modify
@@ -204,8 +246,51 @@ typedef struct {
     char *pResponse;       /* set when a HTTP POST, GET or HEAD is being carried out. */
     size_t *pResponseSize; /* set when a HTTP POST, GET or HEAD is being carried out. */
     char *pContentType;    /* set when a HTTP POST or GET is being carried out. */
+    uHttpClientBodyCallback_t *pBodyCallback; /* set when a streamed HTTP GET is in progress. */
+    void *pBodyCallbackParam;                 /* set when a streamed HTTP GET is in progress. */
 } uHttpClientContext_t;
 
+/** Sink for the data of a download made with uHttpClientDownload().
+ * Since ranges of the download may be fetched in parallel, and a
+ * range that failed part-way through is fetched again from its start,
+ * the sink MUST accept data in any order and MUST accept data being
+ * written more than once at the same offset; writing to a file or to
+ * flash at the given offset naturally satisfies this.
+ *
+ * @param[in] pData            the data.
+ * @param size                 the number of bytes at pData.
+ * @param offset               the offset of pData from the start of
+ *                             the downloaded file.
+ * @param[in] pSinkParam       the pSinkParam pointer that was passed
+ *                             to uHttpClientDownload().
+ * @return                     true to continue, false to abandon the
+ *                             range being fetched, which will be
+ *                             treated as a failure.
+ */
+typedef bool (uHttpClientDownloadSink_t)(const char *pData, size_t size,
+                                         size_t offset, void *pSinkParam);
+
+/** The progress of a download made with uHttpClientDownload(),
+ * owned by the caller.  Before a new download is started this
+ * structure should be zeroed; if uHttpClientDownload() returns
+ * an error then it may be called again with the same structure to
+ * resume the download, fetching only the ranges that have not yet
+ * been completed.  The structure contains no pointers and so may be
+ * stored in non-volatile memory, along with the data already
+ * written to the sink, to allow a download to be resumed after
+ * a restart.
+ */
+typedef struct {
+    size_t sizeBytes;      /**< the size of the file being downloaded,
+                                zero if not yet known. */
+    size_t rangeSizeBytes; /**< the size of each range. */
+    size_t numRanges;      /**< the number of ranges in the download. */
+    size_t bytesDone;      /**< the number of bytes of the file that
+                                have been written to the sink. */
+    uint8_t rangeDone[(U_HTTP_CLIENT_DOWNLOAD_RANGES_MAX_NUM + 7) / 8]; /**< a
+                                bit-map of the completed ranges. */
+} uHttpClientDownloadState_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -418,6 +503,73 @@ int32_t uHttpClientGetRequest(uHttpClientContext_t *pContext,
                               char *pResponseBody, size_t *pSize,
                               char *pContentType);
 
+/** Make an HTTP GET request, streaming the body of the response to
+ * a callback rather than into a buffer: use this for downloads that
+ * are larger than you would wish to buffer.  The body is delivered to
+ * pBodyCallback in chunks, in order, starting as soon as the headers
+ * of the response have been parsed; the body is never held in memory
+ * as a whole.  Otherwise the behaviour is as uHttpClientGetRequest():
+ * if this is a blocking call (i.e. pResponseCallback in the pConnection
+ * structure passed to pUHttpClientOpen() was NULL) this function will
+ * return when the whole body has been delivered, else pResponseCallback
+ * will be called when the whole body has been delivered, with
+ * responseSize set to the number of bytes of body delivered.  Note that
+ * pBodyCallback is called from the context of the underlying HTTP
+ * implementation, it should not block for long and should not call
+ * back into this API.
+ *
+ * If pBodyCallback returns false no more of the body is delivered and
+ * the request completes as normal: the HTTP status code is reported
+ * and responseSize is the number of bytes of body delivered, including
+ * those of the chunk for which pBodyCallback returned false.  If the
+ * body cannot be read in full then, since the body already delivered
+ * would otherwise look complete, a negative error code is reported in
+ * place of the HTTP status code, #U_ERROR_COMMON_TRUNCATED if the body
+ * ended early, and responseSize is again the number of bytes of body
+ * delivered before the failure.
+ *
+ * Only one HTTP request, of any kind, may be outstanding at a time.
+ *
+ * IMPORTANT: see warning below about the validity of the pContentType
+ * pointer.
+ *
+ * Chunked or multi-part content is not handled here: should you wish to
+ * handle such content you will need to do the re-assembly yourself.
+ *
+ * This is currently only supported for cellular.
+ *
+ * @param[in] pContext               a pointer to the internal HTTP context
+ *                                   structure that was originally returned by
+ *                                   pUHttpClientOpen().
+ * @param[in] pPath                  the null-terminated path on the HTTP server
+ *                                   to GET the data from, for example
+ *                                   "/thing/download/1.html"; cannot be NULL.
+ * @param[in] pBodyCallback          the callback that will be given the body
+ *                                   of the response; cannot be NULL.
+ * @param[in] pBodyCallbackParam     a parameter that will be passed to
+ *                                   pBodyCallback; may be NULL.
+ * @param[out] pContentType          a place to put the content type of the response,
+ *                                   for example "application/text", may be NULL.
+ *                                   In the non-blocking case this storage MUST REMAIN
+ *                                   VALID until pResponseCallback is called.  Will
+ *                                   always be null-terminated.  AT LEAST
+ *                                   #U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES of storage
+ *                                   must be provided.
+ * @return                           in the blocking case the HTTP status code or
+ *                                   negative error code, which will be negative
+ *                                   if the body could not be read in full; in the
+ *                                   non-blocking case zero or negative error code.
+ *                                   If #U_ERROR_COMMON_UNKNOWN is reported then the
+ *                                   module has indicated that the HTTP request
+ *                                   has not worked; in this case it may be worth
+ *                                   re-trying.
+ */
+int32_t uHttpClientGetRequestStream(uHttpClientContext_t *pContext,
+                                    const char *pPath,
+                                    uHttpClientBodyCallback_t *pBodyCallback,
+                                    void *pBodyCallbackParam,
+                                    char *pContentType);
+
 /** Make a request for an HTTP header.  If this is a blocking call (i.e.
  * pResponseCallback in the pConnection structure passed to pUHttpClientOpen()
  * was NULL) and a pKeepGoingCallback() was provided in pConnection then
@@ -480,6 +632,74 @@ int32_t uHttpClientHeadRequest(uHttpClientContext_t *pContext,
 int32_t uHttpClientDeleteRequest(uHttpClientContext_t *pContext,
                                  const char *pPath);
 
+/** Download a file from an HTTP server using HTTP Range requests,
+ * writing it to a sink, potentially fetching several ranges in
+ * parallel.  The download is divided into ranges of rangeSizeBytes
+ * and each is fetched with an HTTP GET request carrying a "Range"
+ * header; a range that fails is fetched again, up to
+ * #U_HTTP_CLIENT_DOWNLOAD_FAILURES_MAX_NUM consecutive failures.
+ * Progress is recorded in pState so that, should this function return
+ * an error, it can be called again with the same pState to resume the
+ * download from where it left off rather than starting from zero.
+ *
+ * A HEAD request is first made to find the size of the file and
+ * whether the server supports ranges; if the size of the file is no
+ * longer that recorded in a non-zeroed pState then the file is
+ * assumed to have changed and the download starts again.  If the
+ * server does not support ranges the file is fetched as a single
+ * range using the first context only.
+ *
+ * One range may be in flight on each of the contexts passed in,
+ * each of which must have been opened with pUHttpClientOpen() to the
+ * same server, e.g. using different HTTP profiles of the same module.
+ * While this function is running it takes over the response callback
+ * of each context, restoring them on return, and hence none of the
+ * contexts may be used for anything else until it returns; it always
+ * blocks.  If a pKeepGoingCallback() was provided in the pConnection
+ * structure passed to pUHttpClientOpen() for the first context then
+ * it will be called while this function is waiting and, should it
+ * return false, this function will return when the ranges in flight
+ * have completed.  Should a request not be answered within twice the
+ * timeout of its context this function will return
+ * #U_ERROR_COMMON_TIMEOUT without waiting for it; that context is
+ * then handed back only when the answer finally arrives and, until
+ * then, a request made on it will wait as if the context were busy.
+ *
+ * This is currently only supported for cellular and only for modules
+ * that support custom HTTP request headers.
+ *
+ * @param[in] ppContext       an array of numContexts pointers to
+ *                            HTTP context structures, as returned by
+ *                            pUHttpClientOpen(); cannot be NULL.
+ * @param numContexts         the number of entries in ppContext, the
+ *                            maximum number of ranges that will be in
+ *                            flight at any one time; must be at least 1.
+ * @param[in] pPath           the null-terminated path on the HTTP server
+ *                            to download, for example "/thing/fw.bin";
+ *                            cannot be NULL.
+ * @param rangeSizeBytes      the size of each range; cannot be zero,
+ *                            will be increased if the file would
+ *                            otherwise be divided into more than
+ *                            #U_HTTP_CLIENT_DOWNLOAD_RANGES_MAX_NUM ranges
+ *                            and is ignored when a download is resumed.
+ * @param[in] pSink           the sink for the data; cannot be NULL.
+ * @param[in] pSinkParam      a parameter that will be passed to pSink;
+ *                            may be NULL.
+ * @param[in,out] pState      the progress of the download, see
+ *                            #uHttpClientDownloadState_t; cannot be NULL.
+ * @return                    zero when the whole file has been written
+ *                            to the sink, else negative error code, in
+ *                            which case the download may be resumed
+ *                            by calling this function again with the
+ *                            same pState.
+ */
+int32_t uHttpClientDownload(uHttpClientContext_t **ppContext,
+                            size_t numContexts, const char *pPath,
+                            size_t rangeSizeBytes,
+                            uHttpClientDownloadSink_t *pSink,
+                            void *pSinkParam,
+                            uHttpClientDownloadState_t *pState);
+
 #ifdef __cplusplus
 }
 #endif
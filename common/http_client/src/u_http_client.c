@@ -49,7 +49,7 @@
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
 #include "stdio.h"     // snprintf()
-#include "string.h"    // strstr()/memcmp()/strncpy()/strlen()/strtol()
+#include "string.h"    // strstr()/memcmp()/strncpy()/strncmp()/strlen()/strtol()
 
 #include "u_cfg_sw.h"
 
@@ -123,6 +123,23 @@
  */
 #define U_HTTP_CLIENT_CELL_FILE_READ_HEADERS_LENGTH 1024
 
+#ifndef U_HTTP_CLIENT_CELL_FILE_STREAM_CHUNK_LENGTH
+/** The length of the blocks in which the body of a response is read
+ * from the response file and passed to the body callback when
+ * uHttpClientGetRequestStream() is used in the cellular case; this
+ * is the only buffer used while streaming.  Larger blocks mean fewer
+ * AT command round trips and hence a faster download, subject to the
+ * same caveats as #U_HTTP_CLIENT_CELL_FILE_CHUNK_LENGTH.  Must be
+ * at least #U_HTTP_CLIENT_CELL_FILE_READ_HEADERS_LENGTH since the
+ * first block must contain the headers.
+ */
+# define U_HTTP_CLIENT_CELL_FILE_STREAM_CHUNK_LENGTH 2048
+#endif
+
+#if U_HTTP_CLIENT_CELL_FILE_STREAM_CHUNK_LENGTH < U_HTTP_CLIENT_CELL_FILE_READ_HEADERS_LENGTH
+# error U_HTTP_CLIENT_CELL_FILE_STREAM_CHUNK_LENGTH is smaller than the headers length
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -133,6 +150,44 @@ typedef struct {
     int32_t httpHandle;
 } uHttpClientContextCell_t;
 
+struct uHttpClientDownloadShared_t;
+
+/** Structure to keep track of one context being used by
+ * uHttpClientDownload(), including the settings of the context
+ * which uHttpClientDownload() has to override while it is running.
+ */
+typedef struct {
+    struct uHttpClientDownloadShared_t *pShared;
+    uHttpClientContext_t *pContext;
+    uHttpClientResponseCallback_t *pResponseCallbackSaved;
+    void *pResponseCallbackParamSaved;
+    bool errorOnBusySaved;
+    uHttpClientDownloadSink_t *pSink;
+    void *pSinkParam;
+    bool busy;
+    bool isHead;
+    bool timedOut;
+    bool orphaned; /* uHttpClientDownload() returned while in flight. */
+    int32_t startTimeMs;
+    size_t rangeIndex;
+    size_t rangeStart;
+    size_t rangeLength;
+    size_t received;
+    volatile int32_t statusCodeOrError; /* zero while a request is in flight. */
+} uHttpClientDownloadSlot_t;
+
+/** The memory used by uHttpClientDownload(); a request that is
+ * still in flight when uHttpClientDownload() returns keeps this
+ * alive and the last such request to complete frees it.
+ */
+typedef struct uHttpClientDownloadShared_t {
+    uPortMutexHandle_t mutex; /* protects the orphaned flags and numOrphans. */
+    size_t numOrphans;
+    uHttpClientDownloadSlot_t *pSlots;
+    char headers[U_HTTP_CLIENT_CELL_FILE_READ_HEADERS_LENGTH + 1]; /* +1 for terminator. */
+    size_t headersSize;
+} uHttpClientDownloadShared_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -195,6 +250,44 @@ static int32_t cellFileResponseReadStatusCode(uDeviceHandle_t cellHandle,
     return errorOrStatusCode;
 }
 
+// Find the content type in a null-terminated buffer of HTTP headers,
+// headersLength long, and copy it, null-terminated, to pContentType.
+static void contentTypeFromHeaders(const char *pHeaders, size_t headersLength,
+                                   char *pContentType)
+{
+    const char *pTmp;
+    const char *pEnd;
+    size_t sizeContentType;
+
+    *pContentType = 0;
+    // Find the content type in the headers
+    pTmp = strstr(pHeaders, "Content-Type:");
+    if (pTmp != NULL) {
+        pTmp += 13; // For "Content-Type:"
+        // Need to turn this into a string of max length
+        // U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES - 1
+        // First, remove any initial spaces
+        while (*pTmp == ' ') {
+            pTmp++;
+        }
+        // Assuming the end of the content-type text is the end
+        // of the headers, then work out the size
+        sizeContentType = headersLength - (pTmp - pHeaders);
+        // See if there is actually a line-end on the content-type
+        pEnd = strstr(pTmp, "\r\n");
+        if (pEnd != NULL) {
+            sizeContentType = pEnd - pTmp;
+        }
+        // Populate pContentType
+        if (sizeContentType > U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES - 1) {
+            sizeContentType = U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES - 1;
+        }
+        memcpy(pContentType, pTmp, sizeContentType);
+        // Add a terminator
+        *(pContentType + sizeContentType) = 0;
+    }
+}
+
 // Read the header from the response file, starting at offset,
 // and deriving the content type on the way if required.
 static int32_t cellFileResponseReadHead(uDeviceHandle_t cellHandle,
@@ -209,8 +302,6 @@ static int32_t cellFileResponseReadHead(uDeviceHandle_t cellHandle,
     size_t size = responseHeaderSize;
     bool malloced = false;
     char *pTmp;
-    char *pEnd;
-    size_t sizeContentType;
 
     if (pBuffer == NULL) {
         size = U_HTTP_CLIENT_CELL_FILE_READ_HEADERS_LENGTH;
@@ -232,43 +323,127 @@ static int32_t cellFileResponseReadHead(uDeviceHandle_t cellHandle,
                 errorCodeOrSize = pTmp - pBuffer;
             }
             if (pContentType != NULL) {
-                *pContentType = 0;
-                // Find the content type in the headers
-                pTmp = strstr(pBuffer, "Content-Type:");
+                contentTypeFromHeaders(pBuffer, errorCodeOrSize, pContentType);
+            }
+        }
+
+        if (malloced) {
+            // Free memory
+            uPortFree(pBuffer);
+        }
+    }
+
+    return errorCodeOrSize;
+}
+
+// Read the response file, starting at offset (i.e. at the headers),
+// and pass the body to the body callback of pContext in blocks of
+// U_HTTP_CLIENT_CELL_FILE_STREAM_CHUNK_LENGTH, deriving the content
+// type on the way if required.  The first block read includes the
+// headers and whatever of the body follows them, so that delivery of
+// the body begins with the same read that finds the end of the headers.
+// The number of bytes of body delivered is returned in *pBodySize,
+// whatever the outcome.  Returns zero if the whole body was delivered
+// or the body callback asked to stop, else negative error code: in
+// particular, if reading the file fails part way through the body the
+// error from the read is returned or, if a read comes back empty
+// before the end of the file, U_ERROR_COMMON_TRUNCATED.
+static int32_t cellFileResponseStreamBody(uDeviceHandle_t cellHandle,
+                                          const char *pFileNameResponse,
+                                          size_t offset,
+                                          uHttpClientContext_t *pContext,
+                                          size_t *pBodySize)
+{
+    int32_t errorCode;
+    char *pBuffer;
+    char *pTmp;
+    int32_t fileSize;
+    int32_t readSize;
+    size_t headersLength;
+    size_t bodyLength;
+    size_t thisSize;
+    size_t bodyOffset = 0;
+    bool keepGoing = true;
+
+    *pBodySize = 0;
+    // Need the size of the file to know where the body ends
+    errorCode = uCellFileSize(cellHandle, pFileNameResponse);
+    fileSize = errorCode;
+    if ((errorCode >= 0) && ((size_t) fileSize > offset)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        // +1 to add a terminator
+        pBuffer = (char *) pUPortMalloc(U_HTTP_CLIENT_CELL_FILE_STREAM_CHUNK_LENGTH + 1);
+        if (pBuffer != NULL) {
+            thisSize = (size_t) fileSize - offset;
+            if (thisSize > U_HTTP_CLIENT_CELL_FILE_STREAM_CHUNK_LENGTH) {
+                thisSize = U_HTTP_CLIENT_CELL_FILE_STREAM_CHUNK_LENGTH;
+            }
+            readSize = uCellFileBlockRead(cellHandle, pFileNameResponse, pBuffer, offset,
+                                          thisSize);
+            errorCode = readSize;
+            if (readSize >= 0) {
+                errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                // Need to be able to treat the headers as a string
+                *(pBuffer + readSize) = 0;
+                // Find the end of the headers region, which is marked by
+                // a blank line
+                pTmp = strstr(pBuffer, "\r\n\r\n");
                 if (pTmp != NULL) {
-                    pTmp += 13; // For "Content-Type:"
-                    // Need to turn this into a string of max length
-                    // U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES - 1
-                    // First, remove any initial spaces
-                    while (*pTmp == ' ') {
-                        pTmp++;
-                    }
-                    // Assuming the end of the content-type text is the end
-                    // of the headers, then work out the size
-                    sizeContentType = errorCodeOrSize - (pTmp - pBuffer);
-                    // See if there is actually a line-end on the content-type
-                    pEnd = strstr(pTmp, "\r\n");
-                    if (pEnd != NULL) {
-                        sizeContentType = pEnd - pTmp;
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    headersLength = pTmp - pBuffer;
+                    if (pContext->pContentType != NULL) {
+                        // Terminate the headers so that the body is not searched
+                        *pTmp = 0;
+                        contentTypeFromHeaders(pBuffer, headersLength, pContext->pContentType);
                     }
-                    // Populate pContentType
-                    if (sizeContentType > U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES - 1) {
-                        sizeContentType = U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES - 1;
+                    headersLength += 4; // +4 for "\r\n\r\n"
+                    offset += headersLength;
+                    bodyLength = (size_t) fileSize - offset;
+                    pTmp = pBuffer + headersLength;
+                    thisSize = readSize - headersLength;
+                    // Hand over the body, re-using the same buffer for each
+                    // block, until it is all done or the callback has had
+                    // enough
+                    while ((errorCode == 0) && keepGoing && (bodyOffset < bodyLength)) {
+                        if (thisSize == 0) {
+                            thisSize = bodyLength - bodyOffset;
+                            if (thisSize > U_HTTP_CLIENT_CELL_FILE_STREAM_CHUNK_LENGTH) {
+                                thisSize = U_HTTP_CLIENT_CELL_FILE_STREAM_CHUNK_LENGTH;
+                            }
+                            readSize = uCellFileBlockRead(cellHandle, pFileNameResponse,
+                                                          pBuffer, offset + bodyOffset,
+                                                          thisSize);
+                            thisSize = 0;
+                            if (readSize > 0) {
+                                thisSize = (size_t) readSize;
+                                pTmp = pBuffer;
+                            } else if (readSize < 0) {
+                                errorCode = readSize;
+                            } else {
+                                errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
+                            }
+                        }
+                        if (thisSize > 0) {
+                            keepGoing = pContext->pBodyCallback(pContext->devHandle, pTmp,
+                                                                thisSize, bodyOffset,
+                                                                pContext->pBodyCallbackParam);
+                            bodyOffset += thisSize;
+                            thisSize = 0;
+                        }
                     }
-                    memcpy(pContentType, pTmp, sizeContentType);
-                    // Add a terminator
-                    *(pContentType + sizeContentType) = 0;
+                    *pBodySize = bodyOffset;
                 }
             }
-        }
 
-        if (malloced) {
             // Free memory
             uPortFree(pBuffer);
         }
+    } else if (errorCode >= 0) {
+        // Not even the headers are there
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
     }
 
-    return errorCodeOrSize;
+    return errorCode;
 }
 
 // Callback for HTTP responses in the cellular case.
@@ -284,6 +459,8 @@ static void cellCallback(uDeviceHandle_t cellHandle, int32_t httpHandle,
     int32_t responseSize = 0;
     int32_t thisSize = 0;
     int32_t totalSize = 0;
+    size_t bodySize = 0;
+    int32_t errorCode;
 
     (void) httpHandle;
 
@@ -301,7 +478,22 @@ static void cellCallback(uDeviceHandle_t cellHandle, int32_t httpHandle,
                                                                &offset);
             if (statusCodeOrError >= 0) {
                 // Read data from the response file, where required
-                if ((pContext->pResponse != NULL) &&
+                if ((requestType == U_CELL_HTTP_REQUEST_GET) &&
+                    (pContext->pBodyCallback != NULL)) {
+                    // Streaming: hand the body to the body callback; unlike
+                    // the buffered case below, a failure to read the body
+                    // is reported in place of the HTTP status code since
+                    // the caller has no other way to tell that the body
+                    // they were given is incomplete
+                    errorCode = cellFileResponseStreamBody(cellHandle,
+                                                           pFileNameResponse,
+                                                           offset, pContext,
+                                                           &bodySize);
+                    responseSize = (int32_t) bodySize;
+                    if (errorCode < 0) {
+                        statusCodeOrError = errorCode;
+                    }
+                } else if ((pContext->pResponse != NULL) &&
                     (pContext->pResponseSize != NULL) &&
                     (*pContext->pResponseSize > 0)) {
                     switch (requestType) {
@@ -368,6 +560,11 @@ static void cellCallback(uDeviceHandle_t cellHandle, int32_t httpHandle,
             uCellHttpGetLastErrorCode(cellHandle, httpHandle);
         }
 
+        // A body callback is for this request only, don't let
+        // it leak into the next one in the non-blocking case
+        pContext->pBodyCallback = NULL;
+        pContext->pBodyCallbackParam = NULL;
+
         // Call the callback, if required
         if (pContext->pResponseCallback != NULL) {
             pContext->pResponseCallback(cellHandle,
@@ -550,6 +747,8 @@ static void clearLastRequest(uHttpClientContext_t *pContext)
     pContext->pResponse = NULL;
     pContext->pResponseSize = NULL;
     pContext->pContentType = NULL;
+    pContext->pBodyCallback = NULL;
+    pContext->pBodyCallbackParam = NULL;
     pContext->lastRequestTimeMs = -1;
     pContext->statusCodeOrError = 0;
     uPortSemaphoreGive((uPortSemaphoreHandle_t) pContext->semaphoreHandle);
@@ -652,6 +851,281 @@ static int32_t block(volatile uHttpClientContext_t *pContext)
     return errorCode;
 }
 
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: DOWNLOAD
+ * -------------------------------------------------------------- */
+
+// Free the memory used by uHttpClientDownload().
+static void downloadSharedFree(uHttpClientDownloadShared_t *pShared)
+{
+    uPortMutexDelete(pShared->mutex);
+    uPortFree(pShared->pSlots);
+    uPortFree(pShared);
+}
+
+// Put the context of pSlot back as it was before uHttpClientDownload()
+// took it over.
+static void downloadSlotRestore(uHttpClientDownloadSlot_t *pSlot)
+{
+    uHttpClientContext_t *pContext = pSlot->pContext;
+
+    uCellHttpSetRequestHeader(pContext->devHandle,
+                              ((uHttpClientContextCell_t *) pContext->pPriv)->httpHandle,
+                              0, NULL, NULL);
+    pContext->pResponseCallback = pSlot->pResponseCallbackSaved;
+    pContext->pResponseCallbackParam = pSlot->pResponseCallbackParamSaved;
+    pContext->errorOnBusy = pSlot->errorOnBusySaved;
+}
+
+// Wait up to waitMs for the request in flight on the context of pSlot
+// to complete, using the semaphore that the context holds while a
+// request is outstanding; returns true if it has completed.
+static bool downloadWait(const uHttpClientDownloadSlot_t *pSlot, int32_t waitMs)
+{
+    uPortSemaphoreHandle_t semaphoreHandle;
+
+    semaphoreHandle = (uPortSemaphoreHandle_t) pSlot->pContext->semaphoreHandle;
+    if ((pSlot->statusCodeOrError == 0) &&
+        (uPortSemaphoreTryTake(semaphoreHandle, waitMs) == 0)) {
+        // Not ours to keep: the next request will take it
+        uPortSemaphoreGive(semaphoreHandle);
+        if (pSlot->statusCodeOrError == 0) {
+            // The context gave up waiting for an earlier request
+            // and so is not holding the semaphore for this one:
+            // don't spin on it
+            uPortTaskBlock(waitMs);
+        }
+    }
+
+    return (pSlot->statusCodeOrError != 0);
+}
+
+// Response callback for the requests made by uHttpClientDownload();
+// if uHttpClientDownload() has already given up on the request then
+// this is where the context is handed back and, for the last such
+// request, where the memory of uHttpClientDownload() is freed.
+static void downloadResponseCallback(uDeviceHandle_t devHandle,
+                                     int32_t statusCodeOrError,
+                                     size_t responseSize,
+                                     void *pResponseCallbackParam)
+{
+    uHttpClientDownloadSlot_t *pSlot = (uHttpClientDownloadSlot_t *) pResponseCallbackParam;
+    uHttpClientDownloadShared_t *pShared = pSlot->pShared;
+    bool freeShared = false;
+
+    (void) devHandle;
+    (void) responseSize;
+
+    if (statusCodeOrError == 0) {
+        // Zero is used to mean "in flight"
+        statusCodeOrError = (int32_t) U_ERROR_COMMON_UNKNOWN;
+    }
+    U_PORT_MUTEX_LOCK(pShared->mutex);
+    if (pSlot->orphaned) {
+        pSlot->orphaned = false;
+        downloadSlotRestore(pSlot);
+        pShared->numOrphans--;
+        freeShared = (pShared->numOrphans == 0);
+    } else {
+        pSlot->statusCodeOrError = statusCodeOrError;
+    }
+    U_PORT_MUTEX_UNLOCK(pShared->mutex);
+
+    if (freeShared) {
+        downloadSharedFree(pShared);
+    }
+}
+
+// Body callback for the range requests made by uHttpClientDownload():
+// clips the data to the range and hands it to the sink at its offset
+// within the file.
+static bool downloadBodyCallback(uDeviceHandle_t devHandle,
+                                 const char *pData, size_t size,
+                                 size_t offset, void *pBodyCallbackParam)
+{
+    uHttpClientDownloadSlot_t *pSlot = (uHttpClientDownloadSlot_t *) pBodyCallbackParam;
+    bool keepGoing = false;
+
+    (void) devHandle;
+
+    // Locked so that uHttpClientDownload() cannot return, and the
+    // sink go away, while it is being written to
+    U_PORT_MUTEX_LOCK(pSlot->pShared->mutex);
+    if (!pSlot->orphaned && (offset < pSlot->rangeLength)) {
+        if (size > pSlot->rangeLength - offset) {
+            size = pSlot->rangeLength - offset;
+        }
+        keepGoing = pSlot->pSink(pData, size, pSlot->rangeStart + offset,
+                                 pSlot->pSinkParam);
+        if (keepGoing) {
+            pSlot->received = offset + size;
+            keepGoing = (pSlot->received < pSlot->rangeLength);
+        }
+    }
+    U_PORT_MUTEX_UNLOCK(pSlot->pShared->mutex);
+
+    return keepGoing;
+}
+
+// Find a header in a null-terminated buffer of HTTP headers and
+// return a pointer to its value, or NULL if it is not there.
+static const char *pDownloadHeaderValue(const char *pHeaders, const char *pName)
+{
+    const char *pValue = strstr(pHeaders, pName);
+
+    if (pValue != NULL) {
+        pValue += strlen(pName);
+        while (*pValue == ' ') {
+            pValue++;
+        }
+    }
+
+    return pValue;
+}
+
+// Make a HEAD request on the context of pSlot, which must already
+// be set up for uHttpClientDownload(), and wait for the answer;
+// on success the size of the file is returned in pSizeBytes and
+// whether the server accepts range requests in pRangesOk.  On
+// timeout the request is left busy on pSlot: the answer will land
+// in the shared headers buffer, which outlives it.
+static int32_t downloadHead(uHttpClientDownloadSlot_t *pSlot, const char *pPath,
+                            size_t *pSizeBytes, bool *pRangesOk)
+{
+    int32_t errorCode;
+    uHttpClientContext_t *pContext = pSlot->pContext;
+    uHttpClientDownloadShared_t *pShared = pSlot->pShared;
+    const char *pValue;
+
+    pSlot->statusCodeOrError = 0;
+    pShared->headersSize = sizeof(pShared->headers) - 1;
+    errorCode = uHttpClientHeadRequest(pContext, pPath, pShared->headers,
+                                       &(pShared->headersSize));
+    if (errorCode == 0) {
+        pSlot->busy = true;
+        pSlot->isHead = true;
+        pSlot->startTimeMs = uPortGetTickTimeMs();
+        // Wait for the answer, which will fill in headersSize
+        while (!downloadWait(pSlot, 100) &&
+               (uPortGetTickTimeMs() - pSlot->startTimeMs <
+                (pContext->timeoutSeconds * 2) * 1000)) {
+            // Just waiting
+        }
+        errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        if (pSlot->statusCodeOrError != 0) {
+            pSlot->busy = false;
+            errorCode = pSlot->statusCodeOrError;
+            if (errorCode == 200) {
+                errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                pShared->headers[pShared->headersSize] = 0;
+                pValue = pDownloadHeaderValue(pShared->headers, "Content-Length:");
+                if (pValue != NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    *pSizeBytes = (size_t) strtol(pValue, NULL, 10);
+                    pValue = pDownloadHeaderValue(pShared->headers, "Accept-Ranges:");
+                    *pRangesOk = (pValue != NULL) && (strncmp(pValue, "bytes", 5) == 0);
+                }
+            } else if (errorCode > 0) {
+                // Some other HTTP status code
+                errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+            }
+        } else {
+            pSlot->timedOut = true;
+        }
+    }
+
+    return errorCode;
+}
+
+// Start the GET request for a range on the context of pSlot.
+static int32_t downloadRangeStart(uHttpClientDownloadSlot_t *pSlot,
+                                  const char *pPath,
+                                  const uHttpClientDownloadState_t *pState,
+                                  size_t rangeIndex)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    uHttpClientContext_t *pContext = pSlot->pContext;
+    // Room for "bytes=" and two 32-bit decimal numbers
+    char buffer[32];
+
+    pSlot->rangeIndex = rangeIndex;
+    pSlot->rangeStart = rangeIndex * pState->rangeSizeBytes;
+    pSlot->rangeLength = pState->sizeBytes - pSlot->rangeStart;
+    if (pSlot->rangeLength > pState->rangeSizeBytes) {
+        pSlot->rangeLength = pState->rangeSizeBytes;
+    }
+    pSlot->received = 0;
+    pSlot->isHead = false;
+    pSlot->statusCodeOrError = 0;
+    if (pState->numRanges > 1) {
+        snprintf(buffer, sizeof(buffer), "bytes=%u-%u",
+                 (unsigned int) pSlot->rangeStart,
+                 (unsigned int) (pSlot->rangeStart + pSlot->rangeLength - 1));
+        errorCode = uCellHttpSetRequestHeader(pContext->devHandle,
+                                              ((uHttpClientContextCell_t *) pContext->pPriv)->httpHandle,
+                                              0, "Range", buffer);
+    }
+    if (errorCode == 0) {
+        errorCode = uHttpClientGetRequestStream(pContext, pPath, downloadBodyCallback,
+                                                (void *) pSlot, NULL);
+    }
+    if (errorCode == 0) {
+        pSlot->busy = true;
+        pSlot->startTimeMs = uPortGetTickTimeMs();
+    }
+
+    return errorCode;
+}
+
+// Return the index of the next range after *pNextRange that is
+// neither done nor in flight, wrapping around so that failed ranges
+// are picked up again, or pState->numRanges if there is none.
+static size_t downloadNextRange(const uHttpClientDownloadSlot_t *pSlots,
+                                size_t numSlots,
+                                const uHttpClientDownloadState_t *pState,
+                                size_t *pNextRange)
+{
+    size_t rangeIndex = pState->numRanges;
+    size_t candidate;
+    bool inFlight;
+
+    for (size_t x = 0; (x < pState->numRanges) && (rangeIndex == pState->numRanges); x++) {
+        candidate = (*pNextRange + x) % pState->numRanges;
+        if ((pState->rangeDone[candidate >> 3] & (1U << (candidate & 7))) == 0) {
+            inFlight = false;
+            for (size_t y = 0; y < numSlots; y++) {
+                if (pSlots[y].busy && (pSlots[y].rangeIndex == candidate)) {
+                    inFlight = true;
+                }
+            }
+            if (!inFlight) {
+                rangeIndex = candidate;
+                *pNextRange = candidate + 1;
+            }
+        }
+    }
+
+    return rangeIndex;
+}
+
+// Set up pState for a new download; if ranges are not possible the
+// whole file is a single range.
+static void downloadStateInit(uHttpClientDownloadState_t *pState, size_t sizeBytes,
+                              size_t rangeSizeBytes, bool rangesOk)
+{
+    memset(pState, 0, sizeof(*pState));
+    pState->sizeBytes = sizeBytes;
+    if (!rangesOk && (sizeBytes > 0)) {
+        rangeSizeBytes = sizeBytes;
+    }
+    if (sizeBytes > rangeSizeBytes * U_HTTP_CLIENT_DOWNLOAD_RANGES_MAX_NUM) {
+        rangeSizeBytes = (sizeBytes + U_HTTP_CLIENT_DOWNLOAD_RANGES_MAX_NUM - 1) /
+                         U_HTTP_CLIENT_DOWNLOAD_RANGES_MAX_NUM;
+    }
+    pState->rangeSizeBytes = rangeSizeBytes;
+    pState->numRanges = (sizeBytes + rangeSizeBytes - 1) / rangeSizeBytes;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -912,6 +1386,50 @@ int32_t uHttpClientGetRequest(uHttpClientContext_t *pContext,
     return errorCode;
 }
 
+// Make an HTTP GET request, streaming the body to a callback.
+int32_t uHttpClientGetRequestStream(uHttpClientContext_t *pContext,
+                                    const char *pPath,
+                                    uHttpClientBodyCallback_t *pBodyCallback,
+                                    void *pBodyCallbackParam,
+                                    char *pContentType)
+{
+    int32_t errorCode;
+
+    U_HTTP_CLIENT_REQUEST_ENTRY_FUNCTION(pContext, &errorCode, false);
+
+    if (errorCode == 0) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pPath != NULL) && (pBodyCallback != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
+                pContext->pBodyCallback = pBodyCallback;
+                pContext->pBodyCallbackParam = pBodyCallbackParam;
+                pContext->pContentType = pContentType;
+                errorCode = uCellHttpRequest(pContext->devHandle,
+                                             ((uHttpClientContextCell_t *) pContext->pPriv)->httpHandle,
+                                             U_CELL_HTTP_REQUEST_GET, pPath,
+                                             NULL, NULL, NULL);
+                if (errorCode != 0) {
+                    // Make sure to forget the user's pointers on error
+                    pContext->pBodyCallback = NULL;
+                    pContext->pBodyCallbackParam = NULL;
+                    pContext->pContentType = NULL;
+                }
+            } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_SHORT_RANGE)) {
+                // Not supported for Shortrange
+            }
+            if (errorCode == 0) {
+                // Handle blocking
+                errorCode = block((volatile uHttpClientContext_t *) pContext);
+            }
+        }
+    }
+
+    U_HTTP_CLIENT_REQUEST_EXIT_FUNCTION(pContext, errorCode);
+
+    return errorCode;
+}
+
 // Make an HTTP HEAD request.
 int32_t uHttpClientHeadRequest(uHttpClientContext_t *pContext,
                                const char *pPath,
@@ -988,4 +1506,198 @@ int32_t uHttpClientDeleteRequest(uHttpClientContext_t *pContext,
     return errorCode;
 }
 
+// Download a file using range requests, resumably.
+int32_t uHttpClientDownload(uHttpClientContext_t **ppContext,
+                            size_t numContexts, const char *pPath,
+                            size_t rangeSizeBytes,
+                            uHttpClientDownloadSink_t *pSink,
+                            void *pSinkParam,
+                            uHttpClientDownloadState_t *pState)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uHttpClientDownloadShared_t *pShared = NULL;
+    uHttpClientDownloadSlot_t *pSlots = NULL;
+    uHttpClientDownloadSlot_t *pSlot;
+    uHttpClientDownloadSlot_t *pOldest;
+    uHttpClientContext_t *pContext;
+    size_t sizeBytes = 0;
+    bool rangesOk = false;
+    size_t numSlots = numContexts;
+    size_t numFailures = 0;
+    size_t nextRange = 0;
+    bool stop = false;
+    bool done;
+    size_t x;
+    size_t y;
+
+    if ((ppContext != NULL) && (numContexts > 0) && (pPath != NULL) &&
+        (rangeSizeBytes > 0) && (pSink != NULL) && (pState != NULL) &&
+        (pState->numRanges <= U_HTTP_CLIENT_DOWNLOAD_RANGES_MAX_NUM)) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        for (x = 0; (x < numContexts) && (errorCode == 0); x++) {
+            if (ppContext[x] == NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+            } else if (!U_DEVICE_IS_TYPE(ppContext[x]->devHandle, U_DEVICE_TYPE_CELL)) {
+                // Short-range modules do not support custom request headers
+                errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            }
+        }
+        if (errorCode == 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pShared = (uHttpClientDownloadShared_t *) pUPortMalloc(sizeof(*pShared));
+            pSlots = (uHttpClientDownloadSlot_t *) pUPortMalloc(numContexts * sizeof(*pSlots));
+            if ((pShared == NULL) || (pSlots == NULL) ||
+                (uPortMutexCreate(&(pShared->mutex)) != 0)) {
+                uPortFree(pShared);
+                uPortFree(pSlots);
+                pSlots = NULL;
+            }
+        }
+    }
+
+    if (pSlots != NULL) {
+        // Take over the response callback of each context so that
+        // requests on all of them can be in flight at once
+        pShared->numOrphans = 0;
+        pShared->pSlots = pSlots;
+        memset(pSlots, 0, numContexts * sizeof(*pSlots));
+        for (x = 0; x < numContexts; x++) {
+            pSlot = &(pSlots[x]);
+            pContext = ppContext[x];
+            U_HTTP_CLIENT_REQUEST_ENTRY_FUNCTION(pContext, NULL, true);
+            pSlot->pShared = pShared;
+            pSlot->pContext = pContext;
+            pSlot->pResponseCallbackSaved = pContext->pResponseCallback;
+            pSlot->pResponseCallbackParamSaved = pContext->pResponseCallbackParam;
+            pSlot->errorOnBusySaved = pContext->errorOnBusy;
+            pContext->pResponseCallback = downloadResponseCallback;
+            pContext->pResponseCallbackParam = (void *) pSlot;
+            pContext->errorOnBusy = false;
+            pSlot->pSink = pSink;
+            pSlot->pSinkParam = pSinkParam;
+            clearLastRequest(pContext);
+            U_HTTP_CLIENT_REQUEST_EXIT_FUNCTION(pContext, -1);
+        }
+
+        // Find out how big the file is and whether ranges are possible
+        errorCode = downloadHead(&(pSlots[0]), pPath, &sizeBytes, &rangesOk);
+        if (errorCode == 0) {
+            if ((pState->sizeBytes != sizeBytes) || (pState->numRanges == 0) ||
+                (!rangesOk && (pState->numRanges > 1))) {
+                // A new download, or the file has changed, start again
+                downloadStateInit(pState, sizeBytes, rangeSizeBytes, rangesOk);
+            }
+            if (!rangesOk) {
+                numSlots = 1;
+            }
+        } else {
+            stop = true;
+        }
+
+        // Keep a range in flight on each slot until all ranges are
+        // done or we have to stop, then wait for those in flight;
+        // a slot that has timed out is never re-used since its
+        // request may yet complete
+        done = false;
+        while (!done) {
+            for (x = 0; x < numSlots; x++) {
+                pSlot = &(pSlots[x]);
+                if (pSlot->busy && (pSlot->statusCodeOrError != 0)) {
+                    pSlot->busy = false;
+                    if (!pSlot->isHead) {
+                        // A range request has completed, see if it worked
+                        y = pSlot->rangeIndex;
+                        if (((pSlot->statusCodeOrError == 206) ||
+                             ((pSlot->statusCodeOrError == 200) && (pState->numRanges == 1))) &&
+                            (pSlot->received == pSlot->rangeLength)) {
+                            if ((pState->rangeDone[y >> 3] & (1U << (y & 7))) == 0) {
+                                pState->rangeDone[y >> 3] |= (uint8_t) (1U << (y & 7));
+                                pState->bytesDone += pSlot->rangeLength;
+                            }
+                            numFailures = 0;
+                        } else {
+                            numFailures++;
+                            errorCode = pSlot->statusCodeOrError;
+                            if (errorCode > 0) {
+                                // An HTTP status code we didn't want
+                                errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+                            }
+                        }
+                    }
+                } else if (pSlot->busy && !pSlot->timedOut &&
+                           (uPortGetTickTimeMs() - pSlot->startTimeMs >
+                            (pSlot->pContext->timeoutSeconds * 2) * 1000)) {
+                    // No answer: stop, leaving the request in flight
+                    pSlot->timedOut = true;
+                    errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+                    stop = true;
+                }
+            }
+            if ((numFailures > U_HTTP_CLIENT_DOWNLOAD_FAILURES_MAX_NUM) ||
+                ((pSlots[0].pContext->pKeepGoingCallback != NULL) &&
+                 !pSlots[0].pContext->pKeepGoingCallback())) {
+                if (errorCode == 0) {
+                    errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+                }
+                stop = true;
+            }
+            pOldest = NULL;
+            for (x = 0; x < numSlots; x++) {
+                pSlot = &(pSlots[x]);
+                if (!pSlot->busy && !pSlot->timedOut && !stop) {
+                    y = downloadNextRange(pSlots, numSlots, pState, &nextRange);
+                    if (y < pState->numRanges) {
+                        errorCode = downloadRangeStart(pSlot, pPath, pState, y);
+                        if (errorCode != 0) {
+                            numFailures++;
+                        }
+                    }
+                }
+                if (pSlot->busy && !pSlot->timedOut &&
+                    ((pOldest == NULL) || (pSlot->startTimeMs - pOldest->startTimeMs < 0))) {
+                    pOldest = pSlot;
+                }
+            }
+            // Done once there is nothing in flight that has not
+            // timed out and either everything has been fetched or
+            // we have to stop
+            done = (pOldest == NULL) && (stop || (pState->bytesDone == pState->sizeBytes));
+            if (pOldest != NULL) {
+                // Wait for the request most likely to complete next,
+                // not for too long so that a keep-going callback and
+                // timeouts on the other slots are still checked
+                downloadWait(pOldest, 100);
+            } else if (!done) {
+                // Nothing could be started: back off before retrying
+                uPortTaskBlock(100);
+            }
+        }
+
+        // Put everything back as it was, except for a context with a
+        // request still in flight: that is handed back, and the memory
+        // freed, by downloadResponseCallback() when the request completes
+        U_PORT_MUTEX_LOCK(pShared->mutex);
+        for (x = 0; x < numContexts; x++) {
+            pSlot = &(pSlots[x]);
+            if (pSlot->busy && (pSlot->statusCodeOrError == 0)) {
+                pSlot->orphaned = true;
+                pShared->numOrphans++;
+            } else {
+                downloadSlotRestore(pSlot);
+            }
+        }
+        done = (pShared->numOrphans == 0);
+        U_PORT_MUTEX_UNLOCK(pShared->mutex);
+        if (done) {
+            downloadSharedFree(pShared);
+        }
+
+        if (!stop && (pState->bytesDone == pState->sizeBytes)) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
 // End of file
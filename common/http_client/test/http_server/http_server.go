@@ -20,11 +20,14 @@
  *
  * HEAD, PUT, POST, GET and DELETE requests are accepted; PUT simply writes
  * the file, POST writes the body to file and also returns the body of the
- * file in the response, GET retrieves the file, DELETE deletes
+ * file in the response, GET retrieves the file (or a range of it),
+ * HEAD retrieves just the headers GET would return, DELETE deletes
  * the file or the file is automatically deleted some time (default 60
  * seconds) after it was written.  File size is limited (default 10 kbytes)
  * and a 1 second delay to responses is applied if more than 1000 files
- * are currently present.
+ * are currently present.  To allow the resumption of downloads to be
+ * tested, every third GET request with a "Range" header for a path
+ * containing "_drop_" has its connection dropped without a response.
  */
 
 package main
@@ -43,6 +46,8 @@ import (
     "container/list"
     "path/filepath"
     "sort"
+    "strings"
+    "sync/atomic"
     "net"
     "net/http"
 )
@@ -70,6 +75,13 @@ const RESPONSE_LIMIT_DELAY = 1 * time.Second
 // The number of files that must be present for RESPONSE_LIMIT_DELAY to kick in.
 const RESPONSE_LIMIT_THRESHOLD_FILES = 1000
 
+// Paths containing this have every DROP_EVERY_N_RANGE_REQUESTS'th
+// range request dropped.
+const DROP_PATH_MARKER = "_drop_"
+
+// How often a range request on a DROP_PATH_MARKER path is dropped.
+const DROP_EVERY_N_RANGE_REQUESTS = 3
+
 // Just so we don't suffer from mistyping...
 const PARAMETERS_KEY = "parameters"
 
@@ -84,6 +96,7 @@ type Parameters struct {
     pathList *list.List
     listMutex sync.Mutex
     pResponseDelay *time.Duration
+    pNumRangeRequests *int64
 }
 
 // Struct to store a path with creation time so that we can delete it later.
@@ -103,9 +116,21 @@ func handler(response http.ResponseWriter, request *http.Request) {
     fmt.Printf("Received HTTP request type \"%s\", path \"%s\".\n", request.Method, request.URL.String())
     path := filepath.Join(parameters.dataDir, request.URL.String())
     switch request.Method {
-        case "HEAD":
-            // Nothing to do
         case "GET":
+            if request.Header.Get("Range") != "" && strings.Contains(path, DROP_PATH_MARKER) &&
+               atomic.AddInt64(parameters.pNumRangeRequests, 1) % DROP_EVERY_N_RANGE_REQUESTS == 0 {
+                if hijacker, ok := response.(http.Hijacker); ok {
+                    if connection, _, err := hijacker.Hijack(); err == nil {
+                        fmt.Printf("Dropping connection for range \"%s\" of file \"%s\".\n",
+                                   request.Header.Get("Range"), path)
+                        connection.Close()
+                        return
+                    }
+                }
+            }
+            fallthrough
+        case "HEAD":
+            // ServeFile() handles HEAD and range requests itself
             fmt.Printf("Attempting to serve file \"%s\".\n", path)
             http.ServeFile(response, request, path)
         case "DELETE":
@@ -218,6 +243,7 @@ func main() {
     var keepGoing = true
     var deleteDelay time.Duration
     var responseDelay time.Duration
+    var numRangeRequests int64
 
     // Catch exit signal so that we can clean up
     finished := make(chan os.Signal, 1)
@@ -239,6 +265,7 @@ func main() {
     if parameters.dataDir, err = filepath.Abs(*pDataDir); err == nil {
         responseDelay = 0;
         parameters.pResponseDelay = &responseDelay
+        parameters.pNumRangeRequests = &numRangeRequests
         parameters.pathList = list.New()
         // Create a context we can pass to the HTTP request handler
         ctx := context.WithValue(context.Background(), PARAMETERS_KEY, parameters)
@@ -155,6 +155,26 @@
 # define HTTP_CLIENT_TEST_OVERALL_TRIES_COUNT 30
 #endif
 
+#ifndef U_HTTP_CLIENT_TEST_DOWNLOAD_RANGE_SIZE_BYTES
+/** The range size to use when testing uHttpClientDownload().
+ */
+# define U_HTTP_CLIENT_TEST_DOWNLOAD_RANGE_SIZE_BYTES 1024
+#endif
+
+#ifndef U_HTTP_CLIENT_TEST_DOWNLOAD_NUM_CONTEXTS
+/** The number of HTTP contexts to use, i.e. the number of ranges
+ * in flight at any one time, when testing uHttpClientDownload().
+ */
+# define U_HTTP_CLIENT_TEST_DOWNLOAD_NUM_CONTEXTS 2
+#endif
+
+#ifndef U_HTTP_CLIENT_TEST_DOWNLOAD_MAX_CALLS
+/** The maximum number of times to call uHttpClientDownload() to
+ * get a download to complete.
+ */
+# define U_HTTP_CLIENT_TEST_DOWNLOAD_MAX_CALLS 5
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -165,6 +185,7 @@
 typedef enum {
     U_HTTP_CLIENT_TEST_OPERATION_PUT,
     U_HTTP_CLIENT_TEST_OPERATION_GET_PUT,
+    U_HTTP_CLIENT_TEST_OPERATION_GET_PUT_STREAM,
     U_HTTP_CLIENT_TEST_OPERATION_DELETE_PUT,
     U_HTTP_CLIENT_TEST_OPERATION_GET_DELETED,
     U_HTTP_CLIENT_TEST_OPERATION_POST,
@@ -287,6 +308,43 @@ static void httpCallback(uDeviceHandle_t devHandle,
     }
 }
 
+// Callback for the body of a streamed GET: copies the body into
+// gpDataBufferIn and keeps track of the amount received.
+static bool httpBodyCallback(uDeviceHandle_t devHandle,
+                             const char *pData, size_t size,
+                             size_t offset, void *pBodyCallbackParam)
+{
+    size_t *pSizeReceived = (size_t *) pBodyCallbackParam;
+
+    (void) devHandle;
+
+    if (offset + size <= U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES) {
+        memcpy(gpDataBufferIn + offset, pData, size);
+    }
+    if (pSizeReceived != NULL) {
+        *pSizeReceived = offset + size;
+    }
+
+    return true;
+}
+
+// Sink for uHttpClientDownload(): copies the data into
+// gpDataBufferIn at its offset and counts the bytes written.
+static bool httpDownloadSink(const char *pData, size_t size,
+                             size_t offset, void *pSinkParam)
+{
+    size_t *pBytesWritten = (size_t *) pSinkParam;
+    bool success = false;
+
+    if (offset + size <= U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES) {
+        memcpy(gpDataBufferIn + offset, pData, size);
+        *pBytesWritten += size;
+        success = true;
+    }
+
+    return success;
+}
+
 // Fill a buffer with binary 0 to 255.
 static void bufferFill(char *pBuffer, size_t size)
 {
@@ -427,6 +485,7 @@ static int32_t checkResponse(uHttpClientTestOperation_t operation,
         }
         if (outcome == (int32_t) U_ERROR_COMMON_SUCCESS) {
             if (((operation == U_HTTP_CLIENT_TEST_OPERATION_GET_PUT) ||
+                 (operation == U_HTTP_CLIENT_TEST_OPERATION_GET_PUT_STREAM) ||
                  (operation == U_HTTP_CLIENT_TEST_OPERATION_POST) ||
                  (operation == U_HTTP_CLIENT_TEST_OPERATION_GET_POST)) &&
                 (expectedResponseSize >= 0)) {
@@ -621,7 +680,8 @@ U_PORT_TEST_FUNCTION("[httpClient]", "httpClient")
                 U_PORT_TEST_ASSERT(uHttpClientOpenResetLastError() == 0);
 
                 // Create a path
-                snprintf(pathBuffer, sizeof(pathBuffer), "/%.16s_%d_%d.html", serialNumber, x, y);
+                snprintf(pathBuffer, sizeof(pathBuffer), "/%.16s_%d_%d.html", serialNumber,
+                         (int32_t) x, (int32_t) y);
 
                 // For every request operation...
                 busyCount = 0;
@@ -655,6 +715,18 @@ U_PORT_TEST_FUNCTION("[httpClient]", "httpClient")
                                                                           &gSizeDataBufferIn,
                                                                           gpContentTypeBuffer);
                                 break;
+                            case U_HTTP_CLIENT_TEST_OPERATION_GET_PUT_STREAM:
+                                // GET the file again, this time streaming the body
+                                memset(gpDataBufferIn, 0xFF, uHttpClientTestDataSizeBytes);
+                                memset(gpContentTypeBuffer, 0xFF, U_HTTP_CLIENT_CONTENT_TYPE_LENGTH_BYTES);
+                                gSizeDataBufferIn = 0;
+                                U_TEST_PRINT_LINE("streamed GET of %s...", pathBuffer);
+                                errorOrStatusCode = uHttpClientGetRequestStream(gpHttpContext[y],
+                                                                                pathBuffer,
+                                                                                httpBodyCallback,
+                                                                                &gSizeDataBufferIn,
+                                                                                gpContentTypeBuffer);
+                                break;
                             case U_HTTP_CLIENT_TEST_OPERATION_DELETE_PUT:
                                 // DELETE it
                                 U_TEST_PRINT_LINE("DELETE %s...", pathBuffer);
@@ -794,6 +866,147 @@ U_PORT_TEST_FUNCTION("[httpClient]", "httpClient")
     uNetworkTestListFree();
 }
 
+/** Test a resumable, ranged, download with ranges in parallel on
+ * more than one HTTP context, against a path for which the test
+ * HTTP server drops some of the connections.  Only cellular
+ * supports this.
+ */
+U_PORT_TEST_FUNCTION("[httpClient]", "httpClientDownload")
+{
+    uNetworkTestList_t *pList;
+    uDeviceHandle_t devHandle;
+    uHttpClientConnection_t connection = U_HTTP_CLIENT_CONNECTION_DEFAULT;
+    uHttpClientDownloadState_t state;
+    int32_t heapUsed;
+    char urlBuffer[64];
+    char serialNumber[U_SECURITY_SERIAL_NUMBER_MAX_LENGTH_BYTES];
+    char pathBuffer[32];
+    size_t bytesWritten = 0;
+    int32_t errorOrStatusCode = 0;
+    size_t tries;
+
+    // In case a previous test failed
+    uNetworkTestCleanUp();
+
+    // Do the standard preamble
+    pList = pStdPreamble();
+
+    // Get storage for what we're going to PUT and download
+    gpDataBufferOut = (char *) pUPortMalloc(U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(gpDataBufferOut != NULL);
+    gpDataBufferIn = (char *) pUPortMalloc(U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(gpDataBufferIn != NULL);
+
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        devHandle = *pTmp->pDevHandle;
+        if (uDeviceGetDeviceType(devHandle) != (int32_t) U_DEVICE_TYPE_CELL) {
+            continue;
+        }
+        // Get the initial-ish heap
+        heapUsed = uPortGetHeapFree();
+
+        U_PORT_TEST_ASSERT(uSecurityGetSerialNumber(devHandle, serialNumber) > 0);
+        snprintf(urlBuffer, sizeof(urlBuffer), "%s:%d",
+                 U_HTTP_CLIENT_TEST_SERVER_DOMAIN_NAME,
+                 (int) U_HTTP_CLIENT_TEST_SERVER_PORT);
+        connection.pServerName = urlBuffer;
+        // The "_drop_" in the path makes the test HTTP server drop
+        // some of the connections for range requests
+        snprintf(pathBuffer, sizeof(pathBuffer), "/%.16s_drop_.bin", serialNumber);
+
+        // Open the HTTP contexts, all blocking
+        for (size_t x = 0; x < U_HTTP_CLIENT_TEST_DOWNLOAD_NUM_CONTEXTS; x++) {
+            U_TEST_PRINT_LINE("opening HTTP client %d on %s.", x + 1, urlBuffer);
+            gpHttpContext[x] = pUHttpClientOpen(devHandle, &connection, NULL);
+            U_PORT_TEST_ASSERT(gpHttpContext[x] != NULL);
+        }
+
+        // PUT the file that we are going to download
+        bufferFill(gpDataBufferOut, U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES);
+        tries = 0;
+        do {
+            U_TEST_PRINT_LINE("PUT %d byte(s) to %s...",
+                              U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES, pathBuffer);
+            errorOrStatusCode = uHttpClientPutRequest(gpHttpContext[0], pathBuffer,
+                                                      gpDataBufferOut,
+                                                      U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES,
+                                                      U_HTTP_CLIENT_TEST_CONTENT_TYPE);
+            U_TEST_PRINT_LINE("Result %d.", errorOrStatusCode);
+            tries++;
+        } while ((errorOrStatusCode != 200) && (tries < HTTP_CLIENT_TEST_MAX_TRIES_UNKNOWN));
+        U_PORT_TEST_ASSERT(errorOrStatusCode == 200);
+
+        // Download it in ranges, resuming as necessary: since the test
+        // HTTP server drops every third range request the download
+        // can only complete if failed ranges are fetched again
+        memset(gpDataBufferIn, 0xFF, U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES);
+        memset(&state, 0, sizeof(state));
+        tries = 0;
+        do {
+            U_TEST_PRINT_LINE("download of %s, %d ranges in parallel...", pathBuffer,
+                              U_HTTP_CLIENT_TEST_DOWNLOAD_NUM_CONTEXTS);
+            errorOrStatusCode = uHttpClientDownload(gpHttpContext,
+                                                    U_HTTP_CLIENT_TEST_DOWNLOAD_NUM_CONTEXTS,
+                                                    pathBuffer,
+                                                    U_HTTP_CLIENT_TEST_DOWNLOAD_RANGE_SIZE_BYTES,
+                                                    httpDownloadSink, &bytesWritten, &state);
+            U_TEST_PRINT_LINE("Result %d, %d of %d byte(s) done in %d range(s).",
+                              errorOrStatusCode, state.bytesDone, state.sizeBytes,
+                              state.numRanges);
+            tries++;
+        } while ((errorOrStatusCode != 0) && (tries < U_HTTP_CLIENT_TEST_DOWNLOAD_MAX_CALLS));
+        U_PORT_TEST_ASSERT(errorOrStatusCode == 0);
+        U_PORT_TEST_ASSERT(state.sizeBytes == U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES);
+        U_PORT_TEST_ASSERT(state.bytesDone == U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES);
+        // Ranges may have been written more than once
+        U_PORT_TEST_ASSERT(bytesWritten >= U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES);
+        U_PORT_TEST_ASSERT(bufferCheck(gpDataBufferIn, U_HTTP_CLIENT_TEST_DATA_SIZE_BYTES) == 0);
+
+        // Calling it again with the completed state should do nothing
+        bytesWritten = 0;
+        U_PORT_TEST_ASSERT(uHttpClientDownload(gpHttpContext,
+                                               U_HTTP_CLIENT_TEST_DOWNLOAD_NUM_CONTEXTS,
+                                               pathBuffer,
+                                               U_HTTP_CLIENT_TEST_DOWNLOAD_RANGE_SIZE_BYTES,
+                                               httpDownloadSink, &bytesWritten, &state) == 0);
+        U_PORT_TEST_ASSERT(bytesWritten == 0);
+
+        // Tidy up
+        U_TEST_PRINT_LINE("DELETE %s...", pathBuffer);
+        uHttpClientDeleteRequest(gpHttpContext[0], pathBuffer);
+        for (size_t x = 0; x < U_HTTP_CLIENT_TEST_DOWNLOAD_NUM_CONTEXTS; x++) {
+            uHttpClientClose(gpHttpContext[x]);
+            gpHttpContext[x] = NULL;
+        }
+
+        // Check for memory leaks
+        heapUsed -= uPortGetHeapFree();
+        U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+        U_PORT_TEST_ASSERT(heapUsed <= 0);
+    }
+
+    // Free memory
+    uPortFree(gpDataBufferOut);
+    gpDataBufferOut = NULL;
+    uPortFree(gpDataBufferIn);
+    gpDataBufferIn = NULL;
+
+    // Close the devices once more and free the list
+    for (uNetworkTestList_t *pTmp = pList; pTmp != NULL; pTmp = pTmp->pNext) {
+        if (*pTmp->pDevHandle != NULL) {
+            U_TEST_PRINT_LINE("taking down %s...",
+                              gpUNetworkTestTypeName[pTmp->networkType]);
+            U_PORT_TEST_ASSERT(uNetworkInterfaceDown(*pTmp->pDevHandle,
+                                                     pTmp->networkType) == 0);
+            U_TEST_PRINT_LINE("closing device %s...",
+                              gpUNetworkTestDeviceTypeName[pTmp->pDeviceCfg->deviceType]);
+            U_PORT_TEST_ASSERT(uDeviceClose(*pTmp->pDevHandle, false) == 0);
+            *pTmp->pDevHandle = NULL;
+        }
+    }
+    uNetworkTestListFree();
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
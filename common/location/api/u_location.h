@@ -512,6 +512,102 @@ int32_t uLocationGetStatus(uDeviceHandle_t devHandle);
  */
 void uLocationGetStop(uDeviceHandle_t devHandle);
 
+/** Get a recent location without going to the hardware.  The
+ * location API keeps the last fix of each type from each device,
+ * whether it came from uLocationGet(), uLocationGetStart(),
+ * uLocationGetContinuousStart() or uLocationGetRaceStart(); this
+ * function returns that fix, immediately, if it is no older than
+ * maxAgeMs and has a radius of position no larger than
+ * maxRadiusMillimetres.  If the cached fix does not meet the
+ * policy then call uLocationGet() (or one of the non-blocking
+ * variants) as usual: the new fix will replace the old one.
+ * A continuous session is a cheap way to keep the cache fresh.
+ *
+ * @param devHandle            the device handle to use.
+ * @param type                 the type of location fix wanted; for
+ *                             a GNSS device this is ignored, as for
+ *                             uLocationGet().
+ * @param maxAgeMs             the oldest fix that will do, in
+ *                             milliseconds; -1 for any age.
+ * @param maxRadiusMillimetres the largest radius of position that
+ *                             will do; -1 for any radius, including
+ *                             an unknown one.
+ * @param pLocation            a place to put the fix; cannot be NULL.
+ * @return                     zero on success, #U_ERROR_COMMON_NOT_FOUND
+ *                             if there is no cached fix that meets the
+ *                             policy, else negative error code.
+ */
+int32_t uLocationGetCached(uDeviceHandle_t devHandle, uLocationType_t type,
+                           int32_t maxAgeMs, int32_t maxRadiusMillimetres,
+                           uLocation_t *pLocation);
+
+/** Empty the location cache, e.g. before closing a device so that
+ * its handle can't later pick up a stale fix; the cache is also
+ * emptied when the location API is de-initialised.
+ *
+ * @param devHandle the device whose fixes are to be forgotten, NULL
+ *                  to forget the fixes of all devices.
+ */
+void uLocationCacheClear(uDeviceHandle_t devHandle);
+
+/** Get the current location by racing Cell Locate against GNSS,
+ * non-blocking version.  Both methods are started at the same time
+ * through the same machinery as uLocationGetStart() and pCallback
+ * is called with the first fix that arrives; should a later fix
+ * have a smaller radius of position it is passed to pCallback
+ * also.  The race is over, and any method still running is
+ * cancelled, as soon as a fix meets desiredAccuracyMillimetres
+ * in pLocationAssist (any fix will do if that is -1) or when all
+ * of the methods have reported.  If no method obtained a fix,
+ * pCallback is called once, with the error code of the last
+ * method to fail and a NULL location.
+ *
+ * Either of cellDevHandle or gnssDevHandle may be NULL, in which
+ * case the race has a single runner.  gnssDevHandle may be a
+ * GNSS device or a cellular device with a GNSS chip inside or
+ * connected via it; in the latter case, if it is the same device
+ * as cellDevHandle, you should set disableGnss in pLocationAssist
+ * so that Cell Locate does not claim the GNSS chip.  Cloud Locate
+ * does not take part since it is not supported by
+ * uLocationGetStart().
+ *
+ * Only one race may be in progress at a time and
+ * uLocationGetRaceStop() MUST be called once the race is over,
+ * or to abandon it, before another race can be started; a race
+ * that has not been stopped is stopped by uDeviceDeinit().
+ *
+ * @param cellDevHandle           the handle of the cellular device
+ *                                to use for Cell Locate; may be NULL.
+ * @param gnssDevHandle           the handle of the device to use
+ *                                for GNSS; may be NULL.
+ * @param pLocationAssist         additional information for the location
+ *                                establishment process, as for
+ *                                uLocationGetStart(); may be NULL.
+ * @param pAuthenticationTokenStr the null-terminated authentication token
+ *                                for Cell Locate.
+ * @param pCallback               the callback, with the same form and
+ *                                rules as for uLocationGetStart(); it
+ *                                must not call uLocationGetRaceStop().
+ *                                Cannot be NULL.
+ * @return                        zero on success or negative error code on
+ *                                failure; U_ERROR_COMMON_BUSY is returned
+ *                                if a race has not yet been stopped.
+ */
+int32_t uLocationGetRaceStart(uDeviceHandle_t cellDevHandle,
+                              uDeviceHandle_t gnssDevHandle,
+                              const uLocationAssist_t *pLocationAssist,
+                              const char *pAuthenticationTokenStr,
+                              void (*pCallback) (uDeviceHandle_t devHandle,
+                                                 int32_t errorCode,
+                                                 const uLocation_t *pLocation));
+
+/** Stop a uLocationGetRaceStart(), cancelling any method that is
+ * still running and freeing the resources of the race; this must
+ * be called when a race is over, even if it finished of its own
+ * accord, and must not be called from the race callback.
+ */
+void uLocationGetRaceStop();
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,6 +32,9 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_os_platform_specific.h"  // For U_CFG_OS_APP_TASK_PRIORITY
 
 #include "u_error_common.h"
 
@@ -39,6 +42,7 @@
 
 #include "u_port_heap.h"
 #include "u_port_os.h"
+#include "u_port_event_queue.h"
 
 #include "u_cell_loc.h"
 
@@ -63,14 +67,62 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_LOCATION_RACE_TASK_STACK_SIZE_BYTES
+/** The stack size for the task in which the losers of a
+ * uLocationGetRaceStart() are cancelled; shouldn't need much.
+ */
+# define U_LOCATION_RACE_TASK_STACK_SIZE_BYTES 2304
+#endif
+
+#ifndef U_LOCATION_RACE_TASK_PRIORITY
+/** The priority of the task in which the losers of a
+ * uLocationGetRaceStart() are cancelled; taking the standard
+ * approach of adopting U_CFG_OS_APP_TASK_PRIORITY.
+ */
+# define U_LOCATION_RACE_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+/** The race event queue depth: there is only ever one
+ * cancellation per race.
+ */
+#define U_LOCATION_RACE_QUEUE_LENGTH 1
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The runners in a race, see uLocationGetRaceStart(); a
+ * NULL handle means that the runner is not taking part.
+ */
+typedef struct {
+    uDeviceHandle_t cellDevHandle;
+    uDeviceHandle_t gnssDevHandle;
+} uLocationRaceRunners_t;
+
+/** Context for a race, see uLocationGetRaceStart().
+ */
+typedef struct {
+    int32_t eventQueueHandle;
+    int32_t desiredAccuracyMillimetres;
+    uLocationRaceRunners_t running;
+    uLocationRaceRunners_t cancelling;
+    bool finished;
+    bool haveFix;
+    uLocation_t fix;
+    int32_t errorCode;
+    void (*pCallback) (uDeviceHandle_t devHandle,
+                       int32_t errorCode,
+                       const uLocation_t *pLocation);
+} uLocationRace_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The race that is in progress, protected by gULocationMutex.
+ */
+static uLocationRace_t *gpLocationRace = NULL;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTION PROTOTYPES
  * -------------------------------------------------------------- */
@@ -156,6 +208,9 @@ static void gnssPosCallback(uDeviceHandle_t devHandle,
                     // Time may be valid even if the error code is non-zero
                     location.timeUtc = timeUtc;
                 }
+                if (errorCode == 0) {
+                    uLocationSharedCacheUpdate(devHandle, &location);
+                }
                 pEntry->pCallback(devHandle, errorCode, &location);
             }
             if (pEntry->desiredRateMs > 0) {
@@ -206,6 +261,7 @@ static void cellLocCallback(uDeviceHandle_t devHandle,
                     location.speedMillimetresPerSecond = speedMillimetresPerSecond;
                     location.svs = svs;
                     location.timeUtc = timeUtc;
+                    uLocationSharedCacheUpdate(devHandle, &location);
                     pEntry->pCallback(devHandle, errorCode, &location);
                 } else {
                     // No point in populating the location for
@@ -315,6 +371,129 @@ int32_t startAsync(uDeviceHandle_t devHandle, int32_t desiredRateMs,
     return errorCode;
 }
 
+// Update the race with the outcome from one of its runners.
+// gULocationMutex should be locked before this is called.
+static void raceUpdate(uDeviceHandle_t devHandle, int32_t errorCode,
+                       const uLocation_t *pLocation, bool isCell)
+{
+    uLocationRace_t *pRace = gpLocationRace;
+    uLocationRaceRunners_t losers;
+    int32_t radiusMillimetres;
+
+    if ((pRace != NULL) && !pRace->finished) {
+        if (isCell) {
+            pRace->running.cellDevHandle = NULL;
+        } else {
+            pRace->running.gnssDevHandle = NULL;
+        }
+        if ((errorCode == 0) && (pLocation != NULL)) {
+            // Report the first fix and any fix that improves on it,
+            // where a negative radius means that it is unknown
+            radiusMillimetres = pLocation->radiusMillimetres;
+            if (!pRace->haveFix ||
+                ((radiusMillimetres >= 0) &&
+                 ((pRace->fix.radiusMillimetres < 0) ||
+                  (radiusMillimetres < pRace->fix.radiusMillimetres)))) {
+                pRace->fix = *pLocation;
+                pRace->haveFix = true;
+                pRace->pCallback(devHandle, errorCode, &(pRace->fix));
+            }
+        } else {
+            pRace->errorCode = errorCode;
+        }
+        radiusMillimetres = pRace->fix.radiusMillimetres;
+        if ((pRace->haveFix &&
+             ((pRace->desiredAccuracyMillimetres < 0) ||
+              ((radiusMillimetres >= 0) &&
+               (radiusMillimetres <= pRace->desiredAccuracyMillimetres)))) ||
+            ((pRace->running.cellDevHandle == NULL) &&
+             (pRace->running.gnssDevHandle == NULL))) {
+            // The race is over
+            pRace->finished = true;
+            if (!pRace->haveFix) {
+                pRace->pCallback(devHandle, pRace->errorCode, NULL);
+            }
+            losers = pRace->running;
+            if ((losers.cellDevHandle != NULL) || (losers.gnssDevHandle != NULL)) {
+                // Can't stop the losers from here as the stop functions
+                // may wait on callbacks which need gULocationMutex,
+                // hence this is done from the race event queue
+                pRace->cancelling = losers;
+                memset(&(pRace->running), 0, sizeof(pRace->running));
+                uPortEventQueueSend(pRace->eventQueueHandle, &losers, sizeof(losers));
+            }
+        }
+    }
+}
+
+// Callback for the Cell Locate runner in a race.
+static void raceCallbackCell(uDeviceHandle_t devHandle,
+                             int32_t errorCode,
+                             const uLocation_t *pLocation)
+{
+    raceUpdate(devHandle, errorCode, pLocation, true);
+}
+
+// Callback for the GNSS runner in a race.
+static void raceCallbackGnss(uDeviceHandle_t devHandle,
+                             int32_t errorCode,
+                             const uLocation_t *pLocation)
+{
+    raceUpdate(devHandle, errorCode, pLocation, false);
+}
+
+// Stop the given runners of a race.
+// gULocationMutex should NOT be locked before this is called.
+static void raceStopRunners(const uLocationRaceRunners_t *pRunners)
+{
+    if (pRunners->cellDevHandle != NULL) {
+        uCellLocGetStop(pRunners->cellDevHandle);
+    }
+    if (pRunners->gnssDevHandle != NULL) {
+        uGnssPosGetStop(pRunners->gnssDevHandle);
+    }
+
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        // A stopped runner will never call back, so its
+        // request has to be removed from the FIFO here
+        if (pRunners->cellDevHandle != NULL) {
+            uLocationSharedRequestRemove(U_LOCATION_TYPE_CLOUD_CELL_LOCATE,
+                                         raceCallbackCell);
+        }
+        if (pRunners->gnssDevHandle != NULL) {
+            uLocationSharedRequestRemove(U_LOCATION_TYPE_GNSS,
+                                         raceCallbackGnss);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+}
+
+// Event queue handler that cancels the losers of a race.
+static void raceEventHandler(void *pParam, size_t paramLength)
+{
+    uLocationRaceRunners_t *pLosers = (uLocationRaceRunners_t *) pParam;
+
+    (void) paramLength;
+
+    raceStopRunners(pLosers);
+
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        if (gpLocationRace != NULL) {
+            memset(&(gpLocationRace->cancelling), 0,
+                   sizeof(gpLocationRace->cancelling));
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -397,6 +576,7 @@ int32_t uLocationGet(uDeviceHandle_t devHandle, uLocationType_t type,
         } else if (devType == (int32_t) U_DEVICE_TYPE_GNSS) {
             // type, pLocationAssist and pAuthenticationTokenStr are
             // irrelevant in this case, we just ask GNSS
+            location.type = U_LOCATION_TYPE_GNSS;
             errorCode = uGnssPosGet(devHandle,
                                     &(location.latitudeX1e7),
                                     &(location.longitudeX1e7),
@@ -412,6 +592,11 @@ int32_t uLocationGet(uDeviceHandle_t devHandle, uLocationType_t type,
             }
         }
 
+        if (errorCode == 0) {
+            // Keep the fix for uLocationGetCached()
+            uLocationSharedCacheUpdate(devHandle, &location);
+        }
+
         U_PORT_MUTEX_UNLOCK(gULocationMutex);
     }
 
@@ -517,4 +702,180 @@ void uLocationGetStop(uDeviceHandle_t devHandle)
     }
 }
 
+// Get a recent location from the cache.
+int32_t uLocationGetCached(uDeviceHandle_t devHandle, uLocationType_t type,
+                           int32_t maxAgeMs, int32_t maxRadiusMillimetres,
+                           uLocation_t *pLocation)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    if (gULocationMutex != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        if (pLocation != NULL) {
+            if (uDeviceGetDeviceType(devHandle) == (int32_t) U_DEVICE_TYPE_GNSS) {
+                // Only GNSS fixes come from a GNSS device, whatever the type
+                type = U_LOCATION_TYPE_GNSS;
+            }
+            errorCode = uLocationSharedCacheGet(devHandle, type, maxAgeMs,
+                                                maxRadiusMillimetres, pLocation);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+
+    return errorCode;
+}
+
+// Empty the location cache.
+void uLocationCacheClear(uDeviceHandle_t devHandle)
+{
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        uLocationSharedCacheClear(devHandle);
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+}
+
+// Race Cell Locate against GNSS to get the current location.
+int32_t uLocationGetRaceStart(uDeviceHandle_t cellDevHandle,
+                              uDeviceHandle_t gnssDevHandle,
+                              const uLocationAssist_t *pLocationAssist,
+                              const char *pAuthenticationTokenStr,
+                              void (*pCallback) (uDeviceHandle_t devHandle,
+                                                 int32_t errorCode,
+                                                 const uLocation_t *pLocation))
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    int32_t gnssErrorCode;
+    uLocationRace_t *pRace;
+
+    if (gULocationMutex != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        if ((pCallback != NULL) &&
+            ((cellDevHandle != NULL) || (gnssDevHandle != NULL))) {
+            errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+            if (gpLocationRace == NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pRace = (uLocationRace_t *) pUPortMalloc(sizeof(*pRace));
+                if (pRace != NULL) {
+                    memset(pRace, 0, sizeof(*pRace));
+                    pRace->desiredAccuracyMillimetres = -1;
+                    if (pLocationAssist != NULL) {
+                        pRace->desiredAccuracyMillimetres =
+                            pLocationAssist->desiredAccuracyMillimetres;
+                    }
+                    pRace->errorCode = (int32_t) U_ERROR_COMMON_UNKNOWN;
+                    pRace->pCallback = pCallback;
+                    errorCode = uPortEventQueueOpen(raceEventHandler, "locationRace",
+                                                    sizeof(uLocationRaceRunners_t),
+                                                    U_LOCATION_RACE_TASK_STACK_SIZE_BYTES,
+                                                    U_LOCATION_RACE_TASK_PRIORITY,
+                                                    U_LOCATION_RACE_QUEUE_LENGTH);
+                    if (errorCode >= 0) {
+                        pRace->eventQueueHandle = errorCode;
+                        gpLocationRace = pRace;
+                        // No callback can arrive while we hold the
+                        // mutex so the runners can be started in turn
+                        if (cellDevHandle != NULL) {
+                            errorCode = startAsync(cellDevHandle, 0,
+                                                   U_LOCATION_TYPE_CLOUD_CELL_LOCATE,
+                                                   pLocationAssist,
+                                                   pAuthenticationTokenStr,
+                                                   raceCallbackCell);
+                            if (errorCode == 0) {
+                                pRace->running.cellDevHandle = cellDevHandle;
+                            }
+                        }
+                        if (gnssDevHandle != NULL) {
+                            gnssErrorCode = startAsync(gnssDevHandle, 0,
+                                                       U_LOCATION_TYPE_GNSS,
+                                                       pLocationAssist,
+                                                       pAuthenticationTokenStr,
+                                                       raceCallbackGnss);
+                            if (gnssErrorCode == 0) {
+                                pRace->running.gnssDevHandle = gnssDevHandle;
+                            }
+                            if ((cellDevHandle == NULL) || (errorCode != 0)) {
+                                errorCode = gnssErrorCode;
+                            }
+                        }
+                        if ((pRace->running.cellDevHandle == NULL) &&
+                            (pRace->running.gnssDevHandle == NULL)) {
+                            // Nothing could be started, clean up; no events
+                            // can have been sent so closing the event queue
+                            // with the mutex locked is safe
+                            gpLocationRace = NULL;
+                            uPortEventQueueClose(pRace->eventQueueHandle);
+                            uPortFree(pRace);
+                        } else {
+                            // The race is on if either runner is away
+                            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        }
+                    } else {
+                        uPortFree(pRace);
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+    }
+
+    return errorCode;
+}
+
+// Stop a race.
+void uLocationGetRaceStop()
+{
+    uLocationRace_t *pRace = NULL;
+    uLocationRaceRunners_t runners;
+
+    if (gULocationMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gULocationMutex);
+
+        if (gpLocationRace != NULL) {
+            // Make sure that no more callbacks are made
+            gpLocationRace->finished = true;
+            pRace = gpLocationRace;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gULocationMutex);
+
+        if (pRace != NULL) {
+            // Closing the event queue lets any cancellation that
+            // is in progress finish; it must be done without the
+            // mutex locked since the event handler locks it
+            uPortEventQueueClose(pRace->eventQueueHandle);
+
+            U_PORT_MUTEX_LOCK(gULocationMutex);
+
+            // Anything still running, or that the event queue
+            // didn't get around to cancelling, is stopped here
+            runners = pRace->running;
+            if (pRace->cancelling.cellDevHandle != NULL) {
+                runners.cellDevHandle = pRace->cancelling.cellDevHandle;
+            }
+            if (pRace->cancelling.gnssDevHandle != NULL) {
+                runners.gnssDevHandle = pRace->cancelling.gnssDevHandle;
+            }
+            gpLocationRace = NULL;
+
+            U_PORT_MUTEX_UNLOCK(gULocationMutex);
+
+            raceStopRunners(&runners);
+            uPortFree(pRace);
+        }
+    }
+}
+
 // End of file
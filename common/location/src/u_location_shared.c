@@ -36,6 +36,7 @@
 
 #include "u_error_common.h"
 
+#include "u_port.h"
 #include "u_port_heap.h"
 #include "u_port_os.h"
 
@@ -50,11 +51,20 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** An entry in the location cache.
+ */
+typedef struct uLocationSharedCacheEntry_t {
+    uDeviceHandle_t devHandle;
+    uLocation_t location;
+    int32_t timeMs; /**< The tick time at which the fix was stored. */
+    struct uLocationSharedCacheEntry_t *pNext;
+} uLocationSharedCacheEntry_t;
+
 /* ----------------------------------------------------------------
  * SHARED VARIABLES
  * -------------------------------------------------------------- */
 
-/** Mutex to protect the FIFO.
+/** Mutex to protect the FIFO and the location cache.
  */
 uPortMutexHandle_t gULocationMutex = NULL;
 
@@ -70,6 +80,10 @@ static uLocationSharedFifoEntry_t *gpLocationGnssFifo = NULL;
  */
 static uLocationSharedFifoEntry_t *gpLocationCellLocateFifo = NULL;
 
+/** Hook for the location cache, one entry per device and type.
+ */
+static uLocationSharedCacheEntry_t *gpLocationCache = NULL;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -96,6 +110,10 @@ void uLocationSharedDeinit()
     uLocationSharedFifoEntry_t *pEntry;
 
     if (gULocationMutex != NULL) {
+        // A race that was never stopped would otherwise leak
+        // its event queue and leave the next race BUSY; this
+        // locks gULocationMutex itself so must be done first
+        uLocationGetRaceStop();
         // Free anything in any FIFO
         U_PORT_MUTEX_LOCK(gULocationMutex);
         for (int32_t x = (int32_t) U_LOCATION_TYPE_GNSS;
@@ -105,6 +123,7 @@ void uLocationSharedDeinit()
                 uPortFree(pEntry);
             }
         }
+        uLocationSharedCacheClear(NULL);
         U_PORT_MUTEX_UNLOCK(gULocationMutex);
         uPortMutexDelete(gULocationMutex);
         gULocationMutex = NULL;
@@ -206,4 +225,121 @@ uLocationSharedFifoEntry_t *pULocationSharedRequestPop(uLocationType_t type)
     return pSaved;
 }
 
+// Remove all location requests of the given type with the given callback.
+void uLocationSharedRequestRemove(uLocationType_t type,
+                                  void (*pCallback) (uDeviceHandle_t devHandle,
+                                                     int32_t errorCode,
+                                                     const uLocation_t *pLocation))
+{
+    uLocationSharedFifoEntry_t **ppThis = NULL;
+    uLocationSharedFifoEntry_t *pEntry;
+
+    switch (type) {
+        case U_LOCATION_TYPE_GNSS:
+            ppThis = &gpLocationGnssFifo;
+            break;
+        case U_LOCATION_TYPE_CLOUD_CELL_LOCATE:
+            ppThis = &gpLocationCellLocateFifo;
+            break;
+        case U_LOCATION_TYPE_CLOUD_GOOGLE:
+        //lint -fallthrough
+        case U_LOCATION_TYPE_CLOUD_SKYHOOK:
+        //lint -fallthrough
+        case U_LOCATION_TYPE_CLOUD_HERE:
+        //lint -fallthrough
+        case U_LOCATION_TYPE_NONE:
+        //lint -fallthrough
+        default:
+            break;
+    }
+
+    if (ppThis != NULL) {
+        while (*ppThis != NULL) {
+            pEntry = *ppThis;
+            if (pEntry->pCallback == pCallback) {
+                // Unlink the entry and free it
+                *ppThis = pEntry->pNext;
+                uPortFree(pEntry);
+            } else {
+                ppThis = &(pEntry->pNext);
+            }
+        }
+    }
+}
+
+// Store a fix in the location cache.
+void uLocationSharedCacheUpdate(uDeviceHandle_t devHandle,
+                                const uLocation_t *pLocation)
+{
+    uLocationSharedCacheEntry_t *pEntry = gpLocationCache;
+
+    while ((pEntry != NULL) &&
+           ((pEntry->devHandle != devHandle) ||
+            (pEntry->location.type != pLocation->type))) {
+        pEntry = pEntry->pNext;
+    }
+    if (pEntry == NULL) {
+        // Not seen this device/type before, add it at the start
+        pEntry = (uLocationSharedCacheEntry_t *) pUPortMalloc(sizeof(*pEntry));
+        if (pEntry != NULL) {
+            pEntry->devHandle = devHandle;
+            pEntry->pNext = gpLocationCache;
+            gpLocationCache = pEntry;
+        }
+    }
+    if (pEntry != NULL) {
+        pEntry->location = *pLocation;
+        pEntry->timeMs = uPortGetTickTimeMs();
+    }
+}
+
+// Get a fix from the location cache.
+int32_t uLocationSharedCacheGet(uDeviceHandle_t devHandle,
+                                uLocationType_t type,
+                                int32_t maxAgeMs,
+                                int32_t maxRadiusMillimetres,
+                                uLocation_t *pLocation)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+    uLocationSharedCacheEntry_t *pEntry = gpLocationCache;
+    int32_t radiusMillimetres;
+
+    while ((pEntry != NULL) &&
+           ((pEntry->devHandle != devHandle) ||
+            (pEntry->location.type != type))) {
+        pEntry = pEntry->pNext;
+    }
+    if (pEntry != NULL) {
+        // A negative radius means that it is unknown, which
+        // only satisfies a policy that doesn't care
+        radiusMillimetres = pEntry->location.radiusMillimetres;
+        if (((maxAgeMs < 0) ||
+             (uPortGetTickTimeMs() - pEntry->timeMs <= maxAgeMs)) &&
+            ((maxRadiusMillimetres < 0) ||
+             ((radiusMillimetres >= 0) && (radiusMillimetres <= maxRadiusMillimetres)))) {
+            *pLocation = pEntry->location;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Remove fixes from the location cache.
+void uLocationSharedCacheClear(uDeviceHandle_t devHandle)
+{
+    uLocationSharedCacheEntry_t **ppThis = &gpLocationCache;
+    uLocationSharedCacheEntry_t *pEntry;
+
+    while (*ppThis != NULL) {
+        pEntry = *ppThis;
+        if ((devHandle == NULL) || (pEntry->devHandle == devHandle)) {
+            *ppThis = pEntry->pNext;
+            uPortFree(pEntry);
+        } else {
+            ppThis = &(pEntry->pNext);
+        }
+    }
+}
+
 // End of file
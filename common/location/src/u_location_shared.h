@@ -57,7 +57,7 @@ typedef struct uLocationSharedFifoEntry_t {
  * SHARED VARIABLES
  * -------------------------------------------------------------- */
 
-/** Mutex to protect the FIFO.
+/** Mutex to protect the FIFO and the location cache.
  */
 extern uPortMutexHandle_t gULocationMutex;
 
@@ -76,7 +76,8 @@ int32_t uLocationSharedInit();
 
 /** De-initialise the internally shared location API: should
  * be called by the network API when it de-initialises itself.
- * gULocationMutex should NOT be locked before this
+ * Any race that is still in progress is stopped, see
+ * uLocationGetRaceStop().  gULocationMutex should NOT be locked before this
  * is called (since this deletes the mutex).
  */
 void uLocationSharedDeinit();
@@ -111,6 +112,60 @@ int32_t uLocationSharedRequestPush(uDeviceHandle_t devHandle,
  */
 uLocationSharedFifoEntry_t *pULocationSharedRequestPop(uLocationType_t type);
 
+/** Remove, and free, all of the location requests of the given type
+ * that carry the given callback; useful where a request has been
+ * cancelled and so its callback will never be made.
+ * IMPORTANT: gULocationMutex should be locked before this
+ * is called.
+ *
+ * @param type      the request type.
+ * @param pCallback the callback of the requests to remove.
+ */
+void uLocationSharedRequestRemove(uLocationType_t type,
+                                  void (*pCallback) (uDeviceHandle_t devHandle,
+                                                     int32_t errorCode,
+                                                     const uLocation_t *pLocation));
+
+/** Store a fix in the location cache, replacing any earlier
+ * fix of the same type from the same device.
+ * IMPORTANT: gULocationMutex should be locked before this
+ * is called.
+ *
+ * @param devHandle the handle of the device that made the fix.
+ * @param pLocation the fix; pLocation->type is used as the type.
+ */
+void uLocationSharedCacheUpdate(uDeviceHandle_t devHandle,
+                                const uLocation_t *pLocation);
+
+/** Get a fix from the location cache if one meets the given policy.
+ * IMPORTANT: gULocationMutex should be locked before this
+ * is called.
+ *
+ * @param devHandle            the handle of the device.
+ * @param type                 the location type.
+ * @param maxAgeMs             the maximum age of the fix in
+ *                             milliseconds, -1 for any age.
+ * @param maxRadiusMillimetres the maximum radius of position of
+ *                             the fix, -1 for any radius.
+ * @param pLocation            a place to put the fix; cannot be NULL.
+ * @return                     zero on success, else
+ *                             #U_ERROR_COMMON_NOT_FOUND.
+ */
+int32_t uLocationSharedCacheGet(uDeviceHandle_t devHandle,
+                                uLocationType_t type,
+                                int32_t maxAgeMs,
+                                int32_t maxRadiusMillimetres,
+                                uLocation_t *pLocation);
+
+/** Remove, and free, the fixes in the location cache.
+ * IMPORTANT: gULocationMutex should be locked before this
+ * is called.
+ *
+ * @param devHandle the handle of the device whose fixes are to
+ *                  be removed, NULL for all devices.
+ */
+void uLocationSharedCacheClear(uDeviceHandle_t devHandle);
+
 #ifdef __cplusplus
 }
 #endif
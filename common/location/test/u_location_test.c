@@ -56,6 +56,7 @@
 #include "u_network_test_shared_cfg.h"
 
 #include "u_location.h"
+#include "u_location_shared.h"
 #include "u_location_test_shared_cfg.h"
 
 /* ----------------------------------------------------------------
@@ -107,6 +108,14 @@ static int32_t gErrorCode;
  */
 static int32_t gCount;
 
+/** Keep track of the number of times raceCallback() is called.
+ */
+static int32_t gRaceCount;
+
+/** Keep track of the best error code passed to raceCallback().
+ */
+static int32_t gRaceErrorCode;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -166,6 +175,7 @@ static void testBlocking(uDeviceHandle_t devHandle,
                          const uLocationTestCfg_t *pLocationCfg)
 {
     uLocation_t location;
+    uLocation_t cachedLocation;
     int64_t startTime;
     const uLocationAssist_t *pLocationAssist = NULL;
     const char *pAuthenticationTokenStr = NULL;
@@ -214,6 +224,33 @@ static void testBlocking(uDeviceHandle_t devHandle,
             U_TEST_PRINT_LINE("only able to get time (%d).", (int32_t) location.timeUtc);
         }
         U_PORT_TEST_ASSERT(location.timeUtc > U_LOCATION_TEST_MIN_UTC_TIME);
+        // The fix should now be in the cache
+        uLocationTestResetLocation(&cachedLocation);
+        U_PORT_TEST_ASSERT(uLocationGetCached(devHandle, locationType,
+                                              U_LOCATION_TEST_CFG_TIMEOUT_SECONDS * 1000,
+                                              -1, &cachedLocation) == 0);
+        U_PORT_TEST_ASSERT(cachedLocation.timeUtc == location.timeUtc);
+        U_PORT_TEST_ASSERT(cachedLocation.latitudeX1e7 == location.latitudeX1e7);
+        U_PORT_TEST_ASSERT(cachedLocation.longitudeX1e7 == location.longitudeX1e7);
+        // A fix that is too old should not be returned
+        uPortTaskBlock(10);
+        U_PORT_TEST_ASSERT(uLocationGetCached(devHandle, locationType, 0, -1,
+                                              &cachedLocation) ==
+                           (int32_t) U_ERROR_COMMON_NOT_FOUND);
+        // Nor should a fix with a radius bigger than that asked for;
+        // an unknown (negative) radius is bigger than any asked for
+        if (location.radiusMillimetres > 0) {
+            U_PORT_TEST_ASSERT(uLocationGetCached(devHandle, locationType, -1,
+                                                  location.radiusMillimetres - 1,
+                                                  &cachedLocation) ==
+                               (int32_t) U_ERROR_COMMON_NOT_FOUND);
+        } else if (location.radiusMillimetres < 0) {
+            U_PORT_TEST_ASSERT(uLocationGetCached(devHandle, locationType, -1, 0,
+                                                  &cachedLocation) ==
+                               (int32_t) U_ERROR_COMMON_NOT_FOUND);
+        }
+        U_PORT_TEST_ASSERT(uLocationGetCached(NULL, locationType, -1, -1,
+                                              &cachedLocation) < 0);
     } else {
         if (!U_NETWORK_TEST_TYPE_HAS_LOCATION(networkType)) {
             U_PORT_TEST_ASSERT(uLocationGet(devHandle, locationType,
@@ -471,6 +508,146 @@ static void testContinuous(uDeviceHandle_t devHandle,
     }
 }
 
+// Test the race location API with a single runner.
+static void testRace(uDeviceHandle_t devHandle,
+                     uLocationType_t locationType,
+                     const uLocationTestCfg_t *pLocationCfg)
+{
+    uDeviceHandle_t cellDevHandle = NULL;
+    uDeviceHandle_t gnssDevHandle = devHandle;
+
+    if (locationType == U_LOCATION_TYPE_CLOUD_CELL_LOCATE) {
+        cellDevHandle = devHandle;
+        gnssDevHandle = NULL;
+    }
+    gStopTimeMs = uPortGetTickTimeMs() + U_LOCATION_TEST_CFG_TIMEOUT_SECONDS * 1000;
+    gDevHandle = NULL;
+    gErrorCode = INT_MIN;
+    uLocationTestResetLocation(&gLocation);
+    U_TEST_PRINT_LINE("race API.");
+    U_PORT_TEST_ASSERT(uLocationGetRaceStart(NULL, NULL,
+                                             pLocationCfg->pLocationAssist,
+                                             pLocationCfg->pAuthenticationTokenStr,
+                                             locationCallback) < 0);
+    U_PORT_TEST_ASSERT(uLocationGetRaceStart(cellDevHandle, gnssDevHandle,
+                                             pLocationCfg->pLocationAssist,
+                                             pLocationCfg->pAuthenticationTokenStr,
+                                             locationCallback) == 0);
+    // Only one race at a time
+    U_PORT_TEST_ASSERT(uLocationGetRaceStart(cellDevHandle, gnssDevHandle,
+                                             pLocationCfg->pLocationAssist,
+                                             pLocationCfg->pAuthenticationTokenStr,
+                                             locationCallback) ==
+                       (int32_t) U_ERROR_COMMON_BUSY);
+    while ((gErrorCode == INT_MIN) && (uPortGetTickTimeMs() < gStopTimeMs)) {
+        uPortTaskBlock(1000);
+    }
+    uLocationGetRaceStop();
+    // With a single runner there is always exactly one answer
+    U_TEST_PRINT_LINE("race result %d.", gErrorCode);
+    U_PORT_TEST_ASSERT(gErrorCode != INT_MIN);
+    U_PORT_TEST_ASSERT(gDevHandle == devHandle);
+    if (gErrorCode == 0) {
+        U_PORT_TEST_ASSERT(gLocation.timeUtc > U_LOCATION_TEST_MIN_UTC_TIME);
+    }
+}
+
+// Callback function for a race with two runners.
+static void raceCallback(uDeviceHandle_t devHandle,
+                         int32_t errorCode,
+                         const uLocation_t *pLocation)
+{
+    (void) devHandle;
+    (void) pLocation;
+    if ((gRaceErrorCode == INT_MIN) || (errorCode == 0)) {
+        gRaceErrorCode = errorCode;
+    }
+    gRaceCount++;
+}
+
+// Return true if the list has a GNSS network on the given device.
+static bool hasGnssNetwork(uNetworkTestList_t *pList, uDeviceHandle_t devHandle)
+{
+    bool found = false;
+
+    for (uNetworkTestList_t *pTmp = pList; (pTmp != NULL) && !found; pTmp = pTmp->pNext) {
+        found = (*pTmp->pDevHandle == devHandle) &&
+                (pTmp->networkType == U_NETWORK_TYPE_GNSS);
+    }
+
+    return found;
+}
+
+// Test the race location API with both Cell Locate and GNSS
+// running on a cellular device that has a GNSS chip inside
+// or connected via it, then check that the stopped race has
+// left nothing behind in the FIFO of either location type and
+// that an un-stopped race is torn down by de-initialisation.
+static void testRaceTwoRunners(uDeviceHandle_t devHandle,
+                               const uLocationTestCfg_t *pLocationCfg)
+{
+    uLocationAssist_t locationAssist = U_LOCATION_ASSIST_DEFAULTS;
+    const uLocationType_t locationTypes[] = {U_LOCATION_TYPE_GNSS,
+                                             U_LOCATION_TYPE_CLOUD_CELL_LOCATE
+                                            };
+    int32_t raceCount;
+
+    if (pLocationCfg->pLocationAssist != NULL) {
+        locationAssist = *pLocationCfg->pLocationAssist;
+    }
+    // Cell Locate must leave the GNSS chip to the GNSS runner
+    locationAssist.disableGnss = true;
+    gStopTimeMs = uPortGetTickTimeMs() + U_LOCATION_TEST_CFG_TIMEOUT_SECONDS * 1000;
+    gRaceCount = 0;
+    gRaceErrorCode = INT_MIN;
+    U_TEST_PRINT_LINE("race API with two runners.");
+    U_PORT_TEST_ASSERT(uLocationGetRaceStart(devHandle, devHandle, &locationAssist,
+                                             pLocationCfg->pAuthenticationTokenStr,
+                                             raceCallback) == 0);
+    while ((gRaceCount == 0) && (uPortGetTickTimeMs() < gStopTimeMs)) {
+        uPortTaskBlock(1000);
+    }
+    uLocationGetRaceStop();
+    raceCount = gRaceCount;
+    U_TEST_PRINT_LINE("race result %d after %d callback(s).", gRaceErrorCode, raceCount);
+    U_PORT_TEST_ASSERT(raceCount > 0);
+
+    // Whichever runner lost was cancelled: a request for each
+    // location type must now get its own callback rather than
+    // being consumed by a stale request left by the race
+    for (size_t x = 0; x < sizeof(locationTypes) / sizeof(locationTypes[0]); x++) {
+        gStopTimeMs = uPortGetTickTimeMs() + U_LOCATION_TEST_CFG_TIMEOUT_SECONDS * 1000;
+        gDevHandle = NULL;
+        gErrorCode = INT_MIN;
+        uLocationTestResetLocation(&gLocation);
+        U_PORT_TEST_ASSERT(uLocationGetStart(devHandle, locationTypes[x], &locationAssist,
+                                             pLocationCfg->pAuthenticationTokenStr,
+                                             locationCallback) == 0);
+        while ((gErrorCode == INT_MIN) && (uPortGetTickTimeMs() < gStopTimeMs)) {
+            uPortTaskBlock(1000);
+        }
+        uLocationGetStop(devHandle);
+        U_TEST_PRINT_LINE("%s after race gave %d.", gpULocationTestTypeStr[locationTypes[x]],
+                          gErrorCode);
+        U_PORT_TEST_ASSERT(gErrorCode != INT_MIN);
+        U_PORT_TEST_ASSERT(gDevHandle == devHandle);
+    }
+    // A stopped race never calls back again
+    U_PORT_TEST_ASSERT(gRaceCount == raceCount);
+
+    // Leave a race running and de-initialise: the next race
+    // must not be refused as BUSY and nothing may leak
+    U_PORT_TEST_ASSERT(uLocationGetRaceStart(devHandle, devHandle, &locationAssist,
+                                             pLocationCfg->pAuthenticationTokenStr,
+                                             raceCallback) == 0);
+    uLocationSharedDeinit();
+    U_PORT_TEST_ASSERT(uLocationSharedInit() == 0);
+    U_PORT_TEST_ASSERT(uLocationGetRaceStart(devHandle, devHandle, &locationAssist,
+                                             pLocationCfg->pAuthenticationTokenStr,
+                                             raceCallback) == 0);
+    uLocationGetRaceStop();
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -576,6 +753,22 @@ U_PORT_TEST_FUNCTION("[location]", "locationBasic")
             testContinuous(devHandle, pTmp->networkType,
                            (uLocationType_t) locationType, gpLocationCfg);
 
+            // Test the race location API, which only has runners
+            // for Cell Locate and GNSS
+            if ((gpLocationCfg != NULL) &&
+                ((locationType == (int32_t) U_LOCATION_TYPE_GNSS) ||
+                 (locationType == (int32_t) U_LOCATION_TYPE_CLOUD_CELL_LOCATE))) {
+                testRace(devHandle, (uLocationType_t) locationType, gpLocationCfg);
+            }
+            // ...and, where a cellular device also offers GNSS, with
+            // both runners in the race at once
+            if ((gpLocationCfg != NULL) &&
+                (locationType == (int32_t) U_LOCATION_TYPE_CLOUD_CELL_LOCATE) &&
+                (pTmp->pDeviceCfg->deviceType == U_DEVICE_TYPE_CELL) &&
+                hasGnssNetwork(pList, devHandle)) {
+                testRaceTwoRunners(devHandle, gpLocationCfg);
+            }
+
             if (gpLocationCfg != NULL) {
                 if ((gpLocationCfg->pLocationAssist != NULL) &&
                     (gpLocationCfg->pLocationAssist->pMqttClientContext != NULL)) {
@@ -592,6 +785,10 @@ U_PORT_TEST_FUNCTION("[location]", "locationBasic")
                 gpLocationCfg = NULL;
             }
         }
+
+        // Forget the fixes of this device so that they
+        // don't count against the heap check below
+        uLocationCacheClear(devHandle);
     }
 
     // Check for memory leaks
@@ -65,6 +65,88 @@ extern "C" {
  */
 #define U_MQTT_CLIENT_SN_TOPIC_NAME_SHORT_LENGTH_BYTES 3
 
+#ifndef U_MQTT_CLIENT_OUTBOX_FILE_NAME
+/** The name of the file on the cellular module's file system
+ * that holds the outbox when no storage is passed to
+ * uMqttClientOutboxOpen().
+ */
+# define U_MQTT_CLIENT_OUTBOX_FILE_NAME "ubx_mqtt_outbox"
+#endif
+
+#ifndef U_MQTT_CLIENT_OUTBOX_SIZE_MAX_BYTES
+/** The default limit on the size of the outbox log, used when
+ * zero is passed as the maxSizeBytes parameter of
+ * uMqttClientOutboxOpen().
+ */
+# define U_MQTT_CLIENT_OUTBOX_SIZE_MAX_BYTES (1024 * 32)
+#endif
+
+#ifndef U_MQTT_CLIENT_OUTBOX_TOPIC_MAX_LENGTH_BYTES
+/** The maximum length of the topic of a message stored in the
+ * outbox, not including the null terminator.
+ */
+# define U_MQTT_CLIENT_OUTBOX_TOPIC_MAX_LENGTH_BYTES 128
+#endif
+
+#ifndef U_MQTT_CLIENT_OUTBOX_MESSAGE_MAX_LENGTH_BYTES
+/** The maximum length of a message stored in the outbox.
+ */
+# define U_MQTT_CLIENT_OUTBOX_MESSAGE_MAX_LENGTH_BYTES 512
+#endif
+
+#ifndef U_MQTT_CLIENT_OUTBOX_READ_BUFFER_LENGTH_BYTES
+/** The size of the buffer that the outbox log is read into when
+ * draining; several stored messages are read from storage in one
+ * go if they fit.  Must be at least large enough for one message
+ * of #U_MQTT_CLIENT_OUTBOX_MESSAGE_MAX_LENGTH_BYTES on a topic of
+ * #U_MQTT_CLIENT_OUTBOX_TOPIC_MAX_LENGTH_BYTES plus 12 bytes of
+ * overhead.
+ */
+# define U_MQTT_CLIENT_OUTBOX_READ_BUFFER_LENGTH_BYTES 2048
+#endif
+
+#ifndef U_MQTT_CLIENT_OUTBOX_IN_FLIGHT_MAX_NUM
+/** The maximum number of messages from the outbox that may be in
+ * flight to the broker at once while draining; the number actually
+ * in flight is also limited by the window set with
+ * uMqttClientSetPublishWindow().
+ */
+# define U_MQTT_CLIENT_OUTBOX_IN_FLIGHT_MAX_NUM 8
+#endif
+
+#ifndef U_MQTT_CLIENT_OUTBOX_DRAIN_BATCH_NUM
+/** The number of stored messages that uMqttClientOutboxPublish()
+ * will try to drain from the outbox when it is called while
+ * connected and there are messages stored, and that
+ * uMqttClientConnect() will try to drain once connected.
+ */
+# define U_MQTT_CLIENT_OUTBOX_DRAIN_BATCH_NUM 16
+#endif
+
+#ifndef U_MQTT_CLIENT_DISPATCH_TOPIC_MAX_LENGTH_BYTES
+/** The size of the buffer that the topic of a message received
+ * for the subscriptions made with uMqttClientDispatchSubscribe()
+ * is read into, including the null terminator.
+ */
+# define U_MQTT_CLIENT_DISPATCH_TOPIC_MAX_LENGTH_BYTES 256
+#endif
+
+#ifndef U_MQTT_CLIENT_DISPATCH_MESSAGE_MAX_LENGTH_BYTES
+/** The size of the buffer that a message received for the
+ * subscriptions made with uMqttClientDispatchSubscribe() is read
+ * into; a longer message is passed to the callback truncated.
+ */
+# define U_MQTT_CLIENT_DISPATCH_MESSAGE_MAX_LENGTH_BYTES 1024
+#endif
+
+#ifndef U_MQTT_CLIENT_DISPATCH_MATCH_MAX_NUM
+/** The maximum number of subscriptions made with
+ * uMqttClientDispatchSubscribe() that a single received message
+ * may be passed to, relevant where topic filters overlap.
+ */
+# define U_MQTT_CLIENT_DISPATCH_MATCH_MAX_NUM 8
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -195,8 +277,54 @@ typedef struct {
     uSecurityTlsContext_t *pSecurityContext;
     int32_t totalMessagesSent;      /* Total messages sent from MQTT client */
     int32_t totalMessagesReceived;  /* Total messages received by MQTT client */
+    void *pOutbox; /* The outbox, if one has been opened with uMqttClientOutboxOpen() */
+    void *pDispatch; /* The subscriptions made with uMqttClientDispatchSubscribe() */
 } uMqttClientContext_t;
 
+/** A message read by uMqttClientMessageReadBulk().
+ */
+typedef struct {
+    char *pTopicNameStr;        /**< a place to put the null-terminated
+                                     topic string of the message; cannot
+                                     be NULL. */
+    size_t topicNameSizeBytes;  /**< the number of bytes of storage at
+                                     pTopicNameStr. */
+    char *pMessage;             /**< a place to put the message; may be
+                                     NULL. */
+    size_t messageSizeBytes;    /**< on entry the number of bytes of
+                                     storage at pMessage, on return the
+                                     number of bytes written to pMessage. */
+    uMqttQos_t qos;             /**< on return, the QoS of the message;
+                                     not supported for short range
+                                     modules. */
+    int32_t errorCode;          /**< on return, zero or
+                                     #U_ERROR_COMMON_TRUNCATED if the
+                                     message did not fit into pMessage. */
+} uMqttClientMessage_t;
+
+/** The storage behind an outbox, see uMqttClientOutboxOpen(): an
+ * append-only log which is only ever erased as a whole.
+ */
+typedef struct {
+    int32_t (*pAppend) (void *pParam, const char *pData,
+                        size_t size);  /**< append size bytes from pData
+                                            to the end of the log, returning
+                                            the number of bytes appended or
+                                            negative error code. */
+    int32_t (*pRead) (void *pParam, char *pData, size_t offset,
+                      size_t size);    /**< read up to size bytes from
+                                            offset in the log into pData,
+                                            returning the number of bytes
+                                            read or negative error code. */
+    int32_t (*pSize) (void *pParam);   /**< return the size of the log,
+                                            zero if it does not exist. */
+    int32_t (*pErase) (void *pParam);  /**< erase the log, returning
+                                            zero on success else negative
+                                            error code. */
+    void *pParam;                      /**< passed to all of the above
+                                            as their first parameter. */
+} uMqttClientOutboxStorage_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MQTT AND MQTT-SN
  * -------------------------------------------------------------- */
@@ -254,7 +382,10 @@ void uMqttClientClose(uMqttClientContext_t *pContext);
  * inside pConnection is non-NULL then it will called while this
  * function is waiting for a connection to be made; this function
  * works for both MQTT and MQTT-SN however see also
- * uMqttClientSnConnect().
+ * uMqttClientSnConnect().  If an outbox has been opened with
+ * uMqttClientOutboxOpen() then, once connected, up to
+ * #U_MQTT_CLIENT_OUTBOX_DRAIN_BATCH_NUM of the messages stored
+ * in it are sent before this function returns.
  *
  * @param[in] pContext     a pointer to the internal MQTT context
  *                         structure that was originally returned by
@@ -414,6 +545,88 @@ int32_t uMqttClientPublish(uMqttClientContext_t *pContext,
                            size_t messageSizeBytes,
                            uMqttQos_t qos, bool retain);
 
+/** MQTT only: publish an MQTT message without waiting for the
+ * publish to complete, allowing several messages to be in flight
+ * to the broker at once; the result is passed to pCallback.  The
+ * number of messages whose pCallback has not yet been called is
+ * limited by the window set with uMqttClientSetPublishWindow(); when
+ * the window is full #U_ERROR_COMMON_BUSY is returned and the caller
+ * should retry once a callback has been called.
+ *
+ * For cellular the result is that reported by the module once the
+ * broker has responded (for QoS 1, the PUBACK), results are reported
+ * in the order that messages were published without saying which
+ * message they are for: if the oldest message receives no result
+ * within #U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS then all outstanding
+ * messages are completed with #U_ERROR_COMMON_TIMEOUT and
+ * #U_ERROR_COMMON_BUSY is returned, also by uMqttClientPublish(),
+ * until their late results have been accounted for; likewise
+ * uMqttClientPublish() returns #U_ERROR_COMMON_BUSY while messages
+ * published with this function are outstanding.  For Wi-Fi the module
+ * provides no indication of a broker response and so the result is
+ * that of handing the message to the module.
+ *
+ * @param[in] pContext       a pointer to the internal MQTT context
+ *                           structure that was originally returned
+ *                           by pUMqttClientOpen().
+ * @param[in] pTopicNameStr  the null-terminated topic string
+ *                           for the message; cannot be NULL.
+ * @param[in] pMessage       a pointer to the message, as for
+ *                           uMqttClientPublish(); the message has
+ *                           been copied by the time this function
+ *                           returns.  Cannot be NULL.
+ * @param messageSizeBytes   the length of pMessage.
+ * @param qos                the MQTT QoS to use for this message.
+ * @param retain             if true the message will be kept
+ *                           by the broker across MQTT disconnects/
+ *                           connects, else it will be cleared.
+ * @param[in] pCallback      the callback that will be called with
+ *                           the result, may be NULL: the first
+ *                           parameter is the token returned by this
+ *                           function, the second parameter is zero
+ *                           on success else negative error code and
+ *                           the third parameter is pCallbackParam.
+ *                           The callback is called from a separate
+ *                           task and should not block for long.
+ * @param[in] pCallbackParam this value will be passed to pCallback.
+ * @return                   on success a token, zero or positive,
+ *                           that will be passed to pCallback, else
+ *                           negative error code.
+ */
+int32_t uMqttClientPublishAsync(uMqttClientContext_t *pContext,
+                                const char *pTopicNameStr,
+                                const char *pMessage,
+                                size_t messageSizeBytes,
+                                uMqttQos_t qos, bool retain,
+                                void (*pCallback) (int32_t, int32_t, void *),
+                                void *pCallbackParam);
+
+/** MQTT only: set the number of messages published with
+ * uMqttClientPublishAsync() that may be outstanding at any one time.
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context
+ *                      structure that was originally returned
+ *                      by pUMqttClientOpen().
+ * @param windowSize    the window size, from 1 up to
+ *                      #U_CELL_MQTT_PUBLISH_WINDOW_MAX_NUM for
+ *                      cellular or #U_WIFI_MQTT_PUBLISH_WINDOW_MAX_NUM
+ *                      for Wi-Fi.
+ * @return              zero on success else negative error code.
+ */
+int32_t uMqttClientSetPublishWindow(const uMqttClientContext_t *pContext,
+                                    size_t windowSize);
+
+/** MQTT only: get the number of messages published with
+ * uMqttClientPublishAsync() whose callback has not yet been called.
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context
+ *                      structure that was originally returned
+ *                      by pUMqttClientOpen().
+ * @return              the number of outstanding messages, else
+ *                      negative error code.
+ */
+int32_t uMqttClientGetPublishInFlight(const uMqttClientContext_t *pContext);
+
 /** MQTT only: subscribe to an MQTT topic. If pKeepGoingCallback()
  * inside the pConnection structure passed to uMqttClientConnect()
  * was non-NULL it will be called while this function is waiting
@@ -486,6 +699,268 @@ int32_t uMqttClientMessageRead(uMqttClientContext_t *pContext,
                                size_t *pMessageSizeBytes,
                                uMqttQos_t *pQos);
 
+/** MQTT only: read as many MQTT messages as there are, up to
+ * numMessages, in one go.  Where the underlying module interface
+ * allows it the messages are read without letting go of that
+ * interface in between, which is quicker than repeated calls to
+ * uMqttClientMessageRead() when there are many unread messages,
+ * e.g. after a reconnect.  Messages are read in order into the
+ * elements of pMessages; a message that is longer than the storage
+ * provided for it is copied as far as it will fit and the errorCode
+ * field of that element is set to #U_ERROR_COMMON_TRUNCATED.
+ *
+ * @param[in] pContext           a pointer to the internal MQTT context
+ *                               structure that was originally returned
+ *                               by pUMqttClientOpen().
+ * @param[in,out] pMessages      an array of numMessages messages with
+ *                               the storage fields populated; cannot
+ *                               be NULL.
+ * @param numMessages            the number of elements in pMessages.
+ * @return                       the number of messages read, which
+ *                               will be at least one, else negative
+ *                               error code; #U_ERROR_COMMON_EMPTY if
+ *                               there were no messages to read.
+ */
+int32_t uMqttClientMessageReadBulk(uMqttClientContext_t *pContext,
+                                   uMqttClientMessage_t *pMessages,
+                                   size_t numMessages);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: MQTT ONLY, OUTBOX
+ * -------------------------------------------------------------- */
+
+/** MQTT only: open an outbox for an MQTT client; messages published
+ * with uMqttClientOutboxPublish() while there is no connection to the
+ * broker are stored in the outbox and sent later, in order, by
+ * uMqttClientOutboxDrain().  The outbox is a compact append-only log
+ * and so survives a restart: if the log already contains stored
+ * messages they will be sent by the next drain.
+ *
+ * Each stored message is given an ID, incrementing and persistent
+ * across restarts.  A message is only recorded as delivered once the
+ * publish of it has succeeded, and records of delivery are written
+ * once per drain rather than once per message, hence a restart in
+ * the middle of a drain may cause a message to be sent a second
+ * time; if that matters call uMqttClientOutboxSetIdInTopic() so that
+ * the ID of each stored message is sent with it, allowing the far end
+ * to discard duplicates.  Once all of the stored messages have been
+ * delivered the log is erased.
+ *
+ * The outbox is closed by uMqttClientOutboxClose() or
+ * uMqttClientClose().
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context
+ *                      structure that was originally returned
+ *                      by pUMqttClientOpen().
+ * @param[in] pStorage  the storage to use for the log; the structure
+ *                      is copied.  If NULL the file
+ *                      #U_MQTT_CLIENT_OUTBOX_FILE_NAME on the file
+ *                      system of the cellular module is used, in which
+ *                      case pContext must be a cellular one.
+ * @param maxSizeBytes  the maximum size of the log in bytes; when
+ *                      the log is full uMqttClientOutboxPublish()
+ *                      will return #U_ERROR_COMMON_NO_MEMORY.  Use
+ *                      zero for #U_MQTT_CLIENT_OUTBOX_SIZE_MAX_BYTES.
+ * @return              zero on success else negative error code.
+ */
+int32_t uMqttClientOutboxOpen(uMqttClientContext_t *pContext,
+                              const uMqttClientOutboxStorage_t *pStorage,
+                              size_t maxSizeBytes);
+
+/** MQTT only: close the outbox of an MQTT client, freeing memory;
+ * any stored messages remain in storage.  A drain in progress is
+ * allowed to finish first; the results of publishes that are still
+ * in flight when the outbox is closed are ignored, the message
+ * remaining stored, and hence will be sent again by the next drain
+ * after the outbox is re-opened.
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context
+ *                      structure that was originally returned
+ *                      by pUMqttClientOpen().
+ */
+void uMqttClientOutboxClose(uMqttClientContext_t *pContext);
+
+/** MQTT only: publish an MQTT message through the outbox.  If there
+ * is a connection to the broker and no messages are stored in the
+ * outbox the message is published with uMqttClientPublish(), else, or
+ * if that fails, it is stored in the outbox; if there is a connection
+ * and there were already messages stored then up to
+ * #U_MQTT_CLIENT_OUTBOX_DRAIN_BATCH_NUM stored messages are then
+ * sent, as uMqttClientOutboxDrain().
+ *
+ * @param[in] pContext      a pointer to the internal MQTT context
+ *                          structure that was originally returned
+ *                          by pUMqttClientOpen().
+ * @param[in] pTopicNameStr the null-terminated topic string for the
+ *                          message, no longer than
+ *                          #U_MQTT_CLIENT_OUTBOX_TOPIC_MAX_LENGTH_BYTES;
+ *                          cannot be NULL.
+ * @param[in] pMessage      a pointer to the message, as for
+ *                          uMqttClientPublish(), no longer than
+ *                          #U_MQTT_CLIENT_OUTBOX_MESSAGE_MAX_LENGTH_BYTES;
+ *                          cannot be NULL.
+ * @param messageSizeBytes  the length of pMessage.
+ * @param qos               the MQTT QoS to use for this message.
+ * @param retain            if true the message will be kept
+ *                          by the broker across MQTT disconnects/
+ *                          connects, else it will be cleared.
+ * @return                  zero if the message was published, a
+ *                          positive ID if the message was stored in
+ *                          the outbox (see
+ *                          uMqttClientOutboxSetIdInTopic()), else
+ *                          negative error code.
+ */
+int32_t uMqttClientOutboxPublish(uMqttClientContext_t *pContext,
+                                 const char *pTopicNameStr,
+                                 const char *pMessage,
+                                 size_t messageSizeBytes,
+                                 uMqttQos_t qos, bool retain);
+
+/** MQTT only: set whether the ID of a stored message is sent with
+ * it when the outbox is drained, by adding "/" and the ID, in decimal,
+ * to the end of its topic; e.g. a message stored with the topic
+ * "sensor/temp" that was given the ID 17 is published on the topic
+ * "sensor/temp/17".  Since a message published directly by
+ * uMqttClientOutboxPublish() is not stored, and so never sent twice,
+ * its topic is unchanged: the far end may subscribe to "sensor/temp/#",
+ * which matches both, and discard a message whose ID it has already
+ * seen; IDs are never re-used, even across restarts.  Note that a
+ * retained message is retained against the topic with the ID added.
+ * The default is off and the setting is not stored; it should be made
+ * after uMqttClientOutboxOpen() and before uMqttClientConnect().
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context
+ *                      structure that was originally returned
+ *                      by pUMqttClientOpen().
+ * @param idInTopic     true to add the ID to the topic of a stored
+ *                      message, false to leave the topic unchanged.
+ * @return              zero on success else negative error code.
+ */
+int32_t uMqttClientOutboxSetIdInTopic(uMqttClientContext_t *pContext,
+                                      bool idInTopic);
+
+/** MQTT only: send the messages stored in the outbox, in order; a
+ * batch is sent by uMqttClientConnect() but, if there are more than
+ * that, or if the connection was restored without calling
+ * uMqttClientConnect(), call this to send the rest.  Stored
+ * messages are read from storage several at a time and are published
+ * with uMqttClientPublishAsync(), hence many messages may be in flight
+ * to the broker at once.  Sending stops at the first message that
+ * fails, which will be tried again by the next drain.
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context
+ *                      structure that was originally returned
+ *                      by pUMqttClientOpen().
+ * @param maxNum        the maximum number of messages to send, zero
+ *                      for no limit.
+ * @return              the number of stored messages that were
+ *                      delivered, else negative error code.
+ */
+int32_t uMqttClientOutboxDrain(uMqttClientContext_t *pContext,
+                               size_t maxNum);
+
+/** MQTT only: get the number of messages stored in the outbox that
+ * have not yet been delivered.
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context
+ *                      structure that was originally returned
+ *                      by pUMqttClientOpen().
+ * @return              the number of stored messages, else negative
+ *                      error code.
+ */
+int32_t uMqttClientOutboxGetNum(const uMqttClientContext_t *pContext);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: MQTT ONLY, SUBSCRIPTION DISPATCH
+ * -------------------------------------------------------------- */
+
+/** MQTT only: subscribe to an MQTT topic, as uMqttClientSubscribe(),
+ * with a callback that is called for each message received on a
+ * topic matching pTopicFilterStr.  With the first such subscription
+ * this code takes over the message callback of the MQTT client (see
+ * uMqttClientSetMessageCallback(), which should not be called while
+ * such subscriptions exist) and messages are then read, with
+ * uMqttClientMessageRead(), and passed to the callbacks of the
+ * matching subscriptions automatically, in a task of their own:
+ * there is no need to poll.  A message that matches no subscription
+ * is discarded.
+ *
+ * The topic filters are held in a tree with one level of the tree
+ * per level of topic, hence the effort of finding the subscriptions
+ * that match a received message depends on the number of levels in
+ * its topic rather than on the number of subscriptions.  If
+ * pTopicFilterStr is the same as that of an existing subscription
+ * made with this function the callback of that subscription is
+ * replaced.
+ *
+ * @param[in] pContext         a pointer to the internal MQTT context
+ *                             structure that was originally returned
+ *                             by pUMqttClientOpen().
+ * @param[in] pTopicFilterStr  the null-terminated topic string to
+ *                             subscribe to, which may include the
+ *                             wildcards '+' and '#' as described for
+ *                             uMqttClientSubscribe(); each wildcard
+ *                             must occupy a whole topic level and '#'
+ *                             may only be the last level.  Cannot be
+ *                             NULL.
+ * @param maxQos               the maximum MQTT message QoS for this
+ *                             subscription.
+ * @param[in] pCallback        the callback, which will be called with
+ *                             the null-terminated topic of the message,
+ *                             the message (not null-terminated), the
+ *                             length of the message, which will be no
+ *                             more than
+ *                             #U_MQTT_CLIENT_DISPATCH_MESSAGE_MAX_LENGTH_BYTES,
+ *                             the QoS of the message and pCallbackParam.
+ *                             The callback may call
+ *                             uMqttClientDispatchSubscribe() or
+ *                             uMqttClientDispatchUnsubscribe() but should
+ *                             return quickly as it holds up the reading
+ *                             of further messages.  Cannot be NULL.
+ * @param[in] pCallbackParam   this value will be passed to pCallback
+ *                             as its last parameter.
+ * @return                     the QoS of the subscription else negative
+ *                             error code.
+ */
+int32_t uMqttClientDispatchSubscribe(uMqttClientContext_t *pContext,
+                                     const char *pTopicFilterStr,
+                                     uMqttQos_t maxQos,
+                                     void (*pCallback) (const char *,
+                                                        const char *,
+                                                        size_t,
+                                                        uMqttQos_t,
+                                                        void *),
+                                     void *pCallbackParam);
+
+/** MQTT only: unsubscribe from an MQTT topic that was subscribed to
+ * with uMqttClientDispatchSubscribe(); the callback will not be
+ * called again once this function has returned, except where it
+ * is called from the callback itself.
+ *
+ * @param[in] pContext         a pointer to the internal MQTT context
+ *                             structure that was originally returned
+ *                             by pUMqttClientOpen().
+ * @param[in] pTopicFilterStr  the null-terminated topic string that
+ *                             was passed to
+ *                             uMqttClientDispatchSubscribe().  Cannot
+ *                             be NULL.
+ * @return                     zero on success else negative error code.
+ */
+int32_t uMqttClientDispatchUnsubscribe(uMqttClientContext_t *pContext,
+                                       const char *pTopicFilterStr);
+
+/** MQTT only: remove all of the subscription callbacks set by
+ * uMqttClientDispatchSubscribe(), without unsubscribing from the
+ * broker, giving the message callback of the MQTT client back to
+ * the application and freeing memory.  This is called by
+ * uMqttClientClose().
+ *
+ * @param[in] pContext  a pointer to the internal MQTT context
+ *                      structure that was originally returned
+ *                      by pUMqttClientOpen().
+ */
+void uMqttClientDispatchClose(uMqttClientContext_t *pContext);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MQTT-SN ONLY
  * -------------------------------------------------------------- */
@@ -191,6 +191,8 @@ uMqttClientContext_t *pUMqttClientOpen(uDeviceHandle_t devHandle,
             pContext->totalMessagesSent = 0;
             pContext->totalMessagesReceived = 0;
             pContext->pPriv = pPriv;
+            pContext->pOutbox = NULL;
+            pContext->pDispatch = NULL;
             if (uPortMutexCreate((uPortMutexHandle_t *) &(pContext->mutexHandle)) == 0) { // *NOPAD*
                 gLastOpenError = U_ERROR_COMMON_SUCCESS;
                 if (pSecurityTlsSettings != NULL) {
@@ -241,6 +243,9 @@ void uMqttClientClose(uMqttClientContext_t *pContext)
 {
     if (pContext != NULL) {
 
+        uMqttClientDispatchClose(pContext);
+        uMqttClientOutboxClose(pContext);
+
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
 
         if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
@@ -288,6 +293,12 @@ int32_t uMqttClientConnect(uMqttClientContext_t *pContext,
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        if ((errorCode == 0) && (pContext->pOutbox != NULL)) {
+            // Back in contact with the broker: send a batch of
+            // whatever was stored in the outbox meanwhile
+            uMqttClientOutboxDrain(pContext, U_MQTT_CLIENT_OUTBOX_DRAIN_BATCH_NUM);
+        }
     }
 
     return errorCode;
@@ -498,6 +509,91 @@ int32_t uMqttClientPublish(uMqttClientContext_t *pContext,
     return errorCode;
 }
 
+// Publish an MQTT message without waiting for the result.
+int32_t uMqttClientPublishAsync(uMqttClientContext_t *pContext,
+                                const char *pTopicNameStr,
+                                const char *pMessage,
+                                size_t messageSizeBytes,
+                                uMqttQos_t qos, bool retain,
+                                void (*pCallback) (int32_t, int32_t, void *),
+                                void *pCallbackParam)
+{
+    int32_t errorCodeOrToken = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pContext != NULL) && (pTopicNameStr != NULL) &&
+        (pMessage != NULL) && (messageSizeBytes > 0)) {
+        errorCodeOrToken = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
+            errorCodeOrToken = uCellMqttPublishAsync(pContext->devHandle,
+                                                     pTopicNameStr,
+                                                     pMessage, messageSizeBytes,
+                                                     (uCellMqttQos_t) qos, retain,
+                                                     pCallback, pCallbackParam);
+        } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_SHORT_RANGE)) {
+            errorCodeOrToken = uWifiMqttPublishAsync(pContext,
+                                                     pTopicNameStr,
+                                                     pMessage, messageSizeBytes,
+                                                     qos, retain,
+                                                     pCallback, pCallbackParam);
+        }
+        if (errorCodeOrToken >= 0) {
+            pContext->totalMessagesSent++;
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCodeOrToken;
+}
+
+// Set the publish window of uMqttClientPublishAsync().
+int32_t uMqttClientSetPublishWindow(const uMqttClientContext_t *pContext,
+                                    size_t windowSize)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
+            errorCode = uCellMqttSetPublishWindow(pContext->devHandle, windowSize);
+        } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_SHORT_RANGE)) {
+            errorCode = uWifiMqttSetPublishWindow(pContext, windowSize);
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCode;
+}
+
+// Get the number of outstanding uMqttClientPublishAsync() messages.
+int32_t uMqttClientGetPublishInFlight(const uMqttClientContext_t *pContext)
+{
+    int32_t errorCodeOrNumber = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pContext != NULL) {
+        errorCodeOrNumber = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
+            errorCodeOrNumber = uCellMqttGetPublishInFlight(pContext->devHandle);
+        } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_SHORT_RANGE)) {
+            errorCodeOrNumber = uWifiMqttGetPublishInFlight(pContext);
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCodeOrNumber;
+}
+
 // Subscribe to an MQTT topic.
 int32_t uMqttClientSubscribe(const uMqttClientContext_t *pContext,
                              const char *pTopicFilterStr,
@@ -592,6 +688,56 @@ int32_t uMqttClientMessageRead(uMqttClientContext_t *pContext,
     return errorCode;
 }
 
+// Read many MQTT messages.
+int32_t uMqttClientMessageReadBulk(uMqttClientContext_t *pContext,
+                                   uMqttClientMessage_t *pMessages,
+                                   size_t numMessages)
+{
+    int32_t errorCodeOrNum = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientMessage_t *pMessage;
+    int32_t errorCode;
+
+    if ((pContext != NULL) && (pMessages != NULL) && (numMessages > 0)) {
+        errorCodeOrNum = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+        if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL)) {
+            // uCellMqttMessage_t is the same structure as uMqttClientMessage_t
+            errorCodeOrNum = uCellMqttMessageReadBulk(pContext->devHandle,
+                                                      (uCellMqttMessage_t *) pMessages,
+                                                      numMessages);
+        } else if (U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_SHORT_RANGE)) {
+            // Messages are already buffered locally, just read them out
+            errorCodeOrNum = 0;
+            errorCode = 0;
+            for (size_t x = 0; (x < numMessages) && (errorCodeOrNum == (int32_t) x); x++) {
+                pMessage = pMessages + x;
+                errorCode = uWifiMqttMessageRead(pContext,
+                                                 pMessage->pTopicNameStr,
+                                                 pMessage->topicNameSizeBytes,
+                                                 pMessage->pMessage,
+                                                 &(pMessage->messageSizeBytes),
+                                                 &(pMessage->qos));
+                if ((errorCode == 0) || (errorCode == (int32_t) U_ERROR_COMMON_TRUNCATED)) {
+                    pMessage->errorCode = errorCode;
+                    errorCodeOrNum++;
+                }
+            }
+            if (errorCodeOrNum == 0) {
+                errorCodeOrNum = errorCode;
+            }
+        }
+        if (errorCodeOrNum > 0) {
+            pContext->totalMessagesReceived += errorCodeOrNum;
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+    }
+
+    return errorCodeOrNum;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: MQTT-SN ONLY
  * -------------------------------------------------------------- */
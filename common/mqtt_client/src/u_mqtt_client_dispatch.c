@@ -0,0 +1,334 @@
+/*
+ * Copyright 2019-2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the subscription dispatch of the u-blox
+ * MQTT client API.  The topic filters of the subscriptions are held
+ * in a tree, see u_mqtt_client_dispatch_private.h.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_os_platform_specific.h"  // For U_CFG_OS_APP_TASK_PRIORITY
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_heap.h"
+#include "u_port_os.h"
+#include "u_port_event_queue.h"
+
+#include "u_mqtt_common.h"
+#include "u_mqtt_client.h"
+
+#include "u_mqtt_client_dispatch_private.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_MQTT_CLIENT_DISPATCH_TASK_STACK_SIZE_BYTES
+/** The stack size for the task in which received messages are
+ * read and the subscription callbacks are called.
+ */
+# define U_MQTT_CLIENT_DISPATCH_TASK_STACK_SIZE_BYTES 2304
+#endif
+
+#ifndef U_MQTT_CLIENT_DISPATCH_TASK_PRIORITY
+/** The priority of the task in which received messages are read
+ * and the subscription callbacks are called; taking the standard
+ * approach of adopting U_CFG_OS_APP_TASK_PRIORITY.
+ */
+# define U_MQTT_CLIENT_DISPATCH_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+/** The depth of the dispatch event queue; an event only means
+ * "there is something to read" and the task reads until there is
+ * nothing left, so there is no need for this to be large.
+ */
+#define U_MQTT_CLIENT_DISPATCH_QUEUE_LENGTH 2
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The subscription dispatcher, pointed-to by the pDispatch member
+ * of uMqttClientContext_t.
+ */
+typedef struct {
+    uMqttClientContext_t *pContext;
+    uPortMutexHandle_t mutex;  /**< protects the tree. */
+    uPortMutexHandle_t callMutex; /**< held by the dispatch task while
+                                       callbacks are being called, but
+                                       not while it holds mutex, so
+                                       that a callback may subscribe
+                                       or unsubscribe. */
+    int32_t eventQueueHandle;
+    volatile bool closing;
+    uMqttClientDispatchNode_t root;
+    char *pTopicNameStr;       /**< #U_MQTT_CLIENT_DISPATCH_TOPIC_MAX_LENGTH_BYTES. */
+    char *pMessage;            /**< #U_MQTT_CLIENT_DISPATCH_MESSAGE_MAX_LENGTH_BYTES. */
+    uMqttClientDispatchMatch_t match[U_MQTT_CLIENT_DISPATCH_MATCH_MAX_NUM];
+} uMqttClientDispatch_t;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Event handler: read all of the messages there are and pass each
+// one to the callbacks of the subscriptions that match its topic.
+static void eventHandler(void *pParam, size_t paramLength)
+{
+    uMqttClientDispatch_t *pDispatch = *((uMqttClientDispatch_t **) pParam);
+    uMqttClientContext_t *pContext = pDispatch->pContext;
+    size_t messageSizeBytes;
+    uMqttQos_t qos;
+    int32_t errorCode;
+    size_t numMatches;
+
+    (void) paramLength;
+
+    while (!pDispatch->closing && (uMqttClientGetUnread(pContext) > 0)) {
+        messageSizeBytes = U_MQTT_CLIENT_DISPATCH_MESSAGE_MAX_LENGTH_BYTES;
+        qos = U_MQTT_QOS_AT_MOST_ONCE;
+        errorCode = uMqttClientMessageRead(pContext, pDispatch->pTopicNameStr,
+                                           U_MQTT_CLIENT_DISPATCH_TOPIC_MAX_LENGTH_BYTES,
+                                           pDispatch->pMessage, &messageSizeBytes,
+                                           &qos);
+        if ((errorCode != 0) && (errorCode != (int32_t) U_ERROR_COMMON_TRUNCATED)) {
+            break;
+        }
+
+        U_PORT_MUTEX_LOCK(pDispatch->callMutex);
+
+        // Copy out the callbacks and call them with the tree
+        // unlocked, so that they may subscribe or unsubscribe
+        U_PORT_MUTEX_LOCK(pDispatch->mutex);
+        numMatches = uMqttClientDispatchPrivateMatch(&(pDispatch->root),
+                                                     pDispatch->pTopicNameStr,
+                                                     pDispatch->match,
+                                                     sizeof(pDispatch->match) /
+                                                     sizeof(pDispatch->match[0]));
+        U_PORT_MUTEX_UNLOCK(pDispatch->mutex);
+
+        for (size_t x = 0; (x < numMatches) && !pDispatch->closing; x++) {
+            pDispatch->match[x].pCallback(pDispatch->pTopicNameStr,
+                                          pDispatch->pMessage,
+                                          messageSizeBytes, qos,
+                                          pDispatch->match[x].pCallbackParam);
+        }
+
+        U_PORT_MUTEX_UNLOCK(pDispatch->callMutex);
+    }
+}
+
+// The message callback of the MQTT client: kick the dispatch task.
+static void messageCallback(int32_t numUnread, void *pParam)
+{
+    uMqttClientDispatch_t *pDispatch = (uMqttClientDispatch_t *) pParam;
+
+    if ((numUnread > 0) && !pDispatch->closing) {
+        uPortEventQueueSend(pDispatch->eventQueueHandle, &pDispatch, sizeof(pDispatch));
+    }
+}
+
+// Free a dispatcher.
+static void dispatchFree(uMqttClientDispatch_t *pDispatch)
+{
+    if (pDispatch->eventQueueHandle >= 0) {
+        uPortEventQueueClose(pDispatch->eventQueueHandle);
+    }
+    if (pDispatch->mutex != NULL) {
+        uPortMutexDelete(pDispatch->mutex);
+    }
+    if (pDispatch->callMutex != NULL) {
+        uPortMutexDelete(pDispatch->callMutex);
+    }
+    uMqttClientDispatchPrivateRemoveAll(&(pDispatch->root));
+    uPortFree(pDispatch->pTopicNameStr);
+    uPortFree(pDispatch->pMessage);
+    uPortFree(pDispatch);
+}
+
+// Get the dispatcher of an MQTT client, creating it and taking over
+// the message callback if there isn't one.
+static uMqttClientDispatch_t *pDispatchGet(uMqttClientContext_t *pContext)
+{
+    uMqttClientDispatch_t *pDispatch;
+    bool created = false;
+
+    U_PORT_MUTEX_LOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+    pDispatch = (uMqttClientDispatch_t *) pContext->pDispatch;
+    if (pDispatch == NULL) {
+        pDispatch = (uMqttClientDispatch_t *) pUPortMalloc(sizeof(*pDispatch));
+        if (pDispatch != NULL) {
+            memset(pDispatch, 0, sizeof(*pDispatch));
+            pDispatch->pContext = pContext;
+            pDispatch->eventQueueHandle = -1;
+            pDispatch->pTopicNameStr = (char *) pUPortMalloc(
+                                           U_MQTT_CLIENT_DISPATCH_TOPIC_MAX_LENGTH_BYTES);
+            pDispatch->pMessage = (char *) pUPortMalloc(
+                                      U_MQTT_CLIENT_DISPATCH_MESSAGE_MAX_LENGTH_BYTES);
+            if ((pDispatch->pTopicNameStr != NULL) && (pDispatch->pMessage != NULL) &&
+                (uPortMutexCreate(&(pDispatch->mutex)) == 0) &&
+                (uPortMutexCreate(&(pDispatch->callMutex)) == 0)) {
+                // We employ our own event queue since reading messages
+                // would block the usual callback queue for too long
+                pDispatch->eventQueueHandle =
+                    uPortEventQueueOpen(eventHandler, "mqttDispatch",
+                                        sizeof(pDispatch),
+                                        U_MQTT_CLIENT_DISPATCH_TASK_STACK_SIZE_BYTES,
+                                        U_MQTT_CLIENT_DISPATCH_TASK_PRIORITY,
+                                        U_MQTT_CLIENT_DISPATCH_QUEUE_LENGTH);
+            }
+            if (pDispatch->eventQueueHandle >= 0) {
+                pContext->pDispatch = pDispatch;
+                created = true;
+            } else {
+                // Clean up on error
+                dispatchFree(pDispatch);
+                pDispatch = NULL;
+            }
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) (pContext->mutexHandle));
+
+    if (created &&
+        (uMqttClientSetMessageCallback(pContext, messageCallback, pDispatch) != 0)) {
+        uMqttClientDispatchClose(pContext);
+        pDispatch = NULL;
+    }
+
+    return pDispatch;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Subscribe to a topic with a callback.
+int32_t uMqttClientDispatchSubscribe(uMqttClientContext_t *pContext,
+                                     const char *pTopicFilterStr,
+                                     uMqttQos_t maxQos,
+                                     void (*pCallback) (const char *,
+                                                        const char *,
+                                                        size_t,
+                                                        uMqttQos_t,
+                                                        void *),
+                                     void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientDispatch_t *pDispatch;
+    int32_t isNew;
+
+    if ((pContext != NULL) && (pTopicFilterStr != NULL) && (pCallback != NULL) &&
+        uMqttClientDispatchPrivateFilterIsValid(pTopicFilterStr)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pDispatch = pDispatchGet(pContext);
+        if (pDispatch != NULL) {
+            // Add the callback before subscribing so that a retained
+            // message, sent by the broker straight away, is not missed
+            U_PORT_MUTEX_LOCK(pDispatch->mutex);
+            isNew = uMqttClientDispatchPrivateAdd(&(pDispatch->root), pTopicFilterStr,
+                                                  pCallback, pCallbackParam);
+            if (isNew < 0) {
+                uMqttClientDispatchPrivateRemove(&(pDispatch->root), pTopicFilterStr);
+            }
+            U_PORT_MUTEX_UNLOCK(pDispatch->mutex);
+            errorCode = isNew;
+            if (isNew >= 0) {
+                errorCode = uMqttClientSubscribe(pContext, pTopicFilterStr, maxQos);
+                if ((errorCode < 0) && (isNew > 0)) {
+                    U_PORT_MUTEX_LOCK(pDispatch->mutex);
+                    uMqttClientDispatchPrivateRemove(&(pDispatch->root), pTopicFilterStr);
+                    U_PORT_MUTEX_UNLOCK(pDispatch->mutex);
+                }
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Unsubscribe from a topic subscribed to with a callback.
+int32_t uMqttClientDispatchUnsubscribe(uMqttClientContext_t *pContext,
+                                       const char *pTopicFilterStr)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientDispatch_t *pDispatch;
+
+    if ((pContext != NULL) && (pTopicFilterStr != NULL) &&
+        uMqttClientDispatchPrivateFilterIsValid(pTopicFilterStr)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+        pDispatch = (uMqttClientDispatch_t *) pContext->pDispatch;
+        if (pDispatch != NULL) {
+            U_PORT_MUTEX_LOCK(pDispatch->mutex);
+            // The filter is only removed from the tree if the
+            // broker agrees, otherwise messages would still arrive
+            if (pUMqttClientDispatchPrivateFind(&(pDispatch->root),
+                                                pTopicFilterStr) != NULL) {
+                errorCode = uMqttClientUnsubscribe(pContext, pTopicFilterStr);
+                if (errorCode == 0) {
+                    uMqttClientDispatchPrivateRemove(&(pDispatch->root), pTopicFilterStr);
+                }
+            }
+            U_PORT_MUTEX_UNLOCK(pDispatch->mutex);
+            if ((errorCode == 0) && !uPortEventQueueIsTask(pDispatch->eventQueueHandle)) {
+                // The dispatch task may have picked up the callback
+                // just before it was removed: wait for it to be done
+                U_PORT_MUTEX_LOCK(pDispatch->callMutex);
+                U_PORT_MUTEX_UNLOCK(pDispatch->callMutex);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Remove all of the subscription callbacks.
+void uMqttClientDispatchClose(uMqttClientContext_t *pContext)
+{
+    uMqttClientDispatch_t *pDispatch;
+
+    if ((pContext != NULL) && (pContext->pDispatch != NULL)) {
+        pDispatch = (uMqttClientDispatch_t *) pContext->pDispatch;
+        // Stop the dispatch task before anything else; it must not be
+        // waiting on a mutex that we hold when the queue is closed
+        pDispatch->closing = true;
+        uMqttClientSetMessageCallback(pContext, NULL, NULL);
+        uPortEventQueueClose(pDispatch->eventQueueHandle);
+        pDispatch->eventQueueHandle = -1;
+        pContext->pDispatch = NULL;
+        dispatchFree(pDispatch);
+    }
+}
+
+// End of file
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2019-2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the tree of topic filters used by the
+ * subscription dispatch of the MQTT client API.  These functions are
+ * called by u_mqtt_client_dispatch.c, they are not intended for use
+ * externally.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy(), memcmp(), strcspn()
+
+#include "u_error_common.h"
+
+#include "u_port_heap.h"
+
+#include "u_mqtt_common.h"
+
+#include "u_mqtt_client_dispatch_private.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The state of a match.
+ */
+typedef struct {
+    uMqttClientDispatchMatch_t *pMatches;
+    size_t maxNumMatches;
+    size_t numMatches;
+} uMqttClientDispatchPrivateMatchState_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Return the length of the topic level at pLevel.
+static size_t levelLength(const char *pLevel)
+{
+    return strcspn(pLevel, "/");
+}
+
+// Find the child of a node that is the given level.
+static uMqttClientDispatchNode_t *pFindChild(const uMqttClientDispatchNode_t *pParent,
+                                             const char *pLevel, size_t length)
+{
+    uMqttClientDispatchNode_t *pChild = pParent->pChild;
+
+    while ((pChild != NULL) &&
+           ((pChild->levelLength != length) ||
+            (memcmp(pChild->pLevel, pLevel, length) != 0))) {
+        pChild = pChild->pNext;
+    }
+
+    return pChild;
+}
+
+// Add a node to the matches, if it is the end of a topic filter.
+static void matchAdd(uMqttClientDispatchPrivateMatchState_t *pState,
+                     const uMqttClientDispatchNode_t *pNode)
+{
+    if ((pNode != NULL) && (pNode->pCallback != NULL) &&
+        (pState->numMatches < pState->maxNumMatches)) {
+        pState->pMatches[pState->numMatches].pCallback = pNode->pCallback;
+        pState->pMatches[pState->numMatches].pCallbackParam = pNode->pCallbackParam;
+        pState->numMatches++;
+    }
+}
+
+// Collect the topic filters below the given node that match the
+// topic starting at pLevel.
+static void match(uMqttClientDispatchPrivateMatchState_t *pState,
+                  const uMqttClientDispatchNode_t *pParent,
+                  const char *pLevel, bool first)
+{
+    const uMqttClientDispatchNode_t *pChild;
+    size_t length = levelLength(pLevel);
+    bool last = (*(pLevel + length) == 0);
+    bool wildcardOk = !first || (*pLevel != '$');
+    bool isWildcard;
+
+    for (pChild = pParent->pChild; pChild != NULL; pChild = pChild->pNext) {
+        isWildcard = (pChild->levelLength == 1) &&
+                     ((*pChild->pLevel == '+') || (*pChild->pLevel == '#'));
+        if (isWildcard && (*pChild->pLevel == '#')) {
+            if (wildcardOk) {
+                matchAdd(pState, pChild);
+            }
+        } else if ((isWildcard && wildcardOk) ||
+                   ((pChild->levelLength == length) &&
+                    (memcmp(pChild->pLevel, pLevel, length) == 0))) {
+            if (last) {
+                matchAdd(pState, pChild);
+                // "a/#" also matches "a"
+                matchAdd(pState, pFindChild(pChild, "#", 1));
+            } else {
+                match(pState, pChild, pLevel + length + 1, false);
+            }
+        }
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Check that a topic filter is valid.
+bool uMqttClientDispatchPrivateFilterIsValid(const char *pFilterStr)
+{
+    bool isValid = (*pFilterStr != 0);
+    size_t length;
+
+    while (isValid) {
+        length = levelLength(pFilterStr);
+        if ((length != 1) &&
+            ((memchr(pFilterStr, '+', length) != NULL) ||
+             (memchr(pFilterStr, '#', length) != NULL))) {
+            isValid = false;
+        } else if ((length == 1) && (*pFilterStr == '#') &&
+                   (*(pFilterStr + length) != 0)) {
+            isValid = false;
+        }
+        if (*(pFilterStr + length) == 0) {
+            break;
+        }
+        pFilterStr += length + 1;
+    }
+
+    return isValid;
+}
+
+// Add a topic filter to the tree.
+int32_t uMqttClientDispatchPrivateAdd(uMqttClientDispatchNode_t *pRoot,
+                                      const char *pFilterStr,
+                                      void (*pCallback) (const char *,
+                                                         const char *,
+                                                         size_t,
+                                                         uMqttQos_t,
+                                                         void *),
+                                      void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    uMqttClientDispatchNode_t *pNode = pRoot;
+    uMqttClientDispatchNode_t *pChild;
+    size_t length;
+
+    while ((pNode != NULL) && (errorCode == 0)) {
+        length = levelLength(pFilterStr);
+        pChild = pFindChild(pNode, pFilterStr, length);
+        if (pChild == NULL) {
+            pChild = (uMqttClientDispatchNode_t *) pUPortMalloc(sizeof(*pChild) + length);
+            if (pChild != NULL) {
+                memset(pChild, 0, sizeof(*pChild));
+                memcpy(pChild + 1, pFilterStr, length);
+                pChild->pLevel = (const char *) (pChild + 1);
+                pChild->levelLength = length;
+                pChild->pNext = pNode->pChild;
+                pNode->pChild = pChild;
+            } else {
+                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            }
+        }
+        pNode = pChild;
+        if (*(pFilterStr + length) == 0) {
+            break;
+        }
+        pFilterStr += length + 1;
+    }
+
+    if (pNode != NULL) {
+        errorCode = (pNode->pCallback == NULL) ? 1 : 0;
+        pNode->pCallback = pCallback;
+        pNode->pCallbackParam = pCallbackParam;
+    }
+
+    return errorCode;
+}
+
+// Find the node that is the end of a topic filter.
+uMqttClientDispatchNode_t *pUMqttClientDispatchPrivateFind(const uMqttClientDispatchNode_t *pRoot,
+                                                           const char *pFilterStr)
+{
+    uMqttClientDispatchNode_t *pNode = NULL;
+    size_t length;
+
+    do {
+        length = levelLength(pFilterStr);
+        pNode = pFindChild(pRoot, pFilterStr, length);
+        pRoot = pNode;
+        pFilterStr += length;
+    } while ((pNode != NULL) && (*pFilterStr++ != 0));
+
+    if ((pNode != NULL) && (pNode->pCallback == NULL)) {
+        pNode = NULL;
+    }
+
+    return pNode;
+}
+
+// Remove a topic filter from the tree.
+bool uMqttClientDispatchPrivateRemove(uMqttClientDispatchNode_t *pRoot,
+                                      const char *pFilterStr)
+{
+    bool found = false;
+    uMqttClientDispatchNode_t *pChild = pRoot->pChild;
+    uMqttClientDispatchNode_t *pPrevious = NULL;
+    size_t length = levelLength(pFilterStr);
+
+    while ((pChild != NULL) &&
+           ((pChild->levelLength != length) ||
+            (memcmp(pChild->pLevel, pFilterStr, length) != 0))) {
+        pPrevious = pChild;
+        pChild = pChild->pNext;
+    }
+
+    if (pChild != NULL) {
+        if (*(pFilterStr + length) == 0) {
+            found = (pChild->pCallback != NULL);
+            pChild->pCallback = NULL;
+        } else {
+            found = uMqttClientDispatchPrivateRemove(pChild, pFilterStr + length + 1);
+        }
+        if ((pChild->pCallback == NULL) && (pChild->pChild == NULL)) {
+            if (pPrevious == NULL) {
+                pRoot->pChild = pChild->pNext;
+            } else {
+                pPrevious->pNext = pChild->pNext;
+            }
+            uPortFree(pChild);
+        }
+    }
+
+    return found;
+}
+
+// Remove all of the topic filters from the tree.
+void uMqttClientDispatchPrivateRemoveAll(uMqttClientDispatchNode_t *pRoot)
+{
+    uMqttClientDispatchNode_t *pChild = pRoot->pChild;
+    uMqttClientDispatchNode_t *pNext;
+
+    while (pChild != NULL) {
+        uMqttClientDispatchPrivateRemoveAll(pChild);
+        pNext = pChild->pNext;
+        uPortFree(pChild);
+        pChild = pNext;
+    }
+    pRoot->pChild = NULL;
+}
+
+// Find the topic filters that match a topic.
+size_t uMqttClientDispatchPrivateMatch(const uMqttClientDispatchNode_t *pRoot,
+                                       const char *pTopicNameStr,
+                                       uMqttClientDispatchMatch_t *pMatches,
+                                       size_t maxNumMatches)
+{
+    uMqttClientDispatchPrivateMatchState_t state;
+
+    state.pMatches = pMatches;
+    state.maxNumMatches = maxNumMatches;
+    state.numMatches = 0;
+    match(&state, pRoot, pTopicNameStr, true);
+
+    return state.numMatches;
+}
+
+// End of file
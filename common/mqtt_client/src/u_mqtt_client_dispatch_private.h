@@ -0,0 +1,170 @@
+/*
+ * Copyright 2019-2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _U_MQTT_CLIENT_DISPATCH_PRIVATE_H_
+#define _U_MQTT_CLIENT_DISPATCH_PRIVATE_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** @file
+ * @brief This header file defines the tree of topic filters used by
+ * the subscription dispatch of the MQTT client API.  These functions
+ * are called only inside the MQTT client, they are not intended for
+ * external use.
+ *
+ * The topic filters are held in a tree, a "trie", where each node is
+ * one level of a topic filter, e.g. the filters "a/b", "a/+" and
+ * "c/#" become:
+ *
+ * ```
+ * root -+- a -+- b
+ *       |     +- +
+ *       +- c --- #
+ * ```
+ *
+ * A node with a callback is the end of a topic filter.  The topic of
+ * a received message is matched by walking down the tree one topic
+ * level at a time, following the children which are equal to the
+ * level or are '+', and collecting any '#' child found on the way.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A node in the tree of topic filters: one level of a topic filter.
+ * The root of the tree is a node with no level, which should be
+ * zeroed before use.
+ */
+typedef struct uMqttClientDispatchNode_t {
+    struct uMqttClientDispatchNode_t *pChild; /**< the first child. */
+    struct uMqttClientDispatchNode_t *pNext;  /**< the next sibling. */
+    void (*pCallback) (const char *, const char *, size_t,
+                       uMqttQos_t, void *); /**< non-NULL if a topic
+                                                 filter ends here. */
+    void *pCallbackParam;
+    const char *pLevel;  /**< the level, not null-terminated; stored
+                              immediately after this structure. */
+    size_t levelLength;
+} uMqttClientDispatchNode_t;
+
+/** A subscription that matches a topic.
+ */
+typedef struct {
+    void (*pCallback) (const char *, const char *, size_t,
+                       uMqttQos_t, void *);
+    void *pCallbackParam;
+} uMqttClientDispatchMatch_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Check that the wildcards in a topic filter occupy whole levels
+ * and that '#' is only ever the last level.
+ *
+ * @param[in] pFilterStr the null-terminated topic filter; cannot
+ *                       be NULL.
+ * @return               true if the topic filter is valid.
+ */
+bool uMqttClientDispatchPrivateFilterIsValid(const char *pFilterStr);
+
+/** Add a topic filter to the tree, or replace the callback of an
+ * existing one.  If this fails uMqttClientDispatchPrivateRemove()
+ * should be called with the same topic filter to free any nodes
+ * that were added on the way.
+ *
+ * @param[in] pRoot          the root of the tree; cannot be NULL.
+ * @param[in] pFilterStr     the null-terminated topic filter, which
+ *                           must be valid; cannot be NULL.
+ * @param[in] pCallback      the callback; cannot be NULL.
+ * @param[in] pCallbackParam the parameter for the callback.
+ * @return                   1 if the topic filter is new, zero if it
+ *                           existed, else negative error code.
+ */
+int32_t uMqttClientDispatchPrivateAdd(uMqttClientDispatchNode_t *pRoot,
+                                      const char *pFilterStr,
+                                      void (*pCallback) (const char *,
+                                                         const char *,
+                                                         size_t,
+                                                         uMqttQos_t,
+                                                         void *),
+                                      void *pCallbackParam);
+
+/** Find the node that is the end of a topic filter.
+ *
+ * @param[in] pRoot      the root of the tree; cannot be NULL.
+ * @param[in] pFilterStr the null-terminated topic filter; cannot
+ *                       be NULL.
+ * @return               the node, NULL if the topic filter is
+ *                       not in the tree.
+ */
+uMqttClientDispatchNode_t *pUMqttClientDispatchPrivateFind(const uMqttClientDispatchNode_t *pRoot,
+                                                           const char *pFilterStr);
+
+/** Remove a topic filter from the tree, freeing any nodes left with
+ * nothing to do.
+ *
+ * @param[in] pRoot      the root of the tree; cannot be NULL.
+ * @param[in] pFilterStr the null-terminated topic filter; cannot
+ *                       be NULL.
+ * @return               true if the topic filter was found.
+ */
+bool uMqttClientDispatchPrivateRemove(uMqttClientDispatchNode_t *pRoot,
+                                      const char *pFilterStr);
+
+/** Remove all of the topic filters from the tree, freeing memory.
+ *
+ * @param[in] pRoot the root of the tree; cannot be NULL.
+ */
+void uMqttClientDispatchPrivateRemoveAll(uMqttClientDispatchNode_t *pRoot);
+
+/** Find the topic filters in the tree that match a topic.  As
+ * required by the MQTT specification, a wildcard at the first level
+ * of a topic filter does not match a topic beginning with '$'.
+ *
+ * @param[in] pRoot         the root of the tree; cannot be NULL.
+ * @param[in] pTopicNameStr the null-terminated topic; cannot be NULL.
+ * @param[out] pMatches     a place to put the callbacks of the
+ *                          matching topic filters; cannot be NULL.
+ * @param maxNumMatches     the number of entries at pMatches; any
+ *                          further matches are ignored.
+ * @return                  the number of entries written to pMatches.
+ */
+size_t uMqttClientDispatchPrivateMatch(const uMqttClientDispatchNode_t *pRoot,
+                                       const char *pTopicNameStr,
+                                       uMqttClientDispatchMatch_t *pMatches,
+                                       size_t maxNumMatches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _U_MQTT_CLIENT_DISPATCH_PRIVATE_H_
+
+// End of file
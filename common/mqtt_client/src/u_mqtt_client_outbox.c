@@ -0,0 +1,995 @@
+/*
+ * Copyright 2019-2023 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the outbox of the u-blox MQTT client API.
+ *
+ * The outbox is an append-only log of records, each of which begins
+ * with a fixed-length header:
+ *
+ * - one byte of marker: 'P' for a stored message or 'D' to record
+ *   that all messages with an ID up to and including the one in the
+ *   header have been delivered,
+ * - one byte of flags: QoS in bits 0 and 1, retain in bit 2,
+ * - four bytes of ID, little endian,
+ * - two bytes of topic length, including the null terminator,
+ *   little endian, zero for a 'D' record,
+ * - two bytes of message length, little endian, zero for a 'D' record.
+ *
+ * A 'P' record is followed by the null-terminated topic, the message
+ * and then a single commit byte, 'C'; a 'P' record that was not
+ * completely written, e.g. because power was lost, is ignored.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "stdio.h"     // snprintf()
+#include "string.h"    // memcpy(), strlen()
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+
+#include "u_device_shared.h"
+
+#include "u_port.h"
+#include "u_port_heap.h"
+#include "u_port_os.h"
+
+#include "u_mqtt_common.h"
+#include "u_mqtt_client.h"
+
+#include "u_cell_file.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The length of the header of a record in the outbox log.
+ */
+#define U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES 10
+
+/** The marker of a record that holds a stored message.
+ */
+#define U_MQTT_CLIENT_OUTBOX_MARKER_PUBLISH 'P'
+
+/** The marker of a record that holds the ID of the last
+ * message delivered.
+ */
+#define U_MQTT_CLIENT_OUTBOX_MARKER_DONE 'D'
+
+/** The byte that ends a completely-written 'P' record.
+ */
+#define U_MQTT_CLIENT_OUTBOX_COMMIT 'C'
+
+/** The maximum length of a record in the outbox log.
+ */
+#define U_MQTT_CLIENT_OUTBOX_RECORD_MAX_LENGTH_BYTES               \
+           (U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES +               \
+            U_MQTT_CLIENT_OUTBOX_TOPIC_MAX_LENGTH_BYTES +            \
+            U_MQTT_CLIENT_OUTBOX_MESSAGE_MAX_LENGTH_BYTES + 2)
+
+#if U_MQTT_CLIENT_OUTBOX_READ_BUFFER_LENGTH_BYTES < U_MQTT_CLIENT_OUTBOX_RECORD_MAX_LENGTH_BYTES
+# error U_MQTT_CLIENT_OUTBOX_READ_BUFFER_LENGTH_BYTES is too small to hold the largest record.
+#endif
+
+/** The room needed to add "/" and the ID of a stored message,
+ * a positive int32_t, to its topic, plus a null terminator.
+ */
+#define U_MQTT_CLIENT_OUTBOX_TOPIC_ID_LENGTH_BYTES 12
+
+/** How often to poke the underlying layer, while waiting for the
+ * results of publishes, so that it can time them out.
+ */
+#define U_MQTT_CLIENT_OUTBOX_POLL_INTERVAL_MS 1000
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A record decoded from the outbox log.
+ */
+typedef struct {
+    char marker;
+    uMqttQos_t qos;
+    bool retain;
+    int32_t id;
+    const char *pTopicNameStr;
+    const char *pMessage;
+    size_t messageSizeBytes;
+    size_t length; /**< the length of the whole record. */
+    bool committed;
+} uMqttClientOutboxRecord_t;
+
+/** A message from the outbox that has been handed to
+ * uMqttClientPublishAsync(), awaiting its result.
+ */
+typedef struct {
+    uint32_t seq;     /**< the sequence number of the publish. */
+    int32_t id;
+    size_t endOffset; /**< offset of the end of the record in the log. */
+    bool done;
+    int32_t errorCode;
+} uMqttClientOutboxInFlight_t;
+
+/** The results of the publishes made by the drains of an outbox.
+ * This is allocated separately from the outbox since the result
+ * of a publish may arrive after a drain has given up waiting for
+ * it, or after the outbox has been closed: such a result is
+ * ignored and, if the outbox has been closed, the last of them
+ * frees this structure.
+ */
+typedef struct {
+    uPortMutexHandle_t mutex;
+    uint32_t nextSeq;      /**< the sequence number of the next publish. */
+    size_t numOutstanding; /**< the number of callbacks yet to be called. */
+    bool closed;           /**< true if the outbox has been closed. */
+    uMqttClientOutboxInFlight_t inFlight[U_MQTT_CLIENT_OUTBOX_IN_FLIGHT_MAX_NUM];
+} uMqttClientOutboxResults_t;
+
+/** The parameter passed to the callback of a publish, allocated per
+ * publish and freed by the callback.
+ */
+typedef struct {
+    uMqttClientOutboxResults_t *pResults;
+    uint32_t seq;
+} uMqttClientOutboxTicket_t;
+
+/** An outbox, pointed-to by the pOutbox member of
+ * uMqttClientContext_t.
+ */
+typedef struct {
+    uMqttClientOutboxStorage_t storage;
+    uDeviceHandle_t devHandle; /**< for the default, cellular, storage. */
+    uPortMutexHandle_t mutex;
+    size_t maxSizeBytes;
+    size_t sizeBytes;   /**< the number of bytes written to the log. */
+    bool damaged;       /**< true if the log ends with bytes that are
+                             not a record; nothing further may be
+                             stored until the log has been erased. */
+    size_t drainOffset; /**< the offset of the first stored message not
+                             known to have been delivered. */
+    int32_t nextId;
+    int32_t doneId;     /**< the ID of the last message delivered. */
+    size_t numPending;  /**< the number of stored messages not yet delivered. */
+    bool idInTopic;     /**< true to add "/" and the ID to the topic when draining. */
+    char *pBuffer;      /**< #U_MQTT_CLIENT_OUTBOX_READ_BUFFER_LENGTH_BYTES. */
+    uMqttClientOutboxResults_t *pResults;
+} uMqttClientOutbox_t;
+
+/** The state of a drain.
+ */
+typedef struct {
+    uMqttClientContext_t *pContext;
+    size_t maxNum;
+    uint32_t firstSeq;  /**< the sequence number of the first publish. */
+    size_t numIssued;   /**< messages handed to uMqttClientPublishAsync(). */
+    size_t numResolved; /**< messages whose result has been looked at. */
+    size_t numDelivered;
+    int32_t lastDeliveredId;
+    size_t lastDeliveredOffset;
+    int32_t errorCode;  /**< the first error, if there is one. */
+} uMqttClientOutboxDrain_t;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: DEFAULT STORAGE
+ * -------------------------------------------------------------- */
+
+// Append to the outbox file on the cellular module.
+static int32_t cellFileAppend(void *pParam, const char *pData, size_t size)
+{
+    return uCellFileWrite(((uMqttClientOutbox_t *) pParam)->devHandle,
+                          U_MQTT_CLIENT_OUTBOX_FILE_NAME, pData, size);
+}
+
+// Read from the outbox file on the cellular module.
+static int32_t cellFileRead(void *pParam, char *pData, size_t offset,
+                            size_t size)
+{
+    return uCellFileBlockRead(((uMqttClientOutbox_t *) pParam)->devHandle,
+                              U_MQTT_CLIENT_OUTBOX_FILE_NAME, pData,
+                              offset, size);
+}
+
+// Get the size of the outbox file on the cellular module; a file
+// that does not exist has no size.
+static int32_t cellFileSize(void *pParam)
+{
+    int32_t size = uCellFileSize(((uMqttClientOutbox_t *) pParam)->devHandle,
+                                 U_MQTT_CLIENT_OUTBOX_FILE_NAME);
+    if (size < 0) {
+        size = 0;
+    }
+
+    return size;
+}
+
+// Erase the outbox file on the cellular module; a file that
+// does not exist is already erased.
+static int32_t cellFileErase(void *pParam)
+{
+    int32_t errorCode = uCellFileDelete(((uMqttClientOutbox_t *) pParam)->devHandle,
+                                        U_MQTT_CLIENT_OUTBOX_FILE_NAME);
+    if ((errorCode < 0) && (cellFileSize(pParam) == 0)) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: THE LOG
+ * -------------------------------------------------------------- */
+
+// Encode a record header into pBuffer.
+static void headerEncode(char *pBuffer, char marker, uMqttQos_t qos,
+                         bool retain, int32_t id, size_t topicLength,
+                         size_t messageSizeBytes)
+{
+    uint32_t x = (uint32_t) id;
+
+    pBuffer[0] = marker;
+    pBuffer[1] = (char) (((uint32_t) qos & 0x03) | (retain ? 0x04 : 0));
+    for (size_t y = 0; y < 4; y++) {
+        pBuffer[2 + y] = (char) (x >> (y * 8));
+    }
+    pBuffer[6] = (char) topicLength;
+    pBuffer[7] = (char) (topicLength >> 8);
+    pBuffer[8] = (char) messageSizeBytes;
+    pBuffer[9] = (char) (messageSizeBytes >> 8);
+}
+
+// Decode the record at the start of pData, of which size bytes are
+// available, returning the length of the record, zero if the record
+// is incomplete or negative if it is not a record.
+static int32_t recordDecode(const char *pData, size_t size,
+                            uMqttClientOutboxRecord_t *pRecord)
+{
+    int32_t length = 0;
+    const uint8_t *pBytes = (const uint8_t *) pData;
+    size_t topicLength;
+    uint32_t id = 0;
+
+    if (size >= U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES) {
+        length = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pRecord->marker = pData[0];
+        pRecord->qos = (uMqttQos_t) (pBytes[1] & 0x03);
+        pRecord->retain = ((pBytes[1] & 0x04) != 0);
+        for (size_t y = 0; y < 4; y++) {
+            id |= ((uint32_t) pBytes[2 + y]) << (y * 8);
+        }
+        pRecord->id = (int32_t) id;
+        topicLength = pBytes[6] | (((size_t) pBytes[7]) << 8);
+        pRecord->messageSizeBytes = pBytes[8] | (((size_t) pBytes[9]) << 8);
+        pRecord->pTopicNameStr = NULL;
+        pRecord->pMessage = NULL;
+        pRecord->committed = false;
+        if ((pRecord->marker == U_MQTT_CLIENT_OUTBOX_MARKER_DONE) &&
+            (topicLength == 0) && (pRecord->messageSizeBytes == 0)) {
+            length = U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES;
+            pRecord->length = (size_t) length;
+            pRecord->committed = true;
+        } else if ((pRecord->marker == U_MQTT_CLIENT_OUTBOX_MARKER_PUBLISH) &&
+                   (topicLength > 0) &&
+                   (topicLength <= U_MQTT_CLIENT_OUTBOX_TOPIC_MAX_LENGTH_BYTES + 1) &&
+                   (pRecord->messageSizeBytes > 0) &&
+                   (pRecord->messageSizeBytes <= U_MQTT_CLIENT_OUTBOX_MESSAGE_MAX_LENGTH_BYTES)) {
+            length = 0;
+            if (size >= U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES + topicLength +
+                pRecord->messageSizeBytes + 1) {
+                pRecord->pTopicNameStr = pData + U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES;
+                pRecord->pMessage = pRecord->pTopicNameStr + topicLength;
+                length = (int32_t) (U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES +
+                                    topicLength + pRecord->messageSizeBytes + 1);
+                pRecord->length = (size_t) length;
+                pRecord->committed = (pRecord->pTopicNameStr[topicLength - 1] == 0) &&
+                                     (pData[length - 1] == U_MQTT_CLIENT_OUTBOX_COMMIT);
+            }
+        }
+    }
+
+    return length;
+}
+
+// Call pFunction for each record in the log from offset onwards,
+// reading as many records from storage at a time as will fit into
+// the buffer, until pFunction returns false or there are no more
+// records; endOffset is the offset of the end of the record in the
+// log.  Returns the offset of the end of the last record passed to
+// pFunction, or negative error code.
+static int32_t forEachRecord(uMqttClientOutbox_t *pOutbox, size_t offset,
+                             bool (*pFunction) (uMqttClientOutbox_t *,
+                                                const uMqttClientOutboxRecord_t *,
+                                                size_t, void *),
+                             void *pParam)
+{
+    int32_t errorCode = 0;
+    uMqttClientOutboxRecord_t record;
+    bool keepGoing = true;
+    int32_t readSize;
+    int32_t length;
+    size_t x;
+
+    while (keepGoing && (errorCode == 0) && (offset < pOutbox->sizeBytes)) {
+        readSize = (int32_t) (pOutbox->sizeBytes - offset);
+        if (readSize > U_MQTT_CLIENT_OUTBOX_READ_BUFFER_LENGTH_BYTES) {
+            readSize = U_MQTT_CLIENT_OUTBOX_READ_BUFFER_LENGTH_BYTES;
+        }
+        readSize = pOutbox->storage.pRead(pOutbox->storage.pParam,
+                                          pOutbox->pBuffer, offset,
+                                          (size_t) readSize);
+        if (readSize >= 0) {
+            x = 0;
+            do {
+                length = recordDecode(pOutbox->pBuffer + x, readSize - x, &record);
+                if (length > 0) {
+                    x += length;
+                    keepGoing = pFunction(pOutbox, &record, offset + x, pParam);
+                }
+            } while (keepGoing && (length > 0));
+            if (x == 0) {
+                // A full buffer with no complete record in it: the
+                // rest of the log is not records
+                keepGoing = false;
+            }
+            offset += x;
+        } else {
+            errorCode = readSize;
+        }
+    }
+
+    if (errorCode == 0) {
+        errorCode = (int32_t) offset;
+    }
+
+    return errorCode;
+}
+
+// Record function for forEachRecord() to find the last ID used
+// and the last ID delivered.
+//lint -e{818} Suppress could be declared as pointing to const:
+// need to follow the function signature
+static bool scanIds(uMqttClientOutbox_t *pOutbox,
+                    const uMqttClientOutboxRecord_t *pRecord,
+                    size_t endOffset, void *pParam)
+{
+    (void) endOffset;
+    (void) pParam;
+
+    if (pRecord->id >= pOutbox->nextId) {
+        pOutbox->nextId = pRecord->id + 1;
+    }
+    if ((pRecord->marker == U_MQTT_CLIENT_OUTBOX_MARKER_DONE) &&
+        (pRecord->id > pOutbox->doneId)) {
+        pOutbox->doneId = pRecord->id;
+    }
+
+    return true;
+}
+
+// Record function for forEachRecord() to count the stored messages
+// not yet delivered, once the last ID delivered is known.
+static bool scanPending(uMqttClientOutbox_t *pOutbox,
+                        const uMqttClientOutboxRecord_t *pRecord,
+                        size_t endOffset, void *pParam)
+{
+    bool *pFirst = (bool *) pParam;
+
+    if ((pRecord->marker == U_MQTT_CLIENT_OUTBOX_MARKER_PUBLISH) &&
+        pRecord->committed && (pRecord->id > pOutbox->doneId)) {
+        if (*pFirst) {
+            pOutbox->drainOffset = endOffset - pRecord->length;
+            *pFirst = false;
+        }
+        pOutbox->numPending++;
+    }
+
+    return true;
+}
+
+// Append a record to the log from pOutbox->pBuffer.
+static int32_t append(uMqttClientOutbox_t *pOutbox, size_t length)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+    int32_t x;
+
+    x = pOutbox->storage.pAppend(pOutbox->storage.pParam, pOutbox->pBuffer, length);
+    if (x == (int32_t) length) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    } else if (x > 0) {
+        // Part of a record is now at the end of the log
+        pOutbox->damaged = true;
+    }
+    if (x > 0) {
+        pOutbox->sizeBytes += x;
+    }
+
+    return errorCode;
+}
+
+// Erase the log, leaving only a record of the last ID used so
+// that IDs continue to increment.
+static int32_t compact(uMqttClientOutbox_t *pOutbox)
+{
+    int32_t errorCode;
+
+    errorCode = pOutbox->storage.pErase(pOutbox->storage.pParam);
+    if (errorCode == 0) {
+        pOutbox->sizeBytes = 0;
+        pOutbox->damaged = false;
+        pOutbox->drainOffset = 0;
+        pOutbox->doneId = pOutbox->nextId - 1;
+        if (pOutbox->doneId > 0) {
+            headerEncode(pOutbox->pBuffer, U_MQTT_CLIENT_OUTBOX_MARKER_DONE,
+                         U_MQTT_QOS_AT_MOST_ONCE, false, pOutbox->doneId, 0, 0);
+            errorCode = append(pOutbox, U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES);
+        }
+    }
+
+    return errorCode;
+}
+
+// Store a message in the log, returning its ID.
+static int32_t store(uMqttClientOutbox_t *pOutbox, const char *pTopicNameStr,
+                     const char *pMessage, size_t messageSizeBytes,
+                     uMqttQos_t qos, bool retain)
+{
+    int32_t errorCodeOrId = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    size_t topicLength = strlen(pTopicNameStr) + 1;
+    size_t length = U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES + topicLength +
+                    messageSizeBytes + 1;
+    size_t offset = pOutbox->sizeBytes;
+
+    if ((topicLength <= U_MQTT_CLIENT_OUTBOX_TOPIC_MAX_LENGTH_BYTES + 1) &&
+        (messageSizeBytes <= U_MQTT_CLIENT_OUTBOX_MESSAGE_MAX_LENGTH_BYTES)) {
+        errorCodeOrId = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if ((pOutbox->numPending == 0) &&
+            (pOutbox->damaged || (pOutbox->sizeBytes + length > pOutbox->maxSizeBytes))) {
+            // Nothing is waiting to be sent: start afresh
+            errorCodeOrId = compact(pOutbox);
+            offset = pOutbox->sizeBytes;
+        }
+        if (errorCodeOrId == 0) {
+            errorCodeOrId = (int32_t) U_ERROR_COMMON_DEVICE_ERROR;
+            if (!pOutbox->damaged) {
+                errorCodeOrId = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                if (pOutbox->sizeBytes + length <= pOutbox->maxSizeBytes) {
+                    headerEncode(pOutbox->pBuffer, U_MQTT_CLIENT_OUTBOX_MARKER_PUBLISH,
+                                 qos, retain, pOutbox->nextId, topicLength,
+                                 messageSizeBytes);
+                    memcpy(pOutbox->pBuffer + U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES,
+                           pTopicNameStr, topicLength);
+                    memcpy(pOutbox->pBuffer + U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES +
+                           topicLength, pMessage, messageSizeBytes);
+                    *(pOutbox->pBuffer + length - 1) = U_MQTT_CLIENT_OUTBOX_COMMIT;
+                    errorCodeOrId = append(pOutbox, length);
+                    if (errorCodeOrId == 0) {
+                        if (pOutbox->numPending == 0) {
+                            pOutbox->drainOffset = offset;
+                        }
+                        pOutbox->numPending++;
+                        errorCodeOrId = pOutbox->nextId;
+                        pOutbox->nextId++;
+                    }
+                }
+            }
+        }
+    }
+
+    return errorCodeOrId;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: DRAINING
+ * -------------------------------------------------------------- */
+
+// Free the results of an outbox.
+static void resultsFree(uMqttClientOutboxResults_t *pResults)
+{
+    uPortMutexDelete(pResults->mutex);
+    uPortFree(pResults);
+}
+
+// Record the result of the publish with sequence number seq,
+// provided that it is still being waited for; must be called
+// with the mutex of pResults locked.
+static void resultSet(uMqttClientOutboxResults_t *pResults, uint32_t seq,
+                      int32_t errorCode)
+{
+    uMqttClientOutboxInFlight_t *pInFlight;
+
+    pInFlight = &(pResults->inFlight[seq % U_MQTT_CLIENT_OUTBOX_IN_FLIGHT_MAX_NUM]);
+    if (!pResults->closed && (pInFlight->seq == seq)) {
+        pInFlight->errorCode = errorCode;
+        pInFlight->done = true;
+    }
+}
+
+// Callback for uMqttClientPublishAsync().
+static void publishCallback(int32_t token, int32_t errorCode, void *pParam)
+{
+    uMqttClientOutboxTicket_t *pTicket = (uMqttClientOutboxTicket_t *) pParam;
+    uMqttClientOutboxResults_t *pResults = pTicket->pResults;
+    bool freeResults;
+
+    (void) token;
+
+    U_PORT_MUTEX_LOCK(pResults->mutex);
+
+    // If the drain has given up on this publish its slot will
+    // since have been re-used, or will be, under a different
+    // sequence number, hence a late result is ignored
+    resultSet(pResults, pTicket->seq, errorCode);
+    pResults->numOutstanding--;
+    freeResults = pResults->closed && (pResults->numOutstanding == 0);
+
+    U_PORT_MUTEX_UNLOCK(pResults->mutex);
+
+    if (freeResults) {
+        // The outbox has been closed and this was the last result
+        resultsFree(pResults);
+    }
+    uPortFree(pTicket);
+}
+
+// Look at the results that have arrived, in order, returning
+// true if any have.
+static bool settle(uMqttClientOutbox_t *pOutbox, uMqttClientOutboxDrain_t *pDrain)
+{
+    uMqttClientOutboxResults_t *pResults = pOutbox->pResults;
+    uMqttClientOutboxInFlight_t *pInFlight;
+    bool progress = false;
+    bool done = true;
+
+    U_PORT_MUTEX_LOCK(pResults->mutex);
+
+    while ((pDrain->numResolved < pDrain->numIssued) && done) {
+        pInFlight = &(pResults->inFlight[(pDrain->firstSeq + pDrain->numResolved) %
+                                         U_MQTT_CLIENT_OUTBOX_IN_FLIGHT_MAX_NUM]);
+        done = pInFlight->done;
+        if (done) {
+            if ((pInFlight->errorCode == 0) && (pDrain->errorCode == 0)) {
+                // Delivery only counts up to the first failure
+                pDrain->numDelivered++;
+                pDrain->lastDeliveredId = pInFlight->id;
+                pDrain->lastDeliveredOffset = pInFlight->endOffset;
+            } else if (pDrain->errorCode == 0) {
+                pDrain->errorCode = pInFlight->errorCode;
+            }
+            pDrain->numResolved++;
+            progress = true;
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pResults->mutex);
+
+    return progress;
+}
+
+// Wait until no more than numOutstanding results are awaited,
+// returning false on timeout.
+static bool waitResults(uMqttClientOutbox_t *pOutbox, uMqttClientOutboxDrain_t *pDrain,
+                        size_t numOutstanding)
+{
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    int32_t pollTimeMs = startTimeMs;
+
+    settle(pOutbox, pDrain);
+    while ((pDrain->numIssued - pDrain->numResolved > numOutstanding) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000)) {
+        uPortTaskBlock(10);
+        if (settle(pOutbox, pDrain)) {
+            startTimeMs = uPortGetTickTimeMs();
+        }
+        if (uPortGetTickTimeMs() - pollTimeMs > U_MQTT_CLIENT_OUTBOX_POLL_INTERVAL_MS) {
+            // This lets the underlying layer time out a result
+            // that is never going to come
+            uMqttClientGetPublishInFlight(pDrain->pContext);
+            pollTimeMs = uPortGetTickTimeMs();
+        }
+    }
+
+    return (pDrain->numIssued - pDrain->numResolved <= numOutstanding);
+}
+
+// Record function for forEachRecord() to publish the stored messages
+// not yet delivered.
+static bool drainRecord(uMqttClientOutbox_t *pOutbox,
+                        const uMqttClientOutboxRecord_t *pRecord,
+                        size_t endOffset, void *pParam)
+{
+    uMqttClientOutboxDrain_t *pDrain = (uMqttClientOutboxDrain_t *) pParam;
+    uMqttClientOutboxResults_t *pResults = pOutbox->pResults;
+    uMqttClientOutboxInFlight_t *pInFlight;
+    uMqttClientOutboxTicket_t *pTicket = NULL;
+    const char *pTopicNameStr = pRecord->pTopicNameStr;
+    char topicNameWithId[U_MQTT_CLIENT_OUTBOX_TOPIC_MAX_LENGTH_BYTES +
+                         U_MQTT_CLIENT_OUTBOX_TOPIC_ID_LENGTH_BYTES];
+    uint32_t seq = pDrain->firstSeq + (uint32_t) pDrain->numIssued;
+    int32_t x = (int32_t) U_ERROR_COMMON_TIMEOUT;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    bool keepGoing = true;
+
+    if ((pRecord->marker == U_MQTT_CLIENT_OUTBOX_MARKER_PUBLISH) &&
+        pRecord->committed && (pRecord->id > pOutbox->doneId)) {
+        if (pOutbox->idInTopic) {
+            // So that the far end can discard a message that is
+            // sent again after a restart part way through a drain
+            snprintf(topicNameWithId, sizeof(topicNameWithId), "%s/%d",
+                     pRecord->pTopicNameStr, pRecord->id);
+            pTopicNameStr = topicNameWithId;
+        }
+        pInFlight = &(pResults->inFlight[seq % U_MQTT_CLIENT_OUTBOX_IN_FLIGHT_MAX_NUM]);
+        // Wait for room here, then keep trying while the window
+        // underneath is full
+        while (keepGoing &&
+               waitResults(pOutbox, pDrain, U_MQTT_CLIENT_OUTBOX_IN_FLIGHT_MAX_NUM - 1) &&
+               (pDrain->errorCode == 0)) {
+            x = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            if (pTicket == NULL) {
+                pTicket = (uMqttClientOutboxTicket_t *) pUPortMalloc(sizeof(*pTicket));
+            }
+            if (pTicket != NULL) {
+                pTicket->pResults = pResults;
+                pTicket->seq = seq;
+
+                U_PORT_MUTEX_LOCK(pResults->mutex);
+                pInFlight->seq = seq;
+                pInFlight->id = pRecord->id;
+                pInFlight->endOffset = endOffset;
+                pInFlight->done = false;
+                // Counted before the publish since the callback
+                // may be called before it returns
+                pResults->numOutstanding++;
+                U_PORT_MUTEX_UNLOCK(pResults->mutex);
+
+                x = uMqttClientPublishAsync(pDrain->pContext, pTopicNameStr,
+                                            pRecord->pMessage, pRecord->messageSizeBytes,
+                                            pRecord->qos, pRecord->retain,
+                                            publishCallback, pTicket);
+                if (x >= 0) {
+                    // The ticket now belongs to the callback
+                    pTicket = NULL;
+                } else {
+                    // No callback is coming
+                    U_PORT_MUTEX_LOCK(pResults->mutex);
+                    pResults->numOutstanding--;
+                    U_PORT_MUTEX_UNLOCK(pResults->mutex);
+                    if (x == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+                        // No pipelining underneath, publish one at a time
+                        x = uMqttClientPublish(pDrain->pContext, pTopicNameStr,
+                                               pRecord->pMessage,
+                                               pRecord->messageSizeBytes,
+                                               pRecord->qos, pRecord->retain);
+                        U_PORT_MUTEX_LOCK(pResults->mutex);
+                        resultSet(pResults, seq, x);
+                        U_PORT_MUTEX_UNLOCK(pResults->mutex);
+                        x = 0;
+                    }
+                }
+            }
+            keepGoing = (x == (int32_t) U_ERROR_COMMON_BUSY) &&
+                        (uPortGetTickTimeMs() - startTimeMs <
+                         U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
+            if (keepGoing) {
+                if (pDrain->numIssued > pDrain->numResolved) {
+                    waitResults(pOutbox, pDrain,
+                                pDrain->numIssued - pDrain->numResolved - 1);
+                } else {
+                    uPortTaskBlock(100);
+                }
+            }
+        }
+        uPortFree(pTicket);
+        if (x >= 0) {
+            pDrain->numIssued++;
+        } else if (pDrain->errorCode == 0) {
+            pDrain->errorCode = x;
+        }
+    }
+
+    return (pDrain->errorCode == 0) &&
+           ((pDrain->maxNum == 0) || (pDrain->numIssued < pDrain->maxNum));
+}
+
+// Send up to maxNum stored messages, zero meaning no limit.
+static int32_t drain(uMqttClientContext_t *pContext, uMqttClientOutbox_t *pOutbox,
+                     size_t maxNum)
+{
+    int32_t errorCodeOrNum;
+    uMqttClientOutboxDrain_t state = {0};
+
+    state.pContext = pContext;
+    state.maxNum = maxNum;
+    state.firstSeq = pOutbox->pResults->nextSeq;
+
+    errorCodeOrNum = forEachRecord(pOutbox, pOutbox->drainOffset,
+                                   drainRecord, &state);
+    if (!waitResults(pOutbox, &state, 0) && (state.errorCode == 0)) {
+        state.errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+    }
+    // Sequence numbers are never re-used, hence any result still
+    // to come for this drain will be ignored
+    pOutbox->pResults->nextSeq = state.firstSeq + (uint32_t) state.numIssued;
+    if (state.numDelivered > 0) {
+        // Record what has been delivered, once for the lot
+        pOutbox->doneId = state.lastDeliveredId;
+        pOutbox->drainOffset = state.lastDeliveredOffset;
+        pOutbox->numPending -= state.numDelivered;
+        if (pOutbox->numPending == 0) {
+            compact(pOutbox);
+        } else {
+            headerEncode(pOutbox->pBuffer, U_MQTT_CLIENT_OUTBOX_MARKER_DONE,
+                         U_MQTT_QOS_AT_MOST_ONCE, false, pOutbox->doneId, 0, 0);
+            append(pOutbox, U_MQTT_CLIENT_OUTBOX_HEADER_LENGTH_BYTES);
+        }
+        errorCodeOrNum = (int32_t) state.numDelivered;
+    } else if (errorCodeOrNum >= 0) {
+        errorCodeOrNum = state.errorCode;
+    }
+
+    return errorCodeOrNum;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Open an outbox.
+int32_t uMqttClientOutboxOpen(uMqttClientContext_t *pContext,
+                              const uMqttClientOutboxStorage_t *pStorage,
+                              size_t maxSizeBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientOutbox_t *pOutbox;
+    int32_t x;
+    bool first = true;
+
+    if ((pContext != NULL) &&
+        ((pStorage != NULL) || U_DEVICE_IS_TYPE(pContext->devHandle, U_DEVICE_TYPE_CELL))) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (pContext->pOutbox == NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pOutbox = (uMqttClientOutbox_t *) pUPortMalloc(sizeof(*pOutbox));
+            if (pOutbox != NULL) {
+                memset(pOutbox, 0, sizeof(*pOutbox));
+                pOutbox->devHandle = pContext->devHandle;
+                if (pStorage != NULL) {
+                    pOutbox->storage = *pStorage;
+                } else {
+                    pOutbox->storage.pAppend = cellFileAppend;
+                    pOutbox->storage.pRead = cellFileRead;
+                    pOutbox->storage.pSize = cellFileSize;
+                    pOutbox->storage.pErase = cellFileErase;
+                    pOutbox->storage.pParam = pOutbox;
+                }
+                pOutbox->maxSizeBytes = maxSizeBytes;
+                if (pOutbox->maxSizeBytes == 0) {
+                    pOutbox->maxSizeBytes = U_MQTT_CLIENT_OUTBOX_SIZE_MAX_BYTES;
+                }
+                pOutbox->nextId = 1;
+                pOutbox->pBuffer = (char *) pUPortMalloc(
+                                       U_MQTT_CLIENT_OUTBOX_READ_BUFFER_LENGTH_BYTES);
+                pOutbox->pResults = (uMqttClientOutboxResults_t *) pUPortMalloc(
+                                        sizeof(*(pOutbox->pResults)));
+                if (pOutbox->pResults != NULL) {
+                    memset(pOutbox->pResults, 0, sizeof(*(pOutbox->pResults)));
+                    if (uPortMutexCreate(&(pOutbox->pResults->mutex)) != 0) {
+                        uPortFree(pOutbox->pResults);
+                        pOutbox->pResults = NULL;
+                    }
+                }
+                if ((pOutbox->pBuffer != NULL) && (pOutbox->pResults != NULL) &&
+                    (uPortMutexCreate(&(pOutbox->mutex)) == 0)) {
+                    // Find out what the log already holds
+                    errorCode = pOutbox->storage.pSize(pOutbox->storage.pParam);
+                    if (errorCode >= 0) {
+                        pOutbox->sizeBytes = (size_t) errorCode;
+                        errorCode = forEachRecord(pOutbox, 0, scanIds, NULL);
+                    }
+                    if (errorCode >= 0) {
+                        x = errorCode;
+                        errorCode = forEachRecord(pOutbox, 0, scanPending, &first);
+                        if ((errorCode >= 0) && (x < (int32_t) pOutbox->sizeBytes)) {
+                            // The log ends with something that is not
+                            // a record, e.g. power was lost part way
+                            // through an append
+                            pOutbox->damaged = true;
+                            if (pOutbox->numPending == 0) {
+                                errorCode = compact(pOutbox);
+                            }
+                        }
+                    }
+                    if (errorCode >= 0) {
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        pContext->pOutbox = pOutbox;
+                    } else {
+                        uPortMutexDelete(pOutbox->mutex);
+                    }
+                }
+                if (pContext->pOutbox == NULL) {
+                    if (pOutbox->pResults != NULL) {
+                        resultsFree(pOutbox->pResults);
+                    }
+                    uPortFree(pOutbox->pBuffer);
+                    uPortFree(pOutbox);
+                }
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Close an outbox.
+void uMqttClientOutboxClose(uMqttClientContext_t *pContext)
+{
+    uMqttClientOutbox_t *pOutbox;
+    uMqttClientOutboxResults_t *pResults;
+    bool freeResults;
+
+    if ((pContext != NULL) && (pContext->pOutbox != NULL)) {
+        pOutbox = (uMqttClientOutbox_t *) pContext->pOutbox;
+        // Make sure no-one is in the middle of using it
+        U_PORT_MUTEX_LOCK(pOutbox->mutex);
+        pContext->pOutbox = NULL;
+        U_PORT_MUTEX_UNLOCK(pOutbox->mutex);
+        // Detach the results from any callbacks still to come:
+        // the last of them will free the results
+        pResults = pOutbox->pResults;
+        U_PORT_MUTEX_LOCK(pResults->mutex);
+        pResults->closed = true;
+        freeResults = (pResults->numOutstanding == 0);
+        U_PORT_MUTEX_UNLOCK(pResults->mutex);
+        if (freeResults) {
+            resultsFree(pResults);
+        }
+        uPortMutexDelete(pOutbox->mutex);
+        uPortFree(pOutbox->pBuffer);
+        uPortFree(pOutbox);
+    }
+}
+
+// Publish a message through the outbox.
+int32_t uMqttClientOutboxPublish(uMqttClientContext_t *pContext,
+                                 const char *pTopicNameStr,
+                                 const char *pMessage,
+                                 size_t messageSizeBytes,
+                                 uMqttQos_t qos, bool retain)
+{
+    int32_t errorCodeOrId = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientOutbox_t *pOutbox;
+    bool connected;
+    bool stored;
+
+    if ((pContext != NULL) && (pTopicNameStr != NULL) &&
+        (pMessage != NULL) && (messageSizeBytes > 0)) {
+        errorCodeOrId = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+        pOutbox = (uMqttClientOutbox_t *) pContext->pOutbox;
+        if (pOutbox != NULL) {
+
+            U_PORT_MUTEX_LOCK(pOutbox->mutex);
+
+            connected = uMqttClientIsConnected(pContext);
+            stored = (pOutbox->numPending > 0);
+            errorCodeOrId = (int32_t) U_ERROR_COMMON_UNKNOWN;
+            if (connected && !stored) {
+                // Nothing to keep in order with, just send it
+                errorCodeOrId = uMqttClientPublish(pContext, pTopicNameStr,
+                                                   pMessage, messageSizeBytes,
+                                                   qos, retain);
+            }
+            if (errorCodeOrId != 0) {
+                errorCodeOrId = store(pOutbox, pTopicNameStr, pMessage,
+                                      messageSizeBytes, qos, retain);
+                if ((errorCodeOrId > 0) && connected && stored) {
+                    drain(pContext, pOutbox, U_MQTT_CLIENT_OUTBOX_DRAIN_BATCH_NUM);
+                }
+            }
+
+            U_PORT_MUTEX_UNLOCK(pOutbox->mutex);
+        }
+    }
+
+    return errorCodeOrId;
+}
+
+// Set whether the ID of a stored message is added to its topic.
+int32_t uMqttClientOutboxSetIdInTopic(uMqttClientContext_t *pContext,
+                                      bool idInTopic)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientOutbox_t *pOutbox;
+
+    if (pContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+        pOutbox = (uMqttClientOutbox_t *) pContext->pOutbox;
+        if (pOutbox != NULL) {
+
+            U_PORT_MUTEX_LOCK(pOutbox->mutex);
+
+            pOutbox->idInTopic = idInTopic;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+            U_PORT_MUTEX_UNLOCK(pOutbox->mutex);
+        }
+    }
+
+    return errorCode;
+}
+
+// Send the messages stored in the outbox.
+int32_t uMqttClientOutboxDrain(uMqttClientContext_t *pContext,
+                               size_t maxNum)
+{
+    int32_t errorCodeOrNum = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientOutbox_t *pOutbox;
+
+    if (pContext != NULL) {
+        errorCodeOrNum = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+        pOutbox = (uMqttClientOutbox_t *) pContext->pOutbox;
+        if (pOutbox != NULL) {
+
+            U_PORT_MUTEX_LOCK(pOutbox->mutex);
+
+            errorCodeOrNum = 0;
+            if (pOutbox->numPending > 0) {
+                errorCodeOrNum = drain(pContext, pOutbox, maxNum);
+            }
+
+            U_PORT_MUTEX_UNLOCK(pOutbox->mutex);
+        }
+    }
+
+    return errorCodeOrNum;
+}
+
+// Get the number of messages in the outbox.
+int32_t uMqttClientOutboxGetNum(const uMqttClientContext_t *pContext)
+{
+    int32_t errorCodeOrNum = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uMqttClientOutbox_t *pOutbox;
+
+    if (pContext != NULL) {
+        errorCodeOrNum = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+        pOutbox = (uMqttClientOutbox_t *) pContext->pOutbox;
+        if (pOutbox != NULL) {
+
+            U_PORT_MUTEX_LOCK(pOutbox->mutex);
+
+            errorCodeOrNum = (int32_t) pOutbox->numPending;
+
+            U_PORT_MUTEX_UNLOCK(pOutbox->mutex);
+        }
+    }
+
+    return errorCodeOrNum;
+}
+
+// End of file
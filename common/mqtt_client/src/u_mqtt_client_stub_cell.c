@@ -39,6 +39,7 @@
 #include "u_error_common.h"
 #include "u_device.h"
 #include "u_cell_mqtt.h"
+#include "u_cell_file.h"
 
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
@@ -186,6 +187,39 @@ U_WEAK int32_t uCellMqttPublish(uDeviceHandle_t cellHandle,
     return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
 }
 
+U_WEAK int32_t uCellMqttPublishAsync(uDeviceHandle_t cellHandle,
+                                     const char *pTopicNameStr,
+                                     const char *pMessage,
+                                     size_t messageSizeBytes,
+                                     uCellMqttQos_t qos, bool retain,
+                                     void (*pCallback) (int32_t, int32_t, void *),
+                                     void *pCallbackParam)
+{
+    (void) cellHandle;
+    (void) pTopicNameStr;
+    (void) pMessage;
+    (void) messageSizeBytes;
+    (void) qos;
+    (void) retain;
+    (void) pCallback;
+    (void) pCallbackParam;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+U_WEAK int32_t uCellMqttSetPublishWindow(uDeviceHandle_t cellHandle,
+                                         size_t windowSize)
+{
+    (void) cellHandle;
+    (void) windowSize;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+U_WEAK int32_t uCellMqttGetPublishInFlight(uDeviceHandle_t cellHandle)
+{
+    (void) cellHandle;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
 U_WEAK int32_t uCellMqttSubscribe(uDeviceHandle_t cellHandle,
                                   const char *pTopicFilterStr,
                                   uCellMqttQos_t maxQos)
@@ -219,6 +253,16 @@ U_WEAK int32_t uCellMqttMessageRead(uDeviceHandle_t cellHandle,
     return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
 }
 
+U_WEAK int32_t uCellMqttMessageReadBulk(uDeviceHandle_t cellHandle,
+                                        uCellMqttMessage_t *pMessages,
+                                        size_t numMessages)
+{
+    (void) cellHandle;
+    (void) pMessages;
+    (void) numMessages;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
 U_WEAK bool uCellMqttSnIsSupported(uDeviceHandle_t cellHandle)
 {
     (void) cellHandle;
@@ -322,4 +366,46 @@ U_WEAK int32_t uCellMqttSnSetWillParameters(uDeviceHandle_t cellHandle,
     return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
 }
 
+U_WEAK int32_t uCellFileWrite(uDeviceHandle_t cellHandle,
+                              const char *pFileName,
+                              const char *pData,
+                              size_t dataSize)
+{
+    (void) cellHandle;
+    (void) pFileName;
+    (void) pData;
+    (void) dataSize;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+U_WEAK int32_t uCellFileBlockRead(uDeviceHandle_t cellHandle,
+                                  const char *pFileName,
+                                  char *pData,
+                                  size_t offset,
+                                  size_t dataSize)
+{
+    (void) cellHandle;
+    (void) pFileName;
+    (void) pData;
+    (void) offset;
+    (void) dataSize;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+U_WEAK int32_t uCellFileSize(uDeviceHandle_t cellHandle,
+                             const char *pFileName)
+{
+    (void) cellHandle;
+    (void) pFileName;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+U_WEAK int32_t uCellFileDelete(uDeviceHandle_t cellHandle,
+                               const char *pFileName)
+{
+    (void) cellHandle;
+    (void) pFileName;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
 // End of file
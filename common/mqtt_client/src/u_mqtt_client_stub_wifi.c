@@ -120,6 +120,40 @@ U_WEAK int32_t uWifiMqttPublish(const uMqttClientContext_t *pContext,
     return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
 }
 
+U_WEAK int32_t uWifiMqttPublishAsync(const uMqttClientContext_t *pContext,
+                                     const char *pTopicNameStr,
+                                     const char *pMessage,
+                                     size_t messageSizeBytes,
+                                     uMqttQos_t qos,
+                                     bool retain,
+                                     void (*pCallback) (int32_t, int32_t, void *),
+                                     void *pCallbackParam)
+{
+    (void) pContext;
+    (void) pTopicNameStr;
+    (void) pMessage;
+    (void) messageSizeBytes;
+    (void) qos;
+    (void) retain;
+    (void) pCallback;
+    (void) pCallbackParam;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+U_WEAK int32_t uWifiMqttSetPublishWindow(const uMqttClientContext_t *pContext,
+                                         size_t windowSize)
+{
+    (void) pContext;
+    (void) windowSize;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+U_WEAK int32_t uWifiMqttGetPublishInFlight(const uMqttClientContext_t *pContext)
+{
+    (void) pContext;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
 U_WEAK int32_t uWifiMqttSubscribe(const uMqttClientContext_t *pContext,
                                   const char *pTopicFilterStr,
                                   uMqttQos_t maxQos)
@@ -68,6 +68,9 @@
 #include "u_security.h"     // For uSecurityGetSerialNumber()
 
 #include "u_mqtt_client.h"
+#include "u_mqtt_client_dispatch_private.h"
+
+#include "u_cell_file.h"    // For uCellFileDelete()
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -129,6 +132,38 @@
 # define U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES 126
 #endif
 
+#ifndef U_MQTT_CLIENT_TEST_PUBLISH_ASYNC_NUM
+/** The number of messages to publish with uMqttClientPublishAsync(),
+ * which is also used as the publish window.
+ */
+# define U_MQTT_CLIENT_TEST_PUBLISH_ASYNC_NUM 4
+#endif
+
+#ifndef U_MQTT_CLIENT_TEST_READ_BULK_NUM
+/** The number of messages to read with uMqttClientMessageReadBulk().
+ */
+# define U_MQTT_CLIENT_TEST_READ_BULK_NUM 2
+#endif
+
+#ifndef U_MQTT_CLIENT_TEST_READ_BULK_LENGTH_BYTES
+/** The length of each message read with uMqttClientMessageReadBulk().
+ */
+# define U_MQTT_CLIENT_TEST_READ_BULK_LENGTH_BYTES 16
+#endif
+
+#ifndef U_MQTT_CLIENT_TEST_OUTBOX_NUM
+/** The number of messages to store in the outbox while there
+ * is no connection.
+ */
+# define U_MQTT_CLIENT_TEST_OUTBOX_NUM 3
+#endif
+
+#ifndef U_MQTT_CLIENT_TEST_OUTBOX_STORAGE_LENGTH_BYTES
+/** The size of the RAM storage used for the outbox.
+ */
+# define U_MQTT_CLIENT_TEST_OUTBOX_STORAGE_LENGTH_BYTES 1024
+#endif
+
 #ifndef U_MQTT_CLIENT_TEST_READ_MESSAGE_MAX_LENGTH_BYTES
 /** Maximum length for reading a message from the broker.
  */
@@ -139,6 +174,15 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A topic and the topic filters in gpDispatchTreeFilter[] that
+ * it should match.
+ */
+typedef struct {
+    const char *pTopicNameStr;
+    uint32_t filterBitMap; /**< bit n set if gpDispatchTreeFilter[n]
+                                should match. */
+} uMqttClientTestDispatchTopic_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -171,6 +215,78 @@ static bool gDisconnectCallbackCalled;
  */
 static int32_t gNumUnread;
 
+/** The number of results received by publishAsyncCallback().
+ */
+static volatile int32_t gPublishAsyncNumResults;
+
+/** The number of results received by publishAsyncCallback()
+ * that were errors.
+ */
+static volatile int32_t gPublishAsyncNumErrors;
+
+/** The number of messages passed to dispatchCallback().
+ */
+static volatile int32_t gDispatchNumReceived;
+
+/** The length of the last message passed to dispatchCallback().
+ */
+static volatile size_t gDispatchMessageSizeBytes;
+
+/** RAM storage for the outbox.
+ */
+static char gOutboxStorage[U_MQTT_CLIENT_TEST_OUTBOX_STORAGE_LENGTH_BYTES];
+
+/** The number of bytes in gOutboxStorage.
+ */
+static size_t gOutboxStorageSize = 0;
+
+/** Topic filters that are not valid.
+ */
+static const char *const gpDispatchTreeFilterInvalid[] = {"", "a/#/b", "#/a", "a+",
+                                                          "+a/b", "a/b#"
+                                                         };
+
+/** Topic filters to put in the tree of subscriptions.
+ */
+static const char *const gpDispatchTreeFilter[] = {"a/b/c",   // 0
+                                                   "+/b/c",   // 1
+                                                   "a/+/c",   // 2
+                                                   "a/b/+",   // 3
+                                                   "a/#",     // 4
+                                                   "#",       // 5
+                                                   "+/+",     // 6
+                                                   "a/b/#",   // 7
+                                                   "$SYS/#",  // 8
+                                                   "+/+/+/+"  // 9
+                                                  };
+
+/** Topics and which of gpDispatchTreeFilter[] they should match.
+ */
+static const uMqttClientTestDispatchTopic_t gDispatchTreeTopic[] = {
+    {"a/b/c",   (1U << 0) | (1U << 1) | (1U << 2) | (1U << 3) | (1U << 4) | (1U << 5) | (1U << 7)},
+    {"x/b/c",   (1U << 1) | (1U << 5)},
+    {"a/x/c",   (1U << 2) | (1U << 4) | (1U << 5)},
+    {"a//c",    (1U << 2) | (1U << 4) | (1U << 5)},
+    {"a/b/x",   (1U << 3) | (1U << 4) | (1U << 5) | (1U << 7)},
+    // "a/#" matches "a", "a/b/#" matches "a/b"
+    {"a/b",     (1U << 4) | (1U << 5) | (1U << 6) | (1U << 7)},
+    {"a",       (1U << 4) | (1U << 5)},
+    {"a/b/c/d", (1U << 4) | (1U << 5) | (1U << 7) | (1U << 9)},
+    {"x/y/z/w", (1U << 5) | (1U << 9)},
+    {"b",       (1U << 5)},
+    // A wildcard at the first level does not match '$'
+    {"$SYS/x",  (1U << 8)},
+    {"$SYS",    (1U << 8)},
+    // ...but '$' elsewhere is nothing special
+    {"x/$y",    (1U << 5) | (1U << 6)}
+};
+
+/** A count of the calls to dispatchTreeCallback(), one for
+ * each entry in gpDispatchTreeFilter[].
+ */
+static int32_t gDispatchTreeNumCalls[sizeof(gpDispatchTreeFilter) /
+                                     sizeof(gpDispatchTreeFilter[0])];
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -259,10 +375,200 @@ static void disconnectCallback(int32_t errorCode, void *pParam)
 
     gDisconnectCallbackCalled = true;
 }
+
+// Callback for the results of uMqttClientPublishAsync().
+static void publishAsyncCallback(int32_t token, int32_t errorCode, void *pParam)
+{
+    (void) pParam;
+
+#if !U_CFG_OS_CLIB_LEAKS
+    // Only print stuff if the C library isn't going to leak
+    U_TEST_PRINT_LINE_MQTT("publish with token %d completed with %d.",
+                           token, errorCode);
+#else
+    (void) token;
+#endif
+
+    if (errorCode != 0) {
+        gPublishAsyncNumErrors++;
+    }
+    gPublishAsyncNumResults++;
+}
+
+// Callback for a subscription made with uMqttClientDispatchSubscribe().
+static void dispatchCallback(const char *pTopicNameStr, const char *pMessage,
+                             size_t messageSizeBytes, uMqttQos_t qos,
+                             void *pParam)
+{
+    (void) pMessage;
+    (void) qos;
+
+    if (strcmp(pTopicNameStr, (const char *) pParam) == 0) {
+        gDispatchMessageSizeBytes = messageSizeBytes;
+        gDispatchNumReceived++;
+    }
+}
+
+// Callback for the topic filters in the tree test: pParam points
+// to the entry in gDispatchTreeNumCalls[] for the topic filter.
+static void dispatchTreeCallback(const char *pTopicNameStr, const char *pMessage,
+                                 size_t messageSizeBytes, uMqttQos_t qos,
+                                 void *pParam)
+{
+    (void) pTopicNameStr;
+    (void) pMessage;
+    (void) messageSizeBytes;
+    (void) qos;
+
+    (*((int32_t *) pParam))++;
+}
+
+// Call the callbacks of the topic filters in the tree that match
+// pTopicNameStr and check that exactly those in filterBitMap were
+// called, once each.
+static bool dispatchTreeCheck(const uMqttClientDispatchNode_t *pRoot,
+                              const char *pTopicNameStr, uint32_t filterBitMap)
+{
+    uMqttClientDispatchMatch_t match[(sizeof(gpDispatchTreeFilter) /
+                                      sizeof(gpDispatchTreeFilter[0])) + 1];
+    size_t numMatches;
+    bool success = true;
+
+    memset(gDispatchTreeNumCalls, 0, sizeof(gDispatchTreeNumCalls));
+    numMatches = uMqttClientDispatchPrivateMatch(pRoot, pTopicNameStr, match,
+                                                 sizeof(match) / sizeof(match[0]));
+    for (size_t x = 0; x < numMatches; x++) {
+        match[x].pCallback(pTopicNameStr, "", 0, U_MQTT_QOS_AT_MOST_ONCE,
+                           match[x].pCallbackParam);
+    }
+    for (size_t x = 0; x < sizeof(gDispatchTreeNumCalls) / sizeof(gDispatchTreeNumCalls[0]); x++) {
+        if (gDispatchTreeNumCalls[x] != (((filterBitMap >> x) & 1) ? 1 : 0)) {
+            U_TEST_PRINT_LINE_MQTT("topic \"%s\": topic filter \"%s\" called %d"
+                                   " time(s).", pTopicNameStr, gpDispatchTreeFilter[x],
+                                   gDispatchTreeNumCalls[x]);
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+// Append to the RAM storage of the outbox.
+static int32_t outboxAppend(void *pParam, const char *pData, size_t size)
+{
+    (void) pParam;
+
+    if (size > sizeof(gOutboxStorage) - gOutboxStorageSize) {
+        size = sizeof(gOutboxStorage) - gOutboxStorageSize;
+    }
+    memcpy(gOutboxStorage + gOutboxStorageSize, pData, size);
+    gOutboxStorageSize += size;
+
+    return (int32_t) size;
+}
+
+// Read from the RAM storage of the outbox.
+static int32_t outboxRead(void *pParam, char *pData, size_t offset, size_t size)
+{
+    (void) pParam;
+
+    if (offset > gOutboxStorageSize) {
+        offset = gOutboxStorageSize;
+    }
+    if (size > gOutboxStorageSize - offset) {
+        size = gOutboxStorageSize - offset;
+    }
+    memcpy(pData, gOutboxStorage + offset, size);
+
+    return (int32_t) size;
+}
+
+// Get the size of the RAM storage of the outbox.
+static int32_t outboxSize(void *pParam)
+{
+    (void) pParam;
+
+    return (int32_t) gOutboxStorageSize;
+}
+
+// Erase the RAM storage of the outbox.
+static int32_t outboxErase(void *pParam)
+{
+    (void) pParam;
+
+    gOutboxStorageSize = 0;
+
+    return 0;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
 
+/** Test the tree of topic filters behind uMqttClientDispatchSubscribe():
+ * no connection is required for this.
+ */
+U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClientDispatchTree")
+{
+    int32_t heapUsed;
+    uMqttClientDispatchNode_t root;
+
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    for (size_t x = 0; x < sizeof(gpDispatchTreeFilterInvalid) /
+         sizeof(gpDispatchTreeFilterInvalid[0]); x++) {
+        U_PORT_TEST_ASSERT(!uMqttClientDispatchPrivateFilterIsValid(
+                               gpDispatchTreeFilterInvalid[x]));
+    }
+
+    memset(&root, 0, sizeof(root));
+    for (size_t x = 0; x < sizeof(gpDispatchTreeFilter) / sizeof(gpDispatchTreeFilter[0]); x++) {
+        U_PORT_TEST_ASSERT(uMqttClientDispatchPrivateFilterIsValid(gpDispatchTreeFilter[x]));
+        U_PORT_TEST_ASSERT(uMqttClientDispatchPrivateAdd(&root, gpDispatchTreeFilter[x],
+                                                         dispatchTreeCallback,
+                                                         &(gDispatchTreeNumCalls[x])) == 1);
+    }
+    // Adding again replaces the callback
+    U_PORT_TEST_ASSERT(uMqttClientDispatchPrivateAdd(&root, gpDispatchTreeFilter[0],
+                                                     dispatchTreeCallback,
+                                                     &(gDispatchTreeNumCalls[0])) == 0);
+    // "a/b" is on the way to topic filters but is not one
+    U_PORT_TEST_ASSERT(pUMqttClientDispatchPrivateFind(&root, "a/b") == NULL);
+    U_PORT_TEST_ASSERT(pUMqttClientDispatchPrivateFind(&root, "a/#") != NULL);
+
+    for (size_t x = 0; x < sizeof(gDispatchTreeTopic) / sizeof(gDispatchTreeTopic[0]); x++) {
+        U_PORT_TEST_ASSERT(dispatchTreeCheck(&root, gDispatchTreeTopic[x].pTopicNameStr,
+                                             gDispatchTreeTopic[x].filterBitMap));
+    }
+
+    // Remove "a/#" and check that it is no longer matched while
+    // "a/b/#", which shares its first level, still is
+    U_PORT_TEST_ASSERT(uMqttClientDispatchPrivateRemove(&root, "a/#"));
+    U_PORT_TEST_ASSERT(!uMqttClientDispatchPrivateRemove(&root, "a/#"));
+    U_PORT_TEST_ASSERT(!uMqttClientDispatchPrivateRemove(&root, "a/b"));
+    U_PORT_TEST_ASSERT(pUMqttClientDispatchPrivateFind(&root, "a/#") == NULL);
+    U_PORT_TEST_ASSERT(dispatchTreeCheck(&root, "a", 1U << 5));
+    U_PORT_TEST_ASSERT(dispatchTreeCheck(&root, "a/b",
+                                         (1U << 5) | (1U << 6) | (1U << 7)));
+
+    uMqttClientDispatchPrivateRemoveAll(&root);
+    U_PORT_TEST_ASSERT(root.pChild == NULL);
+
+    uPortDeinit();
+
+#ifndef __XTENSA__
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE_MQTT("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+#else
+    (void) heapUsed;
+#endif
+}
+
 /** Test MQTT connectivity with deliberately minimal option set.
  */
 U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
@@ -273,6 +579,11 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
     int32_t heapXxxSecurityInitLoss = 0;
     uMqttClientConnection_t connection = U_MQTT_CLIENT_CONNECTION_DEFAULT;
     uSecurityTlsSettings_t tlsSettings = U_SECURITY_TLS_SETTINGS_DEFAULT;
+    uMqttClientOutboxStorage_t outboxStorage = {outboxAppend, outboxRead,
+                                                outboxSize, outboxErase, NULL
+                                               };
+    const uMqttClientOutboxStorage_t *pOutboxStorage;
+    size_t outboxRecordLength;
     int32_t y;
     int32_t z;
     size_t s;
@@ -282,6 +593,7 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
     char *pMessageOut;
     char *pMessageIn;
     uMqttQos_t qos;
+    uMqttClientMessage_t bulk[U_MQTT_CLIENT_TEST_READ_BULK_NUM + 1];
 
     // In case a previous test failed
     uNetworkTestCleanUp();
@@ -356,6 +668,59 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
 
                 U_PORT_TEST_ASSERT(!uMqttClientIsConnected(gpMqttContextA));
 
+                // Store some messages in an outbox while there is no
+                // connection, in a log just big enough to hold them;
+                // on cellular the first run uses the default storage,
+                // a file on the module, the rest use RAM storage
+                pOutboxStorage = &outboxStorage;
+                if ((pTmp->networkType == U_NETWORK_TYPE_CELL) && (run == 0)) {
+                    pOutboxStorage = NULL;
+                    // In case a previous test failed
+                    uCellFileDelete(devHandle, U_MQTT_CLIENT_OUTBOX_FILE_NAME);
+                }
+                U_TEST_PRINT_LINE_MQTT("storing %d message(s) in the outbox, %s storage...",
+                                       U_MQTT_CLIENT_TEST_OUTBOX_NUM,
+                                       pOutboxStorage == NULL ? "file" : "RAM");
+                gOutboxStorageSize = 0;
+                U_PORT_TEST_ASSERT(uMqttClientOutboxSetIdInTopic(gpMqttContextA, true) ==
+                                   (int32_t) U_ERROR_COMMON_NOT_INITIALISED);
+                // Header of 10 bytes, topic, message and commit byte
+                outboxRecordLength = 10 + strlen(pTopicOut) + 1 + sizeof(gSendData) - 1 + 1;
+                U_PORT_TEST_ASSERT(uMqttClientOutboxOpen(gpMqttContextA, pOutboxStorage,
+                                                         outboxRecordLength *
+                                                         U_MQTT_CLIENT_TEST_OUTBOX_NUM) == 0);
+                for (z = 0; z < U_MQTT_CLIENT_TEST_OUTBOX_NUM; z++) {
+                    y = uMqttClientOutboxPublish(gpMqttContextA, pTopicOut, gSendData,
+                                                 sizeof(gSendData) - 1,
+                                                 U_MQTT_QOS_AT_LEAST_ONCE, false);
+                    U_PORT_TEST_ASSERT(y == z + 1);
+                }
+                // The log is now full
+                y = uMqttClientOutboxPublish(gpMqttContextA, pTopicOut, gSendData,
+                                             sizeof(gSendData) - 1,
+                                             U_MQTT_QOS_AT_LEAST_ONCE, false);
+                U_PORT_TEST_ASSERT(y == (int32_t) U_ERROR_COMMON_NO_MEMORY);
+                U_PORT_TEST_ASSERT(uMqttClientOutboxGetNum(gpMqttContextA) ==
+                                   U_MQTT_CLIENT_TEST_OUTBOX_NUM);
+                // Check that they survive the outbox being closed and opened again
+                uMqttClientOutboxClose(gpMqttContextA);
+                if (pOutboxStorage != NULL) {
+                    // As if power was lost part way through storing
+                    // another message, copying the start of the last
+                    // one to the end of the log: the partial record
+                    // must be ignored
+                    memcpy(gOutboxStorage + gOutboxStorageSize,
+                           gOutboxStorage + gOutboxStorageSize - outboxRecordLength,
+                           outboxRecordLength / 2);
+                    gOutboxStorageSize += outboxRecordLength / 2;
+                }
+                U_PORT_TEST_ASSERT(uMqttClientOutboxOpen(gpMqttContextA, pOutboxStorage, 0) == 0);
+                U_PORT_TEST_ASSERT(uMqttClientOutboxGetNum(gpMqttContextA) ==
+                                   U_MQTT_CLIENT_TEST_OUTBOX_NUM);
+                // Send the ID of each stored message in its topic, as
+                // the far end would need to discard duplicates
+                U_PORT_TEST_ASSERT(uMqttClientOutboxSetIdInTopic(gpMqttContextA, true) == 0);
+
                 if (noTls) {
                     connection.pBrokerNameStr = U_PORT_STRINGIFY_QUOTED(U_MQTT_CLIENT_TEST_MQTT_BROKER_URL);
 #ifdef U_MQTT_CLIENT_TEST_MQTT_USERNAME
@@ -392,6 +757,8 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
                     uMqttClientGetLastErrorCode(gpMqttContextA);
                     U_PORT_TEST_ASSERT(uMqttClientIsConnected(gpMqttContextA));
                     U_PORT_TEST_ASSERT(!gDisconnectCallbackCalled);
+                    // Connecting sends what was stored in the outbox
+                    U_PORT_TEST_ASSERT(uMqttClientOutboxGetNum(gpMqttContextA) == 0);
 
                     // Set the message indication callback
                     U_PORT_TEST_ASSERT(uMqttClientSetMessageCallback(gpMqttContextA,
@@ -518,6 +885,51 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
                     U_TEST_PRINT_LINE_MQTT("attempting to read a message when there are none returned %d.", y);
                     U_PORT_TEST_ASSERT(y == (int32_t) U_ERROR_COMMON_EMPTY);
 
+                    // Send two short messages and read them back in one go
+                    U_TEST_PRINT_LINE_MQTT("publishing %d message(s) to read in bulk...",
+                                           U_MQTT_CLIENT_TEST_READ_BULK_NUM);
+                    for (z = 0; z < U_MQTT_CLIENT_TEST_READ_BULK_NUM; z++) {
+                        gStopTimeMs = uPortGetTickTimeMs() +
+                                      (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
+                        y = uMqttClientPublish(gpMqttContextA, pTopicOut, pMessageOut + z,
+                                               U_MQTT_CLIENT_TEST_READ_BULK_LENGTH_BYTES,
+                                               U_MQTT_QOS_AT_LEAST_ONCE, false);
+                        U_PORT_TEST_ASSERT(y == 0);
+                    }
+                    startTimeMs = uPortGetTickTimeMs();
+                    while ((uMqttClientGetUnread(gpMqttContextA) <
+                            U_MQTT_CLIENT_TEST_READ_BULK_NUM) &&
+                           (uPortGetTickTimeMs() < startTimeMs +
+                            (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000))) {
+                        uPortTaskBlock(100);
+                    }
+                    // One more element than there are messages; the topics
+                    // are the same so they can share a buffer
+                    for (z = 0; z < U_MQTT_CLIENT_TEST_READ_BULK_NUM + 1; z++) {
+                        bulk[z].pTopicNameStr = pTopicIn;
+                        bulk[z].topicNameSizeBytes =
+                            U_MQTT_CLIENT_TEST_READ_TOPIC_MAX_LENGTH_BYTES;
+                        bulk[z].pMessage = pMessageIn +
+                                           (z * U_MQTT_CLIENT_TEST_READ_BULK_LENGTH_BYTES);
+                        bulk[z].messageSizeBytes = U_MQTT_CLIENT_TEST_READ_BULK_LENGTH_BYTES;
+                        bulk[z].errorCode = -1;
+                    }
+                    y = uMqttClientMessageReadBulk(gpMqttContextA, bulk,
+                                                   U_MQTT_CLIENT_TEST_READ_BULK_NUM + 1);
+                    U_TEST_PRINT_LINE_MQTT("read %d message(s) in bulk.", y);
+                    U_PORT_TEST_ASSERT(y == U_MQTT_CLIENT_TEST_READ_BULK_NUM);
+                    for (z = 0; z < U_MQTT_CLIENT_TEST_READ_BULK_NUM; z++) {
+                        U_PORT_TEST_ASSERT(bulk[z].errorCode == 0);
+                        U_PORT_TEST_ASSERT(bulk[z].messageSizeBytes ==
+                                           U_MQTT_CLIENT_TEST_READ_BULK_LENGTH_BYTES);
+                        U_PORT_TEST_ASSERT(memcmp(bulk[z].pMessage, pMessageOut + z,
+                                                  U_MQTT_CLIENT_TEST_READ_BULK_LENGTH_BYTES) == 0);
+                    }
+                    U_PORT_TEST_ASSERT(strcmp(pTopicIn, pTopicOut) == 0);
+                    U_PORT_TEST_ASSERT(bulk[U_MQTT_CLIENT_TEST_READ_BULK_NUM].errorCode == -1);
+                    U_PORT_TEST_ASSERT(uMqttClientMessageReadBulk(gpMqttContextA, bulk, 1) ==
+                                       (int32_t) U_ERROR_COMMON_EMPTY);
+
                     // Cancel the subscribe
                     U_TEST_PRINT_LINE_MQTT("unsubscribing from topic \"%s\"...", pTopicOut);
                     gStopTimeMs = uPortGetTickTimeMs() +
@@ -528,6 +940,92 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
                     U_PORT_TEST_ASSERT(uMqttClientSetMessageCallback(gpMqttContextA,
                                                                      NULL, NULL) == 0);
 
+                    // Publish a window's worth of messages without waiting
+                    U_TEST_PRINT_LINE_MQTT("publishing %d message(s) asynchronously...",
+                                           U_MQTT_CLIENT_TEST_PUBLISH_ASYNC_NUM);
+                    U_PORT_TEST_ASSERT(uMqttClientSetPublishWindow(gpMqttContextA, 0) < 0);
+                    y = uMqttClientSetPublishWindow(gpMqttContextA,
+                                                    U_MQTT_CLIENT_TEST_PUBLISH_ASYNC_NUM);
+                    U_PORT_TEST_ASSERT(y == 0);
+                    gPublishAsyncNumResults = 0;
+                    gPublishAsyncNumErrors = 0;
+                    startTimeMs = uPortGetTickTimeMs();
+                    for (z = 0; z < U_MQTT_CLIENT_TEST_PUBLISH_ASYNC_NUM; z++) {
+                        y = uMqttClientPublishAsync(gpMqttContextA, pTopicOut, pMessageOut,
+                                                    U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES,
+                                                    U_MQTT_QOS_AT_LEAST_ONCE, false,
+                                                    publishAsyncCallback, NULL);
+                        U_PORT_TEST_ASSERT(y >= 0);
+                    }
+                    while ((gPublishAsyncNumResults < U_MQTT_CLIENT_TEST_PUBLISH_ASYNC_NUM) &&
+                           (uPortGetTickTimeMs() < startTimeMs +
+                            (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000))) {
+                        uPortTaskBlock(100);
+                    }
+                    U_TEST_PRINT_LINE_MQTT("%d result(s), %d error(s), after %d ms.",
+                                           gPublishAsyncNumResults, gPublishAsyncNumErrors,
+                                           (int32_t) (uPortGetTickTimeMs() - startTimeMs));
+                    U_PORT_TEST_ASSERT(gPublishAsyncNumResults ==
+                                       U_MQTT_CLIENT_TEST_PUBLISH_ASYNC_NUM);
+                    U_PORT_TEST_ASSERT(gPublishAsyncNumErrors == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientGetPublishInFlight(gpMqttContextA) == 0);
+
+                    // Check that what connecting sent from the outbox,
+                    // including the partial record, is gone for good:
+                    // nothing is sent again after the outbox is re-opened
+                    U_TEST_PRINT_LINE_MQTT("checking that the outbox is empty...");
+                    uMqttClientOutboxClose(gpMqttContextA);
+                    U_PORT_TEST_ASSERT(uMqttClientOutboxOpen(gpMqttContextA,
+                                                             pOutboxStorage, 0) == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientOutboxGetNum(gpMqttContextA) == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientOutboxDrain(gpMqttContextA, 0) == 0);
+                    if (pOutboxStorage != NULL) {
+                        // Only the record of the last ID used is left
+                        U_PORT_TEST_ASSERT(gOutboxStorageSize < outboxRecordLength);
+                    }
+
+                    // Subscribe with a callback and check that a message
+                    // arrives at it without being read
+                    U_TEST_PRINT_LINE_MQTT("subscribing to \"%s\" with a callback...", pTopicOut);
+                    gDispatchNumReceived = 0;
+                    gStopTimeMs = uPortGetTickTimeMs() +
+                                  (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
+                    U_PORT_TEST_ASSERT(uMqttClientDispatchSubscribe(gpMqttContextA, "a/#/b",
+                                                                    U_MQTT_QOS_AT_LEAST_ONCE,
+                                                                    dispatchCallback,
+                                                                    pTopicOut) < 0);
+                    y = uMqttClientDispatchSubscribe(gpMqttContextA, pTopicOut,
+                                                     U_MQTT_QOS_AT_LEAST_ONCE,
+                                                     dispatchCallback, pTopicOut);
+                    U_PORT_TEST_ASSERT(y >= 0);
+                    startTimeMs = uPortGetTickTimeMs();
+                    gStopTimeMs = startTimeMs +
+                                  (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
+                    y = uMqttClientPublish(gpMqttContextA, pTopicOut, pMessageOut,
+                                           U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES,
+                                           U_MQTT_QOS_AT_LEAST_ONCE, false);
+                    U_PORT_TEST_ASSERT(y == 0);
+                    while ((gDispatchNumReceived == 0) &&
+                           (uPortGetTickTimeMs() < startTimeMs +
+                            (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000))) {
+                        uPortTaskBlock(100);
+                    }
+                    U_TEST_PRINT_LINE_MQTT("%d message(s) dispatched after %d ms.",
+                                           gDispatchNumReceived,
+                                           (int32_t) (uPortGetTickTimeMs() - startTimeMs));
+                    U_PORT_TEST_ASSERT(gDispatchNumReceived == 1);
+                    U_PORT_TEST_ASSERT(gDispatchMessageSizeBytes ==
+                                       U_MQTT_CLIENT_TEST_PUBLISH_MAX_LENGTH_BYTES);
+                    U_PORT_TEST_ASSERT(uMqttClientGetUnread(gpMqttContextA) == 0);
+                    gStopTimeMs = uPortGetTickTimeMs() +
+                                  (U_MQTT_CLIENT_RESPONSE_WAIT_SECONDS * 1000);
+                    U_PORT_TEST_ASSERT(uMqttClientDispatchUnsubscribe(gpMqttContextA,
+                                                                      pTopicOut) == 0);
+                    U_PORT_TEST_ASSERT(uMqttClientDispatchUnsubscribe(gpMqttContextA,
+                                                                      pTopicOut) ==
+                                       (int32_t) U_ERROR_COMMON_NOT_FOUND);
+                    uMqttClientDispatchClose(gpMqttContextA);
+
                     // Disconnect MQTT
                     U_TEST_PRINT_LINE_MQTT("disconnecting from \"%s\"...", connection.pBrokerNameStr);
                     U_PORT_TEST_ASSERT(!gDisconnectCallbackCalled);
@@ -556,6 +1054,9 @@ U_PORT_TEST_FUNCTION("[mqttClient]", "mqttClient")
                 uMqttClientClose(gpMqttContextA);
                 gpMqttContextA = NULL;
                 uPortEventQueueCleanUp();
+                if (pOutboxStorage == NULL) {
+                    uCellFileDelete(devHandle, U_MQTT_CLIENT_OUTBOX_FILE_NAME);
+                }
             }
             U_TEST_PRINT_LINE_MQTT("taking down %s...",
                                    gpUNetworkTestTypeName[pTmp->networkType]);
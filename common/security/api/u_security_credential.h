@@ -124,6 +124,25 @@ typedef struct {
     int64_t expirationUtc;
 } uSecurityCredential_t;
 
+/** An entry in a manifest of security credentials, as passed to
+ * uSecurityCredentialSync().
+ */
+typedef struct {
+    /** The type of the credential. */
+    uSecurityCredentialType_t type;
+    /** The null-terminated name of the credential, maximum length
+        #U_SECURITY_CREDENTIAL_NAME_MAX_LENGTH_BYTES. */
+    const char *pName;
+    /** The X.509 certificate or security key, PEM or DER format,
+        as would be passed to uSecurityCredentialStore(). */
+    const char *pContents;
+    /** The number of bytes at pContents. */
+    size_t size;
+    /** The null-terminated password for a PKCS8 encrypted private
+        key, NULL if there is none. */
+    const char *pPassword;
+} uSecurityCredentialManifestEntry_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -367,6 +386,39 @@ int32_t uSecurityCredentialRemove(uDeviceHandle_t devHandle,
                                   uSecurityCredentialType_t type,
                                   const char *pName);
 
+/** Make sure that the X.509 certificates and security keys stored
+ * in the module match a manifest, writing only those that are
+ * missing or different; this is intended to be called at every
+ * boot in place of calling uSecurityCredentialStore() for each
+ * credential, in which case usually nothing will need to be written.
+ *
+ * The credentials stored in the module are listed once and, for each
+ * manifest entry that is present, the MD5 hash of the stored credential
+ * (see uSecurityCredentialGetHash()) is compared with an MD5 hash
+ * calculated locally from the DER form of the manifest entry; a PEM
+ * format entry is converted to DER for this purpose.  An entry that has
+ * a password is always written since its stored form cannot be
+ * predicted.  Note that some u-blox modules may convert a security key
+ * in ways that mean its local and stored hashes can never match, in
+ * which case the key will also always be written: this is safe, it just
+ * doesn't save any time.
+ *
+ * This function is not thread-safe in the same way as
+ * uSecurityCredentialListFirst().
+ *
+ * @param devHandle      the handle of the instance to be used,
+ *                       for example obtained using uDeviceOpen().
+ * @param[in] pManifest  a pointer to the manifest, an array of
+ *                       numEntries entries; may only be NULL if
+ *                       numEntries is zero.
+ * @param numEntries     the number of entries at pManifest.
+ * @return               on success the number of credentials that
+ *                       had to be written, else negative error code.
+ */
+int32_t uSecurityCredentialSync(uDeviceHandle_t devHandle,
+                                const uSecurityCredentialManifestEntry_t *pManifest,
+                                size_t numEntries);
+
 #ifdef __cplusplus
 }
 #endif
@@ -52,6 +52,8 @@
 
 #include "u_at_client.h"
 
+#include "u_base64.h"
+
 #include "u_device_shared.h"
 
 #include "u_cell_module_type.h"
@@ -76,6 +78,14 @@
  */
 #define U_SECURITY_CREDENTIAL_EXPIRATION_DATE_LENGTH_BYTES 19
 
+/** The block length of an MD5 calculation.
+ */
+#define U_SECURITY_CREDENTIAL_MD5_BLOCK_LENGTH_BYTES 64
+
+/** The string that begins the header line of a PEM-format credential.
+ */
+#define U_SECURITY_CREDENTIAL_PEM_HEADER_START "-----BEGIN "
+
 // Do some cross-checking
 #if U_SECURITY_CREDENTIAL_TYPE_LENGTH_BYTES > U_SECURITY_CREDENTIAL_EXPIRATION_DATE_LENGTH_BYTES
 #error U_SECURITY_CREDENTIAL_TYPE_LENGTH_BYTES  is greater than U_SECURITY_CREDENTIAL_EXPIRATION_DATE_LENGTH_BYTES, check code below
@@ -101,6 +111,14 @@ typedef struct {
     uSecurityCredentialType_t type;
 } uSecuritCredentialTypeStr_t;
 
+/** Context for a local MD5 calculation.
+ */
+typedef struct {
+    uint32_t state[4];
+    uint64_t lengthBytes;
+    uint8_t block[U_SECURITY_CREDENTIAL_MD5_BLOCK_LENGTH_BYTES];
+} uSecurityCredentialMd5_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -121,6 +139,34 @@ static const uSecuritCredentialTypeStr_t gTypeStr[] = {
     {"PU", U_SECURITY_CREDENTIAL_SIGNATURE_VERIFICATION_KEY_PUBLIC}
 };
 
+/** The per-round additive constants of MD5, from RFC 1321.
+ */
+static const uint32_t gMd5K[] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+    0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+    0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+    0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+    0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+    0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+/** The per-round shift amounts of MD5, from RFC 1321, four
+ * for each of the four rounds.
+ */
+static const uint8_t gMd5Shift[] = {7, 12, 17, 22, 5, 9, 14, 20,
+                                    4, 11, 16, 23, 6, 10, 15, 21
+                                   };
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -317,6 +363,171 @@ static size_t stripWhitespace(char *pString, size_t stringLength)
     return newLength;
 }
 
+// Process one block of an MD5 calculation.
+static void md5Block(uint32_t *pState, const uint8_t *pBlock)
+{
+    uint32_t m[U_SECURITY_CREDENTIAL_MD5_BLOCK_LENGTH_BYTES / 4];
+    uint32_t a = pState[0];
+    uint32_t b = pState[1];
+    uint32_t c = pState[2];
+    uint32_t d = pState[3];
+    uint32_t f;
+    uint32_t shift;
+    size_t g;
+
+    // The message words are little-endian
+    for (size_t x = 0; x < sizeof(m) / sizeof(m[0]); x++) {
+        m[x] = ((uint32_t) pBlock[x * 4]) |
+               (((uint32_t) pBlock[(x * 4) + 1]) << 8) |
+               (((uint32_t) pBlock[(x * 4) + 2]) << 16) |
+               (((uint32_t) pBlock[(x * 4) + 3]) << 24);
+    }
+
+    for (size_t x = 0; x < sizeof(gMd5K) / sizeof(gMd5K[0]); x++) {
+        if (x < 16) {
+            f = (b & c) | (~b & d);
+            g = x;
+        } else if (x < 32) {
+            f = (d & b) | (~d & c);
+            g = ((x * 5) + 1) % 16;
+        } else if (x < 48) {
+            f = b ^ c ^ d;
+            g = ((x * 3) + 5) % 16;
+        } else {
+            f = c ^ (b | ~d);
+            g = (x * 7) % 16;
+        }
+        f += a + gMd5K[x] + m[g];
+        a = d;
+        d = c;
+        c = b;
+        shift = gMd5Shift[((x / 16) * 4) + (x % 4)];
+        b += (f << shift) | (f >> (32 - shift));
+    }
+
+    pState[0] += a;
+    pState[1] += b;
+    pState[2] += c;
+    pState[3] += d;
+}
+
+// Start a local MD5 calculation.
+static void md5Init(uSecurityCredentialMd5_t *pMd5)
+{
+    pMd5->state[0] = 0x67452301;
+    pMd5->state[1] = 0xefcdab89;
+    pMd5->state[2] = 0x98badcfe;
+    pMd5->state[3] = 0x10325476;
+    pMd5->lengthBytes = 0;
+}
+
+// Add data to a local MD5 calculation.
+static void md5Update(uSecurityCredentialMd5_t *pMd5,
+                      const char *pData, size_t length)
+{
+    size_t offset;
+
+    while (length > 0) {
+        offset = (size_t) (pMd5->lengthBytes % sizeof(pMd5->block));
+        pMd5->block[offset] = (uint8_t) *pData;
+        pMd5->lengthBytes++;
+        if (offset == sizeof(pMd5->block) - 1) {
+            md5Block(pMd5->state, pMd5->block);
+        }
+        pData++;
+        length--;
+    }
+}
+
+// Complete a local MD5 calculation, writing
+// U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES to pOutput.
+static void md5Finish(uSecurityCredentialMd5_t *pMd5, char *pOutput)
+{
+    uint64_t lengthBits = pMd5->lengthBytes * 8;
+    char c = (char) 0x80;
+    char lengthLittleEndian[8];
+
+    // Pad with 0x80 then zeroes up to the point where the
+    // length in bits, little-endian, will complete a block
+    md5Update(pMd5, &c, 1);
+    c = 0;
+    while ((pMd5->lengthBytes % sizeof(pMd5->block)) !=
+           sizeof(pMd5->block) - sizeof(lengthLittleEndian)) {
+        md5Update(pMd5, &c, 1);
+    }
+    for (size_t x = 0; x < sizeof(lengthLittleEndian); x++) {
+        lengthLittleEndian[x] = (char) (lengthBits >> (x * 8));
+    }
+    md5Update(pMd5, lengthLittleEndian, sizeof(lengthLittleEndian));
+
+    for (size_t x = 0; x < U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES; x++) {
+        *pOutput = (char) (pMd5->state[x / 4] >> ((x % 4) * 8));
+        pOutput++;
+    }
+}
+
+// Return true if the given character is in the base 64 alphabet,
+// including the pad character.
+static bool isBase64(char c)
+{
+    return ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z')) ||
+           ((c >= '0') && (c <= '9')) || (c == '+') || (c == '/') ||
+           (c == '=');
+}
+
+// Calculate the MD5 hash of a credential in DER format, which is
+// how the module stores it and hence what it hashes: a DER-format
+// credential is hashed as it is while, for a PEM-format credential,
+// the base 64 between the header and tail lines is decoded, four
+// characters at a time, as it is hashed, so no extra storage is
+// required.  Returns false if the PEM-format credential contains
+// anything unexpected (e.g. encryption header fields).
+static bool credentialMd5(const char *pContents, size_t size, char *pMd5)
+{
+    bool success = true;
+    uSecurityCredentialMd5_t md5;
+    size_t headerLength = strlen(U_SECURITY_CREDENTIAL_PEM_HEADER_START);
+    char quad[4];
+    size_t quadLength = 0;
+    char bin[3];
+    int32_t binLength;
+
+    md5Init(&md5);
+    if ((size > headerLength) &&
+        (memcmp(pContents, U_SECURITY_CREDENTIAL_PEM_HEADER_START, headerLength) == 0)) {
+        // Skip the header line
+        while ((size > 0) && (*pContents != '\n')) {
+            pContents++;
+            size--;
+        }
+        // Decode up to the start of the tail line
+        while ((size > 0) && (*pContents != '-') && success) {
+            if (isBase64(*pContents)) {
+                quad[quadLength] = *pContents;
+                quadLength++;
+                if (quadLength == sizeof(quad)) {
+                    binLength = uBase64Decode(quad, sizeof(quad), bin, sizeof(bin));
+                    md5Update(&md5, bin, (size_t) binLength);
+                    quadLength = 0;
+                }
+            } else if (!isspace((int32_t) (uint8_t) *pContents)) {
+                success = false;
+            }
+            pContents++;
+            size--;
+        }
+        success = success && (size > 0) && (quadLength == 0);
+    } else {
+        md5Update(&md5, pContents, size);
+    }
+
+    if (success) {
+        md5Finish(&md5, pMd5);
+    }
+
+    return success;
+}
+
 // Store an X.509 certificate or security key from buffer or file.
 static int32_t securityCredentialStoreOrImport(uDeviceHandle_t devHandle,
                                                uSecurityCredentialType_t type,
@@ -701,4 +912,79 @@ int32_t uSecurityCredentialRemove(uDeviceHandle_t devHandle,
     return errorCode;
 }
 
+// Make sure that the stored credentials match a manifest.
+int32_t uSecurityCredentialSync(uDeviceHandle_t devHandle,
+                                const uSecurityCredentialManifestEntry_t *pManifest,
+                                size_t numEntries)
+{
+    uAtClientHandle_t atHandle;
+    int32_t errorCodeOrCount = getAtClient(devHandle, &atHandle);
+    uSecurityCredential_t credential;
+    bool *pStored = NULL;
+    const uSecurityCredentialManifestEntry_t *pEntry;
+    char md5Local[U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES];
+    char md5Stored[U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES];
+    int32_t count = 0;
+
+    if (errorCodeOrCount == 0) {
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if ((pManifest != NULL) || (numEntries == 0)) {
+            errorCodeOrCount = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (numEntries > 0) {
+                errorCodeOrCount = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                pStored = (bool *) pUPortMalloc(numEntries * sizeof(bool));
+            }
+            if (pStored != NULL) {
+                errorCodeOrCount = (int32_t) U_ERROR_COMMON_SUCCESS;
+                memset(pStored, false, numEntries * sizeof(bool));
+                // One pass through the list of stored credentials
+                // to find out which of the manifest entries are
+                // present; if the list can't be read, or is empty,
+                // then everything will be written
+                for (int32_t x = uSecurityCredentialListFirst(devHandle, &credential);
+                     x >= 0;
+                     x = uSecurityCredentialListNext(devHandle, &credential)) {
+                    pEntry = pManifest;
+                    for (size_t y = 0; y < numEntries; y++) {
+                        if ((pEntry->type == credential.type) && (pEntry->pName != NULL) &&
+                            (strcmp(pEntry->pName, credential.name) == 0)) {
+                            pStored[y] = true;
+                        }
+                        pEntry++;
+                    }
+                }
+                // Now write whatever is missing or different
+                pEntry = pManifest;
+                for (size_t x = 0; (x < numEntries) && (errorCodeOrCount == 0); x++) {
+                    // If it is already there and the same there
+                    // is nothing to do
+                    if (!pStored[x] || (pEntry->pPassword != NULL) ||
+                        (pEntry->pContents == NULL) ||
+                        !credentialMd5(pEntry->pContents, pEntry->size, md5Local) ||
+                        (uSecurityCredentialGetHash(devHandle, pEntry->type,
+                                                    pEntry->pName, md5Stored) != 0) ||
+                        (memcmp(md5Local, md5Stored, sizeof(md5Local)) != 0)) {
+                        errorCodeOrCount = uSecurityCredentialStore(devHandle, pEntry->type,
+                                                                    pEntry->pName,
+                                                                    pEntry->pContents,
+                                                                    pEntry->size,
+                                                                    pEntry->pPassword,
+                                                                    NULL);
+                        if (errorCodeOrCount == 0) {
+                            count++;
+                        }
+                    }
+                    pEntry++;
+                }
+                uPortFree(pStored);
+                if (errorCodeOrCount == 0) {
+                    errorCodeOrCount = count;
+                }
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
 // End of file
@@ -32,7 +32,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // strcmp()
+#include "string.h"    // strcmp(), memcpy(), memcmp()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_app_platform_specific.h"
@@ -216,6 +216,8 @@ U_PORT_TEST_FUNCTION("[securityCredential]", "securityCredentialTest")
     int32_t z;
     char hash[U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES];
     char buffer[U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES];
+    char certHash[U_SECURITY_CREDENTIAL_MD5_LENGTH_BYTES];
+    uSecurityCredentialManifestEntry_t manifestEntry = {0};
 
     // In case a previous test failed
     uNetworkTestCleanUp();
@@ -292,6 +294,19 @@ U_PORT_TEST_FUNCTION("[securityCredential]", "securityCredentialTest")
         for (size_t y = 0; y < sizeof(buffer); y++) {
             U_PORT_TEST_ASSERT((uint8_t) buffer[y] == hash[y]);
         }
+        // Keep it for the sync checks below
+        memcpy(certHash, hash, sizeof(certHash));
+
+        // Syncing to a manifest containing the same certificate
+        // should need no writes
+        U_TEST_PRINT_LINE_X("syncing certificate...", x);
+        manifestEntry.type = U_SECURITY_CREDENTIAL_CLIENT_X509;
+        manifestEntry.pName = "ubxlib_test_cert";
+        manifestEntry.pContents = (const char *) gUSecurityCredentialTestClientX509Pem;
+        manifestEntry.size = gUSecurityCredentialTestClientX509PemSize;
+        z = uSecurityCredentialSync(devHandle, &manifestEntry, 1);
+        U_TEST_PRINT_LINE_X("%d credential(s) written.", x, z);
+        U_PORT_TEST_ASSERT(z == 0);
 
         // Check that the certificate is listed
         U_TEST_PRINT_LINE_X("listing credentials...", x);
@@ -516,6 +531,60 @@ U_PORT_TEST_FUNCTION("[securityCredential]", "securityCredentialTest")
                                                      U_SECURITY_CREDENTIAL_CLIENT_KEY_PRIVATE,
                                                      "ubxlib_test_key") == 0);
 
+        // Syncing to a manifest containing the certificate, which
+        // is now missing, should write it and it should then have
+        // the same hash as when it was first stored
+        U_TEST_PRINT_LINE_X("syncing missing certificate...", x);
+        manifestEntry.type = U_SECURITY_CREDENTIAL_CLIENT_X509;
+        manifestEntry.pName = "ubxlib_test_cert";
+        manifestEntry.pContents = (const char *) gUSecurityCredentialTestClientX509Pem;
+        manifestEntry.size = gUSecurityCredentialTestClientX509PemSize;
+        z = uSecurityCredentialSync(devHandle, &manifestEntry, 1);
+        U_TEST_PRINT_LINE_X("%d credential(s) written.", x, z);
+        U_PORT_TEST_ASSERT(z == 1);
+        U_PORT_TEST_ASSERT(uSecurityCredentialGetHash(devHandle,
+                                                      U_SECURITY_CREDENTIAL_CLIENT_X509,
+                                                      "ubxlib_test_cert",
+                                                      buffer) == 0);
+        U_PORT_TEST_ASSERT(memcmp(buffer, certHash, sizeof(buffer)) == 0);
+
+        // Give the same name different contents: it should be
+        // written once and then match, i.e. the MD5 hash calculated
+        // locally from the PEM must agree with that of the module
+        U_TEST_PRINT_LINE_X("syncing different certificate...", x);
+        manifestEntry.pContents = (const char *) gUSecurityCredentialTestRootCaX509Pem;
+        manifestEntry.size = gUSecurityCredentialTestRootCaX509PemSize;
+        z = uSecurityCredentialSync(devHandle, &manifestEntry, 1);
+        U_TEST_PRINT_LINE_X("%d credential(s) written.", x, z);
+        U_PORT_TEST_ASSERT(z == 1);
+        U_PORT_TEST_ASSERT(uSecurityCredentialGetHash(devHandle,
+                                                      U_SECURITY_CREDENTIAL_CLIENT_X509,
+                                                      "ubxlib_test_cert",
+                                                      buffer) == 0);
+        U_PORT_TEST_ASSERT(memcmp(buffer, certHash, sizeof(buffer)) != 0);
+        U_PORT_TEST_ASSERT(uSecurityCredentialSync(devHandle, &manifestEntry, 1) == 0);
+
+        // The same for a PEM key without a password, which has
+        // to be converted to DER before its MD5 hash is calculated
+        U_TEST_PRINT_LINE_X("syncing missing private key...", x);
+        manifestEntry.type = U_SECURITY_CREDENTIAL_CLIENT_KEY_PRIVATE;
+        manifestEntry.pName = "ubxlib_test_key";
+        manifestEntry.pContents = (const char *) gUSecurityCredentialTestKey1024Pkcs1PemNoPass;
+        manifestEntry.size = gUSecurityCredentialTestKey1024Pkcs1PemNoPassSize;
+        z = uSecurityCredentialSync(devHandle, &manifestEntry, 1);
+        U_TEST_PRINT_LINE_X("%d credential(s) written.", x, z);
+        U_PORT_TEST_ASSERT(z == 1);
+        U_PORT_TEST_ASSERT(uSecurityCredentialSync(devHandle, &manifestEntry, 1) == 0);
+
+        // Delete both again
+        U_TEST_PRINT_LINE_X("deleting synced certificate and private key...", x);
+        U_PORT_TEST_ASSERT(uSecurityCredentialRemove(devHandle,
+                                                     U_SECURITY_CREDENTIAL_CLIENT_X509,
+                                                     "ubxlib_test_cert") == 0);
+        U_PORT_TEST_ASSERT(uSecurityCredentialRemove(devHandle,
+                                                     U_SECURITY_CREDENTIAL_CLIENT_KEY_PRIVATE,
+                                                     "ubxlib_test_key") == 0);
+
         // Check that none of ours are listed
         U_TEST_PRINT_LINE_X("listing credentials (should be none of ours)...", x);
         z = 0;
@@ -22,6 +22,9 @@
  * of another module should be included here; otherwise
  * please keep #includes to your .c files. */
 
+#include "u_ringbuffer.h"
+#include "u_spartn_crc.h"
+
 /** \addtogroup __spartn __SPARTN
  *  @{
  */
@@ -60,6 +63,59 @@ extern "C" {
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Callback that is called by uSpartnScan() when a complete SPARTN
+ * message, with valid message CRC, has been found in the ring
+ * buffer.  The message is NOT copied: the pointers passed to the
+ * callback point into the linear buffer underlying the ring buffer,
+ * hence, since the message may wrap around the end of that linear
+ * buffer, it is presented in two parts; pMessageWrap will be NULL
+ * (and messageWrapLengthBytes zero) if the message is contiguous.
+ * The data pointed-to is only valid for the duration of the
+ * callback, it is read out of the ring buffer when the callback
+ * returns.
+ *
+ * @param[in] pMessage             a pointer to the start of the
+ *                                 SPARTN message.
+ * @param messageLengthBytes       the number of bytes at pMessage.
+ * @param[in] pMessageWrap         a pointer to the remainder of the
+ *                                 SPARTN message, NULL if there is none.
+ * @param messageWrapLengthBytes   the number of bytes at pMessageWrap.
+ * @param[in] pCallbackParam       the pCallbackParam that was passed
+ *                                 to uSpartnScanInit().
+ */
+typedef void (*uSpartnScanCallback_t)(const char *pMessage,
+                                      size_t messageLengthBytes,
+                                      const char *pMessageWrap,
+                                      size_t messageWrapLengthBytes,
+                                      void *pCallbackParam);
+
+/** Context for the streaming SPARTN scanner; this is populated
+ * by uSpartnScanInit() and should be passed to each call of
+ * uSpartnScan().  The counts at the end of the structure may be
+ * read for information but no field should be written other than
+ * through the functions of this API.
+ */
+typedef struct {
+    uRingBuffer_t *pRingBuffer;      /**< the ring buffer to scan. */
+    int32_t readHandle;              /**< the read handle to use. */
+    uSpartnScanCallback_t pCallback; /**< the message callback. */
+    void *pCallbackParam;            /**< the callback parameter. */
+    size_t readLossBytes;            /**< the value of uRingBufferStatReadLossHandle()
+                                          when last checked. */
+    size_t messageLengthBytes;       /**< the length of the message in sync,
+                                          zero if not in sync. */
+    size_t messageCrcOffset;         /**< the offset of the message CRC from
+                                          the start of the message. */
+    uSpartnCrcType_t messageCrcType; /**< the type of the message CRC. */
+    size_t crcOffset;                /**< the offset, from the start of the
+                                          message, up to which the CRC has
+                                          been calculated. */
+    uint32_t crc;                    /**< the running CRC remainder. */
+    size_t numMessages;              /**< count of valid messages found. */
+    size_t numCrcErrors;             /**< count of message CRC failures. */
+    size_t discardedBytes;           /**< count of bytes thrown away. */
+} uSpartnScan_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -145,6 +201,70 @@ int32_t uSpartnDetect(const char *pBuffer, size_t bufferLengthBytes,
 int32_t uSpartnValidate(const char *pBuffer, size_t bufferLengthBytes,
                         const char **ppMessage);
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: STREAMING
+ * -------------------------------------------------------------- */
+
+/** Initialise a streaming SPARTN scanner.  Where uSpartnDetect() and
+ * uSpartnValidate() work on a flat buffer which has to be re-examined
+ * from the start each time more data arrives, the streaming scanner
+ * works on data in a ring buffer (e.g. one that is being filled
+ * with correction data from an MQTT or socket connection) and keeps
+ * its state between calls: each call to uSpartnScan() picks up where
+ * the last left off, the message CRC being calculated over the new
+ * data only, and complete messages are passed to a callback without
+ * being copied.
+ *
+ * The ring buffer must have been created with
+ * uRingBufferCreateWithReadHandle() and the scanner must be the only
+ * reader of readHandle.  If whatever is adding data to the ring buffer
+ * uses uRingBufferForceAdd() then it is best to lock readHandle with
+ * uRingBufferLockReadHandle() so that data is not lost from underneath
+ * a message that is being scanned; should that happen anyway the
+ * scanner will notice and re-synchronise.
+ *
+ * @param[out] pScan          a pointer to the scanner context to be
+ *                            initialised, cannot be NULL.
+ * @param[in] pRingBuffer     a pointer to the ring buffer to scan,
+ *                            cannot be NULL.
+ * @param readHandle          a read handle, as returned by
+ *                            uRingBufferTakeReadHandle().
+ * @param[in] pCallback       the callback to be called for each
+ *                            valid SPARTN message; cannot be NULL.
+ * @param[in] pCallbackParam  a parameter that will be passed to
+ *                            pCallback; may be NULL.
+ * @return                    zero on success else negative error code.
+ */
+int32_t uSpartnScanInit(uSpartnScan_t *pScan, uRingBuffer_t *pRingBuffer,
+                        int32_t readHandle, uSpartnScanCallback_t pCallback,
+                        void *pCallbackParam);
+
+/** Scan the data that has arrived in the ring buffer since the last
+ * call, calling the callback for each valid SPARTN message found.
+ * Data that is not part of a valid SPARTN message is read out of the
+ * ring buffer and discarded, a partial SPARTN message is left in the
+ * ring buffer until the rest of it arrives.  Call this whenever
+ * data has been added to the ring buffer.
+ *
+ * @param[in] pScan  a pointer to the scanner context, as initialised
+ *                   by uSpartnScanInit(), cannot be NULL.
+ * @return           on success the number of valid SPARTN messages
+ *                   passed to the callback during this call, else
+ *                   negative error code.
+ */
+int32_t uSpartnScan(uSpartnScan_t *pScan);
+
+/** Reset a streaming SPARTN scanner: any message that is part-way
+ * through being scanned is forgotten (the data remains in the ring
+ * buffer and will be scanned again by the next call to uSpartnScan())
+ * and the counts of messages, CRC errors and discarded bytes are
+ * zeroed.
+ *
+ * @param[in] pScan  a pointer to the scanner context, as initialised
+ *                   by uSpartnScanInit(), cannot be NULL.
+ */
+void uSpartnScanReset(uSpartnScan_t *pScan);
+
 #ifdef __cplusplus
 }
 #endif
@@ -110,6 +110,39 @@ uint32_t uSpartnCrc24(const char *pData, size_t size);
  */
 uint32_t uSpartnCrc32(const char *pData, size_t size);
 
+/** Begin an incremental CRC calculation, for use where the data
+ * to be checked arrives in pieces; call uSpartnCrcUpdate() with
+ * each piece of data and then uSpartnCrcEnd() to obtain the CRC.
+ * The result is the same as that returned by calling the block
+ * function for the given CRC type on the whole of the data.
+ *
+ * @param type  the CRC type.
+ * @return      the initial CRC remainder.
+ */
+uint32_t uSpartnCrcStart(uSpartnCrcType_t type);
+
+/** Add a block of data to an incremental CRC calculation.
+ *
+ * @param type   the CRC type, must be the same as that passed
+ *               to uSpartnCrcStart().
+ * @param crc    the CRC remainder, as returned by uSpartnCrcStart()
+ *               or by a previous call to this function.
+ * @param pData  a pointer to the data to be checked.
+ * @param size   the number of bytes pointed to by pData.
+ * @return       the updated CRC remainder.
+ */
+uint32_t uSpartnCrcUpdate(uSpartnCrcType_t type, uint32_t crc,
+                          const char *pData, size_t size);
+
+/** Complete an incremental CRC calculation.
+ *
+ * @param type   the CRC type, must be the same as that passed
+ *               to uSpartnCrcStart().
+ * @param crc    the CRC remainder, as returned by uSpartnCrcUpdate().
+ * @return       the CRC.
+ */
+uint32_t uSpartnCrcEnd(uSpartnCrcType_t type, uint32_t crc);
+
 #ifdef __cplusplus
 }
 #endif
@@ -93,10 +93,12 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // memcpy()
+#include "string.h"    // memcpy(), memchr(), memset()
 
 #include "u_error_common.h"
 
+#include "u_ringbuffer.h"
+
 #include "u_spartn.h"
 #include "u_spartn_crc.h"
 
@@ -110,6 +112,12 @@
  */
 #define U_SPARTN_HEADER_LENGTH_MIN_BYTES (4 + 4)
 
+/** The maximum length of a SPARTN message header: FRAME START +
+ * largest PAYLOAD DESCRIPTION (i.e. 32-bit GNSS time tag and
+ * ENCRYPT/AUTH).
+ */
+#define U_SPARTN_HEADER_LENGTH_MAX_BYTES (4 + 6 + 2)
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -122,6 +130,140 @@
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Decode a SPARTN message header that begins at the start of a buffer,
+// returning the length of the message and supplying the offset of
+// the message CRC from the start of the message, plus the message CRC
+// type; returns U_ERROR_COMMON_TIMEOUT if more data is needed and
+// U_ERROR_COMMON_NOT_FOUND if pInput is not the start of a SPARTN message.
+static int32_t decodeHeaderAt(const uint8_t *pInput, size_t bufferLengthBytes,
+                              size_t *pMessageCrcOffset,
+                              uSpartnCrcType_t *pMessageCrcType)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+    uint8_t frameBuffer[4];
+    size_t lengthHeader;
+    size_t lengthBeyondHeader;
+    size_t crcType;
+
+    if ((bufferLengthBytes > 0) && (*pInput == 0x73)) {
+        // Potentially a FRAME START
+        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        if (bufferLengthBytes >= U_SPARTN_HEADER_LENGTH_MIN_BYTES) {
+            // Have enough data to work on the header; confirm that this
+            // is a FRAME START by doing a frame CRC check on it
+            // Copy everything from FRAME START except TF001 into a buffer
+            memcpy(&frameBuffer, pInput + 1, 3);
+            frameBuffer[3] = 0;
+
+            // frameBuffer now contains, in order of bit-arrival:
+            //
+            // bytes:    |      0     |     1     |      2      |     3     |
+            // contents: |<---T7---><-----L10------->E1-MCT2-FC4|           |
+            // meaning:  |M       L M |           |L    M L  M L|           |
+
+            // Remove the frame CRC that is in the lower four
+            // bits of byte 2, giving us 20 bits in the buffer with
+            // zero-fill elsewhere
+            frameBuffer[2] &= 0xf0;
+            // Compute the CRC-4 over 24 bits and check it against the frame CRC (TF006)
+            if (uSpartnCrc4((const char *) frameBuffer, 3) == (*(pInput + 3) & 0x0f)) {
+                lengthHeader = U_SPARTN_HEADER_LENGTH_MIN_BYTES;
+                // So far so good, now parse the PAYLOAD DESCRIPTION to work out
+                // how long it is; check if the TF008 (GNSS time tag type) bit is set
+                if (*(pInput + 4) & 0x08) {
+                    // The GNSS time tag is 32 bits instead of 16, so account for that
+                    lengthHeader += 2;
+                }
+                // Work out the length beyond the message header
+                // First the length of the payload from the 10-bit TF003 field,
+                // which is splattered across the three bytes of frameBuffer
+                lengthBeyondHeader = ((((size_t) frameBuffer[0]) & 0x01) << 9) +
+                                     (((size_t) frameBuffer[1]) << 1) +
+                                     ((((size_t) frameBuffer[2]) & 0x80) >> 7);
+                // Add the length of the message CRC by looking at
+                // the 2-bit message CRC type field (TF005).  Since we have
+                // 0: CRC-8, 1: CRC-16, 2: CRC-24, 3: CRC-32 it is easy
+                // to calculate
+                crcType = (frameBuffer[2] & 0x30) >> 4;
+                lengthBeyondHeader += crcType + 1;
+                if (pMessageCrcType != NULL) {
+                    *pMessageCrcType = (uSpartnCrcType_t) crcType;
+                }
+                // Work out the additions as a consequence of encryption/authentication
+                // being switched on
+                if (frameBuffer[2] & 0x40) {
+                    // TF004 is set, so we need the ENCRYPT/AUTH fields to work
+                    // out the message length; see if they are in the buffer
+                    if ((int32_t) bufferLengthBytes - (int32_t) lengthHeader >= 2) {
+                        // The ENCRYPT/AUTH fields are in the buffer
+                        lengthHeader += 2;
+                        // To work out how big the AUTHENTICATION field is we
+                        // need to check if the authentication indicator field
+                        // (TF014) in PAYLOAD DESCRIPTION is greater than 1.
+                        // This is in the final byte of the header so we
+                        // can use lengthHeader, which is now pointing
+                        // at the start of the payload, to index to it
+                        if (((*(pInput + lengthHeader - 1) & 0x38) >> 3) > 1) {
+                            // AUTHENTICATION is present, find out how
+                            // big it is from the 3-bit authentication
+                            // length (TF015) at the beginning of the same
+                            // byte
+                            switch (*(pInput + lengthHeader - 1) & 0x07) {
+                                case 0: // 64 bits
+                                    lengthBeyondHeader += 64 / 8;
+                                    break;
+                                case 1: // 96 bits
+                                    lengthBeyondHeader += 96 / 8;
+                                    break;
+                                case 2: // 128 bits
+                                    lengthBeyondHeader += 128 / 8;
+                                    break;
+                                case 3: // 256 bits
+                                    lengthBeyondHeader += 256 / 8;
+                                    break;
+                                case 4: // 512 bits
+                                    lengthBeyondHeader += 512 / 8;
+                                    break;
+                                default:
+                                    // Error case: not a supported message
+                                    sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+                                    lengthHeader = 0;
+                                    break;
+                            }
+                        }
+                    } else {
+                        // Might be a message but we don't yet have enough
+                        // data to work out its length; set the length
+                        // of the header to zero to flag this
+                        lengthHeader = 0;
+                    }
+                }
+                if (lengthHeader > 0) {
+                    // We have a header length, so (a) there are no errors and (b)
+                    // we have all the data we need to determine the message length,
+                    // then we are done; otherwise sizeOrErrorCode is left at
+                    // U_ERROR_COMMON_TIMEOUT (or U_ERROR_COMMON_NOT_FOUND if there
+                    // was an error)
+                    sizeOrErrorCode = (int32_t) (lengthHeader + lengthBeyondHeader);
+                    if (pMessageCrcOffset != NULL) {
+                        *pMessageCrcOffset = lengthHeader + lengthBeyondHeader - (crcType + 1);
+                    }
+                }
+            } else {
+                // Not a SPARTN message
+                sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+            }
+        } else {
+            // Might be a SPARTN message but we don't yet have all of
+            // the header and hence can't work out the message
+            // length; leave sizeOrErrorCode at U_ERROR_COMMON_TIMEOUT
+            // so that the caller knows we need more data
+        }
+    }
+
+    return sizeOrErrorCode;
+}
+
 // Look for a SPARTN message header in a buffer and supply its position,
 // plus the message CRC position and type.
 static int32_t decodeHeader(const char *pBuffer, size_t bufferLengthBytes,
@@ -133,129 +275,18 @@ static int32_t decodeHeader(const char *pBuffer, size_t bufferLengthBytes,
     // Use a uint8_t pointer for maths, more certain of its behaviour than char
     const uint8_t *pInput = (const uint8_t *) pBuffer;
     const uint8_t *pMessage = NULL;
-    uint8_t frameBuffer[4];
-    size_t lengthHeader;
-    size_t lengthBeyondHeader;
-    size_t crcType;
+    size_t messageCrcOffset = 0;
 
     if (pInput != NULL) {
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
         while ((sizeOrErrorCode < 0) && (sizeOrErrorCode != (int32_t) U_ERROR_COMMON_TIMEOUT) &&
                (bufferLengthBytes > 0)) {
             if (*pInput == 0x73) {
-                // Potentially a FRAME START
-                sizeOrErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
                 pMessage = pInput;
-                if (bufferLengthBytes >= U_SPARTN_HEADER_LENGTH_MIN_BYTES) {
-                    // Have enough data to work on the header; confirm that this
-                    // is a FRAME START by doing a frame CRC check on it
-                    // Copy everything from FRAME START except TF001 into a buffer
-                    memcpy(&frameBuffer, pInput + 1, 3);
-                    frameBuffer[3] = 0;
-
-                    // frameBuffer now contains, in order of bit-arrival:
-                    //
-                    // bytes:    |      0     |     1     |      2      |     3     |
-                    // contents: |<---T7---><-----L10------->E1-MCT2-FC4|           |
-                    // meaning:  |M       L M |           |L    M L  M L|           |
-
-                    // Remove the frame CRC that is in the lower four
-                    // bits of byte 2, giving us 20 bits in the buffer with
-                    // zero-fill elsewhere
-                    frameBuffer[2] &= 0xf0;
-                    // Compute the CRC-4 over 24 bits and check it against the frame CRC (TF006)
-                    if (uSpartnCrc4((const char *) frameBuffer, 3) == (*(pInput + 3) & 0x0f)) {
-                        lengthHeader = U_SPARTN_HEADER_LENGTH_MIN_BYTES;
-                        // So far so good, now parse the PAYLOAD DESCRIPTION to work out
-                        // how long it is; check if the TF008 (GNSS time tag type) bit is set
-                        if (*(pInput + 4) & 0x08) {
-                            // The GNSS time tag is 32 bits instead of 16, so account for that
-                            lengthHeader += 2;
-                        }
-                        // Work out the length beyond the message header
-                        // First the length of the payload from the 10-bit TF003 field,
-                        // which is splattered across the three bytes of frameBuffer
-                        lengthBeyondHeader = ((((size_t) frameBuffer[0]) & 0x01) << 9) +
-                                             (((size_t) frameBuffer[1]) << 1) +
-                                             ((((size_t) frameBuffer[2]) & 0x80) >> 7);
-                        // Add the length of the message CRC by looking at
-                        // the 2-bit message CRC type field (TF005).  Since we have
-                        // 0: CRC-8, 1: CRC-16, 2: CRC-24, 3: CRC-32 it is easy
-                        // to calculate
-                        crcType = (frameBuffer[2] & 0x30) >> 4;
-                        lengthBeyondHeader += crcType + 1;
-                        if (pMessageCrcType != NULL) {
-                            *pMessageCrcType = (uSpartnCrcType_t) crcType;
-                        }
-                        // Work out the additions as a consequence of encryption/authentication
-                        // being switched on
-                        if (frameBuffer[2] & 0x40) {
-                            // TF004 is set, so we need the ENCRYPT/AUTH fields to work
-                            // out the message length; see if they are in the buffer
-                            if ((int32_t) bufferLengthBytes - (int32_t) lengthHeader >= 2) {
-                                // The ENCRYPT/AUTH fields are in the buffer
-                                lengthHeader += 2;
-                                // To work out how big the AUTHENTICATION field is we
-                                // need to check if the authentication indicator field
-                                // (TF014) in PAYLOAD DESCRIPTION is greater than 1.
-                                // This is in the final byte of the header so we
-                                // can use lengthHeader, which is now pointing
-                                // at the start of the payload, to index to it
-                                if (((*(pInput + lengthHeader - 1) & 0x38) >> 3) > 1) {
-                                    // AUTHENTICATION is present, find out how
-                                    // big it is from the 3-bit authentication
-                                    // length (TF015) at the beginning of the same
-                                    // byte
-                                    switch (*(pInput + lengthHeader - 1) & 0x07) {
-                                        case 0: // 64 bits
-                                            lengthBeyondHeader += 64 / 8;
-                                            break;
-                                        case 1: // 96 bits
-                                            lengthBeyondHeader += 96 / 8;
-                                            break;
-                                        case 2: // 128 bits
-                                            lengthBeyondHeader += 128 / 8;
-                                            break;
-                                        case 3: // 256 bits
-                                            lengthBeyondHeader += 256 / 8;
-                                            break;
-                                        case 4: // 512 bits
-                                            lengthBeyondHeader += 512 / 8;
-                                            break;
-                                        default:
-                                            // Error case: not a supported message
-                                            sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
-                                            lengthHeader = 0;
-                                            break;
-                                    }
-                                }
-                            } else {
-                                // Might be a message but we don't yet have enough
-                                // data to work out its length; set the length
-                                // of the header to zero to flag this
-                                lengthHeader = 0;
-                            }
-                        }
-                        if (lengthHeader > 0) {
-                            // We have a header length, so (a) there are no errors and (b)
-                            // we have all the data we need to determine the message length,
-                            // then we are done; otherwise sizeOrErrorCode is left at
-                            // U_ERROR_COMMON_TIMEOUT (or U_ERROR_COMMON_NOT_FOUND if there
-                            // was an error)
-                            sizeOrErrorCode = (int32_t) (lengthHeader + lengthBeyondHeader);
-                            if (ppMessageCrcStart != NULL) {
-                                *ppMessageCrcStart = (const char *) pMessage + lengthHeader + lengthBeyondHeader - (crcType + 1);
-                            }
-                        }
-                    } else {
-                        // Not a SPARTN message
-                        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
-                    }
-                } else {
-                    // Might be a SPARTN message but we don't yet have all of
-                    // the header and hence can't work out the message
-                    // length; leave sizeOrErrorCode at U_ERROR_COMMON_TIMEOUT
-                    // so that the caller knows we need more data
+                sizeOrErrorCode = decodeHeaderAt(pInput, bufferLengthBytes,
+                                                 &messageCrcOffset, pMessageCrcType);
+                if ((sizeOrErrorCode >= 0) && (ppMessageCrcStart != NULL)) {
+                    *ppMessageCrcStart = (const char *) pMessage + messageCrcOffset;
                 }
             }
 
@@ -272,6 +303,145 @@ static int32_t decodeHeader(const char *pBuffer, size_t bufferLengthBytes,
     return sizeOrErrorCode;
 }
 
+// Throw away the given number of bytes from the front of the
+// ring buffer being scanned, dropping out of sync.
+static void scanDiscard(uSpartnScan_t *pScan, size_t length)
+{
+    pScan->discardedBytes += uRingBufferReadHandle(pScan->pRingBuffer,
+                                                   pScan->readHandle,
+                                                   NULL, length);
+    pScan->messageLengthBytes = 0;
+}
+
+// Get in sync with a SPARTN message at the front of the ring buffer
+// being scanned, returning true if that has been achieved, false
+// if more data is needed.
+static bool scanSync(uSpartnScan_t *pScan)
+{
+    bool inSync = false;
+    bool needMoreData = false;
+    const char *pData = NULL;
+    const char *pFrameStart;
+    char header[U_SPARTN_HEADER_LENGTH_MAX_BYTES];
+    size_t length;
+    int32_t messageLength;
+
+    while (!inSync && !needMoreData) {
+        // Look for the preamble in the contiguous data at the front
+        // of the ring buffer, throwing away anything before it
+        length = uRingBufferPeekSpanHandle(pScan->pRingBuffer, pScan->readHandle,
+                                           &pData, 0);
+        if (length > 0) {
+            pFrameStart = (const char *) memchr(pData, 0x73, length);
+            if (pFrameStart == NULL) {
+                scanDiscard(pScan, length);
+            } else if (pFrameStart > pData) {
+                scanDiscard(pScan, pFrameStart - pData);
+            } else {
+                // The preamble is at the front: the header is small,
+                // and may be split across the wrap, so take a copy
+                // of it to decode
+                length = uRingBufferPeekHandle(pScan->pRingBuffer, pScan->readHandle,
+                                               header, sizeof(header), 0);
+                messageLength = decodeHeaderAt((const uint8_t *) header, length,
+                                               &(pScan->messageCrcOffset),
+                                               &(pScan->messageCrcType));
+                if (messageLength == (int32_t) U_ERROR_COMMON_TIMEOUT) {
+                    needMoreData = true;
+                } else if ((messageLength < 0) ||
+                           ((size_t) messageLength >= pScan->pRingBuffer->size)) {
+                    // Not a SPARTN message or one that could never fit
+                    // into the ring buffer: move past the preamble
+                    scanDiscard(pScan, 1);
+                } else {
+                    pScan->messageLengthBytes = messageLength;
+                    // The message CRC does not include the preamble
+                    pScan->crcOffset = 1;
+                    pScan->crc = uSpartnCrcStart(pScan->messageCrcType);
+                    inSync = true;
+                }
+            }
+        } else {
+            needMoreData = true;
+        }
+    }
+
+    return inSync;
+}
+
+// Calculate the message CRC over any data that has arrived since
+// last time, returning true if the message CRC can now be checked.
+static bool scanCrc(uSpartnScan_t *pScan)
+{
+    const char *pData = NULL;
+    size_t length = 1;
+
+    while ((pScan->crcOffset < pScan->messageCrcOffset) && (length > 0)) {
+        length = uRingBufferPeekSpanHandle(pScan->pRingBuffer, pScan->readHandle,
+                                           &pData, pScan->crcOffset);
+        if (length > pScan->messageCrcOffset - pScan->crcOffset) {
+            length = pScan->messageCrcOffset - pScan->crcOffset;
+        }
+        pScan->crc = uSpartnCrcUpdate(pScan->messageCrcType, pScan->crc,
+                                      pData, length);
+        pScan->crcOffset += length;
+    }
+
+    return (pScan->crcOffset == pScan->messageCrcOffset) &&
+           (uRingBufferDataSizeHandle(pScan->pRingBuffer,
+                                      pScan->readHandle) >= pScan->messageLengthBytes);
+}
+
+// Check the message CRC and, if it is good, call the callback with
+// the message; either way the message is then removed from the
+// ring buffer.  Returns true if the message was good.
+static bool scanDeliver(uSpartnScan_t *pScan)
+{
+    bool isGood = false;
+    uint8_t crcBuffer[4];
+    size_t crcLength = ((size_t) pScan->messageCrcType) + 1;
+    uint32_t crcFromMessage = 0;
+    const char *pMessage = NULL;
+    const char *pMessageWrap = NULL;
+    size_t length;
+    size_t lengthWrap = 0;
+
+    // The message CRC is MSB first
+    uRingBufferPeekHandle(pScan->pRingBuffer, pScan->readHandle,
+                          (char *) crcBuffer, crcLength,
+                          pScan->messageCrcOffset);
+    for (size_t x = 0; x < crcLength; x++) {
+        crcFromMessage = (crcFromMessage << 8) + crcBuffer[x];
+    }
+    if (uSpartnCrcEnd(pScan->messageCrcType, pScan->crc) == crcFromMessage) {
+        isGood = true;
+        length = uRingBufferPeekSpanHandle(pScan->pRingBuffer, pScan->readHandle,
+                                           &pMessage, 0);
+        if (length > pScan->messageLengthBytes) {
+            length = pScan->messageLengthBytes;
+        }
+        if (length < pScan->messageLengthBytes) {
+            lengthWrap = uRingBufferPeekSpanHandle(pScan->pRingBuffer, pScan->readHandle,
+                                                   &pMessageWrap, length);
+            if (lengthWrap > pScan->messageLengthBytes - length) {
+                lengthWrap = pScan->messageLengthBytes - length;
+            }
+        }
+        pScan->pCallback(pMessage, length, pMessageWrap, lengthWrap,
+                         pScan->pCallbackParam);
+        pScan->numMessages++;
+        uRingBufferReadHandle(pScan->pRingBuffer, pScan->readHandle,
+                              NULL, pScan->messageLengthBytes);
+        pScan->messageLengthBytes = 0;
+    } else {
+        // Move past the preamble and hunt again
+        pScan->numCrcErrors++;
+        scanDiscard(pScan, 1);
+    }
+
+    return isGood;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -352,4 +522,78 @@ int32_t uSpartnValidate(const char *pBuffer, size_t bufferLengthBytes,
     return sizeOrErrorCode;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: STREAMING
+ * -------------------------------------------------------------- */
+
+// Initialise a streaming SPARTN scanner.
+int32_t uSpartnScanInit(uSpartnScan_t *pScan, uRingBuffer_t *pRingBuffer,
+                        int32_t readHandle, uSpartnScanCallback_t pCallback,
+                        void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pScan != NULL) && (pRingBuffer != NULL) && (readHandle > 0) &&
+        (pCallback != NULL)) {
+        memset(pScan, 0, sizeof(*pScan));
+        pScan->pRingBuffer = pRingBuffer;
+        pScan->readHandle = readHandle;
+        pScan->pCallback = pCallback;
+        pScan->pCallbackParam = pCallbackParam;
+        pScan->readLossBytes = uRingBufferStatReadLossHandle(pRingBuffer, readHandle);
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Scan the data that has arrived in the ring buffer.
+int32_t uSpartnScan(uSpartnScan_t *pScan)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    size_t readLossBytes;
+    bool moreToDo = true;
+
+    if ((pScan != NULL) && (pScan->pRingBuffer != NULL) &&
+        (pScan->pCallback != NULL)) {
+        errorCodeOrCount = 0;
+        // If data has been pushed out from under us by a forced
+        // add then any message we were in sync with is gone
+        readLossBytes = uRingBufferStatReadLossHandle(pScan->pRingBuffer,
+                                                      pScan->readHandle);
+        if (readLossBytes != pScan->readLossBytes) {
+            pScan->readLossBytes = readLossBytes;
+            pScan->messageLengthBytes = 0;
+        }
+        while (moreToDo) {
+            moreToDo = false;
+            if ((pScan->messageLengthBytes > 0) || scanSync(pScan)) {
+                if (scanCrc(pScan)) {
+                    if (scanDeliver(pScan)) {
+                        errorCodeOrCount++;
+                    }
+                    moreToDo = true;
+                }
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Reset a streaming SPARTN scanner.
+void uSpartnScanReset(uSpartnScan_t *pScan)
+{
+    if (pScan != NULL) {
+        pScan->messageLengthBytes = 0;
+        pScan->numMessages = 0;
+        pScan->numCrcErrors = 0;
+        pScan->discardedBytes = 0;
+        if (pScan->pRingBuffer != NULL) {
+            pScan->readLossBytes = uRingBufferStatReadLossHandle(pScan->pRingBuffer,
+                                                                 pScan->readHandle);
+        }
+    }
+}
+
 // End of file
@@ -232,94 +232,91 @@ static const uint32_t u32Crc32Table[] = {
 
 uint8_t uSpartnCrc4(const char *pData, size_t size)
 {
-    // Initialize local variables
-    uint8_t u8TableRemainder;
-    uint8_t u8Remainder = 0; // Initial remainder
-    const uint8_t *pU8Msg = (uint8_t *) pData;
-
-    // Compute the CRC value
-    // Divide each byte of the message by the corresponding polynomial
-    for (size_t x = 0; x < size; x++) {
-        u8TableRemainder = pU8Msg[x] ^ u8Remainder;
-        u8Remainder = u8Crc4Table[u8TableRemainder];
-    }
-
-    return u8Remainder;
+    return (uint8_t) uSpartnCrcUpdate(U_SPARTN_CRC_TYPE_4,
+                                      uSpartnCrcStart(U_SPARTN_CRC_TYPE_4),
+                                      pData, size);
 }
 
 uint8_t uSpartnCrc8(const char *pData, size_t size)
 {
-    // Initialize local variables
-    uint8_t u8TableRemainder;
-    uint8_t u8Remainder = 0; // Initial remainder
-    const uint8_t *pU8Msg = (uint8_t *) pData;
-
-    // Compute the CRC value
-    // Divide each byte of the message by the corresponding polynomial
-    for (size_t x = 0; x < size; x++) {
-        u8TableRemainder = pU8Msg[x] ^ u8Remainder;
-        u8Remainder = u8Crc8Table[u8TableRemainder];
-    }
-
-    return u8Remainder;
+    return (uint8_t) uSpartnCrcUpdate(U_SPARTN_CRC_TYPE_8,
+                                      uSpartnCrcStart(U_SPARTN_CRC_TYPE_8),
+                                      pData, size);
 }
 
 uint16_t uSpartnCrc16(const char *pData, size_t size)
 {
-    // Initialize local variables
-    uint16_t u16TableRemainder;
-    uint16_t u16Remainder = 0; // Initial remainder
-    uint8_t  u8NumBitsInCrc = (8 * sizeof(uint16_t));
-    const uint8_t  *pU8Msg = (uint8_t *) pData;
-
-    // Compute the CRC value
-    // Divide each byte of the message by the corresponding polynomial
-    for (size_t x = 0; x < size; x++) {
-        u16TableRemainder = pU8Msg[x] ^ (u16Remainder >> (u8NumBitsInCrc - 8));
-        u16Remainder = u16Crc16Table[u16TableRemainder] ^ (u16Remainder << 8);
-    }
-
-    return u16Remainder;
+    return (uint16_t) uSpartnCrcUpdate(U_SPARTN_CRC_TYPE_16,
+                                       uSpartnCrcStart(U_SPARTN_CRC_TYPE_16),
+                                       pData, size);
 }
 
 uint32_t uSpartnCrc24(const char *pData, size_t size)
 {
-    // Initialize local variables
-    uint32_t u32TableRemainder;
-    uint32_t u32Remainder = 0; // Initial remainder
-    uint8_t u8NumBitsInCrc = (8 * sizeof(uint8_t) * 3);
-    const uint8_t *pU8Msg = (uint8_t *) pData;
+    return uSpartnCrcUpdate(U_SPARTN_CRC_TYPE_24,
+                            uSpartnCrcStart(U_SPARTN_CRC_TYPE_24),
+                            pData, size);
+}
 
-    // Compute the CRC value
-    // Divide each byte of the message by the corresponding polynomial
-    for (size_t x = 0; x < size; x++) {
-        u32TableRemainder = pU8Msg[x] ^ (u32Remainder >> (u8NumBitsInCrc - 8));
-        u32Remainder = u32Crc24Table[u32TableRemainder] ^ (u32Remainder << 8);
-        u32Remainder = u32Remainder & 0x00FFFFFF; // Only interested in 24 bits
-    }
+uint32_t uSpartnCrc32(const char *pData, size_t size)
+{
+    return uSpartnCrcEnd(U_SPARTN_CRC_TYPE_32,
+                         uSpartnCrcUpdate(U_SPARTN_CRC_TYPE_32,
+                                          uSpartnCrcStart(U_SPARTN_CRC_TYPE_32),
+                                          pData, size));
+}
 
-    return u32Remainder;
+uint32_t uSpartnCrcStart(uSpartnCrcType_t type)
+{
+    // Only CRC-32 begins with a non-zero remainder
+    return (type == U_SPARTN_CRC_TYPE_32) ? 0xFFFFFFFFU : 0;
 }
 
-uint32_t uSpartnCrc32(const char *pData, size_t size)
+uint32_t uSpartnCrcUpdate(uSpartnCrcType_t type, uint32_t crc,
+                          const char *pData, size_t size)
 {
-    // Initialize local variables
-    uint32_t u32TableRemainder;
-    uint32_t u32Remainder = 0xFFFFFFFFU; // Initial remainder
-    uint8_t u8NumBitsInCrc = (8 * sizeof(uint32_t));
-    uint32_t u32FinalXORValue = 0xFFFFFFFFU;
-    const uint8_t *pU8Msg = (uint8_t *) pData;
+    const uint8_t *pU8Msg = (const uint8_t *) pData;
 
     // Compute the CRC value
     // Divide each byte of the message by the corresponding polynomial
-    for (size_t x = 0; x < size; x++) {
-        u32TableRemainder = pU8Msg[x] ^ (u32Remainder >> (u8NumBitsInCrc - 8));
-        u32Remainder = u32Crc32Table[u32TableRemainder] ^ (u32Remainder << 8);
+    switch (type) {
+        case U_SPARTN_CRC_TYPE_4:
+            for (size_t x = 0; x < size; x++) {
+                crc = u8Crc4Table[(uint8_t) (pU8Msg[x] ^ crc)];
+            }
+            break;
+        case U_SPARTN_CRC_TYPE_8:
+            for (size_t x = 0; x < size; x++) {
+                crc = u8Crc8Table[(uint8_t) (pU8Msg[x] ^ crc)];
+            }
+            break;
+        case U_SPARTN_CRC_TYPE_16:
+            for (size_t x = 0; x < size; x++) {
+                crc = (u16Crc16Table[(uint8_t) (pU8Msg[x] ^ (crc >> 8))] ^ (crc << 8)) & 0xFFFF;
+            }
+            break;
+        case U_SPARTN_CRC_TYPE_24:
+            for (size_t x = 0; x < size; x++) {
+                crc = u32Crc24Table[(uint8_t) (pU8Msg[x] ^ (crc >> 16))] ^ (crc << 8);
+                crc = crc & 0x00FFFFFF; // Only interested in 24 bits
+            }
+            break;
+        case U_SPARTN_CRC_TYPE_32:
+            for (size_t x = 0; x < size; x++) {
+                crc = u32Crc32Table[(uint8_t) (pU8Msg[x] ^ (crc >> 24))] ^ (crc << 8);
+            }
+            break;
+        default:
+            break;
     }
 
-    u32Remainder = u32Remainder ^ u32FinalXORValue;
+    return crc;
+}
 
-    return u32Remainder;
+uint32_t uSpartnCrcEnd(uSpartnCrcType_t type, uint32_t crc)
+{
+    // Only CRC-32 has a final XOR
+    return (type == U_SPARTN_CRC_TYPE_32) ? crc ^ 0xFFFFFFFFU : crc;
 }
 
 // End of file
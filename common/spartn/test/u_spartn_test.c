@@ -49,6 +49,8 @@
 #include "u_port_debug.h"
 #include "u_port_os.h"
 
+#include "u_ringbuffer.h"
+
 #include "u_spartn.h"
 #include "u_spartn_crc.h"
 #include "u_spartn_test_data.h"
@@ -80,10 +82,28 @@
 # define U_SPARTN_TEST_BUFFER_SIZE_BYTES (U_SPARTN_MESSAGE_LENGTH_MAX_BYTES + U_SPARTN_TEST_BUFFER_EXTRA_SIZE_BYTES)
 #endif
 
+#ifndef U_SPARTN_TEST_RING_BUFFER_SIZE_BYTES
+/** The size of ring buffer to use when testing the streaming
+ * SPARTN scanner; deliberately not a multiple of anything in
+ * particular so that messages wrap at odd places.
+ */
+# define U_SPARTN_TEST_RING_BUFFER_SIZE_BYTES ((U_SPARTN_MESSAGE_LENGTH_MAX_BYTES * 2) + 37)
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Struct to keep track of what the streaming SPARTN scanner
+ * has delivered.
+ */
+typedef struct {
+    const char *pExpected; /**< where the next message should be in the test data. */
+    size_t numMessages;
+    size_t numWrapped;
+    bool mismatch;
+} uSpartnTestScan_t;
+
 /** Struct to hold the test data for a CRC algorithm.
  */
 typedef struct {
@@ -226,6 +246,37 @@ static const char gpSpartnMessage[] = {
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+#ifndef __ZEPHYR__
+
+// Callback for the streaming SPARTN scanner: checks that the
+// message delivered is a valid SPARTN message that matches
+// the next one in the test data.
+static void scanCallback(const char *pMessage, size_t messageLengthBytes,
+                         const char *pMessageWrap, size_t messageWrapLengthBytes,
+                         void *pCallbackParam)
+{
+    uSpartnTestScan_t *pTestScan = (uSpartnTestScan_t *) pCallbackParam;
+    const char *pExpected = NULL;
+    size_t remainingLength = gUSpartnTestDataSize - (pTestScan->pExpected - gUSpartnTestData);
+    int32_t expectedLength;
+
+    expectedLength = uSpartnValidate(pTestScan->pExpected, remainingLength, &pExpected);
+    if ((expectedLength == (int32_t) (messageLengthBytes + messageWrapLengthBytes)) &&
+        (memcmp(pMessage, pExpected, messageLengthBytes) == 0) &&
+        ((messageWrapLengthBytes == 0) ||
+         (memcmp(pMessageWrap, pExpected + messageLengthBytes, messageWrapLengthBytes) == 0))) {
+        pTestScan->pExpected = pExpected + expectedLength;
+    } else {
+        pTestScan->mismatch = true;
+    }
+    if (messageWrapLengthBytes > 0) {
+        pTestScan->numWrapped++;
+    }
+    pTestScan->numMessages++;
+}
+
+#endif // __ZEPHYR__
+
 // The implementation of CRC-24 Radix 64 cut and pasted
 // from https://datatracker.ietf.org/doc/html/rfc4880#page-59.
 #define CRC24_INIT 0
@@ -452,6 +503,122 @@ U_PORT_TEST_FUNCTION("[spartn]", "spartnMessage")
     U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
 }
 
+/** Testing of the streaming SPARTN scanner: the SPARTN message
+ * data kept in u_spartn_test_data.c, with some random rubbish
+ * in front of it, is fed into a ring buffer in randomly-sized
+ * chunks, the scanner being called after each chunk, and the
+ * messages delivered to the callback are checked.  Not run on
+ * Zephyr for the same reason as spartnMessage.
+ */
+U_PORT_TEST_FUNCTION("[spartn]", "spartnScan")
+{
+    int32_t heapUsed;
+    uRingBuffer_t ringBuffer = {0};
+    char *pLinearBuffer;
+    int32_t readHandle;
+    uSpartnScan_t scan;
+    uSpartnTestScan_t testScan = {0};
+    char rubbish[U_SPARTN_TEST_BUFFER_EXTRA_SIZE_BYTES];
+    const char *pData;
+    size_t length;
+    int32_t count = 0;
+    int32_t x;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    heapUsed = uPortGetHeapFree();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_TEST_PRINT_LINE("testing streaming SPARTN scanner.");
+
+    pLinearBuffer = (char *) pUPortMalloc(U_SPARTN_TEST_RING_BUFFER_SIZE_BYTES);
+    U_PORT_TEST_ASSERT(pLinearBuffer != NULL);
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, pLinearBuffer,
+                                                       U_SPARTN_TEST_RING_BUFFER_SIZE_BYTES,
+                                                       1) == 0);
+    uRingBufferSetReadRequiresHandle(&ringBuffer, true);
+    readHandle = uRingBufferTakeReadHandle(&ringBuffer);
+    U_PORT_TEST_ASSERT(readHandle > 0);
+
+    // Parameter checking
+    U_PORT_TEST_ASSERT(uSpartnScanInit(NULL, &ringBuffer, readHandle,
+                                       scanCallback, &testScan) < 0);
+    U_PORT_TEST_ASSERT(uSpartnScanInit(&scan, NULL, readHandle,
+                                       scanCallback, &testScan) < 0);
+    U_PORT_TEST_ASSERT(uSpartnScanInit(&scan, &ringBuffer, readHandle,
+                                       NULL, &testScan) < 0);
+    U_PORT_TEST_ASSERT(uSpartnScanInit(&scan, &ringBuffer, readHandle,
+                                       scanCallback, &testScan) == 0);
+    // Nothing in the ring buffer, nothing found
+    U_PORT_TEST_ASSERT(uSpartnScan(&scan) == 0);
+
+    // Start with some rubbish that doesn't contain the preamble
+    // so that the first message is not at the start of things
+    for (size_t y = 0; y < sizeof(rubbish); y++) {
+        rubbish[y] = (char) (rand() & 0x7f);
+        if (rubbish[y] == 0x73) {
+            rubbish[y] = 0;
+        }
+    }
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, rubbish, sizeof(rubbish)));
+
+    testScan.pExpected = gUSpartnTestData;
+    pData = gUSpartnTestData;
+    while (pData < gUSpartnTestData + gUSpartnTestDataSize) {
+        length = (rand() % 100) + 1;
+        if (pData + length > gUSpartnTestData + gUSpartnTestDataSize) {
+            length = gUSpartnTestData + gUSpartnTestDataSize - pData;
+        }
+        U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, pData, length));
+        pData += length;
+        x = uSpartnScan(&scan);
+        U_PORT_TEST_ASSERT(x >= 0);
+        count += x;
+        U_PORT_TEST_ASSERT(!testScan.mismatch);
+    }
+
+    U_TEST_PRINT_LINE("scanner found %d message(s) out of %d (%d wrapped),"
+                      " %d CRC error(s), %d byte(s) discarded.",
+                      count, gUSpartnTestDataNumMessages, testScan.numWrapped,
+                      scan.numCrcErrors, scan.discardedBytes);
+    U_PORT_TEST_ASSERT(count == (int32_t) gUSpartnTestDataNumMessages);
+    U_PORT_TEST_ASSERT(testScan.numMessages == gUSpartnTestDataNumMessages);
+    U_PORT_TEST_ASSERT(scan.numMessages == gUSpartnTestDataNumMessages);
+    U_PORT_TEST_ASSERT(scan.discardedBytes >= sizeof(rubbish));
+
+    // A corrupted message should be rejected and the scanner
+    // should get back in sync for the one that follows; corrupt
+    // the message on the way in by flipping a bit in the middle
+    uSpartnScanReset(&scan);
+    length = sizeof(gpSpartnMessage) / 2;
+    rubbish[0] = gpSpartnMessage[length] ^ 0x01;
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, gpSpartnMessage, length));
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, rubbish, 1));
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, gpSpartnMessage + length + 1,
+                                      sizeof(gpSpartnMessage) - length - 1));
+    U_PORT_TEST_ASSERT(uSpartnScan(&scan) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, gpSpartnMessage, sizeof(gpSpartnMessage)));
+    U_PORT_TEST_ASSERT(uSpartnScan(&scan) == 1);
+    U_PORT_TEST_ASSERT(scan.numMessages == 1);
+    U_PORT_TEST_ASSERT(scan.numCrcErrors > 0);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, readHandle) == 0);
+
+    uRingBufferGiveReadHandle(&ringBuffer, readHandle);
+    uRingBufferDelete(&ringBuffer);
+    uPortFree(pLinearBuffer);
+
+    uPortDeinit();
+
+    // Check for memory leaks
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT((heapUsed == 0) || (heapUsed == (int32_t)U_ERROR_COMMON_NOT_SUPPORTED));
+}
+
 #endif // __ZEPHYR__
 
 /** Clean-up to be run at the end of this round of tests, just
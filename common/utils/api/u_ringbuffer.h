@@ -409,6 +409,36 @@ size_t uRingBufferReadHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
 size_t uRingBufferPeekHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
                              char *pData, size_t length, size_t offset);
 
+/** Like uRingBufferPeekHandle() but, rather than copying the data out,
+ * returns a pointer to the data where it sits in the linear buffer
+ * underlying the ring buffer, along with the number of bytes that
+ * may be read contiguously from that pointer; where the data wraps
+ * around the end of the linear buffer call this function again with
+ * offset increased by the number returned to get the remainder.
+ * To use this function the ring buffer must have been created by
+ * calling uRingBufferCreateWithReadHandle() rather than
+ * uRingBufferCreate().
+ *
+ * IMPORTANT: the data pointed-to remains valid only until it is
+ * read out through this read handle; if something may call
+ * uRingBufferForceAdd() on the ring buffer in the meantime then
+ * the read handle should be locked with uRingBufferLockReadHandle()
+ * for the duration.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param handle            a read handle, as originally  returned by
+ *                          uRingBufferTakeReadHandle().
+ * @param[out] ppData       a place to put a pointer to the data, cannot
+ *                          be NULL.
+ * @param offset            the offset from the read pointer at which
+ *                          the data should begin.
+ * @return                  the number of bytes that may be read
+ *                          contiguously from *ppData; zero if there is
+ *                          no data at the given offset.
+ */
+size_t uRingBufferPeekSpanHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                 const char **ppData, size_t offset);
+
 /** Like uRingBufferDataSize() except for use by an entity that has
  * previously obtained a read handle by calling uRingBufferTakeReadHandle();
  * this mechanism should be employed if there is to be more than one consumer
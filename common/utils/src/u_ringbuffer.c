@@ -751,6 +751,39 @@ size_t uRingBufferPeekHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
     return bytesRead;
 }
 
+size_t uRingBufferPeekSpanHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                 const char **ppData, size_t offset)
+{
+    size_t bytesContiguous = 0;
+    size_t available;
+    const char *pSource;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 0) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL)) {
+            available = ptrDiff(pRingBuffer->pDataRead[handle], pRingBuffer->pDataWrite,
+                                pRingBuffer->size);
+            if (offset < available) {
+                pSource = pPtrOffset(pRingBuffer->pDataRead[handle], offset,
+                                     pRingBuffer->pBuffer, pRingBuffer->size);
+                bytesContiguous = available - offset;
+                // Limit to what is left before the end of the linear buffer
+                if (pSource + bytesContiguous > pRingBuffer->pBuffer + pRingBuffer->size) {
+                    bytesContiguous = pRingBuffer->pBuffer + pRingBuffer->size - pSource;
+                }
+                *ppData = pSource;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return bytesContiguous;
+}
+
 size_t uRingBufferDataSizeHandle(const uRingBuffer_t *pRingBuffer, int32_t handle)
 {
     size_t dataSize = 0;
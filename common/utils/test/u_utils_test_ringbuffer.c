@@ -123,6 +123,7 @@ U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferBasic")
     size_t readLoss = 0;
     size_t readLossHandle[U_TEST_UTILS_RINGBUFFER_READ_HANDLES_MAX_NUM] = {0};
     char b = ~U_TEST_UTILS_RINGBUFFER_FILL_CHAR;
+    const char *pSpan = NULL;
     size_t y;
     size_t z;
 
@@ -806,9 +807,35 @@ U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferBasic")
     // Now the whole ring buffer should be available again
     U_PORT_TEST_ASSERT(uRingBufferAvailableSize(&ringBuffer) == sizeof(linearBuffer) - 1);
     U_PORT_TEST_ASSERT(uRingBufferAvailableSizeMax(&ringBuffer) == sizeof(linearBuffer) - 1);
-    uRingBufferGiveReadHandle(&ringBuffer, handle[0]);
     uRingBufferGiveReadHandle(&ringBuffer, handle[1]);
 
+    // Peek spans of data in place, including across the wrap
+    U_TEST_PRINT_LINE("testing peeking spans of data...");
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpanHandle(&ringBuffer, handle[0], &pSpan, 0) == 0);
+    // Move the pointers to just before the end of the linear buffer
+    uRingBufferReset(&ringBuffer);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn, sizeof(linearBuffer) - 3));
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle[0], NULL,
+                                             sizeof(linearBuffer) - 3) == sizeof(linearBuffer) - 3);
+    uRingBufferFlush(&ringBuffer);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn, 5));
+    pSpan = NULL;
+    y = uRingBufferPeekSpanHandle(&ringBuffer, handle[0], &pSpan, 0);
+    U_TEST_PRINT_LINE(" first span is %d byte(s).", y);
+    U_PORT_TEST_ASSERT(y == 3);
+    U_PORT_TEST_ASSERT(pSpan == linearBuffer + sizeof(linearBuffer) - 3);
+    U_PORT_TEST_ASSERT(memcmp(pSpan, bufferIn, y) == 0);
+    z = uRingBufferPeekSpanHandle(&ringBuffer, handle[0], &pSpan, y);
+    U_TEST_PRINT_LINE(" second span is %d byte(s).", z);
+    U_PORT_TEST_ASSERT(z == 2);
+    U_PORT_TEST_ASSERT(pSpan == linearBuffer);
+    U_PORT_TEST_ASSERT(memcmp(pSpan, bufferIn + y, z) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpanHandle(&ringBuffer, handle[0], &pSpan, y + z) == 0);
+    // Peeking spans must not have moved anything on
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle[0]) == 5);
+    uRingBufferFlushHandle(&ringBuffer, handle[0]);
+    uRingBufferGiveReadHandle(&ringBuffer, handle[0]);
+
     // Check that delete does what it says on the tin
     U_TEST_PRINT_LINE("deleting ring buffer...");
     uRingBufferDelete(&ringBuffer);
@@ -73,6 +73,47 @@ int32_t uPortCryptoSha256(const char *pInput,
                           size_t inputLengthBytes,
                           char *pOutput);
 
+/** Start a SHA256 calculation that will be performed in pieces, for
+ * when the input is too large to hold in memory at once (e.g. while
+ * it is being received).  Feed the data in with
+ * uPortCryptoSha256Update() and get the result with
+ * uPortCryptoSha256Finish(), which must always be called to free
+ * the context, even if the result is not required.
+ *
+ * @param[out] ppContext a place to put a pointer to the context
+ *                       of the calculation, which is allocated by
+ *                       this function; cannot be NULL.
+ * @return               zero on success else negative error code.
+ */
+int32_t uPortCryptoSha256Init(void **ppContext);
+
+/** Add a piece of input data to a SHA256 calculation started with
+ * uPortCryptoSha256Init().
+ *
+ * @param[in] pContext     the context returned by
+ *                         uPortCryptoSha256Init().
+ * @param[in] pInput       a pointer to the input data; cannot be
+ *                         NULL unless inputLengthBytes is zero.
+ * @param inputLengthBytes the length of the input data.
+ * @return                 zero on success else negative error code.
+ */
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes);
+
+/** Complete a SHA256 calculation started with uPortCryptoSha256Init()
+ * and free the context.
+ *
+ * @param[in] pContext the context returned by uPortCryptoSha256Init();
+ *                     this will no longer be valid when this function
+ *                     returns.
+ * @param[out] pOutput a pointer to at least 32 bytes of space to which
+ *                     the output will be written; may be NULL if only
+ *                     the context is to be freed.
+ * @return             zero on success else negative error code.
+ */
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput);
+
 /** Perform a HMAC SHA256 calculation on a block of data.
  *
  * @param pKey             a pointer to the key; cannot be NULL.
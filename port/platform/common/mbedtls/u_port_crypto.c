@@ -33,6 +33,7 @@
 #include "u_error_common.h"
 
 #include "u_port.h"
+#include "u_port_heap.h"
 #include "u_port_crypto.h"
 
 /* ----------------------------------------------------------------
@@ -77,6 +78,63 @@ int32_t uPortCryptoSha256(const char *pInput,
     return errorCode;
 }
 
+// Start a piecewise SHA256 calculation.
+int32_t uPortCryptoSha256Init(void **ppContext)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    mbedtls_sha256_context *pContext;
+
+    if (ppContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pContext = (mbedtls_sha256_context *) pUPortMalloc(sizeof(*pContext));
+        if (pContext != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            // As for uPortCryptoSha256(), use the functions
+            // that NRF5 also has, ignoring any return value
+            mbedtls_sha256_init(pContext);
+            mbedtls_sha256_starts(pContext, 0);
+            *ppContext = (void *) pContext;
+        }
+    }
+
+    return errorCode;
+}
+
+// Add data to a piecewise SHA256 calculation.
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pContext != NULL) && ((pInput != NULL) || (inputLengthBytes == 0))) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        mbedtls_sha256_update((mbedtls_sha256_context *) pContext,
+                              (const unsigned char *) pInput,
+                              inputLengthBytes);
+    }
+
+    return errorCode;
+}
+
+// Complete a piecewise SHA256 calculation.
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (pContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (pOutput != NULL) {
+            mbedtls_sha256_finish((mbedtls_sha256_context *) pContext,
+                                  (unsigned char *) pOutput);
+        }
+        mbedtls_sha256_free((mbedtls_sha256_context *) pContext);
+        uPortFree(pContext);
+    }
+
+    return errorCode;
+}
+
 // Perform a HMAC SHA256 calculation on a block of data.
 int32_t uPortCryptoHmacSha256(const char *pKey,
                               size_t keyLengthBytes,
@@ -581,6 +581,26 @@ int32_t uPortCryptoSha256(const char *pInput,
     (void) pOutput;
     return 0;
 }
+int32_t uPortCryptoSha256Init(void **ppContext)
+{
+    (void) ppContext;
+    return 0;
+}
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes)
+{
+    (void) pContext;
+    (void) pInput;
+    (void) inputLengthBytes;
+    return 0;
+}
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput)
+{
+    (void) pContext;
+    (void) pOutput;
+    return 0;
+}
 int32_t uPortCryptoHmacSha256(const char *pKey,
                               size_t keyLengthBytes,
                               const char *pInput,
@@ -33,6 +33,7 @@
 #include "u_error_common.h"
 
 #include "u_port.h"
+#include "u_port_heap.h"
 #include "u_port_crypto.h"
 
 /* ----------------------------------------------------------------
@@ -43,6 +44,13 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Context for a piecewise SHA256 calculation.
+ */
+typedef struct {
+    BCRYPT_ALG_HANDLE algorithmHandle;
+    BCRYPT_HASH_HANDLE hashHandle;
+} uPortCryptoSha256Context_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -92,6 +100,82 @@ int32_t uPortCryptoSha256(const char *pInput,
     return errorCode;
 }
 
+// Start a piecewise SHA256 calculation.
+int32_t uPortCryptoSha256Init(void **ppContext)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortCryptoSha256Context_t *pContext;
+
+    if (ppContext != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pContext = (uPortCryptoSha256Context_t *) pUPortMalloc(sizeof(*pContext));
+        if (pContext != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            pContext->algorithmHandle = NULL;
+            pContext->hashHandle = NULL;
+            // Open an algorithm handle for SHA256
+            if (BCryptOpenAlgorithmProvider(&(pContext->algorithmHandle),
+                                            BCRYPT_SHA256_ALGORITHM,
+                                            NULL, 0) >= 0) {
+                // Create the hash object, letting Windows allocate
+                // the memory for it
+                if (BCryptCreateHash(pContext->algorithmHandle,
+                                     &(pContext->hashHandle),
+                                     NULL, 0, NULL, 0, 0) >= 0) {
+                    errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    *ppContext = (void *) pContext;
+                } else {
+                    BCryptCloseAlgorithmProvider(pContext->algorithmHandle, 0);
+                }
+            }
+            if (errorCode != 0) {
+                uPortFree(pContext);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Add data to a piecewise SHA256 calculation.
+int32_t uPortCryptoSha256Update(void *pContext,
+                                const char *pInput,
+                                size_t inputLengthBytes)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pContext != NULL) && ((pInput != NULL) || (inputLengthBytes == 0))) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        if (BCryptHashData(((uPortCryptoSha256Context_t *) pContext)->hashHandle,
+                           (PBYTE) pInput, inputLengthBytes, 0) >= 0) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
+// Complete a piecewise SHA256 calculation.
+int32_t uPortCryptoSha256Finish(void *pContext, char *pOutput)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortCryptoSha256Context_t *pSha256Context = (uPortCryptoSha256Context_t *) pContext;
+
+    if (pSha256Context != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if ((pOutput != NULL) &&
+            (BCryptFinishHash(pSha256Context->hashHandle, (PUCHAR) pOutput,
+                              U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES, 0) < 0)) {
+            errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        }
+        BCryptDestroyHash(pSha256Context->hashHandle);
+        BCryptCloseAlgorithmProvider(pSha256Context->algorithmHandle, 0);
+        uPortFree(pSha256Context);
+    }
+
+    return errorCode;
+}
+
 // Perform a HMAC SHA256 calculation on a block of data.
 int32_t uPortCryptoHmacSha256(const char *pKey,
                               size_t keyLengthBytes,
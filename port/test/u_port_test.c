@@ -2867,6 +2867,8 @@ U_PORT_TEST_FUNCTION("[port]", "portCrypto")
     char iv[U_PORT_CRYPTO_AES128_INITIALISATION_VECTOR_LENGTH_BYTES];
     int32_t heapUsed;
     int32_t x;
+    size_t z;
+    void *pContext = NULL;
 
     // Whatever called us likely initialised the
     // port so deinitialise it here to obtain the
@@ -2890,6 +2892,26 @@ U_PORT_TEST_FUNCTION("[port]", "portCrypto")
         U_TEST_PRINT_LINE("SHA256 not supported.");
     }
 
+    U_TEST_PRINT_LINE("testing piecewise SHA256...");
+    x = uPortCryptoSha256Init(&pContext);
+    if (x != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+        U_PORT_TEST_ASSERT(x == (int32_t) U_ERROR_COMMON_SUCCESS);
+        memset(buffer, 0, sizeof(buffer));
+        // Feed the test vector in, in uneven pieces
+        for (size_t y = 0; y < sizeof(gSha256Input) - 1; y += 7) {
+            z = sizeof(gSha256Input) - 1 - y;
+            if (z > 7) {
+                z = 7;
+            }
+            U_PORT_TEST_ASSERT(uPortCryptoSha256Update(pContext, gSha256Input + y, z) == 0);
+        }
+        U_PORT_TEST_ASSERT(uPortCryptoSha256Finish(pContext, buffer) == 0);
+        U_PORT_TEST_ASSERT(memcmp(buffer, gSha256Output,
+                                  U_PORT_CRYPTO_SHA256_OUTPUT_LENGTH_BYTES) == 0);
+    } else {
+        U_TEST_PRINT_LINE("piecewise SHA256 not supported.");
+    }
+
     U_TEST_PRINT_LINE("testing HMAC SHA256...");
     x = uPortCryptoHmacSha256(gHmacSha256Key,
                               sizeof(gHmacSha256Key) - 1,
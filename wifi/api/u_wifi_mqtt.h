@@ -48,6 +48,20 @@ extern "C" {
  */
 #define U_WIFI_MQTT_MAX_NUM_CONNECTIONS 7
 
+#ifndef U_WIFI_MQTT_PUBLISH_WINDOW_MAX_NUM
+/** The maximum number of messages published with
+ * uWifiMqttPublishAsync() that may be outstanding on a session.
+ */
+#define U_WIFI_MQTT_PUBLISH_WINDOW_MAX_NUM 8
+#endif
+
+#ifndef U_WIFI_MQTT_PUBLISH_WINDOW_DEFAULT
+/** The default number of messages published with
+ * uWifiMqttPublishAsync() that may be outstanding on a session.
+ */
+#define U_WIFI_MQTT_PUBLISH_WINDOW_DEFAULT 4
+#endif
+
 
 typedef enum {
     U_WIFI_MQTT_QOS_AT_MOST_ONCE = 0,
@@ -115,6 +129,56 @@ int32_t uWifiMqttPublish(const uMqttClientContext_t *pContext,
                          uMqttQos_t qos,
                          bool retain);
 
+/** Publish topic on connected MQTT session without waiting for
+ * the result, which is passed to pCallback.  The module provides no
+ * indication of a broker acknowledgement, hence the result is that
+ * of handing the message to the module.  If the number of messages
+ * whose pCallback has not yet been called has reached the window
+ * set with uWifiMqttSetPublishWindow() #U_ERROR_COMMON_BUSY is
+ * returned.
+ *
+ * @param[in] pContext       client context returned by pUMqttClientOpen().
+ * @param[in] pTopicNameStr  pointer to topic string.
+ * @param[in] pMessage       pointer to message buffer that need to be published.
+ * @param messageSizeBytes   size of the message buffer.
+ * @param qos                qos of the message.
+ * @param retain             set to true if the message need to be retained by the broker
+ *                           between connect and disconnect.
+ * @param[in] pCallback      callback that will be called with the token returned by
+ *                           this function, the result (zero or negative error code)
+ *                           and pCallbackParam; may be NULL.
+ * @param[in] pCallbackParam parameter that will be passed to pCallback.
+ * @return                   a token, zero or positive, on success, else negative
+ *                           error code.
+ */
+int32_t uWifiMqttPublishAsync(const uMqttClientContext_t *pContext,
+                              const char *pTopicNameStr,
+                              const char *pMessage,
+                              size_t messageSizeBytes,
+                              uMqttQos_t qos,
+                              bool retain,
+                              void (*pCallback) (int32_t, int32_t, void *),
+                              void *pCallbackParam);
+
+/** Set the number of messages published with uWifiMqttPublishAsync()
+ * that may be outstanding on a session.
+ *
+ * @param[in] pContext client context returned by pUMqttClientOpen().
+ * @param windowSize   1 to #U_WIFI_MQTT_PUBLISH_WINDOW_MAX_NUM.
+ * @return             zero on success or negative error code.
+ */
+int32_t uWifiMqttSetPublishWindow(const uMqttClientContext_t *pContext,
+                                  size_t windowSize);
+
+/** Get the number of messages published with uWifiMqttPublishAsync()
+ * whose callback has not yet been called.
+ *
+ * @param[in] pContext client context returned by pUMqttClientOpen().
+ * @return             the number of outstanding messages or negative
+ *                     error code.
+ */
+int32_t uWifiMqttGetPublishInFlight(const uMqttClientContext_t *pContext);
+
 /** Set a callback to be called when new messages are available to
  * be read.  The callback may then call uWifiMqttGetUnread() to read
  * the messages.  Note that this callback will only be called when
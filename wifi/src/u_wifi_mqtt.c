@@ -101,6 +101,9 @@ typedef struct uWifiMqttSession_t {
     void *pCbParam;
     void (*pDataCb)(int32_t unreadMsgsCount, void *pCbParam);
     void (*pDisconnectCb)(int32_t status, void *pCbParam);
+    size_t publishWindow;
+    size_t publishInFlight;
+    int32_t publishNextToken;
 } uWifiMqttSession_t;
 
 typedef struct {
@@ -109,6 +112,10 @@ typedef struct {
     void (*pDataCb)(int32_t unreadMsgsCount, void *pCbParam);
     int32_t disconnStatus;
     void (*pDisconnectCb)(int32_t disconnStatus, void *pCbParam);
+    bool isPublish;
+    int32_t publishToken;
+    int32_t publishErrorCode;
+    void (*pPublishCb)(int32_t token, int32_t errorCode, void *pCbParam);
 } uCallbackEvent_t;
 
 static uWifiMqttSession_t gMqttSessions[U_WIFI_MQTT_MAX_NUM_CONNECTIONS];
@@ -474,7 +481,8 @@ static int32_t disconnectMqttConnectionToBroker(uWifiMqttSession_t *pMqttSession
 }
 
 /**
- *  Callback to handle both data available and disconnection events
+ *  Callback to handle data available, disconnection and
+ *  asynchronous publish events
  */
 static void onCallbackEvent(void *pParam, size_t eventSize)
 {
@@ -483,7 +491,19 @@ static void onCallbackEvent(void *pParam, size_t eventSize)
     int unreadMsgsCount = 0;
     (void) eventSize;
 
-    if (pCbEvent->pDataCb) {
+    if (pCbEvent->isPublish) {
+        U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+
+        if ((pMqttSession != NULL) && (pMqttSession->publishInFlight > 0)) {
+            pMqttSession->publishInFlight--;
+        }
+        U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+
+        if (pCbEvent->pPublishCb) {
+            pCbEvent->pPublishCb(pCbEvent->publishToken, pCbEvent->publishErrorCode,
+                                 pCbEvent->pCbParam);
+        }
+    } else if (pCbEvent->pDataCb) {
         U_PORT_MUTEX_LOCK(gMqttSessionMutex);
 
         if (pMqttSession != NULL) {
@@ -712,6 +732,25 @@ static void freeMqttSession(uWifiMqttSession_t *pMqttSession)
     }
 }
 
+/**
+ * Open the callback event queue if it is not already open;
+ * must be called with gMqttSessionMutex locked.
+ */
+static int32_t openCallbackQueue(void)
+{
+    if (gCallbackQueue == (int32_t)U_ERROR_COMMON_NOT_INITIALISED) {
+        gCallbackQueue = uPortEventQueueOpen(onCallbackEvent,
+                                             "uWifiMqttCallbackQueue",
+                                             sizeof(uCallbackEvent_t),
+                                             U_WIFI_MQTT_DATA_EVENT_STACK_SIZE,
+                                             U_WIFI_MQTT_DATA_EVENT_PRIORITY,
+                                             2 * U_WIFI_MQTT_MAX_NUM_CONNECTIONS);
+    }
+
+    return (gCallbackQueue >= 0) ? (int32_t)U_ERROR_COMMON_SUCCESS :
+           (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
+}
+
 static int32_t initMqttSessions(void)
 {
     int32_t err;
@@ -769,6 +808,7 @@ static uWifiMqttSession_t *allocateMqttSession(void)
 
             pMqttSession = &gMqttSessions[i];
             pMqttSession->sessionHandle = i;
+            pMqttSession->publishWindow = U_WIFI_MQTT_PUBLISH_WINDOW_DEFAULT;
             break;
 
         }
@@ -953,16 +993,7 @@ int32_t uWifiMqttSetMessageCallback(const uMqttClientContext_t *pContext,
             pMqttSession->pDataCb = pCallback;
             pMqttSession->pCbParam = pCallbackParam;
 
-            if (gCallbackQueue == (int32_t)U_ERROR_COMMON_NOT_INITIALISED) {
-                gCallbackQueue = uPortEventQueueOpen(onCallbackEvent,
-                                                     "uWifiMqttCallbackQueue",
-                                                     sizeof(uCallbackEvent_t),
-                                                     U_WIFI_MQTT_DATA_EVENT_STACK_SIZE,
-                                                     U_WIFI_MQTT_DATA_EVENT_PRIORITY,
-                                                     2 * U_WIFI_MQTT_MAX_NUM_CONNECTIONS);
-            }
-            err = (gCallbackQueue >= 0) ? (int32_t)U_ERROR_COMMON_SUCCESS : (int32_t)
-                  U_ERROR_COMMON_NOT_INITIALISED;
+            err = openCallbackQueue();
             U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
         }
         uShortRangeUnlock();
@@ -985,16 +1016,7 @@ int32_t uWifiMqttSetDisconnectCallback(const uMqttClientContext_t *pContext,
             pMqttSession->pDisconnectCb = pCallback;
             pMqttSession->pCbParam = pCallbackParam;
 
-            if (gCallbackQueue == (int32_t)U_ERROR_COMMON_NOT_INITIALISED) {
-                gCallbackQueue = uPortEventQueueOpen(onCallbackEvent,
-                                                     "uWifiMqttCallbackQueue",
-                                                     sizeof(uCallbackEvent_t),
-                                                     U_WIFI_MQTT_DATA_EVENT_STACK_SIZE,
-                                                     U_WIFI_MQTT_DATA_EVENT_PRIORITY,
-                                                     2 * U_WIFI_MQTT_MAX_NUM_CONNECTIONS);
-            }
-            err = (gCallbackQueue >= 0) ? (int32_t)U_ERROR_COMMON_SUCCESS : (int32_t)
-                  U_ERROR_COMMON_NOT_INITIALISED;
+            err = openCallbackQueue();
             U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
         }
         uShortRangeUnlock();
@@ -1069,6 +1091,111 @@ int32_t uWifiMqttPublish(const uMqttClientContext_t *pContext,
     return err;
 }
 
+int32_t uWifiMqttPublishAsync(const uMqttClientContext_t *pContext,
+                              const char *pTopicNameStr,
+                              const char *pMessage,
+                              size_t messageSizeBytes,
+                              uMqttQos_t qos,
+                              bool retain,
+                              void (*pCallback) (int32_t, int32_t, void *),
+                              void *pCallbackParam)
+{
+    uWifiMqttSession_t *pMqttSession = NULL;
+    uShortRangePrivateInstance_t *pInstance;
+    int32_t token = 0;
+    int32_t err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+
+    // Reserve a place in the window
+    if (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS) {
+        err = getMqttInstance(pContext, &pInstance, &pMqttSession);
+        if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
+            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+            err = openCallbackQueue();
+            if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
+                err = (int32_t)U_ERROR_COMMON_BUSY;
+                if (pMqttSession->publishInFlight < pMqttSession->publishWindow) {
+                    token = pMqttSession->publishNextToken;
+                    pMqttSession->publishNextToken = (token < INT32_MAX) ? token + 1 : 0;
+                    pMqttSession->publishInFlight++;
+                    err = (int32_t)U_ERROR_COMMON_SUCCESS;
+                }
+            }
+            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+        }
+        uShortRangeUnlock();
+    }
+
+    if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
+        err = uWifiMqttPublish(pContext, pTopicNameStr, pMessage,
+                               messageSizeBytes, qos, retain);
+        if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
+            // Hand the result to the callback task, which frees
+            // the place in the window
+            //lint -save -e785
+            uCallbackEvent_t event = {
+                .pMqttSession = pMqttSession,
+                .pCbParam = pCallbackParam,
+                .isPublish = true,
+                .publishToken = token,
+                .publishErrorCode = err,
+                .pPublishCb = pCallback
+            };
+            //lint -restore
+            if (uPortEventQueueSend(gCallbackQueue, &event,
+                                    sizeof(event)) != (int32_t)U_ERROR_COMMON_SUCCESS) {
+                onCallbackEvent(&event, sizeof(event));
+            }
+            err = token;
+        } else {
+            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+            pMqttSession->publishInFlight--;
+            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+        }
+    }
+
+    return err;
+}
+
+int32_t uWifiMqttSetPublishWindow(const uMqttClientContext_t *pContext,
+                                  size_t windowSize)
+{
+    uWifiMqttSession_t *pMqttSession;
+    uShortRangePrivateInstance_t *pInstance;
+    int32_t err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((windowSize > 0) && (windowSize <= U_WIFI_MQTT_PUBLISH_WINDOW_MAX_NUM) &&
+        (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS)) {
+        err = getMqttInstance(pContext, &pInstance, &pMqttSession);
+        if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
+            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+            pMqttSession->publishWindow = windowSize;
+            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+        }
+        uShortRangeUnlock();
+    }
+
+    return err;
+}
+
+int32_t uWifiMqttGetPublishInFlight(const uMqttClientContext_t *pContext)
+{
+    uWifiMqttSession_t *pMqttSession;
+    uShortRangePrivateInstance_t *pInstance;
+    int32_t err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if (uShortRangeLock() == (int32_t)U_ERROR_COMMON_SUCCESS) {
+        err = getMqttInstance(pContext, &pInstance, &pMqttSession);
+        if (err == (int32_t)U_ERROR_COMMON_SUCCESS) {
+            U_PORT_MUTEX_LOCK(gMqttSessionMutex);
+            err = (int32_t)pMqttSession->publishInFlight;
+            U_PORT_MUTEX_UNLOCK(gMqttSessionMutex);
+        }
+        uShortRangeUnlock();
+    }
+
+    return err;
+}
+
 int32_t uWifiMqttSubscribe(const uMqttClientContext_t *pContext,
                            const char *pTopicFilterStr,
                            uMqttQos_t maxQos)